@@ -0,0 +1,121 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pbbuf_pool.h"
+
+#include <stdlib.h>
+
+
+/** The number of size classes, from #PBBUF_POOL_MIN_SIZE to
+    #PBBUF_POOL_MAX_SIZE */
+#define POOL_CLASSES 7
+
+/** A free buffer in the pool. The link to the next one is kept in
+    the buffer itself. */
+struct free_buf {
+    struct free_buf* next;
+};
+
+/** A size class of the pool */
+struct pool_class {
+    /** The list of free buffers */
+    struct free_buf* first;
+    /** The number of buffers in the list */
+    unsigned count;
+};
+
+static struct pool_class m_class[POOL_CLASSES];
+pubnub_mutex_static_decl_and_init(m_lock);
+
+
+/** Returns the index of the size class for @p size, or
+    #POOL_CLASSES if it is bigger than the biggest class */
+static unsigned class_of(size_t size)
+{
+    unsigned i;
+    size_t   class_size = PBBUF_POOL_MIN_SIZE;
+
+    for (i = 0; i < POOL_CLASSES; ++i) {
+        if (size <= class_size) {
+            break;
+        }
+        class_size *= 2;
+    }
+    return i;
+}
+
+
+void* pbbuf_pool_take(size_t size)
+{
+    unsigned         i = class_of(size);
+    struct free_buf* buf;
+
+    if (POOL_CLASSES == i) {
+        return malloc(size);
+    }
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    buf = m_class[i].first;
+    if (buf != NULL) {
+        m_class[i].first = buf->next;
+        --m_class[i].count;
+    }
+    pubnub_mutex_unlock(m_lock);
+    if (NULL == buf) {
+        buf = (struct free_buf*)malloc((size_t)PBBUF_POOL_MIN_SIZE << i);
+    }
+
+    return buf;
+}
+
+
+void pbbuf_pool_give(void* buf, size_t size)
+{
+    unsigned i = class_of(size);
+
+    if (NULL == buf) {
+        return;
+    }
+    if (i < POOL_CLASSES) {
+        pubnub_mutex_init_static(m_lock);
+        pubnub_mutex_lock(m_lock);
+        if (m_class[i].count < PUBNUB_BUFFER_POOL_MAX_FREE) {
+            struct free_buf* fb = (struct free_buf*)buf;
+            fb->next            = m_class[i].first;
+            m_class[i].first    = fb;
+            ++m_class[i].count;
+            buf = NULL;
+        }
+        pubnub_mutex_unlock(m_lock);
+    }
+    free(buf);
+}
+
+
+unsigned pbbuf_pool_trim(void)
+{
+    unsigned         i;
+    unsigned         freed = 0;
+    struct free_buf* list  = NULL;
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    for (i = 0; i < POOL_CLASSES; ++i) {
+        while (m_class[i].first != NULL) {
+            struct free_buf* fb = m_class[i].first;
+            m_class[i].first    = fb->next;
+            fb->next            = list;
+            list                = fb;
+        }
+        m_class[i].count = 0;
+    }
+    pubnub_mutex_unlock(m_lock);
+    while (list != NULL) {
+        struct free_buf* fb = list;
+        list                = fb->next;
+        free(fb);
+        ++freed;
+    }
+
+    return freed;
+}
@@ -0,0 +1,63 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PBBUF_POOL
+#define      INC_PBBUF_POOL
+
+#include <stddef.h>
+
+
+/** @file pbbuf_pool.h
+
+    A process-wide pool of (big) buffers, shared by all the contexts.
+    Buffers that a context needs only in some states (like the one for
+    the compressed message, which is needed only while publishing) are
+    taken from the pool when the context gets in such a state and
+    given back when it is done, instead of being a part of every
+    context. So, a context that is idle, or waits for a subscribe
+    response, doesn't take memory for buffers it isn't using.
+
+    The pool has size classes - powers of two, from
+    #PBBUF_POOL_MIN_SIZE to #PBBUF_POOL_MAX_SIZE. A buffer is taken
+    from the class of the smallest size that is not less than the size
+    asked for, and given back to it. Each class keeps at most
+    #PUBNUB_BUFFER_POOL_MAX_FREE buffers that were given back, others
+    are freed. Buffers bigger than the biggest class are not kept.
+
+    All functions are thread-safe.
+*/
+
+#if !defined PUBNUB_BUFFER_POOL_MAX_FREE
+/** The maximum number of free buffers kept in a size class of the
+    pool, for contexts to take. It's the number of contexts that can
+    take a buffer of the class at the same time without allocating
+    memory, if they are given back in between.
+*/
+#define PUBNUB_BUFFER_POOL_MAX_FREE 16
+#endif
+
+/** The size of the smallest size class of the pool. */
+#define PBBUF_POOL_MIN_SIZE 1024
+
+/** The size of the biggest size class of the pool. */
+#define PBBUF_POOL_MAX_SIZE 65536
+
+
+/** Takes a buffer of at least @p size octets from the pool. If
+    there's no free buffer in its size class, it is allocated.
+
+    @return The buffer, NULL if out of memory
+*/
+void* pbbuf_pool_take(size_t size);
+
+/** Gives back the buffer @p buf, taken from the pool with the same @p
+    size. Does nothing if @p buf is NULL.
+*/
+void pbbuf_pool_give(void* buf, size_t size);
+
+/** Frees all the free buffers kept in the pool.
+
+    @return The number of buffers freed
+*/
+unsigned pbbuf_pool_trim(void);
+
+
+#endif /* !defined INC_PBBUF_POOL */
@@ -0,0 +1,103 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pbbuf_pool.h"
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+
+
+Describe(pbbuf_pool);
+
+
+BeforeEach(pbbuf_pool) {
+    pbbuf_pool_trim();
+}
+
+
+AfterEach(pbbuf_pool) {
+    pbbuf_pool_trim();
+}
+
+
+Ensure(pbbuf_pool, take_gives_usable_buffer) {
+    char* buf = (char*)pbbuf_pool_take(32000);
+
+    attest(buf, differs(NULL));
+    memset(buf, 'x', 32000);
+    pbbuf_pool_give(buf, 32000);
+    attest(pbbuf_pool_trim(), equals(1));
+}
+
+
+Ensure(pbbuf_pool, given_back_buffer_is_taken_again) {
+    void* buf = pbbuf_pool_take(32000);
+
+    pbbuf_pool_give(buf, 32000);
+    attest(pbbuf_pool_take(32000), equals(buf));
+    pbbuf_pool_give(buf, 32000);
+}
+
+
+Ensure(pbbuf_pool, sizes_of_the_same_class_share_buffers) {
+    void* buf = pbbuf_pool_take(20000);
+
+    pbbuf_pool_give(buf, 20000);
+    attest(pbbuf_pool_take(32768), equals(buf));
+    pbbuf_pool_give(buf, 32768);
+}
+
+
+Ensure(pbbuf_pool, sizes_of_other_classes_dont_share_buffers) {
+    void* small = pbbuf_pool_take(PUBNUB_NTLM_MAX_TOKEN);
+    void* big;
+
+    pbbuf_pool_give(small, PUBNUB_NTLM_MAX_TOKEN);
+    big = pbbuf_pool_take(32000);
+    attest(big, differs(small));
+    attest(pbbuf_pool_take(PUBNUB_NTLM_MAX_TOKEN), equals(small));
+    pbbuf_pool_give(big, 32000);
+    pbbuf_pool_give(small, PUBNUB_NTLM_MAX_TOKEN);
+    attest(pbbuf_pool_trim(), equals(2));
+}
+
+
+Ensure(pbbuf_pool, keeps_at_most_max_free_buffers) {
+    void*    bufs[PUBNUB_BUFFER_POOL_MAX_FREE + 2];
+    unsigned i;
+
+    for (i = 0; i < sizeof bufs / sizeof bufs[0]; ++i) {
+        bufs[i] = pbbuf_pool_take(4096);
+        attest(bufs[i], differs(NULL));
+    }
+    for (i = 0; i < sizeof bufs / sizeof bufs[0]; ++i) {
+        pbbuf_pool_give(bufs[i], 4096);
+    }
+    attest(pbbuf_pool_trim(), equals(PUBNUB_BUFFER_POOL_MAX_FREE));
+    attest(pbbuf_pool_trim(), equals(0));
+}
+
+
+Ensure(pbbuf_pool, too_big_buffers_are_not_kept) {
+    void* buf = pbbuf_pool_take(PBBUF_POOL_MAX_SIZE + 1);
+
+    attest(buf, differs(NULL));
+    pbbuf_pool_give(buf, PBBUF_POOL_MAX_SIZE + 1);
+    attest(pbbuf_pool_trim(), equals(0));
+}
+
+
+Ensure(pbbuf_pool, giving_back_null_does_nothing) {
+    pbbuf_pool_give(NULL, 32000);
+    attest(pbbuf_pool_trim(), equals(0));
+}
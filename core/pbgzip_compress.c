@@ -5,29 +5,156 @@
 #include "lib/miniz/miniz_tdef.h"
 #include "lib/pbcrc32.h"
 #include "core/pubnub_log.h"
+#include "core/pubnub_mutex.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 #define GZIP_HEADER_LENGTH_BYTES 10
 #define GZIP_FOOTER_LENGTH_BYTES 8
 /* Percents 'off' message length after compression */
 #define PUBNUB_MINIMAL_ACCEPTABLE_COMPRESSION_RATIO 10
+/* Compression level used by default (same as miniz default) */
+#define PUBNUB_DEFAULT_COMPRESSION_LEVEL 6
+#define PUBNUB_MAXIMAL_COMPRESSION_LEVEL 10
+/* Negative window bits (-15) mean no zlib header, just 'deflate' data */
+#define RAW_DEFLATE_WINDOW_BITS -15
+
+/** A (miniz) compressor. It's big (a few hundred KB), but needed
+    only while compressing a message, so compressors are not kept in
+    the contexts, but taken from a process-wide list of free ones, and
+    given back to it when the message is compressed. Its hash table
+    and dictionary are cleared only when it is allocated - resetting
+    it for each message leaves them as they were after the previous
+    one (of any context), which is safe (miniz doesn't look for
+    matches beyond the start of the message), but saves clearing
+    ~100KB per message.
+ */
+struct pbgzip_compressor {
+    tdefl_compressor comp;
+    /** Next in the list of free compressors */
+    struct pbgzip_compressor* next;
+};
+
+/** The list of free compressors */
+static struct pbgzip_compressor* m_free_compressors;
+/** The number of compressors in #m_free_compressors */
+static unsigned m_free_count;
+pubnub_mutex_static_decl_and_init(m_compressor_lock);
+
+
+struct pubnub_gzip_options pubnub_gzip_defopts(void)
+{
+    struct pubnub_gzip_options result;
+    result.level      = PUBNUB_DEFAULT_COMPRESSION_LEVEL;
+    result.min_size   = 0;
+    result.min_saving = PUBNUB_MINIMAL_ACCEPTABLE_COMPRESSION_RATIO;
+    return result;
+}
+
+
+int pubnub_set_gzip_options(pubnub_t* pb, struct pubnub_gzip_options opts)
+{
+    PUBNUB_ASSERT_OPT(pb != NULL);
+    if ((opts.level < 0) || (opts.level > PUBNUB_MAXIMAL_COMPRESSION_LEVEL)) {
+        return -1;
+    }
+    pubnub_mutex_lock(pb->monitor);
+    pb->core.gzip_options = opts;
+    pubnub_mutex_unlock(pb->monitor);
+
+    return 0;
+}
+
+
+static struct pbgzip_compressor* take_compressor(pubnub_t* pb)
+{
+    struct pbgzip_compressor* rslt;
+
+    pubnub_mutex_init_static(m_compressor_lock);
+    pubnub_mutex_lock(m_compressor_lock);
+    rslt = m_free_compressors;
+    if (rslt != NULL) {
+        m_free_compressors = rslt->next;
+        --m_free_count;
+    }
+    pubnub_mutex_unlock(m_compressor_lock);
+
+    if (NULL == rslt) {
+        rslt = (struct pbgzip_compressor*)malloc(sizeof *rslt);
+        if (NULL == rslt) {
+            PUBNUB_LOG_ERROR("take_compressor(pb=%p) - "
+                             "Failed to allocate compressor\n",
+                             pb);
+            return NULL;
+        }
+        tdefl_init(&rslt->comp, NULL, NULL, 0);
+    }
+    return rslt;
+}
 
-static enum pubnub_res deflate_total_to_context_buffer(pubnub_t*   pb,
-                                                       char const* message,
-                                                       size_t      message_size)
+
+static void give_compressor(struct pbgzip_compressor* compressor)
+{
+    pubnub_mutex_init_static(m_compressor_lock);
+    pubnub_mutex_lock(m_compressor_lock);
+    if (m_free_count < PUBNUB_GZIP_MAX_FREE_COMPRESSORS) {
+        compressor->next   = m_free_compressors;
+        m_free_compressors = compressor;
+        ++m_free_count;
+        compressor = NULL;
+    }
+    pubnub_mutex_unlock(m_compressor_lock);
+    free(compressor);
+}
+
+
+unsigned pbgzip_compressor_trim(void)
+{
+    struct pbgzip_compressor* list;
+    unsigned                  rslt;
+
+    pubnub_mutex_init_static(m_compressor_lock);
+    pubnub_mutex_lock(m_compressor_lock);
+    list               = m_free_compressors;
+    rslt               = m_free_count;
+    m_free_compressors = NULL;
+    m_free_count       = 0;
+    pubnub_mutex_unlock(m_compressor_lock);
+
+    while (list != NULL) {
+        struct pbgzip_compressor* next = list->next;
+        free(list);
+        list = next;
+    }
+
+    return rslt;
+}
+
+
+static enum pubnub_res deflate_total_to_context_buffer(pubnub_t*         pb,
+                                                       tdefl_compressor* comp,
+                                                       char const*       message,
+                                                       size_t            message_size)
 {
     size_t unpacked_size = message_size;
-    size_t compressed = sizeof pb->core.gzip_msg_buf -
+    size_t compressed = PUBNUB_COMPRESSED_MAXLEN -
                         (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES);
     char* gzip_msg_buf = pb->core.gzip_msg_buf;
-    tdefl_compressor comp;
+    tdefl_status status;
 
-    tdefl_init(&comp, NULL, NULL, TDEFL_DEFAULT_MAX_PROBES);
-    tdefl_status status = tdefl_compress(&comp,
-                                         message,
-                                         &message_size,
-                                         gzip_msg_buf + GZIP_HEADER_LENGTH_BYTES,
-                                         &compressed,
-                                         TDEFL_FINISH);
+    tdefl_init(comp,
+               NULL,
+               NULL,
+               tdefl_create_comp_flags_from_zip_params(
+                   pb->core.gzip_options.level, RAW_DEFLATE_WINDOW_BITS, 0)
+                   | TDEFL_NONDETERMINISTIC_PARSING_FLAG);
+    status = tdefl_compress(comp,
+                            message,
+                            &message_size,
+                            gzip_msg_buf + GZIP_HEADER_LENGTH_BYTES,
+                            &compressed,
+                            TDEFL_FINISH);
     switch (status) {
     case TDEFL_STATUS_DONE:
         if (message_size == unpacked_size) {
@@ -41,7 +168,7 @@ static enum pubnub_res deflate_total_to_context_buffer(pubnub_t*   pb,
                              pb,
                              packed_size,
                              (diff*1000)/unpacked_size);
-            if ((diff*100)/unpacked_size < PUBNUB_MINIMAL_ACCEPTABLE_COMPRESSION_RATIO) {
+            if ((diff*100)/(long)unpacked_size < (long)pb->core.gzip_options.min_saving) {
                 /* With insufficient compression we choose not to pack */
                 return PNR_STARTED;
             }
@@ -100,7 +227,7 @@ static enum pubnub_res deflate_total_to_context_buffer(pubnub_t*   pb,
 }
 
 /* Compile-time assertion */
-PUBNUB_STATIC_ASSERT(sizeof (*(pubnub_t*)(NULL)).core.gzip_msg_buf
+PUBNUB_STATIC_ASSERT(PUBNUB_COMPRESSED_MAXLEN
                      > (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES),
                      gzip_msg_buf_too_small_);
 
@@ -108,9 +235,29 @@ enum pubnub_res pbgzip_compress(pubnub_t* pb, char const* message)
 {
     char* data;
     size_t size;
+    struct pbgzip_compressor* compressor;
+    enum pubnub_res rslt;
 
     PUBNUB_ASSERT_OPT(pb != NULL);
     PUBNUB_ASSERT_OPT(message != NULL);
+    size = strlen(message);
+    PUBNUB_LOG_TRACE("pbgzip_compress(pb=%p) - Length before compression:%zu bytes\n", pb, size);
+    if (size <= pb->core.gzip_options.min_size) {
+        /* Too short to bother compressing */
+        return PNR_STARTED;
+    }
+#if PUBNUB_BUFFER_POOL
+    if (NULL == pb->core.gzip_msg_buf) {
+        pb->core.gzip_msg_buf = (char*)pbbuf_pool_take(PUBNUB_COMPRESSED_MAXLEN);
+        if (NULL == pb->core.gzip_msg_buf) {
+            PUBNUB_LOG_ERROR("pbgzip_compress(pb=%p) - "
+                             "Failed to take buffer for compressed message\n",
+                             pb);
+            /* Can't compress, so send it as it is */
+            return PNR_STARTED;
+        }
+    }
+#endif
     data = pb->core.gzip_msg_buf;
     /* Gzip format */
     data[0] = 0x1f;
@@ -119,8 +266,14 @@ enum pubnub_res pbgzip_compress(pubnub_t* pb, char const* message)
     data[2] = 8;
     /* flags: no file_name, no f_extras, no f_comment, no f_hcrc */
     memset(data + 3, '\0', 7);
-    size = strlen(message);
-    PUBNUB_LOG_TRACE("pbgzip_compress(pb=%p) - Length before compression:%zu bytes\n", pb, size);
 
-    return deflate_total_to_context_buffer(pb, message, size);
+    compressor = take_compressor(pb);
+    if (NULL == compressor) {
+        /* Can't compress, so send it as it is */
+        return PNR_STARTED;
+    }
+    rslt = deflate_total_to_context_buffer(pb, &compressor->comp, message, size);
+    give_compressor(compressor);
+
+    return rslt;
 }
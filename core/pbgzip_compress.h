@@ -4,6 +4,16 @@
 
 #include "pubnub_api_types.h"
 
+#if !defined PUBNUB_GZIP_MAX_FREE_COMPRESSORS
+/** The maximum number of free compressors kept, for contexts to
+    take when they compress a message. Each is a few hundred KB. It's
+    the number of contexts that can compress at the same time without
+    allocating a compressor.
+*/
+#define PUBNUB_GZIP_MAX_FREE_COMPRESSORS 2
+#endif
+
+
 /** Compresses(deflates) @p message into gzip-formatted data stored in context buffer.
     @retval PNR_OK on success,
     @retval PNR_STARTED on poor comression ratio,
@@ -11,4 +21,10 @@
  */
 enum pubnub_res pbgzip_compress(pubnub_t *pb, char const* message);
 
+/** Frees all the free compressors kept for compressing messages.
+
+    @return The number of compressors freed
+ */
+unsigned pbgzip_compressor_trim(void);
+
 #endif /* INC_PUBNUB_COMPRESSION */
@@ -0,0 +1,217 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pbgzip_compress.h"
+
+#include "pubnub_coreapi_ex.h"
+#include "lib/miniz/miniz_tinfl.h"
+#include "lib/pbcrc32.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+#define streqs is_equal_to_string
+
+
+#define GZIP_HEADER_LENGTH 10
+#define GZIP_FOOTER_LENGTH 8
+
+static pubnub_t m_pb;
+static char     m_msg[4096];
+static char     m_inflated[4096];
+
+
+/* Makes a message of @p len characters, which compresses well if
+   @p repetitive, or hardly at all, if not */
+static char const* make_message(size_t len, bool repetitive)
+{
+    size_t i;
+
+    for (i = 0; i < len; ++i) {
+        m_msg[i] = repetitive ? "\"abcdefgh\","[i % 11] : (char)(1 + rand() % 255);
+    }
+    m_msg[len] = '\0';
+
+    return m_msg;
+}
+
+
+static uint32_t get_le32(char const* s)
+{
+    unsigned char const* u = (unsigned char const*)s;
+    return u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+
+/* Checks that the gzip data in the context is @p message,
+   compressed, returns the percent that compressing saved */
+static long check_gzipped(char const* message)
+{
+    char const* gz      = m_pb.core.gzip_msg_buf;
+    size_t      len     = m_pb.core.gzip_msg_len;
+    size_t      msg_len = strlen(message);
+    size_t      inflated;
+
+    attest(len, is_greater_than(GZIP_HEADER_LENGTH + GZIP_FOOTER_LENGTH));
+    attest((unsigned char)gz[0], equals(0x1f));
+    attest((unsigned char)gz[1], equals(0x8b));
+    attest(gz[2], equals(8));
+    inflated = tinfl_decompress_mem_to_mem(m_inflated,
+                                           sizeof m_inflated,
+                                           gz + GZIP_HEADER_LENGTH,
+                                           len - GZIP_HEADER_LENGTH - GZIP_FOOTER_LENGTH,
+                                           0);
+    attest(inflated, equals(msg_len));
+    attest(memcmp(m_inflated, message, msg_len), equals(0));
+    attest(get_le32(gz + len - 8), equals(pbcrc32(message, msg_len)));
+    attest(get_le32(gz + len - 4), equals(msg_len));
+
+    return ((long)msg_len - (long)len) * 100 / (long)msg_len;
+}
+
+
+Describe(pbgzip_compress);
+
+
+BeforeEach(pbgzip_compress) {
+    memset(&m_pb, 0, sizeof m_pb);
+    m_pb.core.gzip_options = pubnub_gzip_defopts();
+    srand(1);
+}
+
+
+AfterEach(pbgzip_compress) {
+    pbgzip_compressor_trim();
+}
+
+
+Ensure(pbgzip_compress, default_options) {
+    struct pubnub_gzip_options opts = pubnub_gzip_defopts();
+
+    attest(opts.level, equals(6));
+    attest(opts.min_size, equals(0));
+    attest(opts.min_saving, equals(10));
+}
+
+
+Ensure(pbgzip_compress, set_options_checks_the_level) {
+    struct pubnub_gzip_options opts = pubnub_gzip_defopts();
+
+    opts.level      = 1;
+    opts.min_size   = 256;
+    opts.min_saving = 20;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(m_pb.core.gzip_options.level, equals(1));
+    attest(m_pb.core.gzip_options.min_size, equals(256));
+    attest(m_pb.core.gzip_options.min_saving, equals(20));
+
+    opts.level = -1;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(-1));
+    opts.level = 11;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(-1));
+    attest(m_pb.core.gzip_options.level, equals(1));
+
+    opts.level = 0;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    opts.level = 10;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(m_pb.core.gzip_options.level, equals(10));
+}
+
+
+Ensure(pbgzip_compress, compresses_to_gzip_format) {
+    char const* message = make_message(1000, true);
+
+    attest(pbgzip_compress(&m_pb, message), equals(PNR_OK));
+    attest(check_gzipped(message), is_greater_than(10));
+}
+
+
+Ensure(pbgzip_compress, all_levels_inflate_back_to_the_message) {
+    struct pubnub_gzip_options opts = pubnub_gzip_defopts();
+    char const*                message = make_message(3000, true);
+
+    for (opts.level = 1; opts.level <= 10; ++opts.level) {
+        attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+        attest(pbgzip_compress(&m_pb, message), equals(PNR_OK));
+        check_gzipped(message);
+    }
+}
+
+
+Ensure(pbgzip_compress, messages_up_to_min_size_are_not_compressed) {
+    struct pubnub_gzip_options opts = pubnub_gzip_defopts();
+
+    opts.min_size = 500;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(pbgzip_compress(&m_pb, make_message(499, true)), equals(PNR_STARTED));
+    attest(pbgzip_compress(&m_pb, make_message(500, true)), equals(PNR_STARTED));
+    attest(pbgzip_compress(&m_pb, make_message(501, true)), equals(PNR_OK));
+    check_gzipped(m_msg);
+}
+
+
+Ensure(pbgzip_compress, messages_that_dont_save_min_saving_are_not_compressed) {
+    struct pubnub_gzip_options opts = pubnub_gzip_defopts();
+    char const*                message = make_message(1000, true);
+    long                       saving;
+
+    opts.min_saving = 0;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(pbgzip_compress(&m_pb, message), equals(PNR_OK));
+    saving = check_gzipped(message);
+
+    opts.min_saving = (unsigned)saving;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(pbgzip_compress(&m_pb, message), equals(PNR_OK));
+    opts.min_saving = (unsigned)saving + 1;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(pbgzip_compress(&m_pb, message), equals(PNR_STARTED));
+}
+
+
+Ensure(pbgzip_compress, messages_that_get_bigger_are_not_compressed) {
+    struct pubnub_gzip_options opts = pubnub_gzip_defopts();
+    char const*                message = make_message(200, false);
+
+    attest(pbgzip_compress(&m_pb, message), equals(PNR_STARTED));
+
+    /* Even if any saving will do */
+    opts.min_saving = 0;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    opts.level = 0;
+    attest(pubnub_set_gzip_options(&m_pb, opts), equals(0));
+    attest(pbgzip_compress(&m_pb, make_message(1000, true)), equals(PNR_STARTED));
+}
+
+
+Ensure(pbgzip_compress, compressor_is_given_back_for_others_to_use) {
+    pubnub_t    other;
+    char const* message = make_message(1000, true);
+    unsigned    i;
+
+    memset(&other, 0, sizeof other);
+    other.core.gzip_options = pubnub_gzip_defopts();
+    attest(pbgzip_compressor_trim(), equals(0));
+
+    for (i = 0; i < 5; ++i) {
+        attest(pbgzip_compress(&m_pb, message), equals(PNR_OK));
+        check_gzipped(message);
+        attest(pbgzip_compress(&other, message), equals(PNR_OK));
+    }
+    attest(pbgzip_compressor_trim(), equals(1));
+    attest(pbgzip_compressor_trim(), equals(0));
+
+    /* Reused compressor doesn't leak the previous message */
+    attest(pbgzip_compress(&m_pb, make_message(1000, false)), equals(PNR_STARTED));
+    attest(pbgzip_compress(&m_pb, make_message(800, true)), equals(PNR_OK));
+    check_gzipped(m_msg);
+}
@@ -3,161 +3,234 @@
 
 #include "core/pubnub_assert.h"
 #include "lib/miniz/miniz_tinfl.h"
+#include "lib/pbcrc32.h"
 #include "core/pubnub_log.h"
 
-#define GZIP_HEADER_LENGTH_BYTES 10
-#define GZIP_FOOTER_LENGTH_BYTES 8
+#include <string.h>
 
-static enum pubnub_res inflate_total_to_context_buffer(pubnub_t*      pb,
-                                                       uint8_t const* p_in_buf_next,
-                                                       size_t in_buf_size,
-                                                       size_t out_len)
+
+static enum pubnub_res check_header(uint8_t const* header)
 {
-    tinfl_decompressor decomp;
-    size_t             dst_buf_size = out_len;
-    tinfl_init(&decomp);
-    tinfl_status status =
-        tinfl_decompress(&decomp,
-                         (const mz_uint8*)p_in_buf_next,
-                         &in_buf_size,
-                         (mz_uint8*)pb->core.decomp_http_reply,
-                         (mz_uint8*)pb->core.decomp_http_reply,
-                         &dst_buf_size,
-                         TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
-    switch (status) {
-    case TINFL_STATUS_DONE:
-        if (dst_buf_size == out_len) {
-            return PNR_OK;
-        }
-        else {
-            PUBNUB_LOG_ERROR("Decompressed length[%zu] is smaller than the "
-                             "'unpacked_size' value[%zu]!\n"
-                             "(Unpacked:['%.*s'])\n",
-                             dst_buf_size,
-                             out_len,
-                             (long)dst_buf_size,
-                             pb->core.decomp_http_reply);
-        }
-        break;
-    case TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS:
-        PUBNUB_LOG_ERROR(
-            "'Tinfl'-decompress status: failed(cannot make progress)!\n");
-        break;
-    case TINFL_STATUS_FAILED:
-        PUBNUB_LOG_ERROR("'Tinfl'-decompress status: failed!\n");
-        break;
-    case TINFL_STATUS_HAS_MORE_OUTPUT:
-        PUBNUB_LOG_ERROR("Decompressed length is grater than the "
-                         "'unpacked_size' value[%u]!\n"
-                         "(Unpacked:['%.*s'])\n",
-                         (unsigned)out_len,
-                         (int)out_len,
-                         pb->core.decomp_http_reply);
-        break;
-    default:
-        if (status < 0) {
-            PUBNUB_LOG_ERROR("Decompression failed(Status: %d)!", status);
-        }
-        else {
-            PUBNUB_LOG_ERROR("'Tinfl'-decompress status: %d!\n", status);
-        }
-        break;
+    if ((header[0] != 0x1f) || (header[1] != 0x8b)) {
+        PUBNUB_LOG_ERROR("Compressed data format is not gzip!\n");
+        return PNR_BAD_COMPRESSION_FORMAT;
     }
-    return PNR_BAD_COMPRESSION_FORMAT;
+    if (header[2] != 8) {
+        PUBNUB_LOG_ERROR("Unknown compression method %uX - only 'deflate'(8) "
+                         "is supported!\n",
+                         (unsigned)header[2]);
+        return PNR_BAD_COMPRESSION_FORMAT;
+    }
+    if (header[3] != 0) {
+        PUBNUB_LOG_ERROR("GZIP flags should be 0, but are %uX\n",
+                         (unsigned)header[3]);
+        return PNR_BAD_COMPRESSION_FORMAT;
+    }
+    return PNR_OK;
 }
 
-static void swap_reply_buffer(pubnub_t* pb)
+
+/** Returns how many inflated octets can be put in the reply buffer of
+    @p pb after the ones already there, leaving room for the string
+    end.
+ */
+static size_t reply_room(pubnub_t const* pb)
 {
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
-    char*  aux_buf             = pb->core.http_reply;
-    size_t aux_buf_len         = pb->core.http_buf_len;
-    pb->core.http_reply        = pb->core.decomp_http_reply;
-    pb->core.http_buf_len      = pb->core.decomp_buf_size;
-    pb->core.decomp_http_reply = aux_buf;
-    pb->core.decomp_buf_size   = aux_buf_len;
+    if (pb->core.http_reply_capacity <= pb->core.http_buf_len + 1) {
+        return 0;
+    }
+    return pb->core.http_reply_capacity - pb->core.http_buf_len - 1;
 #else
-    PUBNUB_STATIC_ASSERT(sizeof pb->core.http_reply
-                         == sizeof pb->core.decomp_http_reply);
-    PUBNUB_ASSERT(pb->core.decomp_buf_size < sizeof pb->core.decomp_http_reply);
-    memcpy(pb->core.http_reply, pb->core.decomp_http_reply, pb->core.decomp_buf_size);
-    pb->core.http_buf_len = pb->core.decomp_buf_size;
-#endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
-    return;
+    return sizeof pb->core.http_reply - pb->core.http_buf_len - 1;
+#endif
 }
 
 
-static enum pubnub_res inflate_total(pubnub_t*      pb,
-                                     const uint8_t* p_in_buf_next,
-                                     size_t         in_buf_size,
-                                     size_t         out_len)
+static enum pubnub_res grow_reply_buffer(pubnub_t* pb)
 {
-    enum pubnub_res result;
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
-    if (pb->core.decomp_buf_size < out_len) {
-        char* newbuf = (char*)realloc(pb->core.decomp_http_reply, out_len + 1);
-        if (NULL == newbuf) {
-            PUBNUB_LOG_ERROR("Failed to reallocate decompression buffer!\n"
-                             "Out length:%zu\n",
-                             out_len);
-            return PNR_REPLY_TOO_BIG;
-        }
-        pb->core.decomp_http_reply = newbuf;
+    if (0 == pbcc_realloc_reply_buffer(&pb->core, pb->core.http_buf_len + PUBNUB_BUF_MAXLEN)) {
+        return PNR_OK;
     }
+    PUBNUB_LOG_ERROR("Failed to reallocate reply buffer for decompression!\n"
+                     "Decompressed so far:%zu\n",
+                     pb->core.http_buf_len);
 #else
-    if (out_len >= sizeof pb->core.decomp_http_reply) {
-        PUBNUB_LOG_ERROR("Decompression buffer too small!\n"
-                         "Size of buffer:%zu - Out length:%zu\n",
-                         sizeof pb->core.decomp_http_reply,
-                         out_len);
-        return PNR_REPLY_TOO_BIG;
+    PUBNUB_LOG_ERROR("Reply buffer too small for decompression!\n"
+                     "Size of buffer:%zu\n",
+                     sizeof pb->core.http_reply);
+#endif
+    return PNR_REPLY_TOO_BIG;
+}
+
+
+/** Inflates as much as it can of the @p size octets at @p data into
+    the reply buffer of @p pb, advancing them past the ones that were
+    used. Stops when all are used or the "deflate" stream is done, in
+    which case the ones left are (of) the gzip footer.
+ */
+static enum pubnub_res inflate_to_reply(pubnub_t*       pb,
+                                        uint8_t const** data,
+                                        size_t*         size)
+{
+    struct pbgzip_inflate* inflate = pb->core.gzip_inflate;
+    mz_uint8*              out;
+    size_t                 in_size;
+    size_t                 out_size;
+    tinfl_status           status;
+
+    for (;;) {
+        out      = (mz_uint8*)pb->core.http_reply;
+        in_size  = *size;
+        out_size = reply_room(pb);
+        status   = tinfl_decompress(&inflate->decomp,
+                                  (const mz_uint8*)*data,
+                                  &in_size,
+                                  out,
+                                  out + pb->core.http_buf_len,
+                                  &out_size,
+                                  TINFL_FLAG_HAS_MORE_INPUT
+                                      | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+        if (out_size > 0) {
+            inflate->crc =
+                pbcrc32_update(inflate->crc, out + pb->core.http_buf_len, out_size);
+            pb->core.http_buf_len += out_size;
+        }
+        *data += in_size;
+        *size -= in_size;
+
+        switch (status) {
+        case TINFL_STATUS_DONE:
+            inflate->inflated = true;
+            return PNR_OK;
+        case TINFL_STATUS_NEEDS_MORE_INPUT:
+            return PNR_OK;
+        case TINFL_STATUS_HAS_MORE_OUTPUT:
+            if (grow_reply_buffer(pb) != PNR_OK) {
+                return PNR_REPLY_TOO_BIG;
+            }
+            break;
+        case TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS:
+            PUBNUB_LOG_ERROR(
+                "'Tinfl'-decompress status: failed(cannot make progress)!\n");
+            return PNR_BAD_COMPRESSION_FORMAT;
+        case TINFL_STATUS_FAILED:
+            PUBNUB_LOG_ERROR("'Tinfl'-decompress status: failed!\n");
+            return PNR_BAD_COMPRESSION_FORMAT;
+        default:
+            PUBNUB_LOG_ERROR("Decompression failed(Status: %d)!\n", status);
+            return PNR_BAD_COMPRESSION_FORMAT;
+        }
+    }
+}
+
+
+enum pubnub_res pbgzip_decompress_start(pubnub_t* pb)
+{
+    struct pbgzip_inflate* inflate;
+
+#if PUBNUB_DYNAMIC_REPLY_BUFFER
+    if (NULL == pb->core.gzip_inflate) {
+        pb->core.gzip_inflate =
+            (struct pbgzip_inflate*)malloc(sizeof *pb->core.gzip_inflate);
+        if (NULL == pb->core.gzip_inflate) {
+            PUBNUB_LOG_ERROR("Failed to allocate decompression state!\n");
+            return PNR_REPLY_TOO_BIG;
+        }
     }
 #endif
-    result =
-        inflate_total_to_context_buffer(pb, p_in_buf_next, in_buf_size, out_len);
-    if (result == PNR_OK) {
-        pb->core.decomp_buf_size = out_len;
-        swap_reply_buffer(pb);
+    inflate = pb->core.gzip_inflate;
+    tinfl_init(&inflate->decomp);
+    inflate->header_len = 0;
+    inflate->footer_len = 0;
+    inflate->inflated   = false;
+    inflate->crc        = 0;
+
+    return PNR_OK;
+}
+
+
+enum pubnub_res pbgzip_decompress_feed(pubnub_t* pb, uint8_t const* data, size_t size)
+{
+    struct pbgzip_inflate* inflate = pb->core.gzip_inflate;
+
+    PUBNUB_ASSERT_OPT(inflate != NULL);
+    if (inflate->header_len < GZIP_HEADER_LENGTH_BYTES) {
+        size_t n = GZIP_HEADER_LENGTH_BYTES - inflate->header_len;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(inflate->header + inflate->header_len, data, n);
+        inflate->header_len += (uint8_t)n;
+        data += n;
+        size -= n;
+        if (inflate->header_len < GZIP_HEADER_LENGTH_BYTES) {
+            return PNR_OK;
+        }
+        if (check_header(inflate->header) != PNR_OK) {
+            return PNR_BAD_COMPRESSION_FORMAT;
+        }
+    }
+    if (!inflate->inflated && (size > 0)) {
+        enum pubnub_res result = inflate_to_reply(pb, &data, &size);
+        if (result != PNR_OK) {
+            return result;
+        }
+    }
+    if (size > 0) {
+        if (inflate->footer_len + size > GZIP_FOOTER_LENGTH_BYTES) {
+            PUBNUB_LOG_ERROR("Data after the end of gzip footer!\n");
+            return PNR_BAD_COMPRESSION_FORMAT;
+        }
+        memcpy(inflate->footer + inflate->footer_len, data, size);
+        inflate->footer_len += (uint8_t)size;
     }
-    return result;
+
+    return PNR_OK;
 }
 
 
-enum pubnub_res pbgzip_decompress(pubnub_t* pb)
+enum pubnub_res pbgzip_decompress_finish(pubnub_t* pb)
 {
-    const uint8_t* data = (uint8_t*)pb->core.http_reply;
-    size_t         size = (size_t)pb->core.http_buf_len;
-    uint32_t       unpacked_size;
+    struct pbgzip_inflate const* inflate = pb->core.gzip_inflate;
+    uint8_t const*               footer  = inflate->footer;
+    uint32_t                     crc;
+    uint32_t                     unpacked_size;
 
-    if ((size < (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES))
-        || (data[0] != 0x1f) || (data[1] != 0x8b)) {
-        PUBNUB_LOG_ERROR("Compressed data format is not gzip!\n");
+    if (!inflate->inflated || (inflate->footer_len != GZIP_FOOTER_LENGTH_BYTES)) {
+        PUBNUB_LOG_ERROR("Compressed data ended before the gzip footer!\n");
         return PNR_BAD_COMPRESSION_FORMAT;
     }
-    if (data[2] != 8) {
-        PUBNUB_LOG_ERROR("Unknown compression method %uX - only 'deflate'(8) "
-                         "is supported!\n",
-                         (unsigned)data[2]);
+    /* The gzip footer has the CRC32 of the unpacked data and its size
+       (modulo 2^32), in little endian
+    */
+    crc = (uint32_t)footer[0];
+    crc |= (uint32_t)footer[1] << 8;
+    crc |= (uint32_t)footer[2] << 16;
+    crc |= (uint32_t)footer[3] << 24;
+    unpacked_size = (uint32_t)footer[4];
+    unpacked_size |= (uint32_t)footer[5] << 8;
+    unpacked_size |= (uint32_t)footer[6] << 16;
+    unpacked_size |= (uint32_t)footer[7] << 24;
+    PUBNUB_LOG_TRACE("pbgzip_decompress_finish(pb=%p)-Length after "
+                     "decompresion:%zu\n",
+                     pb,
+                     pb->core.http_buf_len);
+    if (unpacked_size != (uint32_t)pb->core.http_buf_len) {
+        PUBNUB_LOG_ERROR("Decompressed length[%zu] differs from the "
+                         "'unpacked_size' value[%lu]!\n",
+                         pb->core.http_buf_len,
+                         (unsigned long)unpacked_size);
         return PNR_BAD_COMPRESSION_FORMAT;
     }
-    if (data[3] != 0) {
-        PUBNUB_LOG_ERROR("GZIP flags should be 0, but are %uX\n",
-                         (unsigned)data[3]);
+    if (crc != inflate->crc) {
+        PUBNUB_LOG_ERROR("Decompressed data CRC32[%lX] differs from the "
+                         "one in gzip footer[%lX]!\n",
+                         (unsigned long)inflate->crc,
+                         (unsigned long)crc);
         return PNR_BAD_COMPRESSION_FORMAT;
     }
-    /* Unpacked message size is placed at the end of the 'gzip' formated message
-       in the last four bytes
-     */
-    unpacked_size = (uint32_t)data[size - 4];
-    unpacked_size |= (uint32_t)data[size - 3] << 8;
-    unpacked_size |= (uint32_t)data[size - 2] << 16;
-    unpacked_size |= (uint32_t)data[size - 1] << 24;
-    PUBNUB_LOG_TRACE("pbgzip_decompress(pb=%p)-Length before:%zu and after "
-                     "decompresion:%lu\n",
-                     pb,
-                     size,
-                     (unsigned long)unpacked_size);
-    size -= (GZIP_HEADER_LENGTH_BYTES + GZIP_FOOTER_LENGTH_BYTES);
 
-    return inflate_total(
-        pb, data + GZIP_HEADER_LENGTH_BYTES, size, (size_t)unpacked_size);
+    return PNR_OK;
 }
@@ -4,18 +4,67 @@
 
 #include "pubnub_api_types.h"
 
+#include "lib/miniz/miniz_tinfl.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
 /* Types of compressed data format */
 enum pubnub_data_compressionType{
     compressionNONE,
     compressionGZIP
 };
 
-/** Decompresses(inflates) gzip-formatted data stored in the reply context buffer.
-    After decompression puts it back into the same buffer.
+#define GZIP_HEADER_LENGTH_BYTES 10
+#define GZIP_FOOTER_LENGTH_BYTES 8
+
+/** The state of inflating a gzip-formatted HTTP response body as it
+    is received.
+ */
+struct pbgzip_inflate {
+    /** The (miniz) inflater of the "deflate" stream */
+    tinfl_decompressor decomp;
+    /** The gzip header, as received so far */
+    uint8_t header[GZIP_HEADER_LENGTH_BYTES];
+    /** The gzip footer (CRC32 and ISIZE), as received so far */
+    uint8_t footer[GZIP_FOOTER_LENGTH_BYTES];
+    /** How much of the gzip header was received */
+    uint8_t header_len;
+    /** How much of the gzip footer was received */
+    uint8_t footer_len;
+    /** Is the "deflate" stream done (all inflated)? */
+    bool inflated;
+    /** The CRC32 of the data inflated so far */
+    uint32_t crc;
+};
+
+/** Starts inflating a gzip-formatted HTTP response body, to be
+    received and given to pbgzip_decompress_feed() piece by piece.
+
+    @retval PNR_OK on success,
+    @retval PNR_REPLY_TOO_BIG lack of memory
+ */
+enum pubnub_res pbgzip_decompress_start(pubnub_t* pb);
+
+/** Inflates the @p size octets of the gzip-formatted HTTP response
+    body at @p data - the next piece of it that was received - and
+    appends the inflated data to the reply buffer of the context,
+    growing it as needed.
+
     @retval PNR_OK on success,
     @retval PNR_REPLY_TOO_BIG lack of memory,
-    @retval PNR_BAD_COMPRESSION_FORMAT on error     
+    @retval PNR_BAD_COMPRESSION_FORMAT on error
+ */
+enum pubnub_res pbgzip_decompress_feed(pubnub_t* pb, uint8_t const* data, size_t size);
+
+/** Finishes inflating the gzip-formatted HTTP response body, after
+    all of it was given to pbgzip_decompress_feed(). Checks that the
+    "deflate" stream is done and that the CRC32 and length of the
+    inflated data match the ones in the gzip footer.
+
+    @retval PNR_OK on success,
+    @retval PNR_BAD_COMPRESSION_FORMAT on error
  */
-enum pubnub_res pbgzip_decompress(pubnub_t *pb);
+enum pubnub_res pbgzip_decompress_finish(pubnub_t* pb);
 
 #endif /* INC_PUBNUB_DECOMPRESSION */
@@ -1,5 +1,11 @@
 /* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
 
+#if PUBNUB_PUBLISH_PIPELINE
+#define PBNTF_END_PUBLISH_PIPELINE(pb) (pb)->flags.publish_pipeline = false
+#else
+#define PBNTF_END_PUBLISH_PIPELINE(pb)
+#endif
+
 /** This macro does the common "stuff to do" on the outcome of a
     transaction. Should be used by all `pbntf_trans_outcome()`
     functions.
@@ -24,5 +30,7 @@
             break;                                                                 \
         }                                                                          \
         M_pb_->flags.is_publish_via_post = false;                                  \
+        PBNTF_END_PUBLISH_PIPELINE(M_pb_);                                         \
+        pbnc_give_back_buffers(M_pb_);                                             \
         M_pb_->state = state;                                                      \
     } while (0)
@@ -153,10 +153,19 @@ int pbntlm_unpack_type2(pbntlm_ctx_t *pb, pubnub_bymebl_t msg)
     PUBNUB_ASSERT_OPT(msg.ptr != NULL);
     PUBNUB_ASSERT_OPT(msg.size > 0);
 
-    if (msg.size > sizeof pb->in_token) {
-        PUBNUB_LOG_ERROR("NTLM Type2 message too long: %zu bytes, max allowed %zu\n", msg.size, sizeof pb->in_token);
+    if (msg.size > PUBNUB_NTLM_MAX_TOKEN) {
+        PUBNUB_LOG_ERROR("NTLM Type2 message too long: %zu bytes, max allowed %zu\n", msg.size, (size_t)PUBNUB_NTLM_MAX_TOKEN);
         return -1;
     }
+#if PUBNUB_BUFFER_POOL
+    if (NULL == pb->in_token) {
+        pb->in_token = (uint8_t*)pbbuf_pool_take(PUBNUB_NTLM_MAX_TOKEN);
+        if (NULL == pb->in_token) {
+            PUBNUB_LOG_ERROR("Failed to take buffer for NTLM Type2 message\n");
+            return -1;
+        }
+    }
+#endif
     memcpy(pb->in_token, msg.ptr, msg.size);
     pb->in_token_size = msg.size;
 
@@ -211,4 +220,8 @@ void pbntlm_packer_deinit(pbntlm_ctx_t *pb)
         FreeCredentialsHandle(&pb->hcreds);
         SecInvalidateHandle(&pb->hcreds);
     }
+#if PUBNUB_BUFFER_POOL
+    pbbuf_pool_give(pb->in_token, PUBNUB_NTLM_MAX_TOKEN);
+    pb->in_token = NULL;
+#endif
 }
@@ -26,10 +26,19 @@ int pbntlm_unpack_type2(pbntlm_ctx_t *pb, pubnub_bymebl_t msg)
     PUBNUB_ASSERT_OPT(msg.ptr != NULL);
     PUBNUB_ASSERT_OPT(msg.size > 0);
 
-    if (msg.size > sizeof pb->in_token) {
-        PUBNUB_LOG_ERROR("NTLM Type2 message too long: %zi bytes, max allowed %zi\n", msg.size, sizeof pb->in_token);
+    if (msg.size > PUBNUB_NTLM_MAX_TOKEN) {
+        PUBNUB_LOG_ERROR("NTLM Type2 message too long: %zi bytes, max allowed %zi\n", msg.size, (size_t)PUBNUB_NTLM_MAX_TOKEN);
         return -1;
     }
+#if PUBNUB_BUFFER_POOL
+    if (NULL == pb->in_token) {
+        pb->in_token = (uint8_t*)pbbuf_pool_take(PUBNUB_NTLM_MAX_TOKEN);
+        if (NULL == pb->in_token) {
+            PUBNUB_LOG_ERROR("Failed to take buffer for NTLM Type2 message\n");
+            return -1;
+        }
+    }
+#endif
 
     /* Should probably do some basic checking of the message */
 
@@ -49,5 +58,10 @@ int pbntlm_pack_type3(pbntlm_ctx_t *pb, char const* username, char const* passwo
 
 void pbntlm_packer_deinit(pbntlm_ctx_t *pb)
 {
+#if PUBNUB_BUFFER_POOL
+    pbbuf_pool_give(pb->in_token, PUBNUB_NTLM_MAX_TOKEN);
+    pb->in_token = NULL;
+#else
     PUBNUB_UNUSED(pb);
+#endif
 }
@@ -165,6 +165,25 @@ enum pubnub_res pbpal_line_read_status(pubnub_t *pb);
 */
 int pbpal_read_len(pubnub_t *pb);
 
+/** Returns a pointer to the data that was received, but not yet read
+    (by reading a line or a given number of octets), and puts its length
+    in @p len. This lets one process received data in place, without
+    reading (and moving) it. Returns NULL (and 0 in @p len) if there is
+    no such data, or the PAL doesn't keep it.
+
+    @precondition Previous read on the context was finished
+*/
+char const* pbpal_unread_data(pubnub_t *pb, size_t *len);
+
+/** Drops the first @p n octets of the data that was received, but not
+    yet read, as if they were read - the next read will start after
+    them.
+
+    @precondition @p n is not bigger than the length of the unread data
+    (as returned by pbpal_unread_data())
+*/
+void pbpal_skip_unread(pubnub_t *pb, size_t n);
+
 /** Starts reading a given number of octets (bytes) from an
     established TCP connection. Only one reading can take place at any
     given time.
@@ -179,6 +198,26 @@ int pbpal_read_len(pubnub_t *pb);
 */
 int pbpal_start_read(pubnub_t *pb, size_t n);
 
+/** Starts reading a given number of octets (bytes) from an
+    established TCP connection straight into the given @p dest
+    buffer, instead of our buffer, avoiding the copying from the
+    latter to the former. Data that was already received in our
+    buffer is (of course) copied first.
+
+    To check if reading is complete, call pbpal_read_status(), which,
+    in this case, reports PNR_OK only when all of the @p n octets were
+    read.
+
+    @precondition Previous read (or write) on the context was finished
+
+    @param pb The Pubnub context of an established TCP connection
+    @param dest The buffer to read to, at least @p n octets long
+    @param n Number of octets (bytes) to read
+    @return 0: OK (started), -1: PAL doesn't support it, use
+    pbpal_start_read()
+*/
+int pbpal_start_read_into(pubnub_t *pb, char* dest, size_t n);
+
 /** Returns the status of reading a chunk of data. In general, it's
     used to receive the body (or chunk of it) of the HTTP response.
 
@@ -229,4 +268,11 @@ void pbpal_free(pubnub_t *pb);
 #if PUBNUB_USE_MULTIPLE_ADDRESSES
 void pbpal_multiple_addresses_reset_counters(struct pubnub_multi_addresses* spare_addresses);
 #endif /* PUBNUB_USE_MULTIPLE_ADDRESSES */
+
+#if PUBNUB_HAPPY_EYEBALLS
+/** Stops the race of connection attempts of the context @p pb, if
+    any, closing the socket of the racing attempt.
+ */
+void pbpal_connect_race_forget(pubnub_t* pb);
+#endif /* PUBNUB_HAPPY_EYEBALLS */
 #endif /* !defined INC_PBPAL */
@@ -7,6 +7,24 @@
 #include "pubnub_assert.h"
 
 
+#if PUBNUB_CALLBACK_THREAD_COUNT > 1
+pubnub_mutex_static_decl_and_init(m_lock);
+static unsigned m_next_thread_index pubnub_guarded_by(m_lock);
+
+
+void pbntf_assign_thread(pubnub_t* pb)
+{
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    pb->thread_index = m_next_thread_index++;
+    if (m_next_thread_index == PUBNUB_CALLBACK_THREAD_COUNT) {
+        m_next_thread_index = 0;
+    }
+    pubnub_mutex_unlock(m_lock);
+}
+#endif
+
+
 void pbntf_trans_outcome(pubnub_t* pb, enum pubnub_state state)
 {
     PBNTF_TRANS_OUTCOME_COMMON(pb, state);
@@ -73,3 +91,28 @@ pubnub_callback_t pubnub_get_callback(pubnub_t* pb)
 
     return result;
 }
+
+
+enum pubnub_res pubnub_set_thread_affinity(pubnub_t* pb, unsigned thread_index)
+{
+    enum pubnub_res rslt = PNR_OK;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    if (thread_index >= PUBNUB_CALLBACK_THREAD_COUNT) {
+        return PNR_INVALID_PARAMETERS;
+    }
+#if PUBNUB_CALLBACK_THREAD_COUNT > 1
+    pubnub_mutex_lock(pb->monitor);
+    /* A kept alive connection is still watched by the current thread */
+    if ((pb->state != PBS_IDLE) || (pb->pal.socket != SOCKET_INVALID)) {
+        rslt = PNR_IN_PROGRESS;
+    }
+    else {
+        pb->thread_index = thread_index;
+    }
+    pubnub_mutex_unlock(pb->monitor);
+#endif
+
+    return rslt;
+}
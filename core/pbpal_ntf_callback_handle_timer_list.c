@@ -10,12 +10,15 @@
 
 void pbntf_handle_timer_list(int ms_elapsed, pubnub_t** head)
 {
-    pubnub_t* expired;
-
     PUBNUB_ASSERT_OPT(head != NULL);
     PUBNUB_ASSERT_OPT(ms_elapsed > 0);
 
-    expired = pubnub_timer_list_as_time_goes_by(head, ms_elapsed);
+    pbntf_handle_expired_timers(pubnub_timer_list_as_time_goes_by(head, ms_elapsed));
+}
+
+
+void pbntf_handle_expired_timers(pubnub_t* expired)
+{
     while (expired != NULL) {
         pubnub_t* next;
 
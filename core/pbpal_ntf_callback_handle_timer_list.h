@@ -9,6 +9,12 @@ typedef struct pubnub_ pubnub_t;
  */
 void pbntf_handle_timer_list(int ms_elapsed, pubnub_t** head);
 
+/** Handles the timeout of all the contexts in the list of @p expired
+    timers, as returned by pubnub_timer_list_as_time_goes_by() or
+    pubnub_timer_wheel_as_time_goes_by().
+ */
+void pbntf_handle_expired_timers(pubnub_t* expired);
+
 /** Removes the context @p to_remove @p from_head list, in a "safe"
     manner. That is, it handles ("ignores") if @p to_remove is not in
     @p from_head.
@@ -50,6 +50,18 @@ void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb
 */
 void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb);
 
+/** Add the socket of the connection attempt that races the one of
+    the Pubnub context @p pb (`pb->connect_race.socket`) to the
+    poll-set @p data, watching for "out" events, which are processed
+    as events of @p pb.
+ */
+void pbpal_ntf_callback_save_race_socket(struct pbpal_poll_data* data, pubnub_t* pb);
+
+/** Remove the socket of the connection attempt that races the one of
+    the Pubnub context @p pb from the poll-set @p data.
+ */
+void pbpal_ntf_callback_remove_race_socket(struct pbpal_poll_data* data, pubnub_t* pb);
+
 /** Watch for "out" events ("can write") on @p pbp context in poll-set
     @p data.
  */
@@ -60,7 +72,10 @@ int pbpal_ntf_watch_out_events(struct pbpal_poll_data* data, pubnub_t* pbp);
  */
 int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp);
 
-/** Do the polling and queue any events to process. 
+/** Do the polling and queue any events to process. Waits at most
+    @p ms milliseconds for something to happen, `-1` means to wait
+    until something happens (or the poller is woken up by
+    pbpal_ntf_callback_poller_wakeup()).
 
     Maybe it could return (give back) the contexts that need
     processing instead, but, if there are many, that would slow things
@@ -71,6 +86,18 @@ int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp);
  */
 int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms);
 
+/** Wake up the poller - make a pbpal_ntf_poll_away() that is in
+    progress return, or, if none is, make the next one return without
+    waiting. This can be called from any thread, without holding any
+    lock that guards the poller data @p data.
+
+    @retval 0 OK
+    @retval -1 waking up is not supported by this poller (on this
+    platform), so one should not wait in pbpal_ntf_poll_away() for
+    long
+ */
+int pbpal_ntf_callback_poller_wakeup(struct pbpal_poll_data* data);
+
 /** Deinitialize and deellocate the poller data */
 void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data);
 
@@ -9,83 +9,107 @@
 void pbpal_ntf_callback_queue_init(struct pbpal_ntf_callback_queue* queue)
 {
     pubnub_mutex_init(queue->monitor);
-    queue->size = sizeof queue->apb / sizeof queue->apb[0];
-    queue->head = queue->tail = 0;
+    queue->first = queue->last = NULL;
 }
 
 
 void pbpal_ntf_callback_queue_deinit(struct pbpal_ntf_callback_queue* queue)
 {
     pubnub_mutex_destroy(queue->monitor);
-    queue->head = queue->tail = 0;
+    queue->first = queue->last = NULL;
+}
+
+
+/** Is @p pb in the @p queue. Call with @p queue monitor locked. */
+static bool is_queued(struct pbpal_ntf_callback_queue const* queue,
+                      pubnub_t const*                        pb)
+{
+    return (pb->queue_previous != NULL) || (queue->first == pb);
+}
+
+
+/** Appends @p pb to the end of the @p queue. Call with @p queue
+    monitor locked.
+ */
+static void append(struct pbpal_ntf_callback_queue* queue, pubnub_t* pb)
+{
+    pb->queue_next     = NULL;
+    pb->queue_previous = queue->last;
+    if (NULL == queue->last) {
+        queue->first = pb;
+    }
+    else {
+        queue->last->queue_next = pb;
+    }
+    queue->last = pb;
+}
+
+
+/** Unlinks @p pb from the @p queue. Call with @p queue monitor
+    locked.
+ */
+static void unlink_from(struct pbpal_ntf_callback_queue* queue, pubnub_t* pb)
+{
+    if (NULL == pb->queue_previous) {
+        queue->first = pb->queue_next;
+    }
+    else {
+        pb->queue_previous->queue_next = pb->queue_next;
+    }
+    if (NULL == pb->queue_next) {
+        queue->last = pb->queue_previous;
+    }
+    else {
+        pb->queue_next->queue_previous = pb->queue_previous;
+    }
+    pb->queue_previous = pb->queue_next = NULL;
 }
 
 
 int pbpal_ntf_callback_enqueue_for_processing(struct pbpal_ntf_callback_queue* queue,
                                               pubnub_t* pb)
 {
-    int    result;
-    size_t next_head;
-
     PUBNUB_ASSERT_OPT(queue != NULL);
     PUBNUB_ASSERT_OPT(pb != NULL);
 
     pubnub_mutex_lock(queue->monitor);
-    next_head = queue->head + 1;
-    if (next_head == queue->size) {
-        next_head = 0;
-    }
-    if (next_head != queue->tail) {
-        queue->apb[queue->head] = pb;
-        queue->head             = next_head;
-        result                  = +1;
-    }
-    else {
-        result = -1;
+    if (!is_queued(queue, pb)) {
+        append(queue, pb);
     }
     pubnub_mutex_unlock(queue->monitor);
 
-    return result;
+    return +1;
 }
 
 
 int pbpal_ntf_callback_requeue_for_processing(struct pbpal_ntf_callback_queue* queue,
                                               pubnub_t* pb)
 {
-    bool   found = false;
-    size_t i;
+    int result = 0;
 
+    PUBNUB_ASSERT_OPT(queue != NULL);
     PUBNUB_ASSERT_OPT(pb != NULL);
 
     pubnub_mutex_lock(queue->monitor);
-    for (i = queue->tail; i != queue->head;
-         i = (((i + 1) == queue->size) ? 0 : i + 1)) {
-        if (queue->apb[i] == pb) {
-            found = true;
-            break;
-        }
+    if (!is_queued(queue, pb)) {
+        append(queue, pb);
+        result = +1;
     }
     pubnub_mutex_unlock(queue->monitor);
 
-    return !found ? pbpal_ntf_callback_enqueue_for_processing(queue, pb) : 0;
+    return result;
 }
 
 
 void pbpal_ntf_callback_remove_from_queue(struct pbpal_ntf_callback_queue* queue,
                                           pubnub_t*                        pb)
 {
-    size_t i;
-
     PUBNUB_ASSERT_OPT(queue != NULL);
     PUBNUB_ASSERT_OPT(pb != NULL);
 
     pubnub_mutex_lock(queue->monitor);
-    for (i = queue->tail; i != queue->head;
-         i = (((i + 1) == queue->size) ? 0 : i + 1)) {
-        if (queue->apb[i] == pb) {
-            queue->apb[i] = NULL;
-            break;
-        }
+    if (is_queued(queue, pb)) {
+        unlink_from(queue, pb);
     }
     pubnub_mutex_unlock(queue->monitor);
 }
@@ -94,24 +118,21 @@ void pbpal_ntf_callback_remove_from_queue(struct pbpal_ntf_callback_queue* queue
 void pbpal_ntf_callback_process_queue(struct pbpal_ntf_callback_queue* queue)
 {
     pubnub_mutex_lock(queue->monitor);
-    while (queue->head != queue->tail) {
-        pubnub_t* pbp = queue->apb[queue->tail++];
-        if (queue->tail == queue->size) {
-            queue->tail = 0;
+    while (queue->first != NULL) {
+        pubnub_t* pbp = queue->first;
+        unlink_from(queue, pbp);
+        pubnub_mutex_unlock(queue->monitor);
+
+        pubnub_mutex_lock(pbp->monitor);
+        if (pbp->state == PBS_NULL) {
+            pubnub_mutex_unlock(pbp->monitor);
+            pballoc_free_at_last(pbp);
         }
-        if (pbp != NULL) {
-            pubnub_mutex_unlock(queue->monitor);
-            pubnub_mutex_lock(pbp->monitor);
-            if (pbp->state == PBS_NULL) {
-                pubnub_mutex_unlock(pbp->monitor);
-                pballoc_free_at_last(pbp);
-            }
-            else {
-                pbnc_fsm(pbp);
-                pubnub_mutex_unlock(pbp->monitor);
-            }
-            pubnub_mutex_lock(queue->monitor);
+        else {
+            pbnc_fsm(pbp);
+            pubnub_mutex_unlock(pbp->monitor);
         }
+        pubnub_mutex_lock(queue->monitor);
     }
     pubnub_mutex_unlock(queue->monitor);
 }
@@ -19,17 +19,19 @@
  */
 
 
-#define PBPAL_NTF_CALLBACK_QUEUE_LIMIT 1024
-
-/** The queue data. It's a simple circular buffer of (pointers to)
-    contexts, with a mutex as a monitor for multithreading.
+/** The queue data. It's an intrusive doubly linked list of
+    contexts - the links are in the contexts themselves, so there is
+    no limit on the number of contexts in the queue and checking if a
+    context is in the queue, as well as removing it from the queue,
+    doesn't depend on the number of contexts in the queue. There is a
+    mutex as a monitor for multithreading.
  */
 struct pbpal_ntf_callback_queue {
     pubnub_mutex_t monitor;
-    size_t         size;
-    size_t         head;
-    size_t         tail;
-    pubnub_t*      apb[PBPAL_NTF_CALLBACK_QUEUE_LIMIT];
+    /** The first context in the queue, the one to process next */
+    pubnub_t*      first pubnub_guarded_by(monitor);
+    /** The last context in the queue, the one last enqueued */
+    pubnub_t*      last pubnub_guarded_by(monitor);
 };
 
 
@@ -41,7 +43,10 @@ void pbpal_ntf_callback_queue_init(struct pbpal_ntf_callback_queue* queue);
 void pbpal_ntf_callback_queue_deinit(struct pbpal_ntf_callback_queue* queue);
 
 
-/** Enqueue Pubnub context @p pb for processing in the @p queue */
+/** Enqueue Pubnub context @p pb for processing in the @p queue. As
+    a context can be in the queue only once, if it's already in it,
+    it stays where it is.
+ */
 int pbpal_ntf_callback_enqueue_for_processing(struct pbpal_ntf_callback_queue* queue,
                                               pubnub_t* pb);
 
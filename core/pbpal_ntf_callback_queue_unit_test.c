@@ -0,0 +1,168 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pbpal_ntf_callback_queue.h"
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+
+
+#define MAX_PROCESSED 10
+
+static struct pbpal_ntf_callback_queue m_queue;
+static pubnub_t m_pb[3];
+static pubnub_t* m_processed[MAX_PROCESSED];
+static size_t m_processed_count;
+static pubnub_t* m_requeue_on_processing;
+
+
+int pbnc_fsm(struct pubnub_* pbp)
+{
+    if (m_processed_count < MAX_PROCESSED) {
+        m_processed[m_processed_count++] = pbp;
+    }
+    if (m_requeue_on_processing == pbp) {
+        m_requeue_on_processing = NULL;
+        pbpal_ntf_callback_requeue_for_processing(&m_queue, pbp);
+    }
+    return 0;
+}
+
+
+void pballoc_free_at_last(pubnub_t* pb)
+{
+}
+
+
+Describe(pbpal_ntf_callback_queue);
+
+
+BeforeEach(pbpal_ntf_callback_queue) {
+    size_t i;
+    memset(m_pb, 0, sizeof m_pb);
+    for (i = 0; i < sizeof m_pb / sizeof m_pb[0]; ++i) {
+        m_pb[i].state = PBS_IDLE;
+    }
+    m_processed_count = 0;
+    m_requeue_on_processing = NULL;
+    pbpal_ntf_callback_queue_init(&m_queue);
+}
+
+
+AfterEach(pbpal_ntf_callback_queue) {
+    pbpal_ntf_callback_queue_deinit(&m_queue);
+}
+
+
+Ensure(pbpal_ntf_callback_queue, process_when_empty) {
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(0));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, enqueue_and_process_in_order) {
+    attest(pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]), equals(1));
+    attest(pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[1]), equals(1));
+    attest(pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[2]), equals(1));
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(3));
+    attest(m_processed[0], equals(&m_pb[0]));
+    attest(m_processed[1], equals(&m_pb[1]));
+    attest(m_processed[2], equals(&m_pb[2]));
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(3));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, enqueue_twice_processes_once) {
+    attest(pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]), equals(1));
+    attest(pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[1]), equals(1));
+    attest(pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]), equals(1));
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(2));
+    attest(m_processed[0], equals(&m_pb[0]));
+    attest(m_processed[1], equals(&m_pb[1]));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, requeue_only_if_not_queued) {
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[0]), equals(1));
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[1]), equals(1));
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[0]), equals(0));
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[1]), equals(0));
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(2));
+
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[0]), equals(1));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, remove_from_the_middle) {
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]);
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[1]);
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[2]);
+
+    pbpal_ntf_callback_remove_from_queue(&m_queue, &m_pb[1]);
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[0]), equals(0));
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[2]), equals(0));
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(2));
+    attest(m_processed[0], equals(&m_pb[0]));
+    attest(m_processed[1], equals(&m_pb[2]));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, remove_first_and_last) {
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]);
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[1]);
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[2]);
+
+    pbpal_ntf_callback_remove_from_queue(&m_queue, &m_pb[0]);
+    pbpal_ntf_callback_remove_from_queue(&m_queue, &m_pb[2]);
+    attest(pbpal_ntf_callback_requeue_for_processing(&m_queue, &m_pb[0]), equals(1));
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(2));
+    attest(m_processed[0], equals(&m_pb[1]));
+    attest(m_processed[1], equals(&m_pb[0]));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, remove_when_not_queued) {
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]);
+
+    pbpal_ntf_callback_remove_from_queue(&m_queue, &m_pb[1]);
+    pbpal_ntf_callback_remove_from_queue(&m_queue, &m_pb[0]);
+    pbpal_ntf_callback_remove_from_queue(&m_queue, &m_pb[0]);
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(0));
+}
+
+
+Ensure(pbpal_ntf_callback_queue, requeue_while_processing) {
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[0]);
+    pbpal_ntf_callback_enqueue_for_processing(&m_queue, &m_pb[1]);
+    m_requeue_on_processing = &m_pb[0];
+
+    pbpal_ntf_callback_process_queue(&m_queue);
+    attest(m_processed_count, equals(3));
+    attest(m_processed[0], equals(&m_pb[0]));
+    attest(m_processed[1], equals(&m_pb[1]));
+    attest(m_processed[2], equals(&m_pb[0]));
+}
@@ -0,0 +1,339 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+#include "pubnub_assert.h"
+#include "pubnub_log.h"
+
+#include "core/pubnub_alloc_slab.h"
+#include "pbpal.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <stdlib.h>
+#include <stddef.h>
+
+
+/** The size of a (transparent) huge page we align big chunks to */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/** A slot for a context in a chunk. While the context is free, the
+    slot holds the link to the next free one.
+*/
+union slab_slot {
+    struct pubnub_   ctx;
+    union slab_slot* next_free;
+};
+
+/** A chunk of slots. Slots are carved in order, the free ones are
+    put on the (global) free list.
+*/
+struct slab_chunk {
+    /** The next chunk in the list of all chunks */
+    struct slab_chunk* next;
+    /** The number of slots in the chunk */
+    size_t count;
+    /** The number of slots carved from the chunk */
+    size_t carved;
+    /** For each slot, is it allocated. Kept only for checking context
+        pointers (with #PUBNUB_ASSERT_LEVEL_EX). It's after the slots,
+        so that checking doesn't touch the (free) contexts.
+    */
+    unsigned char* in_use;
+    /** The slots, there's @p count of them */
+    union slab_slot slot[1];
+};
+
+/** All the chunks, in the order they were added */
+static struct slab_chunk* m_first;
+static struct slab_chunk* m_last;
+/** The chunk from which we carve slots when the free list is empty */
+static struct slab_chunk* m_carve;
+/** The list of free slots */
+static union slab_slot* m_free;
+/** The number of slots that can be taken without adding a chunk */
+static size_t m_available;
+pubnub_mutex_static_decl_and_init(m_lock);
+
+
+static size_t slots_per_chunk(void)
+{
+    size_t const header = offsetof(struct slab_chunk, slot);
+
+    if (PUBNUB_SLAB_CHUNK_SIZE < header + sizeof(union slab_slot) + 1) {
+        return 1;
+    }
+    return (PUBNUB_SLAB_CHUNK_SIZE - header) / (sizeof(union slab_slot) + 1);
+}
+
+
+static void* chunk_alloc(size_t size)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    void* p;
+    if (size >= HUGE_PAGE_SIZE) {
+        if (posix_memalign(&p, HUGE_PAGE_SIZE, size) != 0) {
+            return NULL;
+        }
+        /* Just a hint, it's OK if it fails */
+        madvise(p, size, MADV_HUGEPAGE);
+        return p;
+    }
+#endif
+    return malloc(size);
+}
+
+
+/** Allocates a new chunk. Doesn't touch its slots. */
+static struct slab_chunk* new_chunk(void)
+{
+    size_t const       n = slots_per_chunk();
+    size_t             size = offsetof(struct slab_chunk, slot)
+                              + n * sizeof(union slab_slot) + n;
+    struct slab_chunk* chunk;
+
+    /* Slots hardly ever fill the chunk exactly, but the whole chunk
+       is allocated, so that a chunk of the huge page size is one
+       huge page.
+    */
+    if (size < PUBNUB_SLAB_CHUNK_SIZE) {
+        size = PUBNUB_SLAB_CHUNK_SIZE;
+    }
+    chunk = (struct slab_chunk*)chunk_alloc(size);
+    if (NULL == chunk) {
+        PUBNUB_LOG_ERROR("Failed to allocate a chunk of %u contexts\n", (unsigned)n);
+        return NULL;
+    }
+    chunk->next   = NULL;
+    chunk->count  = n;
+    chunk->carved = 0;
+    chunk->in_use = (unsigned char*)(chunk->slot + n);
+
+    return chunk;
+}
+
+
+/** Adds the @p chunk to the slab. Has to be called with `m_lock`
+    locked.
+*/
+static void add_chunk(struct slab_chunk* chunk)
+{
+    if (NULL == m_last) {
+        m_first = chunk;
+    }
+    else {
+        m_last->next = chunk;
+    }
+    m_last = chunk;
+    if (NULL == m_carve) {
+        m_carve = chunk;
+    }
+    m_available += chunk->count;
+}
+
+
+#if defined PUBNUB_ASSERT_LEVEL_EX
+/** Returns the chunk the context @p pb is carved from, NULL if it is
+    not from the slab. Has to be called with `m_lock` locked.
+*/
+static struct slab_chunk* chunk_of(pubnub_t const* pb)
+{
+    struct slab_chunk* chunk;
+
+    for (chunk = m_first; chunk != NULL; chunk = chunk->next) {
+        char const* begin = (char const*)chunk->slot;
+        if (((char const*)pb >= begin)
+            && ((char const*)pb < (char const*)(chunk->slot + chunk->carved))) {
+            if (((char const*)pb - begin) % sizeof(union slab_slot) != 0) {
+                return NULL;
+            }
+            return chunk;
+        }
+    }
+    return NULL;
+}
+
+
+static void mark_in_use(pubnub_t const* pb, bool in_use)
+{
+    struct slab_chunk* chunk = chunk_of(pb);
+
+    PUBNUB_ASSERT_OPT(chunk != NULL);
+    chunk->in_use[(union slab_slot const*)pb - chunk->slot] = in_use;
+}
+#else
+#define mark_in_use(pb, in_use)
+#endif
+
+
+/** Takes a slot from the free list or, if it's empty, carves one
+    from the chunks. Has to be called with `m_lock` locked.
+
+    @return The slot taken, NULL if the slab is full
+*/
+static pubnub_t* take_slot(void)
+{
+    union slab_slot* slot = m_free;
+
+    if (slot != NULL) {
+        m_free = slot->next_free;
+    }
+    else {
+        while ((m_carve != NULL) && (m_carve->carved == m_carve->count)) {
+            m_carve = m_carve->next;
+        }
+        if (NULL == m_carve) {
+            return NULL;
+        }
+        slot = &m_carve->slot[m_carve->carved++];
+    }
+    --m_available;
+    mark_in_use(&slot->ctx, true);
+
+    return &slot->ctx;
+}
+
+
+/** Puts the slot of the context @p pb on the free list. Has to be
+    called with `m_lock` locked.
+*/
+static void give_slot(pubnub_t* pb)
+{
+    union slab_slot* slot = (union slab_slot*)pb;
+
+    mark_in_use(pb, false);
+    slot->next_free = m_free;
+    m_free          = slot;
+    ++m_available;
+}
+
+
+#if defined PUBNUB_ASSERT_LEVEL_EX
+/** Checks that @p pb is an allocated context from the slab. Has to
+    be called with `m_lock` locked.
+*/
+static bool check_ctx_ptr(pubnub_t const* pb)
+{
+    struct slab_chunk const* chunk = chunk_of(pb);
+
+    if (NULL == chunk) {
+        return false;
+    }
+    return chunk->in_use[(union slab_slot const*)pb - chunk->slot] != 0;
+}
+#endif
+
+
+bool pb_valid_ctx_ptr(pubnub_t const* pb)
+{
+#if defined PUBNUB_ASSERT_LEVEL_EX
+    bool result;
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    result = check_ctx_ptr(pb);
+    pubnub_mutex_unlock(m_lock);
+
+    return result;
+#else
+    return pb != NULL;
+#endif
+}
+
+
+int pubnub_prealloc(unsigned n)
+{
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    while (m_available < n) {
+        struct slab_chunk* chunk;
+        pubnub_mutex_unlock(m_lock);
+        chunk = new_chunk();
+        if (NULL == chunk) {
+            return -1;
+        }
+        pubnub_mutex_lock(m_lock);
+        add_chunk(chunk);
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    return 0;
+}
+
+
+pubnub_t* pubnub_alloc(void)
+{
+    pubnub_t* pb;
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    pb = take_slot();
+    pubnub_mutex_unlock(m_lock);
+    if (NULL == pb) {
+        /* Allocate outside of the lock, it may take a while */
+        struct slab_chunk* chunk = new_chunk();
+        if (NULL == chunk) {
+            return NULL;
+        }
+        pubnub_mutex_lock(m_lock);
+        add_chunk(chunk);
+        pb = take_slot();
+        pubnub_mutex_unlock(m_lock);
+    }
+
+    return pb;
+}
+
+
+void pballoc_free_at_last(pubnub_t* pb)
+{
+    PUBNUB_LOG_TRACE("pballoc_free_at_last(%p)\n", pb);
+
+    PUBNUB_ASSERT_OPT(pb != NULL);
+
+    pubnub_mutex_lock(pb->monitor);
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+
+    PUBNUB_ASSERT_OPT(pb->state == PBS_NULL);
+
+    pbnc_give_back_buffers(pb);
+    pbcc_deinit(&pb->core);
+    pbpal_free(pb);
+    pubnub_mutex_unlock(pb->monitor);
+    pubnub_mutex_destroy(pb->monitor);
+    give_slot(pb);
+    pubnub_mutex_unlock(m_lock);
+}
+
+
+int pubnub_free(pubnub_t* pb)
+{
+    int result = -1;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    PUBNUB_LOG_TRACE("pubnub_free(%p)\n", pb);
+
+    pubnub_mutex_lock(pb->monitor);
+    pbnc_stop(pb, PNR_CANCELLED);
+    if (PBS_IDLE == pb->state) {
+        PUBNUB_LOG_TRACE("pubnub_free(%p) PBS_IDLE\n", pb);
+        pb->state = PBS_NULL;
+#if defined(PUBNUB_CALLBACK_API)
+        pbntf_requeue_for_processing(pb);
+        pubnub_mutex_unlock(pb->monitor);
+#else
+        pubnub_mutex_unlock(pb->monitor);
+        pballoc_free_at_last(pb);
+#endif
+
+        result = 0;
+    }
+    else {
+        PUBNUB_LOG_TRACE("pubnub_free(%p) pb->state=%d\n", pb, pb->state);
+        pubnub_mutex_unlock(pb->monitor);
+    }
+
+    return result;
+}
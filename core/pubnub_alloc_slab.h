@@ -0,0 +1,53 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_ALLOC_SLAB
+#define      INC_PUBNUB_ALLOC_SLAB
+
+#include "pubnub_api_types.h"
+
+
+/** @file pubnub_alloc_slab.h
+
+    The "slab" context allocator, an alternative to the "standard"
+    (`pubnub_alloc_std.c`, which `malloc()`s each context) and the
+    "static" (`pubnub_alloc_static.c`, with a fixed array of
+    contexts) allocators. Use it instead of them if your application
+    allocates and frees contexts often (like one per request).
+
+    Contexts are carved from big chunks, each holding as many
+    contexts as fit in #PUBNUB_SLAB_CHUNK_SIZE octets. A freed
+    context is put on a free list, from which pubnub_alloc() takes
+    it, so allocating and freeing is O(1) and, once the slab has
+    grown to the number of contexts in use, doesn't touch the system
+    allocator at all. Chunks are never freed, the memory is kept for
+    the contexts to come.
+
+    On Linux, chunks of (at least) the huge page size are aligned to
+    it and marked as eligible for transparent huge pages, to save TLB
+    entries. The memory of a context is not touched until it is
+    allocated for the first time, so its pages are placed (on a NUMA
+    system) on the node of the thread that first uses it, not of the
+    one that allocated the chunk.
+*/
+
+#if !defined PUBNUB_SLAB_CHUNK_SIZE
+/** The size of a chunk of contexts of the slab allocator, in octets.
+    The default is the usual size of a huge page. If it's smaller
+    than a context, each chunk will hold a single context.
+*/
+#define PUBNUB_SLAB_CHUNK_SIZE (2 * 1024 * 1024)
+#endif
+
+
+/** Makes sure that at least @p n contexts can be allocated without
+    growing the slab, that is, without asking the system for memory.
+    Use it at start-up, to "warm-up" the slab for the number of
+    contexts you expect to use.
+
+    @param n The number of contexts to have ready for allocation
+    @retval 0 OK
+    @retval -1 out of memory, slab not (fully) grown
+*/
+int pubnub_prealloc(unsigned n);
+
+
+#endif /* !defined INC_PUBNUB_ALLOC_SLAB */
@@ -0,0 +1,139 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_alloc.h"
+#include "pubnub_alloc_slab.h"
+#include "pubnub_assert.h"
+
+#include "pbpal.h"
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+
+
+/* Functions the allocator calls when freeing a context */
+
+void pbcc_deinit(struct pbcc_context* p)
+{
+    PUBNUB_UNUSED(p);
+}
+
+
+void pbpal_free(pubnub_t* pb)
+{
+    PUBNUB_UNUSED(pb);
+}
+
+
+void pbnc_stop(struct pubnub_* pbp, enum pubnub_res outcome_to_report)
+{
+    PUBNUB_UNUSED(pbp);
+    PUBNUB_UNUSED(outcome_to_report);
+}
+
+
+static pubnub_t* alloc_idle(void)
+{
+    pubnub_t* pb = pubnub_alloc();
+    if (pb != NULL) {
+        pb->state = PBS_IDLE;
+    }
+    return pb;
+}
+
+
+Describe(pubnub_alloc_slab);
+
+
+BeforeEach(pubnub_alloc_slab) {
+}
+
+
+AfterEach(pubnub_alloc_slab) {
+}
+
+
+Ensure(pubnub_alloc_slab, allocates_distinct_valid_contexts) {
+    pubnub_t* pb   = alloc_idle();
+    pubnub_t* pb_2 = alloc_idle();
+
+    attest(pb, differs(NULL));
+    attest(pb_2, differs(NULL));
+    attest(pb_2, differs(pb));
+    attest(pb_valid_ctx_ptr(pb), equals(true));
+    attest(pb_valid_ctx_ptr(pb_2), equals(true));
+    attest(pubnub_free(pb_2), equals(0));
+    attest(pubnub_free(pb), equals(0));
+}
+
+
+Ensure(pubnub_alloc_slab, freed_context_is_allocated_again) {
+    pubnub_t* pb = alloc_idle();
+
+    attest(pubnub_free(pb), equals(0));
+    attest(pb_valid_ctx_ptr(pb), equals(false));
+    attest(alloc_idle(), equals(pb));
+    attest(pb_valid_ctx_ptr(pb), equals(true));
+    attest(pubnub_free(pb), equals(0));
+}
+
+
+Ensure(pubnub_alloc_slab, context_in_transaction_is_not_freed) {
+    pubnub_t* pb = alloc_idle();
+
+    pb->state = PBS_WAIT_CONNECT;
+    attest(pubnub_free(pb), equals(-1));
+    attest(pb_valid_ctx_ptr(pb), equals(true));
+    pb->state = PBS_IDLE;
+    attest(pubnub_free(pb), equals(0));
+}
+
+
+Ensure(pubnub_alloc_slab, pointers_not_from_the_slab_are_not_valid) {
+    struct pubnub_ ctx;
+    pubnub_t*      pb = alloc_idle();
+
+    attest(pb_valid_ctx_ptr(NULL), equals(false));
+    attest(pb_valid_ctx_ptr(&ctx), equals(false));
+    attest(pb_valid_ctx_ptr((pubnub_t*)((char*)pb + 1)), equals(false));
+    attest(pubnub_free(pb), equals(0));
+}
+
+
+Ensure(pubnub_alloc_slab, grows_past_a_chunk) {
+    pubnub_t* pbs[3 * PUBNUB_SLAB_CHUNK_SIZE / sizeof(struct pubnub_) + 3];
+    unsigned  i;
+
+    for (i = 0; i < sizeof pbs / sizeof pbs[0]; ++i) {
+        pbs[i] = alloc_idle();
+        attest(pbs[i], differs(NULL));
+    }
+    for (i = 0; i < sizeof pbs / sizeof pbs[0]; ++i) {
+        attest(pb_valid_ctx_ptr(pbs[i]), equals(true));
+    }
+    for (i = 0; i < sizeof pbs / sizeof pbs[0]; ++i) {
+        attest(pubnub_free(pbs[i]), equals(0));
+    }
+}
+
+
+Ensure(pubnub_alloc_slab, prealloc_makes_contexts_ready) {
+    pubnub_t* pbs[100];
+    unsigned  i;
+
+    attest(pubnub_prealloc(sizeof pbs / sizeof pbs[0]), equals(0));
+    for (i = 0; i < sizeof pbs / sizeof pbs[0]; ++i) {
+        pbs[i] = alloc_idle();
+        attest(pbs[i], differs(NULL));
+    }
+    for (i = 0; i < sizeof pbs / sizeof pbs[0]; ++i) {
+        attest(pubnub_free(pbs[i]), equals(0));
+    }
+    attest(pubnub_prealloc(0), equals(0));
+}
@@ -122,6 +122,7 @@ void pballoc_free_at_last(pubnub_t* pb)
 
     PUBNUB_ASSERT_OPT(pb->state == PBS_NULL);
 
+    pbnc_give_back_buffers(pb);
     pbcc_deinit(&pb->core);
     pbpal_free(pb);
     remove_allocated(pb);
@@ -21,16 +21,34 @@ void pbcc_init(struct pbcc_context* p, const char* publish_key, const char* subs
     p->auth = NULL;
     p->msg_ofs = p->msg_end = 0;
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
-    p->http_reply = NULL;
+    p->http_reply          = NULL;
+    p->http_reply_capacity = 0;
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
-    p->decomp_buf_size   = (size_t)0;
-    p->decomp_http_reply = NULL;
+    p->gzip_inflate = NULL;
 #endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
 #endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
     p->message_to_publish = NULL;
 
+#if PUBNUB_USE_SUBSCRIBE_V2
+#if PUBNUB_DYNAMIC_REPLY_BUFFER
+    p->v2_index          = NULL;
+    p->v2_index_capacity = 0;
+#endif
+    p->v2_msg_count = p->v2_msg_next = 0;
+#endif /* PUBNUB_USE_SUBSCRIBE_V2 */
+
 #if PUBNUB_CRYPTO_API
     p->secret_key = NULL;
+#if PUBNUB_BUFFER_POOL
+    p->encrypted_msg_buf = NULL;
+#endif
+#endif
+
+#if PUBNUB_USE_GZIP_COMPRESSION
+    p->gzip_options = pubnub_gzip_defopts();
+#if PUBNUB_BUFFER_POOL
+    p->gzip_msg_buf = NULL;
+#endif
 #endif
 }
 
@@ -40,14 +58,22 @@ void pbcc_deinit(struct pbcc_context* p)
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
     if (p->http_reply != NULL) {
         free(p->http_reply);
-        p->http_reply = NULL;
+        p->http_reply          = NULL;
+        p->http_reply_capacity = 0;
     }
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
-    if (p->decomp_http_reply != NULL) {
-        free(p->decomp_http_reply);
-        p->decomp_http_reply = NULL;
+    if (p->gzip_inflate != NULL) {
+        free(p->gzip_inflate);
+        p->gzip_inflate = NULL;
     }
 #endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
+#if PUBNUB_USE_SUBSCRIBE_V2
+    if (p->v2_index != NULL) {
+        free(p->v2_index);
+        p->v2_index          = NULL;
+        p->v2_index_capacity = 0;
+    }
+#endif /* PUBNUB_USE_SUBSCRIBE_V2 */
 #endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
 }
 
@@ -55,11 +81,29 @@ void pbcc_deinit(struct pbcc_context* p)
 int pbcc_realloc_reply_buffer(struct pbcc_context* p, unsigned bytes)
 {
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
-    char* newbuf = (char*)realloc(p->http_reply, bytes + 1);
+    size_t size = (size_t)bytes + 1;
+    char*  newbuf;
+
+    if (size <= p->http_reply_capacity) {
+        return 0;
+    }
+    /* Grow geometrically, so that a (large) chunked reply doesn't
+       reallocate on every chunk.
+     */
+    if (size < 2 * p->http_reply_capacity) {
+        newbuf = (char*)realloc(p->http_reply, 2 * p->http_reply_capacity);
+        if (newbuf != NULL) {
+            p->http_reply          = newbuf;
+            p->http_reply_capacity = 2 * p->http_reply_capacity;
+            return 0;
+        }
+    }
+    newbuf = (char*)realloc(p->http_reply, size);
     if (NULL == newbuf) {
         return -1;
     }
-    p->http_reply = newbuf;
+    p->http_reply          = newbuf;
+    p->http_reply_capacity = size;
     return 0;
 #else
     if (bytes < sizeof p->http_reply / sizeof p->http_reply[0]) {
@@ -79,6 +123,7 @@ bool pbcc_ensure_reply_buffer(struct pbcc_context* p)
         if (NULL == p->http_reply) {
            return false;
         }
+        p->http_reply_capacity = 1;
     }
 #endif
     return true;
@@ -155,43 +200,46 @@ static int find_string_start(char const* buf, int len)
 
 bool pbcc_split_array(char* buf)
 {
-    bool escaped       = false;
-    bool in_string     = false;
-    int  bracket_level = 0;
-
-    for (; *buf != '\0'; ++buf) {
-        if (escaped) {
-            escaped = false;
-        }
-        else if ('"' == *buf) {
-            in_string = !in_string;
-        }
-        else if (in_string) {
-            escaped = ('\\' == *buf);
-        }
-        else {
-            switch (*buf) {
-            case '[':
-            case '{':
-                bracket_level++;
-                break;
-            case ']':
-            case '}':
-                bracket_level--;
-                break;
-                /* if at root, split! */
-            case ',':
-                if (bracket_level == 0) {
-                    *buf = '\0';
-                }
-                break;
-            default:
+    char const* end           = buf + strlen(buf);
+    int         bracket_level = 0;
+
+    for (; buf < end; ++buf) {
+        if (bracket_level > 0) {
+            /* Only the commas at root matter, skip to what changes
+               the level */
+            buf = (char*)pbjson_scan_structural(buf, end);
+            if (buf == end) {
                 break;
             }
         }
+        switch (*buf) {
+        case '"':
+            buf = (char*)pbjson_find_end_string(buf + 1, end);
+            if (buf == end) {
+                /* String (or escape) not finished */
+                return false;
+            }
+            break;
+        case '[':
+        case '{':
+            bracket_level++;
+            break;
+        case ']':
+        case '}':
+            bracket_level--;
+            break;
+            /* if at root, split! */
+        case ',':
+            if (bracket_level == 0) {
+                *buf = '\0';
+            }
+            break;
+        default:
+            break;
+        }
     }
 
-    return !(escaped || in_string || (bracket_level > 0));
+    return bracket_level <= 0;
 }
 
 
@@ -322,6 +370,196 @@ enum pubnub_res pbcc_parse_subscribe_response(struct pbcc_context* p)
 }
 
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+void pbcc_subscribe_stream_start(struct pbcc_context* p)
+{
+    memset(&p->stream, 0, sizeof p->stream);
+    p->stream.phase = pbccStreamStart;
+    p->msg_ofs = p->msg_end = 0;
+    p->chan_ofs = p->chan_end = 0;
+}
+
+
+/** The message array element that ends at @p end is received
+    whole, so, "NUL-terminate" it and make it available to
+    pbcc_get_msg().
+ */
+static void stream_element_done(struct pbcc_context* p, unsigned end)
+{
+    p->http_reply[end] = '\0';
+    if (end > p->stream.elem_ofs) {
+        p->msg_end = end;
+    }
+    p->stream.elem_ofs = end + 1;
+}
+
+
+enum pubnub_res pbcc_subscribe_stream_scan(struct pbcc_context* p)
+{
+    struct pbcc_subscribe_stream* s     = &p->stream;
+    char*                         reply = p->http_reply;
+    unsigned                      i;
+
+    for (i = s->scan_ofs; i < p->http_buf_len; ++i) {
+        char const c = reply[i];
+        switch (s->phase) {
+        case pbccStreamStart:
+            if (c != '[') {
+                s->phase = pbccStreamError;
+                return PNR_FORMAT_ERROR;
+            }
+            s->phase = pbccStreamMessagesStart;
+            break;
+        case pbccStreamMessagesStart:
+            if (c != '[') {
+                s->phase = pbccStreamError;
+                return PNR_FORMAT_ERROR;
+            }
+            s->phase    = pbccStreamMessages;
+            s->elem_ofs = i + 1;
+            p->msg_ofs = p->msg_end = i + 1;
+            break;
+        case pbccStreamMessages:
+            if (s->escaped) {
+                s->escaped = false;
+            }
+            else if ('"' == c) {
+                s->in_string = !s->in_string;
+            }
+            else if (s->in_string) {
+                s->escaped = ('\\' == c);
+            }
+            else {
+                switch (c) {
+                case '[':
+                case '{':
+                    ++s->level;
+                    break;
+                case ']':
+                case '}':
+                    if (s->level > 0) {
+                        --s->level;
+                    }
+                    else if (']' == c) {
+                        /* The end of the message array */
+                        stream_element_done(p, i);
+                        s->phase    = pbccStreamTail;
+                        s->tail_ofs = i + 1;
+                    }
+                    else {
+                        s->phase = pbccStreamError;
+                        return PNR_FORMAT_ERROR;
+                    }
+                    break;
+                case ',':
+                    if (0 == s->level) {
+                        stream_element_done(p, i);
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+            break;
+        case pbccStreamTail:
+            /* Will be parsed when it's all here */
+            i = p->http_buf_len - 1;
+            break;
+        default:
+            return PNR_FORMAT_ERROR;
+        }
+    }
+    s->scan_ofs = i;
+
+    return PNR_OK;
+}
+
+
+unsigned pbcc_subscribe_stream_compact(struct pbcc_context* p)
+{
+    struct pbcc_subscribe_stream* s = &p->stream;
+    unsigned const                discard = p->msg_ofs;
+
+    if ((0 == discard)
+        || ((s->phase != pbccStreamMessages) && (s->phase != pbccStreamTail))) {
+        return 0;
+    }
+    PUBNUB_ASSERT_OPT(discard <= s->scan_ofs);
+    memmove(p->http_reply, p->http_reply + discard, p->http_buf_len - discard);
+    p->http_buf_len -= discard;
+    s->scan_ofs -= discard;
+    if (pbccStreamMessages == s->phase) {
+        s->elem_ofs -= discard;
+    }
+    else {
+        s->tail_ofs -= discard;
+    }
+    p->msg_end = (p->msg_end > discard) ? p->msg_end - discard : 0;
+    p->msg_ofs = 0;
+
+    return discard;
+}
+
+
+enum pubnub_res pbcc_subscribe_stream_finish(struct pbcc_context* p)
+{
+    char*    reply = p->http_reply;
+    unsigned pos   = p->stream.tail_ofs;
+    unsigned str_ofs[3];
+    unsigned str_end[3];
+    unsigned count = 0;
+    unsigned k;
+
+    if (p->stream.phase != pbccStreamTail) {
+        return PNR_FORMAT_ERROR;
+    }
+
+    /* What's left is: ,"5678"] or ,"5678","a,b,c"] or
+       ,"5678","gr-a,gr-b","a,b,c"]
+     */
+    while ((pos < p->http_buf_len) && (',' == reply[pos])) {
+        char const* end;
+        if ((count == sizeof str_ofs / sizeof str_ofs[0]) || (reply[pos + 1] != '"')) {
+            return PNR_FORMAT_ERROR;
+        }
+        end = strchr(reply + pos + 2, '"');
+        if (NULL == end) {
+            return PNR_FORMAT_ERROR;
+        }
+        str_ofs[count] = pos + 2;
+        str_end[count] = end - reply;
+        reply[str_end[count]] = '\0';
+        ++count;
+        pos = str_end[count - 1] + 1;
+    }
+    if ((0 == count) || (pos >= p->http_buf_len) || (reply[pos] != ']')) {
+        return PNR_FORMAT_ERROR;
+    }
+
+    if (str_end[0] - str_ofs[0] >= sizeof p->timetoken) {
+        p->timetoken[0] = '\0';
+        return PNR_FORMAT_ERROR;
+    }
+    memcpy(p->timetoken, reply + str_ofs[0], str_end[0] - str_ofs[0] + 1);
+
+    /* The last one is the channel list (the one before it, if any, is
+       the channel group list, which we skip).
+     */
+    if (count > 1) {
+        for (k = str_ofs[count - 1]; k < str_end[count - 1]; ++k) {
+            if (',' == reply[k]) {
+                reply[k] = '\0';
+            }
+        }
+        p->chan_ofs = str_ofs[count - 1];
+        p->chan_end = str_end[count - 1];
+    }
+
+    return PNR_OK;
+}
+#endif /* PUBNUB_SUBSCRIBE_STREAMING */
+
+
 enum pubnub_res pbcc_append_url_param(struct pbcc_context* pb,
                                       char const*          param_name,
                                       size_t               param_name_len,
@@ -5,6 +5,12 @@
 #include "pubnub_config.h"
 #include "pubnub_api_types.h"
 #include "pubnub_generate_uuid.h"
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+#include "pbgzip_decompress.h"
+#endif
+#if PUBNUB_USE_GZIP_COMPRESSION
+#include "pubnub_coreapi_ex.h"
+#endif
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -18,6 +24,92 @@
 */
 
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+/** Phases of scanning the subscribe response while it is being
+    received
+*/
+enum pbcc_subscribe_stream_phase {
+    /** Expecting the start of the response (outer array) */
+    pbccStreamStart,
+    /** Expecting the start of the message array */
+    pbccStreamMessagesStart,
+    /** In the message array */
+    pbccStreamMessages,
+    /** Message array is done, the rest (time token, channels) is
+        parsed when the whole response is received */
+    pbccStreamTail,
+    /** Response is not in the expected format */
+    pbccStreamError
+};
+
+/** The state of scanning the subscribe response while it is being
+    received, to find the messages in it as soon as they are
+    received whole.
+*/
+struct pbcc_subscribe_stream {
+    /** The phase of the scanning */
+    enum pbcc_subscribe_stream_phase phase;
+    /** Offset in the reply buffer up to which it was scanned */
+    unsigned scan_ofs;
+    /** Offset of the message (element of the message array) that
+        is being scanned */
+    unsigned elem_ofs;
+    /** Offset of the rest of the response, after the message array */
+    unsigned tail_ofs;
+    /** JSON (array/object) nesting level inside the message */
+    int level;
+    /** Are we in a JSON string */
+    bool in_string;
+    /** Is the last character in a JSON string an escape */
+    bool escaped;
+};
+#endif /* PUBNUB_SUBSCRIBE_STREAMING */
+
+
+#if PUBNUB_USE_SUBSCRIBE_V2
+#if !PUBNUB_DYNAMIC_REPLY_BUFFER && !defined PUBNUB_MAX_SUBSCRIBE_V2_MESSAGES
+/** The most messages in a subscribe V2 response that can be indexed,
+    if the reply buffer is static (otherwise, the index grows as
+    needed).
+ */
+#define PUBNUB_MAX_SUBSCRIBE_V2_MESSAGES 100
+#endif
+
+/** A part of the reply: the offset of its start in the reply buffer
+    and its length.
+*/
+struct pbcc_reply_span {
+    unsigned ofs;
+    unsigned len;
+};
+
+/** The fields of a message of a subscribe V2 response, found while
+    parsing the response (in one pass), so that getting the message
+    doesn't have to look for them.
+*/
+struct pbcc_v2_message_index {
+    /** Offset of the start of the message (JSON object) */
+    unsigned start;
+    /** Offset just past the end of the message */
+    unsigned end;
+    /** Publish time token, w/out the quotes */
+    struct pbcc_reply_span tt;
+    /** Channel, w/out the quotes */
+    struct pbcc_reply_span channel;
+    /** Subscription match or channel group */
+    struct pbcc_reply_span match_or_group;
+    /** The message payload */
+    struct pbcc_reply_span payload;
+    /** The message metadata */
+    struct pbcc_reply_span metadata;
+    /** Publish region */
+    int region;
+    /** Message flags */
+    int flags;
+};
+#endif /* PUBNUB_USE_SUBSCRIBE_V2 */
+
+
 /** The Pubnub "(C) core" context, contains context data
     that is shared among all Pubnub C clients.
  */
@@ -45,33 +137,33 @@ struct pbcc_context {
     /** The result of the last Pubnub transaction */
     enum pubnub_res last_result;
 
-    /** The "scratch" buffer for HTTP data */
-    char http_buf[PUBNUB_BUF_MAXLEN];
-
     /** The length of the data currently in the HTTP buffer ("scratch"
         or reply, depending on the state).
      */
     size_t http_buf_len;
 
-#if PUBNUB_CRYPTO_API
-    /** Holds encrypted message */
-    char encrypted_msg_buf[PUBNUB_BUF_MAXLEN];
+#if PUBNUB_CRYPTO_API && PUBNUB_BUFFER_POOL
+    /** Holds encrypted message. Taken from the buffer pool (of
+        #PUBNUB_BUF_MAXLEN octets) when a message is encrypted, given
+        back on the outcome of the transaction. */
+    char* encrypted_msg_buf;
 #endif
 
 #if PUBNUB_USE_GZIP_COMPRESSION
-    /** Buffer for compressed message */
-    char gzip_msg_buf[PUBNUB_COMPRESSED_MAXLEN];
+#if PUBNUB_BUFFER_POOL
+    /** Buffer for compressed message. Taken from the buffer pool (of
+        #PUBNUB_COMPRESSED_MAXLEN octets) when a message is compressed,
+        given back on the outcome of the transaction. */
+    char* gzip_msg_buf;
+#endif
     
     /** The length of compressed data in 'comp_http_buf' ready to be sent */
     size_t gzip_msg_len;
-#endif
 
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-    /** The length of the decompressed data currently in the decompressing
-     * buffer ("scratch").
-     */
-    size_t decomp_buf_size;
+    /** Options for compressing messages */
+    struct pubnub_gzip_options gzip_options;
 #endif
+
     /** The total length of data to be received in a HTTP reply or
         chunk of it.
      */
@@ -79,16 +171,14 @@ struct pbcc_context {
 
 #if PUBNUB_DYNAMIC_REPLY_BUFFER
     char* http_reply;
+    /** The size of the allocated `http_reply` buffer */
+    size_t http_reply_capacity;
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
-    char* decomp_http_reply;
-#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
-#else
-    /** The contents of a HTTP reply/reponse */
-    char http_reply[PUBNUB_REPLY_MAXLEN + 1];
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-    /** Auxiliary buffer for unpacking(decompresing) data from HTTP reply buffer
+    /** The state of inflating a gzip-formatted reply, as it is
+        received, straight into `http_reply`. Allocated on the first
+        such reply.
      */
-    char decomp_http_reply[PUBNUB_REPLY_MAXLEN + 1];
+    struct pbgzip_inflate* gzip_inflate;
 #endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
 #endif /* PUBNUB_DYNAMIC_REPLY_BUFFER */
 
@@ -104,10 +194,60 @@ struct pbcc_context {
     */
     unsigned chan_ofs, chan_end;
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+    /** Scanning of the subscribe response while it is received */
+    struct pbcc_subscribe_stream stream;
+#endif
+
+#if PUBNUB_USE_SUBSCRIBE_V2
+    /** The index of the messages of the last subscribe V2 response */
+#if PUBNUB_DYNAMIC_REPLY_BUFFER
+    struct pbcc_v2_message_index* v2_index;
+    /** How many messages the (allocated) index can hold */
+    unsigned v2_index_capacity;
+#else
+    struct pbcc_v2_message_index v2_index[PUBNUB_MAX_SUBSCRIBE_V2_MESSAGES];
+#endif
+    /** The number of messages in the index */
+    unsigned v2_msg_count;
+    /** The index of the next message to get */
+    unsigned v2_msg_next;
+#endif
+
 #if PUBNUB_CRYPTO_API
     /** Secret key to use for encryption/decryption */
     char const* secret_key;
 #endif
+
+    /* The big buffers are last, so that the fields above, used on
+       (almost) every step of the FSM, are together in a few cache
+       lines, instead of on both sides of a buffer of a few dozen KB.
+     */
+
+    /** The "scratch" buffer for HTTP data */
+    char http_buf[PUBNUB_BUF_MAXLEN];
+
+#if PUBNUB_CRYPTO_API && !PUBNUB_BUFFER_POOL
+    /** Holds encrypted message */
+    char encrypted_msg_buf[PUBNUB_BUF_MAXLEN];
+#endif
+
+#if PUBNUB_USE_GZIP_COMPRESSION && !PUBNUB_BUFFER_POOL
+    /** Buffer for compressed message */
+    char gzip_msg_buf[PUBNUB_COMPRESSED_MAXLEN];
+#endif
+
+#if !PUBNUB_DYNAMIC_REPLY_BUFFER
+    /** The contents of a HTTP reply/reponse */
+    char http_reply[PUBNUB_REPLY_MAXLEN + 1];
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+    /** The state of inflating a gzip-formatted reply, as it is
+        received, straight into `http_reply`. An array of one, to be
+        used as a pointer, like with the dynamic reply buffer.
+     */
+    struct pbgzip_inflate gzip_inflate[1];
+#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
+#endif /* !PUBNUB_DYNAMIC_REPLY_BUFFER */
 };
 
 
@@ -240,6 +380,42 @@ typedef enum pubnub_res (*PFpbcc_parse_response_T)(struct pbcc_context*);
 */
 enum pubnub_res pbcc_parse_subscribe_response(struct pbcc_context* p);
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+/** Starts scanning the response for a subscribe operation while it
+    is being received, which is to start in the reply buffer.
+ */
+void pbcc_subscribe_stream_start(struct pbcc_context* p);
+
+/** Scans the (part of the) response for a subscribe operation that
+    was received (into the reply buffer) since the last scan. Messages
+    that are received whole are made available via pbcc_get_msg(),
+    while the rest of the response is still being received.
+
+    @return PNR_OK: OK so far, PNR_FORMAT_ERROR: invalid response, no
+    more messages will be found by scanning
+*/
+enum pubnub_res pbcc_subscribe_stream_scan(struct pbcc_context* p);
+
+/** Discards the part of the reply buffer that holds the messages
+    that were already gotten (via pbcc_get_msg()), moving the rest
+    of the received response to the start of the reply buffer.
+
+    @return Number of octets discarded
+ */
+unsigned pbcc_subscribe_stream_compact(struct pbcc_context* p);
+
+/** Parses the rest of the response for a subscribe operation - the
+    part after the message array - when it was all received (and
+    scanned), like pbcc_parse_subscribe_response() does for the
+    whole response. Messages that were not gotten yet can still be
+    gotten via pbcc_get_msg().
+
+    @return The result of the parsing, expressed as the "Pubnub
+    result" enum
+ */
+enum pubnub_res pbcc_subscribe_stream_finish(struct pbcc_context* p);
+#endif /* PUBNUB_SUBSCRIBE_STREAMING */
+
 /** Parses the string received as a response for a publish operation
     (transaction). This checks if the response is valid, and, if it
     is, enables getting it as the gotten message (like for
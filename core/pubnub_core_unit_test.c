@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 #include <setjmp.h>
 #include <time.h>
 #include <assert.h>
@@ -76,8 +77,9 @@ static void wait_time_in_seconds(time_t time_in_seconds)
 
 static void buf_setup(pubnub_t* pb)
 {
-    pb->ptr  = (uint8_t*)pb->core.http_buf;
-    pb->left = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+    pb->ptr       = (uint8_t*)pb->core.http_buf;
+    pb->left      = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+    pb->read_into = NULL;
 }
 
 void pbpal_init(pubnub_t* pb)
@@ -220,6 +222,20 @@ int pbpal_read_len(pubnub_t* pb)
 }
 
 
+char const* pbpal_unread_data(pubnub_t* pb, size_t* len)
+{
+    *len = pb->unreadlen;
+    return (0 == pb->unreadlen) ? NULL : (char const*)pb->ptr;
+}
+
+
+void pbpal_skip_unread(pubnub_t* pb, size_t n)
+{
+    pb->ptr += n;
+    pb->unreadlen -= n;
+}
+
+
 static int my_recv(void* p, size_t n)
 {
     static short m_new = 1;
@@ -367,16 +383,64 @@ int pbpal_start_read(pubnub_t* pb, size_t n)
 
     pb->sock_state = STATE_READ;
     pb->len        = n;
+    pb->read_into  = NULL;
 
     return +1;
 }
 
+int pbpal_start_read_into(pubnub_t* pb, char* dest, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, >, 0);
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+
+    pb->sock_state = STATE_READ;
+    pb->len        = n;
+    pb->read_into  = (uint8_t*)dest;
+
+    return 0;
+}
+
+static enum pubnub_res read_into_status(pubnub_t* pb)
+{
+    int have_read;
+
+    if (pb->unreadlen > 0) {
+        have_read = (pb->unreadlen >= pb->len) ? pb->len : pb->unreadlen;
+        memcpy(pb->read_into, pb->ptr, have_read);
+        pb->ptr += have_read;
+        pb->unreadlen -= have_read;
+    }
+    else {
+        have_read = my_recv((char*)pb->read_into, pb->len);
+        if (have_read < 0) {
+            return PNR_IN_PROGRESS;
+        }
+        else if (0 == have_read) {
+            pb->sock_state = STATE_NONE;
+            return PNR_TIMEOUT;
+        }
+    }
+    pb->read_into += have_read;
+    pb->len -= have_read;
+
+    if (0 == pb->len) {
+        pb->read_into  = NULL;
+        pb->sock_state = STATE_NONE;
+        return PNR_OK;
+    }
+
+    return PNR_IN_PROGRESS;
+}
+
 enum pubnub_res pbpal_read_status(pubnub_t* pb)
 {
     int have_read;
 
     PUBNUB_ASSERT_OPT(STATE_READ == pb->sock_state);
 
+    if (pb->read_into != NULL) {
+        return read_into_status(pb);
+    }
     if (0 == pb->unreadlen) {
         unsigned to_recv = pb->len;
         if (to_recv > pb->left) {
@@ -737,6 +801,198 @@ Ensure(/*pbjson_parse, */ gibberish_json)
 }
 
 
+Ensure(/*pbjson_parse, */ get_next_object_member)
+{
+    char const* json = "{\"t\":{\"t\":\"15\",\"r\":4}, \"m\" : [{\"d\":\"a,}\"}],"
+                       "\"e\\\"\":null }";
+    struct pbjson_elem elem  = { json, json + strlen(json) };
+    struct pbjson_elem empty = { "{ }", NULL };
+    struct pbjson_elem name;
+    struct pbjson_elem value;
+    char const*        pos = elem.start;
+
+    attest(pbjson_get_next_object_member(&elem, &pos, &name, &value), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&name, "t"), is_true);
+    attest(pbjson_elem_equals_string(&value, "{\"t\":\"15\",\"r\":4}"), is_true);
+    attest(pbjson_get_next_object_member(&elem, &pos, &name, &value), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&name, "m"), is_true);
+    attest(pbjson_elem_equals_string(&value, "[{\"d\":\"a,}\"}]"), is_true);
+    attest(pbjson_get_next_object_member(&elem, &pos, &name, &value), equals(jonmpOK));
+    attest(pbjson_elem_equals_string(&name, "e\\\""), is_true);
+    attest(pbjson_elem_equals_string(&value, "null"), is_true);
+    attest(pbjson_get_next_object_member(&elem, &pos, &name, &value),
+           equals(jonmpKeyNotFound));
+
+    empty.end = empty.start + strlen(empty.start);
+    pos       = empty.start;
+    attest(pbjson_get_next_object_member(&empty, &pos, &name, &value),
+           equals(jonmpKeyNotFound));
+
+    elem.end = elem.start + 10;
+    pos      = elem.start;
+    attest(pbjson_get_next_object_member(&elem, &pos, &name, &value),
+           equals(jonmpValueIncomplete));
+}
+
+
+/* The JSON scanning functions as they were before they looked at
+   many characters at a time, to check that the results are the same.
+ */
+static char const* one_at_a_time_find_end_string(char const* start, char const* end)
+{
+    bool in_escape = false;
+
+    for (; start < end; ++start) {
+        switch (*start) {
+        case '\\':
+            in_escape = !in_escape;
+            break;
+        case '\0':
+            return start;
+        case '"':
+            if (!in_escape) {
+                return start;
+            }
+            /*FALLTHRU*/
+        default:
+            in_escape = false;
+            break;
+        }
+    }
+    return start;
+}
+
+
+static char const* one_at_a_time_find_end_complex(char const* start, char const* end)
+{
+    bool        in_string = false, in_escape = false;
+    int         bracket_level = 0, brace_level = 0;
+    char const* s;
+
+    for (s = start; (s < end) && (*s != '\0'); ++s) {
+        if (!in_string) {
+            switch (*s) {
+            case '{':
+                ++brace_level;
+                break;
+            case '}':
+                if ((--brace_level == 0) && (0 == bracket_level)) {
+                    return s;
+                }
+                break;
+            case '[':
+                ++bracket_level;
+                break;
+            case ']':
+                if ((--bracket_level == 0) && (0 == brace_level)) {
+                    return s;
+                }
+                break;
+            case '"':
+                in_string = true;
+                in_escape = false;
+                break;
+            default:
+                break;
+            }
+        }
+        else if ('\\' == *s) {
+            in_escape = !in_escape;
+        }
+        else {
+            if (('"' == *s) && !in_escape) {
+                in_string = false;
+            }
+            in_escape = false;
+        }
+    }
+    return s;
+}
+
+
+static bool one_at_a_time_split_array(char* buf)
+{
+    bool escaped       = false;
+    bool in_string     = false;
+    int  bracket_level = 0;
+
+    for (; *buf != '\0'; ++buf) {
+        if (escaped) {
+            escaped = false;
+        }
+        else if ('"' == *buf) {
+            in_string = !in_string;
+        }
+        else if (in_string) {
+            escaped = ('\\' == *buf);
+        }
+        else if (('[' == *buf) || ('{' == *buf)) {
+            bracket_level++;
+        }
+        else if ((']' == *buf) || ('}' == *buf)) {
+            bracket_level--;
+        }
+        else if ((',' == *buf) && (0 == bracket_level)) {
+            *buf = '\0';
+        }
+    }
+    return !(escaped || in_string || (bracket_level > 0));
+}
+
+
+Ensure(/*pbjson_parse, */ find_end_across_many_characters)
+{
+    /* Escapes and ends at (and around) 16 and 32 character boundaries */
+    char const* str = "0123456789abcd\\\"\\\\0123456789abcdef\\\"x\\\\\"tail";
+    char const* cpx = "{\"a\":[\"0123456789abcdef]}\\\"\",{\"b\":\"}\"}],"
+                      "\"0123456789abcdef0123456789\":{}}, rest";
+    char const* nul = "[\"0123456789abcdef0123\\\0\"]]";
+
+    attest(pbjson_find_end_string(str, str + strlen(str)), equals(strchr(str, 't') - 1));
+    attest(pbjson_find_end_string(str, str + 14), equals(str + 14));
+    attest(pbjson_find_end_string(str, str + 15), equals(str + 15));
+    attest(pbjson_find_end_string(str, str + 16), equals(str + 16));
+    attest(pbjson_find_end_complex(cpx, cpx + strlen(cpx)),
+           equals(strstr(cpx, ", rest") - 1));
+    attest(pbjson_find_end_complex(cpx, cpx + 40), equals(cpx + 40));
+    attest(pbjson_find_end_complex(nul, nul + 27), equals(nul + 23));
+    attest(pbjson_find_end_string(nul + 2, nul + 27), equals(nul + 23));
+}
+
+
+Ensure(/*pbjson_parse, */ scan_same_as_one_character_at_a_time)
+{
+    static char const alphabet[] = "\"\\{}[],: \0ab\"\\";
+    char              buf[160];
+    char              split[2][sizeof buf];
+    int               i;
+
+    srand(1);
+    for (i = 0; i < 20000; ++i) {
+        int len   = 1 + rand() % (sizeof buf - 2);
+        int start = rand() % len;
+        int end   = start + rand() % (len - start + 1);
+        int j;
+
+        for (j = 0; j < len; ++j) {
+            buf[j] = (rand() % 3) ? alphabet[rand() % (sizeof alphabet - 1)]
+                                  : (char)('a' + rand() % 26);
+        }
+        buf[len] = '\0';
+
+        attest(pbjson_find_end_string(buf + start, buf + end),
+               equals(one_at_a_time_find_end_string(buf + start, buf + end)));
+        attest(pbjson_find_end_complex(buf + start, buf + end),
+               equals(one_at_a_time_find_end_complex(buf + start, buf + end)));
+        memcpy(split[0], buf, len + 1);
+        memcpy(split[1], buf, len + 1);
+        attest(pbcc_split_array(split[0] + start),
+               equals(one_at_a_time_split_array(split[1] + start)));
+        attest(memcmp(split[0], split[1], len + 1), equals(0));
+    }
+}
+
+
 Describe(single_context_pubnub);
 
 static pubnub_t* pbp;
@@ -1231,6 +1487,38 @@ Ensure(single_context_pubnub, publish_http_chunked)
     attest(pubnub_last_publish_result(pbp), streqs("\"Sent\""));
 }
 
+Ensure(single_context_pubnub, http_headers_case_insensitive)
+{
+    pubnub_init(pbp, "publkey", "subkey");
+
+    expect_have_dns_for_pubnub_origin();
+
+    expect_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/%22zec%22?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\nserver: Pubnub\r\ncontent-LENGTH:  "
+             "30 \r\n\r\n[1,\"Sent\",\"14178940800777403\"]",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_publish(pbp, "jarak", "\"zec\""), equals(PNR_OK));
+    attest(pubnub_last_http_code(pbp), equals(200));
+    attest(pubnub_last_publish_result(pbp), streqs("\"Sent\""));
+
+    expect(pbntf_enqueue_for_processing, when(pb, equals(pbp)), returns(0));
+    expect(pbntf_got_socket, when(pb, equals(pbp)), returns(0));
+    expect_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/%22zec%22?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\ntransfer-encoding: gzip, "
+             "Chunked\r\n\r\n12\r\n[1,\"Sent\",\"1417894\r\n0C\r\n0800777403\"]"
+             "\r\n0\r\n",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_publish(pbp, "jarak", "\"zec\""), equals(PNR_OK));
+    attest(pubnub_last_http_code(pbp), equals(200));
+    attest(pubnub_last_publish_result(pbp), streqs("\"Sent\""));
+}
+
 Ensure(single_context_pubnub, http_headers_no_content_length_or_chunked)
 {
     pubnub_init(pbp, "publkey", "subkey");
@@ -1249,6 +1537,23 @@ Ensure(single_context_pubnub, http_headers_no_content_length_or_chunked)
     attest(pubnub_last_publish_result(pbp), streqs(""));
 }
 
+Ensure(single_context_pubnub, http_headers_content_length_overflow)
+{
+    pubnub_init(pbp, "publkey", "subkey");
+
+    expect_have_dns_for_pubnub_origin();
+
+    expect_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/%22zec%22?pnsdk=unit-test-0.1");
+    /* Would wrap around to 2 */
+    incoming("HTTP/1.1 200\r\nContent-Length: 18446744073709551618\r\n\r\n{}",
+             NULL);
+    expect(pbpal_close, when(pb, equals(pbp)), returns(0));
+    expect(pbpal_forget, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_publish(pbp, "jarak", "\"zec\""), equals(PNR_IO_ERROR));
+}
+
 Ensure(single_context_pubnub, publish_failed_invalid_channel)
 {
     pubnub_init(pbp, "publkey", "subkey");
@@ -3353,6 +3658,134 @@ Ensure(single_context_pubnub, subscribe_parse_response_format_error)
            equals(PNR_FORMAT_ERROR));
 }
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+static char m_streamed_msgs[4][64];
+static int  m_streamed_msg_count;
+
+static void streamed_message(pubnub_t* pb, char const* message, void* user_data)
+{
+    attest(pb, equals(pbp));
+    attest(user_data, equals(&m_streamed_msg_count));
+    attest(m_streamed_msg_count, is_less_than(4));
+    strcpy(m_streamed_msgs[m_streamed_msg_count++], message);
+}
+
+Ensure(single_context_pubnub, subscribe_streamed_to_message_callback)
+{
+    pubnub_init(pbp, "publ-stream", "sub-stream");
+    m_streamed_msg_count = 0;
+    attest(pubnub_register_message_callback(pbp, streamed_message, &m_streamed_msg_count),
+           equals(PNR_OK));
+
+    expect_have_dns_for_pubnub_origin();
+    expect_outgoing_with_url("/subscribe/sub-stream/ch1,ch2/0/0?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\nTransfer-Encoding: chunked\r\n\r\n"
+             "d\r\n[[{\"a\":1},\"x,\r\n"
+             "23\r\ny]\"],\"15161497892512345\",\"ch1,ch2\"]\r\n0\r\n",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_subscribe(pbp, "ch1,ch2", NULL), equals(PNR_OK));
+
+    attest(m_streamed_msg_count, equals(2));
+    attest(m_streamed_msgs[0], streqs("{\"a\":1}"));
+    attest(m_streamed_msgs[1], streqs("\"x,y]\""));
+    attest(pubnub_get(pbp), equals(NULL));
+    attest(pubnub_get_channel(pbp), streqs("ch1"));
+    attest(pubnub_get_channel(pbp), streqs("ch2"));
+    attest(pubnub_get_channel(pbp), equals(NULL));
+    attest(pubnub_last_time_token(pbp), streqs("15161497892512345"));
+    attest(pubnub_last_http_code(pbp), equals(200));
+
+    expect(pbntf_enqueue_for_processing, when(pb, equals(pbp)), returns(0));
+    expect(pbntf_got_socket, when(pb, equals(pbp)), returns(0));
+    expect_outgoing_with_url(
+        "/subscribe/sub-stream/ch1/0/15161497892512345?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\nContent-Length: 31\r\n\r\n"
+             "[[1,[2,3]],\"15161497892512346\"]",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_subscribe(pbp, "ch1", NULL), equals(PNR_OK));
+
+    attest(m_streamed_msg_count, equals(4));
+    attest(m_streamed_msgs[2], streqs("1"));
+    attest(m_streamed_msgs[3], streqs("[2,3]"));
+    attest(pubnub_get(pbp), equals(NULL));
+    attest(pubnub_get_channel(pbp), equals(NULL));
+    attest(pubnub_last_time_token(pbp), streqs("15161497892512346"));
+}
+#endif /* PUBNUB_SUBSCRIBE_STREAMING */
+
+#if PUBNUB_PUBLISH_PIPELINE
+/* Request of a pipeline that is sent before the response to the
+   previous one is received, so, we don't start watching for it */
+static inline void expect_pipelined_outgoing_with_url(char const* url)
+{
+    expect(pbpal_send_str, when(s, streqs("GET ")), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str, when(s, streqs(url)), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send, when(data, streqs(" HTTP/1.1\r\nHost: ")), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str, when(s, streqs(PUBNUB_ORIGIN)), returns(0));
+    expect(pbpal_send_status, returns(0));
+    expect(pbpal_send_str,
+           when(s,
+                streqs("\r\nUser-Agent: POSIX-PubNub-C-core/" PUBNUB_SDK_VERSION
+                       "\r\n" ACCEPT_ENCODING "\r\n")),
+           returns(0));
+    expect(pbpal_send_status, returns(0));
+}
+
+Ensure(single_context_pubnub, publish_pipelined)
+{
+    char const* msgs[] = { "1", "\"2\"", "3" };
+
+    pubnub_init(pbp, "publkey", "subkey");
+
+    expect_have_dns_for_pubnub_origin();
+    expect_pipelined_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/1?pnsdk=unit-test-0.1");
+    expect_pipelined_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/%222%22?pnsdk=unit-test-0.1");
+    expect_outgoing_with_url(
+        "/publish/publkey/subkey/0/jarak/0/3?pnsdk=unit-test-0.1");
+    incoming("HTTP/1.1 200\r\nContent-Length: "
+             "30\r\n\r\n[1,\"Sent\",\"14178940800777403\"]",
+             NULL);
+    incoming("HTTP/1.1 200\r\nTransfer-Encoding: "
+             "chunked\r\n\r\n21\r\n[0,\"Invalid\",\"14178940800777404\"]"
+             "\r\n0\r\n\r\n",
+             NULL);
+    incoming("HTTP/1.1 200\r\nContent-Length: "
+             "30\r\n\r\n[1,\"Sent\",\"14178940800777405\"]",
+             NULL);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_publish_pipelined(pbp, "jarak", msgs, 3, pubnubPublishViaGET),
+           equals(PNR_PUBLISH_FAILED));
+    attest(pubnub_last_http_code(pbp), equals(200));
+    attest(pubnub_last_publish_result(pbp), streqs("\"Sent\""));
+    attest(pubnub_publish_pipeline_result(pbp, 0), equals(PNR_OK));
+    attest(pubnub_publish_pipeline_result(pbp, 1), equals(PNR_PUBLISH_FAILED));
+    attest(pubnub_publish_pipeline_result(pbp, 2), equals(PNR_OK));
+    attest(pubnub_publish_pipeline_result(pbp, 3), equals(PNR_INVALID_PARAMETERS));
+}
+
+Ensure(single_context_pubnub, publish_pipelined_invalid_count)
+{
+    char const* msgs[] = { "1" };
+
+    pubnub_init(pbp, "publkey", "subkey");
+    attest(pubnub_publish_pipelined(pbp, "jarak", msgs, 0, pubnubPublishViaGET),
+           equals(PNR_INVALID_PARAMETERS));
+    attest(pubnub_publish_pipelined(
+               pbp, "jarak", msgs, PUBNUB_PUBLISH_PIPELINE_MAX + 1, pubnubPublishViaGET),
+           equals(PNR_INVALID_PARAMETERS));
+}
+#endif /* PUBNUB_PUBLISH_PIPELINE */
+
 Ensure(single_context_pubnub, subscribe_reestablishing_broken_keep_alive_conection)
 {
     pubnub_init(pbp, "publ-key", "sub-Key");
@@ -4844,6 +5277,24 @@ Ensure(single_context_pubnub, gzip_bad_compression_format)
            equals(PNR_BAD_COMPRESSION_FORMAT));
     gzip_body[sizeof gzip_body - 4]--;
 
+    /* Changing 'crc32'(checksum of decompressed block) value byte */
+    expect(pbntf_enqueue_for_processing, when(pb, equals(pbp)), returns(0));
+    expect(pbntf_got_socket, when(pb, equals(pbp)), returns(0));
+    expect_outgoing_with_url("/subscribe/looking-glass/island/0/"
+                             "1516014978925123457?pnsdk=unit-test-0.1");
+    gzip_body[sizeof gzip_body - 8]++;
+    body_block.size = sizeof gzip_body;
+    incoming("HTTP/1.1 200\r\n"
+             "Content-Length: 63\r\n"
+             "Content-Encoding: gzip\r\n"
+             "\r\n",
+             &body_block);
+    expect(pbntf_lost_socket, when(pb, equals(pbp)));
+    expect(pbntf_trans_outcome, when(pb, equals(pbp)));
+    attest(pubnub_subscribe(pbp, "island", NULL),
+           equals(PNR_BAD_COMPRESSION_FORMAT));
+    gzip_body[sizeof gzip_body - 8]--;
+
     /* Contaminated content */
     expect(pbntf_enqueue_for_processing, when(pb, equals(pbp)), returns(0));
     expect(pbntf_got_socket, when(pb, equals(pbp)), returns(0));
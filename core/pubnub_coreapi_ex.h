@@ -88,6 +88,51 @@ enum pubnub_res pubnub_publish_ex(pubnub_t*                     p,
                                   struct pubnub_publish_options opts);
 
 
+/** Options for compressing the messages published via POST with GZIP
+    (`pubnubPublishViaPOSTwithGZIP`). Available if the library is
+    built with `PUBNUB_USE_GZIP_COMPRESSION`.
+ */
+struct pubnub_gzip_options {
+    /** The compression level, from 0 (fastest, but compresses the
+        least) to 10 (slowest, but compresses the most).
+     */
+    int level;
+    /** Messages of this length, or shorter, are not compressed, but
+        sent as they are. Small messages usually don't compress well,
+        so this saves the time spent compressing them.
+     */
+    size_t min_size;
+    /** If compressing doesn't make a message shorter by at least this
+        many percent, it is sent as it is (uncompressed).
+     */
+    unsigned min_saving;
+};
+
+/** This returns the default options for compressing published
+    messages. Will set `level = 6`, `min_size = 0` and `min_saving =
+    10`.
+ */
+struct pubnub_gzip_options pubnub_gzip_defopts(void);
+
+/** Sets the options for compressing the messages published via POST
+    with GZIP on the context @p p.
+
+    Basic usage:
+
+        struct pubnub_gzip_options opt = pubnub_gzip_defopts();
+        opt.level = 1;
+        opt.min_size = 256;
+        pubnub_set_gzip_options(pn, opt);
+
+    @pre Call this after pubnub_init() on the context
+    @param p The Pubnub context. Can't be NULL.
+    @param opts Compression options
+    @retval 0 OK
+    @retval -1 invalid options (level out of range)
+ */
+int pubnub_set_gzip_options(pubnub_t* p, struct pubnub_gzip_options opts);
+
+
 /** Options for "extended" subscribe. */
 struct pubnub_subscribe_options {
     /** Channel group (a comma-delimited list of channel group names).
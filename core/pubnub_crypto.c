@@ -57,16 +57,17 @@ int pbcrypto_signature(struct pbcc_context *pbcc, char const *channel, char cons
 
 static int cipher_hash(char const* cipher_key, uint8_t hash[33])
 {
+    static char const hex[] = "0123456789abcdef";
     uint8_t digest[32];
-    pbsha256_digest_str(cipher_key, digest);
+    int i;
 
-    snprintf((char*)hash, 33, 
-             "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-             digest[0], digest[1], digest[2], digest[3],
-             digest[4], digest[5], digest[6], digest[7],
-             digest[8], digest[9], digest[10], digest[11],
-             digest[12], digest[13], digest[14], digest[15]
-        );
+    pbsha256_digest_str(cipher_key, digest);
+    /* Only the first half of the digest is used, in hex */
+    for (i = 0; i < 16; ++i) {
+        hash[2*i] = hex[digest[i] >> 4];
+        hash[2*i + 1] = hex[digest[i] & 0x0F];
+    }
+    hash[32] = '\0';
 
     return 0;
 }
@@ -165,6 +166,68 @@ pubnub_bymebl_t pubnub_decrypt_alloc(char const *cipher_key, char const *base64_
 }
 
 
+void pubnub_crypto_key_init(pubnub_crypto_key_t* key, char const* cipher_key)
+{
+    PUBNUB_ASSERT_OPT(key != NULL);
+    PUBNUB_ASSERT_OPT(cipher_key != NULL);
+
+    cipher_hash(cipher_key, key->derived);
+    key->encrypt_ctx = NULL;
+    key->decrypt_ctx = NULL;
+}
+
+
+void pubnub_crypto_key_deinit(pubnub_crypto_key_t* key)
+{
+    PUBNUB_ASSERT_OPT(key != NULL);
+
+    pbaes256_context_free(key->encrypt_ctx);
+    pbaes256_context_free(key->decrypt_ctx);
+    key->encrypt_ctx = NULL;
+    key->decrypt_ctx = NULL;
+}
+
+
+int pubnub_encrypt_prepared(pubnub_crypto_key_t* key, pubnub_bymebl_t msg, char* base64_str, size_t* n, pubnub_bymebl_t buffer)
+{
+    uint8_t const iv[] = "0123456789012345";
+
+    PUBNUB_ASSERT_OPT(key != NULL);
+
+    if (NULL == key->encrypt_ctx) {
+        key->encrypt_ctx = pbaes256_context_new_encrypt(key->derived);
+        if (NULL == key->encrypt_ctx) {
+            return -1;
+        }
+    }
+    if (-1 == pbaes256_encrypt_with(key->encrypt_ctx, msg, iv, &buffer)) {
+        return -1;
+    }
+    return pbbase64_encode_std(buffer, base64_str, n);
+}
+
+
+int pubnub_decrypt_prepared(pubnub_crypto_key_t* key, char const* base64_str, pubnub_bymebl_t* data, pubnub_bymebl_t* buffer)
+{
+    uint8_t const iv[] = "0123456789012345";
+
+    PUBNUB_ASSERT_OPT(key != NULL);
+
+    if (NULL == key->decrypt_ctx) {
+        key->decrypt_ctx = pbaes256_context_new_decrypt(key->derived);
+        if (NULL == key->decrypt_ctx) {
+            return -1;
+        }
+    }
+    if (0 != pbbase64_decode_std_str(base64_str, buffer)) {
+        return -1;
+    }
+    buffer->ptr[buffer->size] = '\0';
+
+    return pbaes256_decrypt_with(key->decrypt_ctx, *buffer, iv, data);
+}
+
+
 char *pubnub_json_string_unescape_slash(char *json_string)
 {
     char *s = json_string;
@@ -271,6 +334,78 @@ pubnub_bymebl_t pubnub_get_decrypted_alloc(pubnub_t *pb, char const* cipher_key)
 }
 
 
+enum pubnub_res pubnub_get_decrypted_all(pubnub_t* pb, pubnub_crypto_key_t* key, pubnub_bymebl_t arena, pubnub_bymebl_t* msgs, size_t* n)
+{
+    uint8_t decoded_msg[PUBNUB_BUF_MAXLEN];
+    size_t used = 0;
+    size_t i;
+    enum pubnub_res rslt = PNR_OK;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT(key != NULL);
+    PUBNUB_ASSERT_OPT(arena.ptr != NULL);
+    PUBNUB_ASSERT_OPT(msgs != NULL);
+    PUBNUB_ASSERT_OPT(n != NULL);
+
+    pubnub_mutex_lock(pb->monitor);
+    for (i = 0; ; ++i) {
+        unsigned const msg_ofs = pb->core.msg_ofs;
+        char *msg = (char*)pbcc_get_msg(&pb->core);
+        size_t msg_len;
+        size_t needed;
+        pubnub_bymebl_t data;
+        /* Leave room for the NUL that decoding puts at the end */
+        pubnub_bymebl_t buffer = { decoded_msg, sizeof decoded_msg - 1 };
+
+        if (NULL == msg) {
+            break;
+        }
+        if (i == *n) {
+            pb->core.msg_ofs = msg_ofs;
+            rslt = PNR_RX_BUFF_NOT_EMPTY;
+            break;
+        }
+        msgs[i].ptr = NULL;
+        msgs[i].size = 0;
+        msg_len = strlen(msg);
+        if ((msg_len < 2) || (msg[0] != '"') || (msg[msg_len-1] != '"')) {
+            continue;
+        }
+        /* Decrypting needs room for the decoded message, an AES block
+           and the NUL. Check before changing the message, so that it
+           can be left for the next call. If it wouldn't fit even in an
+           empty arena, it can't be decrypted in this arena at all, so
+           it's consumed, as if decrypting failed.
+         */
+        needed = pbbase64_decoded_length(msg_len) + 16 + 1;
+        if (arena.size < needed) {
+            continue;
+        }
+        if (arena.size - used < needed) {
+            pb->core.msg_ofs = msg_ofs;
+            rslt = PNR_RX_BUFF_NOT_EMPTY;
+            break;
+        }
+        msg[msg_len - 1] = '\0';
+        ++msg;
+
+        pubnub_json_string_unescape_slash(msg);
+
+        data.ptr = arena.ptr + used;
+        data.size = arena.size - used;
+        if (0 == pubnub_decrypt_prepared(key, msg, &data, &buffer)) {
+            data.ptr[data.size] = '\0';
+            msgs[i] = data;
+            used += data.size + 1;
+        }
+    }
+    pubnub_mutex_unlock(pb->monitor);
+    *n = i;
+
+    return rslt;
+}
+
+
 enum pubnub_res pubnub_publish_encrypted(pubnub_t *p, char const* channel, char const* message, char const* cipher_key)
 {
     struct pubnub_publish_options opts =  pubnub_publish_defopts();
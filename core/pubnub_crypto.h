@@ -92,6 +92,71 @@ int pubnub_decrypt_buffered(char const *cipher_key, char const *base64_str, pubn
 pubnub_bymebl_t pubnub_decrypt_alloc(char const *cipher_key, char const *base64_str);
 
 
+/** A prepared cipher key. Holds the AES-256 key derived from a
+    cipher key and the AES-256 contexts keyed with it, so that
+    encrypting/decrypting many messages with the same cipher key
+    doesn't derive the key, expand it and allocate a context for
+    every message, as pubnub_encrypt() and pubnub_decrypt() do.
+
+    Use pubnub_crypto_key_init() to prepare it, and
+    pubnub_crypto_key_deinit() when done with it. Don't look inside.
+
+    A prepared key is not thread-safe. If you encrypt or decrypt in
+    several threads, prepare a key for each of them.
+*/
+struct pbaes256_context;
+typedef struct pubnub_crypto_key {
+    /** The AES-256 key derived from the cipher key */
+    uint8_t derived[33];
+    /** The context for encrypting, created on first use */
+    struct pbaes256_context* encrypt_ctx;
+    /** The context for decrypting, created on first use */
+    struct pbaes256_context* decrypt_ctx;
+} pubnub_crypto_key_t;
+
+/** Prepares the @p key for encrypting and decrypting with the
+    cipher key @p cipher_key, which is not used afterwards.
+
+    @pre key != NULL
+    @pre cipher_key != NULL
+*/
+void pubnub_crypto_key_init(pubnub_crypto_key_t* key, char const* cipher_key);
+
+/** Releases the resources of the prepared @p key. To use it again,
+    it has to be prepared with pubnub_crypto_key_init().
+*/
+void pubnub_crypto_key_deinit(pubnub_crypto_key_t* key);
+
+/** Similar to pubnub_encrypt_buffered(), but uses the prepared @p
+    key, and doesn't allocate memory (after the first call).
+
+    @param key The prepared key to encrypt with
+    @param msg The memory block (pointer and size) of the data to encrypt
+    @param base64_str String (allocated by the user) to write encrypted and
+    base64 encoded string
+    @param n On input, the size of @p base64_str, on output the number
+    of characters written to it
+    @param buffer The "working memory", has to be at least 16 octets
+    bigger than @p msg
+    @return 0: OK, -1: error
+*/
+int pubnub_encrypt_prepared(pubnub_crypto_key_t* key, pubnub_bymebl_t msg, char* base64_str, size_t* n, pubnub_bymebl_t buffer);
+
+/** Similar to pubnub_decrypt_buffered(), but uses the prepared @p
+    key, and doesn't allocate memory (after the first call).
+
+    @param key The prepared key to decrypt with
+    @param base64_str String to Base64 decode and decrypt
+    @param data User allocated memory block to write the decrypted
+    contents to. On input, its size is the size of the block, on
+    output, the number of octets written.
+    @param buffer The "working memory", for the Base64 decoded string.
+    Has to be bigger than its decoded length, as a `NUL` is put after it.
+    @return 0: OK, -1: error
+*/
+int pubnub_decrypt_prepared(pubnub_crypto_key_t* key, char const* base64_str, pubnub_bymebl_t* data, pubnub_bymebl_t* buffer);
+
+
 /** Decrypts the next message in the context @p p using the key
     @p cipher_key, puting the decrypted contents to user-allocated
     @p s having size @p n.
@@ -131,6 +196,48 @@ enum pubnub_res pubnub_get_decrypted(pubnub_t *pb, char const* cipher_key, char
 */
 pubnub_bymebl_t pubnub_get_decrypted_alloc(pubnub_t *pb, char const* cipher_key);
 
+/** Decrypts all the (remaining) messages in the context @p pb with
+    the prepared @p key, in one call. This is much faster than calling
+    pubnub_get_decrypted() for each message of a big response (like
+    when catching up after a long disconnect), as the key schedule and
+    cipher context are reused and the context is locked only once.
+
+    Decrypted messages are written one after another to the
+    user-allocated @p arena, each terminated by a NUL, and for each
+    message, its memory block (pointer into @p arena and size, without
+    the NUL) is written to @p msgs. If a message is not a JSON string,
+    or there is an error in Base64 decoding or decrypting it, its
+    memory block is `{NULL, 0}` and the rest of the messages are still
+    decrypted.
+
+    If there are more messages than fit in @p msgs or @p arena, the
+    ones that didn't fit are not consumed, so you can get them with
+    another call, after you're done with the ones in @p arena. A
+    message that is too big to fit even in an empty @p arena (its
+    Base64 decoded length plus 17 octets) is consumed, with its memory
+    block `{NULL, 0}`, as if decrypting it failed - get it with
+    pubnub_get_decrypted() or pubnub_get_decrypted_alloc() before this
+    if you need such messages.
+
+    Messages are decrypted independently of each other, so if you
+    want to spread the work of a huge response over several threads,
+    pubnub_get() the messages and pubnub_decrypt_prepared() them in
+    your threads, with a prepared key for each thread.
+
+    @param pb The context to get the messages from
+    @param key The prepared key to decrypt with
+    @param arena User allocated memory block to write the decrypted
+    messages to
+    @param msgs User allocated array of memory blocks of the decrypted
+    messages
+    @param n On input, the number of elements of @p msgs, on output,
+    the number of messages decrypted (or failed to decrypt)
+    @retval PNR_OK all messages were decrypted
+    @retval PNR_RX_BUFF_NOT_EMPTY some messages didn't fit and are left
+    in @p pb
+*/
+enum pubnub_res pubnub_get_decrypted_all(pubnub_t* pb, pubnub_crypto_key_t* key, pubnub_bymebl_t arena, pubnub_bymebl_t* msgs, size_t* n);
+
 /** Publishes the @p message on @p channel in the context @p p
     encrypted with the key @p cipher_key
 
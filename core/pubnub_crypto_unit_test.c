@@ -0,0 +1,585 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_crypto.h"
+
+#include "pubnub_pubsubapi.h"
+#include "pubnub_coreapi_ex.h"
+#include "pubnub_assert.h"
+#include "pbaes256.h"
+#include "lib/base64/pbbase64.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+#define streqs is_equal_to_string
+
+
+#define CIPHER_KEY "enigma"
+#define MAX_MSGS 10
+#define MAX_PLAIN 2000
+#define AES_BLOCK 16
+
+static pubnub_t m_pb;
+/* The messages "received" in the context, as JSON */
+static char     m_msgs[MAX_MSGS][PUBNUB_BUF_MAXLEN];
+static unsigned m_msg_count;
+/* A plain message, encrypted and Base64 encoded */
+static uint8_t  m_plain[MAX_PLAIN + 1];
+static uint8_t  m_encrypted[MAX_PLAIN + AES_BLOCK];
+static char     m_base64[2 * MAX_PLAIN + 1];
+static char     m_base64_ref[2 * MAX_PLAIN + 1];
+static uint8_t  m_decrypted[MAX_PLAIN + 2 * AES_BLOCK + 1];
+
+
+/* Functions of the Pubnub API the crypto module uses */
+
+char const* pbcc_get_msg(struct pbcc_context* pb)
+{
+    if (pb->msg_ofs >= m_msg_count) {
+        return NULL;
+    }
+    return m_msgs[pb->msg_ofs++];
+}
+
+
+char const* pubnub_get(pubnub_t* pb)
+{
+    return pbcc_get_msg(&pb->core);
+}
+
+
+struct pubnub_publish_options pubnub_publish_defopts(void)
+{
+    struct pubnub_publish_options rslt;
+    memset(&rslt, 0, sizeof rslt);
+    return rslt;
+}
+
+
+enum pubnub_res pubnub_publish_ex(pubnub_t*                     p,
+                                  const char*                   channel,
+                                  const char*                   message,
+                                  struct pubnub_publish_options opts)
+{
+    PUBNUB_UNUSED(p);
+    PUBNUB_UNUSED(channel);
+    PUBNUB_UNUSED(message);
+    PUBNUB_UNUSED(opts);
+    return PNR_INTERNAL_ERROR;
+}
+
+
+/* Adds the (JSON) message, as it would be received */
+static void add_json(char const* json)
+{
+    attest(m_msg_count, is_less_than(MAX_MSGS));
+    strcpy(m_msgs[m_msg_count++], json);
+}
+
+
+/* Adds the @p plain message encrypted, as it would be received, in a
+   JSON string, with slashes escaped */
+static void add_encrypted(char const* plain)
+{
+    pubnub_bymebl_t msg = { (uint8_t*)plain, strlen(plain) };
+    char            base64[PUBNUB_BUF_MAXLEN];
+    size_t          n = sizeof base64;
+    char*           json;
+    char const*     s;
+
+    attest(pubnub_encrypt(CIPHER_KEY, msg, base64, &n), equals(0));
+    base64[n] = '\0';
+    attest(m_msg_count, is_less_than(MAX_MSGS));
+    json    = m_msgs[m_msg_count++];
+    *json++ = '"';
+    for (s = base64; *s != '\0'; ++s) {
+        if ('/' == *s) {
+            *json++ = '\\';
+        }
+        *json++ = *s;
+    }
+    *json++ = '"';
+    *json   = '\0';
+}
+
+
+/* Makes "received" messages to be gotten from the start again */
+static void rewind_msgs(char saved[MAX_MSGS][PUBNUB_BUF_MAXLEN])
+{
+    memcpy(m_msgs, saved, sizeof m_msgs);
+    m_pb.core.msg_ofs = 0;
+}
+
+
+/* Makes a plain message of @p len octets, which are not all
+   printable, in #m_plain */
+static pubnub_bymebl_t make_plain(size_t len)
+{
+    pubnub_bymebl_t rslt = { m_plain, len };
+    size_t          i;
+
+    for (i = 0; i < len; ++i) {
+        m_plain[i] = (uint8_t)(i * 7 + len);
+    }
+    return rslt;
+}
+
+
+static void check_msg(pubnub_bymebl_t msg, char const* plain)
+{
+    if (NULL == plain) {
+        attest(msg.ptr, equals(NULL));
+        attest(msg.size, equals(0));
+    }
+    else {
+        attest(msg.ptr, differs(NULL));
+        attest(msg.size, equals(strlen(plain)));
+        attest((char const*)msg.ptr, streqs(plain));
+    }
+}
+
+
+Describe(pubnub_crypto);
+
+
+BeforeEach(pubnub_crypto) {
+    memset(&m_pb, 0, sizeof m_pb);
+    m_msg_count = 0;
+}
+
+
+AfterEach(pubnub_crypto) {
+}
+
+
+Ensure(pubnub_crypto, get_decrypted_all_decrypts_all_messages) {
+    pubnub_crypto_key_t key;
+    uint8_t             arena[1024];
+    pubnub_bymebl_t     blk = { arena, sizeof arena };
+    pubnub_bymebl_t     msgs[MAX_MSGS];
+    size_t              n = MAX_MSGS;
+
+    add_encrypted("\"Hello world\"");
+    add_encrypted("");
+    add_encrypted("{\"text\":\"a somewhat longer message, over 3 AES blocks\"}");
+    add_encrypted("0123456789abcdef");
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(4));
+    check_msg(msgs[0], "\"Hello world\"");
+    check_msg(msgs[1], "");
+    check_msg(msgs[2], "{\"text\":\"a somewhat longer message, over 3 AES blocks\"}");
+    check_msg(msgs[3], "0123456789abcdef");
+    attest(pubnub_get(&m_pb), equals(NULL));
+
+    n = MAX_MSGS;
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(0));
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, get_decrypted_all_skips_messages_it_cant_decrypt) {
+    pubnub_crypto_key_t key;
+    uint8_t             arena[1024];
+    pubnub_bymebl_t     blk = { arena, sizeof arena };
+    pubnub_bymebl_t     msgs[MAX_MSGS];
+    size_t              n = MAX_MSGS;
+
+    add_encrypted("\"first\"");
+    add_json("{\"not\":\"a string\"}");
+    add_json("42");
+    add_json("\"\"");
+    add_json("\"!!not base64!!\"");
+    add_json("\"AAAA\"");
+    add_encrypted("\"last\"");
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(7));
+    check_msg(msgs[0], "\"first\"");
+    check_msg(msgs[1], NULL);
+    check_msg(msgs[2], NULL);
+    check_msg(msgs[3], NULL);
+    check_msg(msgs[4], NULL);
+    check_msg(msgs[5], NULL);
+    check_msg(msgs[6], "\"last\"");
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, get_decrypted_all_resumes_when_arena_is_full) {
+    pubnub_crypto_key_t key;
+    uint8_t             arena[60];
+    pubnub_bymebl_t     blk = { arena, sizeof arena };
+    pubnub_bymebl_t     msgs[MAX_MSGS];
+    size_t              n = MAX_MSGS;
+
+    /* Each needs 37 octets of the arena ((26 * 3 + 3) / 4 + 16 + 1)
+       to be decrypted, and takes 14 */
+    add_encrypted("\"message one\"");
+    add_encrypted("\"message two\"");
+    add_encrypted("\"message six\"");
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_RX_BUFF_NOT_EMPTY));
+    attest(n, equals(2));
+    check_msg(msgs[0], "\"message one\"");
+    check_msg(msgs[1], "\"message two\"");
+
+    n = MAX_MSGS;
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(1));
+    check_msg(msgs[0], "\"message six\"");
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, get_decrypted_all_resumes_when_msgs_are_full) {
+    pubnub_crypto_key_t key;
+    uint8_t             arena[1024];
+    pubnub_bymebl_t     blk = { arena, sizeof arena };
+    pubnub_bymebl_t     msgs[2];
+    size_t              n = 2;
+
+    add_encrypted("\"1\"");
+    add_json("1");
+    add_encrypted("\"3\"");
+    add_encrypted("\"4\"");
+    add_encrypted("\"5\"");
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_RX_BUFF_NOT_EMPTY));
+    attest(n, equals(2));
+    check_msg(msgs[0], "\"1\"");
+    check_msg(msgs[1], NULL);
+
+    n = 2;
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_RX_BUFF_NOT_EMPTY));
+    attest(n, equals(2));
+    check_msg(msgs[0], "\"3\"");
+    check_msg(msgs[1], "\"4\"");
+
+    n = 2;
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(1));
+    check_msg(msgs[0], "\"5\"");
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, get_decrypted_all_consumes_message_too_big_for_arena) {
+    pubnub_crypto_key_t key;
+    uint8_t             arena[64];
+    pubnub_bymebl_t     blk = { arena, sizeof arena };
+    pubnub_bymebl_t     msgs[MAX_MSGS];
+    size_t              n = MAX_MSGS;
+
+    add_encrypted("\"small\"");
+    add_encrypted("\"a message that is too big to fit in the arena, even if "
+                  "it is empty\"");
+    add_encrypted("\"small again\"");
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(3));
+    check_msg(msgs[0], "\"small\"");
+    check_msg(msgs[1], NULL);
+    check_msg(msgs[2], "\"small again\"");
+
+    /* The same, when it's the first one, so nothing else is in the
+       arena */
+    m_msg_count       = 0;
+    m_pb.core.msg_ofs = 0;
+    add_encrypted("\"another message that is too big for the arena, even if "
+                  "it is empty\"");
+    add_encrypted("\"small\"");
+    n = MAX_MSGS;
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(2));
+    check_msg(msgs[0], NULL);
+    check_msg(msgs[1], "\"small\"");
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, get_decrypted_all_same_as_get_decrypted) {
+    static char         saved[MAX_MSGS][PUBNUB_BUF_MAXLEN];
+    static char const*  plain[] = { "\"a\"",
+                                    "[1,2,3]",
+                                    "{\"key\":\"value/with/slashes\"}",
+                                    "\"0123456789abcdef0123456789abcdef\"",
+                                    "true" };
+    pubnub_crypto_key_t key;
+    uint8_t             arena[1024];
+    pubnub_bymebl_t     blk = { arena, sizeof arena };
+    pubnub_bymebl_t     msgs[MAX_MSGS];
+    size_t              n = MAX_MSGS;
+    size_t              i;
+
+    for (i = 0; i < sizeof plain / sizeof plain[0]; ++i) {
+        add_encrypted(plain[i]);
+    }
+    memcpy(saved, m_msgs, sizeof saved);
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_get_decrypted_all(&m_pb, &key, blk, msgs, &n), equals(PNR_OK));
+    attest(n, equals(sizeof plain / sizeof plain[0]));
+    pubnub_crypto_key_deinit(&key);
+
+    rewind_msgs(saved);
+    for (i = 0; i < n; ++i) {
+        char   s[PUBNUB_BUF_MAXLEN];
+        size_t len = sizeof s;
+
+        attest(pubnub_get_decrypted(&m_pb, CIPHER_KEY, s, &len), equals(PNR_OK));
+        attest(len, equals(msgs[i].size));
+        attest(memcmp(s, msgs[i].ptr, len), equals(0));
+        attest(s, streqs(plain[i]));
+    }
+}
+
+
+Ensure(pubnub_crypto, key_is_derived_from_cipher_key) {
+    pubnub_crypto_key_t key;
+
+    /* The first half of SHA-256("enigma"), in hex */
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest((char const*)key.derived, streqs("67a4f45f0d1d9bc606486fc42dc49416"));
+    attest(key.encrypt_ctx, equals(NULL));
+    attest(key.decrypt_ctx, equals(NULL));
+    pubnub_crypto_key_deinit(&key);
+
+    pubnub_crypto_key_init(&key, "");
+    attest((char const*)key.derived, streqs("e3b0c44298fc1c149afbf4c8996fb924"));
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, encrypts_known_message) {
+    char const*         plain = "\"Pubnub Messaging API 1\"";
+    char const*         expected = "f42pIQcWZ9zbTbH8cyLwByD/GsviOE0vcREIEVPARR0=";
+    pubnub_bymebl_t     msg = { (uint8_t*)plain, strlen(plain) };
+    pubnub_bymebl_t     buffer = { m_encrypted, sizeof m_encrypted };
+    pubnub_bymebl_t     data = { m_decrypted, sizeof m_decrypted };
+    pubnub_bymebl_t     decoded = { m_plain, sizeof m_plain };
+    pubnub_crypto_key_t key;
+    size_t              n = sizeof m_base64;
+
+    attest(pubnub_encrypt(CIPHER_KEY, msg, m_base64, &n), equals(0));
+    attest(m_base64, streqs(expected));
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    n = sizeof m_base64;
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(0));
+    attest(n, equals(strlen(expected)));
+    attest(m_base64, streqs(expected));
+    attest(pubnub_decrypt_prepared(&key, expected, &data, &decoded), equals(0));
+    attest(data.size, equals(msg.size));
+    attest(memcmp(data.ptr, plain, data.size), equals(0));
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, prepared_same_as_unprepared_for_all_lengths) {
+    pubnub_crypto_key_t key;
+    size_t              len;
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    for (len = 0; len <= MAX_PLAIN; ++len) {
+        pubnub_bymebl_t msg = make_plain(len);
+        pubnub_bymebl_t buffer = { m_encrypted, sizeof m_encrypted };
+        pubnub_bymebl_t data = { m_decrypted, sizeof m_decrypted };
+        uint8_t         decoded_msg[MAX_PLAIN + AES_BLOCK + 1];
+        pubnub_bymebl_t decoded = { decoded_msg, sizeof decoded_msg };
+        size_t          n = sizeof m_base64;
+        size_t          n_ref = sizeof m_base64_ref;
+
+        attest(pubnub_encrypt(CIPHER_KEY, msg, m_base64_ref, &n_ref), equals(0));
+        attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(0));
+        attest(n, equals(n_ref));
+        attest(m_base64, streqs(m_base64_ref));
+
+        attest(pubnub_decrypt_prepared(&key, m_base64, &data, &decoded), equals(0));
+        attest(data.size, equals(len));
+        attest(memcmp(data.ptr, m_plain, len), equals(0));
+
+        data.size = sizeof m_decrypted;
+        attest(pubnub_decrypt(CIPHER_KEY, m_base64, &data), equals(0));
+        attest(data.size, equals(len));
+        attest(memcmp(data.ptr, m_plain, len), equals(0));
+    }
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, aes256_context_is_reused_for_many_messages) {
+    uint8_t                  key[33];
+    pubnub_crypto_key_t      prepared;
+    struct pbaes256_context* enc;
+    struct pbaes256_context* dec;
+    unsigned                 i;
+
+    pubnub_crypto_key_init(&prepared, CIPHER_KEY);
+    memcpy(key, prepared.derived, sizeof key);
+    pubnub_crypto_key_deinit(&prepared);
+    enc = pbaes256_context_new_encrypt(key);
+    attest(enc, differs(NULL));
+    dec = pbaes256_context_new_decrypt(key);
+    attest(dec, differs(NULL));
+
+    /* Different messages, and IVs, interleaving encrypting and
+       decrypting */
+    for (i = 0; i < 300; ++i) {
+        uint8_t         iv[AES_BLOCK + 1];
+        pubnub_bymebl_t msg = make_plain((i * 37) % (MAX_PLAIN + 1));
+        pubnub_bymebl_t encrypted = { m_encrypted, sizeof m_encrypted };
+        pubnub_bymebl_t decrypted = { m_decrypted, sizeof m_decrypted };
+        pubnub_bymebl_t ref;
+
+        snprintf((char*)iv, sizeof iv, "%016u", i);
+        attest(pbaes256_encrypt_with(enc, msg, iv, &encrypted), equals(0));
+        attest(encrypted.size, equals((msg.size / AES_BLOCK + 1) * AES_BLOCK));
+        ref = pbaes256_encrypt_alloc(msg, key, iv);
+        attest(ref.ptr, differs(NULL));
+        attest(encrypted.size, equals(ref.size));
+        attest(memcmp(encrypted.ptr, ref.ptr, ref.size), equals(0));
+        free(ref.ptr);
+
+        attest(pbaes256_decrypt_with(dec, encrypted, iv, &decrypted), equals(0));
+        attest(decrypted.size, equals(msg.size));
+        attest(memcmp(decrypted.ptr, msg.ptr, msg.size), equals(0));
+    }
+
+    pbaes256_context_free(enc);
+    pbaes256_context_free(dec);
+    pbaes256_context_free(NULL);
+}
+
+
+Ensure(pubnub_crypto, aes256_context_checks_buffer_sizes) {
+    uint8_t const            iv[] = "0123456789012345";
+    uint8_t                  key[33];
+    pubnub_crypto_key_t      prepared;
+    struct pbaes256_context* enc;
+    struct pbaes256_context* dec;
+    pubnub_bymebl_t          msg = make_plain(40);
+    pubnub_bymebl_t          encrypted = { m_encrypted, msg.size + AES_BLOCK - 1 };
+    pubnub_bymebl_t          decrypted;
+
+    pubnub_crypto_key_init(&prepared, CIPHER_KEY);
+    memcpy(key, prepared.derived, sizeof key);
+    pubnub_crypto_key_deinit(&prepared);
+    enc = pbaes256_context_new_encrypt(key);
+    dec = pbaes256_context_new_decrypt(key);
+
+    attest(pbaes256_encrypt_with(enc, msg, iv, &encrypted), equals(-1));
+    encrypted.size = msg.size + AES_BLOCK;
+    attest(pbaes256_encrypt_with(enc, msg, iv, &encrypted), equals(0));
+    attest(encrypted.size, equals(48));
+
+    decrypted.ptr  = m_decrypted;
+    decrypted.size = encrypted.size + AES_BLOCK;
+    attest(pbaes256_decrypt_with(dec, encrypted, iv, &decrypted), equals(-1));
+    decrypted.size = encrypted.size + AES_BLOCK + 1;
+    attest(pbaes256_decrypt_with(dec, encrypted, iv, &decrypted), equals(0));
+    attest(decrypted.size, equals(msg.size));
+    attest(memcmp(decrypted.ptr, msg.ptr, msg.size), equals(0));
+
+    pbaes256_context_free(enc);
+    pbaes256_context_free(dec);
+}
+
+
+Ensure(pubnub_crypto, prepared_checks_buffer_sizes) {
+    pubnub_crypto_key_t key;
+    pubnub_bymebl_t     msg = make_plain(40);
+    /* 48 octets encrypted, 64 characters in Base64 */
+    pubnub_bymebl_t     buffer = { m_encrypted, msg.size + AES_BLOCK - 1 };
+    size_t              n = sizeof m_base64;
+    pubnub_bymebl_t     data;
+    uint8_t             decoded_msg[64];
+    pubnub_bymebl_t     decoded;
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(-1));
+    buffer.size = msg.size + AES_BLOCK;
+    n = 64;
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(-1));
+    n = 65;
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(0));
+    attest(n, equals(64));
+
+    data.ptr     = m_decrypted;
+    data.size    = sizeof m_decrypted;
+    decoded.ptr  = decoded_msg;
+    decoded.size = 47;
+    attest(pubnub_decrypt_prepared(&key, m_base64, &data, &decoded), equals(-1));
+    decoded.size = sizeof decoded_msg;
+    data.size    = 48 + AES_BLOCK;
+    attest(pubnub_decrypt_prepared(&key, m_base64, &data, &decoded), equals(-1));
+    decoded.size = sizeof decoded_msg;
+    data.size    = 48 + AES_BLOCK + 1;
+    attest(pubnub_decrypt_prepared(&key, m_base64, &data, &decoded), equals(0));
+    attest(data.size, equals(msg.size));
+    attest(memcmp(data.ptr, msg.ptr, msg.size), equals(0));
+
+    /* Not Base64 */
+    decoded.size = sizeof decoded_msg;
+    data.size    = sizeof m_decrypted;
+    attest(pubnub_decrypt_prepared(&key, "!!not base64!!", &data, &decoded), equals(-1));
+    pubnub_crypto_key_deinit(&key);
+}
+
+
+Ensure(pubnub_crypto, prepared_key_can_be_prepared_again) {
+    pubnub_crypto_key_t key;
+    pubnub_bymebl_t     msg = make_plain(100);
+    pubnub_bymebl_t     buffer = { m_encrypted, sizeof m_encrypted };
+    pubnub_bymebl_t     data = { m_decrypted, sizeof m_decrypted };
+    uint8_t             decoded_msg[256];
+    pubnub_bymebl_t     decoded = { decoded_msg, sizeof decoded_msg };
+    size_t              n = sizeof m_base64;
+    size_t              n_ref = sizeof m_base64_ref;
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(0));
+    attest(pubnub_decrypt_prepared(&key, m_base64, &data, &decoded), equals(0));
+    attest(key.encrypt_ctx, differs(NULL));
+    attest(key.decrypt_ctx, differs(NULL));
+    pubnub_crypto_key_deinit(&key);
+    attest(key.encrypt_ctx, equals(NULL));
+    attest(key.decrypt_ctx, equals(NULL));
+    /* Deinit again is harmless */
+    pubnub_crypto_key_deinit(&key);
+
+    pubnub_crypto_key_init(&key, "another key");
+    n = sizeof m_base64;
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(0));
+    attest(pubnub_encrypt("another key", msg, m_base64_ref, &n_ref), equals(0));
+    attest(m_base64, streqs(m_base64_ref));
+    data.size    = sizeof m_decrypted;
+    decoded.size = sizeof decoded_msg;
+    attest(pubnub_decrypt_prepared(&key, m_base64, &data, &decoded), equals(0));
+    attest(data.size, equals(msg.size));
+    attest(memcmp(data.ptr, msg.ptr, msg.size), equals(0));
+    pubnub_crypto_key_deinit(&key);
+
+    pubnub_crypto_key_init(&key, CIPHER_KEY);
+    n     = sizeof m_base64;
+    n_ref = sizeof m_base64_ref;
+    attest(pubnub_encrypt_prepared(&key, msg, m_base64, &n, buffer), equals(0));
+    attest(pubnub_encrypt(CIPHER_KEY, msg, m_base64_ref, &n_ref), equals(0));
+    attest(m_base64, streqs(m_base64_ref));
+    pubnub_crypto_key_deinit(&key);
+}
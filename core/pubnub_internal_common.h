@@ -28,6 +28,40 @@
 #define PUBNUB_CHANGE_DNS_SERVERS 0
 #endif
 
+/* The DNS cache is used only by the asynchronous DNS resolver, which
+   is used only in the callback interface */
+#if !defined(PUBNUB_DNS_CACHE) || !defined(PUBNUB_CALLBACK_API)
+#undef PUBNUB_DNS_CACHE
+#define PUBNUB_DNS_CACHE 0
+#elif PUBNUB_DNS_CACHE && !PUBNUB_USE_MULTIPLE_ADDRESSES
+#error PUBNUB_DNS_CACHE needs PUBNUB_USE_MULTIPLE_ADDRESSES, to keep the TTL of addresses
+#endif
+
+/* Connection attempts are raced only with the asynchronous DNS
+   resolver (callback interface), which gives us the addresses */
+#if !defined(PUBNUB_HAPPY_EYEBALLS) || !defined(PUBNUB_CALLBACK_API)
+#undef PUBNUB_HAPPY_EYEBALLS
+#define PUBNUB_HAPPY_EYEBALLS 0
+#elif PUBNUB_HAPPY_EYEBALLS && !PUBNUB_USE_MULTIPLE_ADDRESSES
+#error PUBNUB_HAPPY_EYEBALLS needs PUBNUB_USE_MULTIPLE_ADDRESSES, to have addresses to race
+#endif
+
+#if defined(PUBNUB_CALLBACK_API)
+#include "lib/msstopwatch/msstopwatch.h"
+#endif
+
+#if PUBNUB_HAPPY_EYEBALLS
+#if !defined(PUBNUB_CONNECTION_ATTEMPT_DELAY_MS)
+/** How long to wait for a connection attempt to complete before
+    starting another one, to another address, to race it */
+#define PUBNUB_CONNECTION_ATTEMPT_DELAY_MS 250
+#endif
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+#if !defined(PUBNUB_CALLBACK_THREAD_COUNT)
+#define PUBNUB_CALLBACK_THREAD_COUNT 1
+#endif
+
 #define PUBNUB_ADNS_RETRY_AFTER_CLOSE                               \
     (PUBNUB_CHANGE_DNS_SERVERS || PUBNUB_USE_MULTIPLE_ADDRESSES)
 
@@ -66,6 +100,28 @@
 #include "core/pbgzip_decompress.h"
 #endif
 
+#if !defined PUBNUB_BUFFER_POOL
+#define PUBNUB_BUFFER_POOL 0
+#elif PUBNUB_BUFFER_POOL
+#include "core/pbbuf_pool.h"
+#endif
+
+#if !defined PUBNUB_SEND_REQUEST_AT_ONCE
+#define PUBNUB_SEND_REQUEST_AT_ONCE 0
+#endif
+
+#if !defined PUBNUB_SUBSCRIBE_STREAMING
+#define PUBNUB_SUBSCRIBE_STREAMING 0
+#elif PUBNUB_SUBSCRIBE_STREAMING
+#include "core/pubnub_subscribe_stream.h"
+#endif
+
+#if !defined PUBNUB_PUBLISH_PIPELINE
+#define PUBNUB_PUBLISH_PIPELINE 0
+#elif PUBNUB_PUBLISH_PIPELINE
+#include "core/pubnub_publish_pipeline.h"
+#endif
+
 #include <stdint.h>
 #if PUBNUB_ADVANCED_KEEP_ALIVE
 #include <time.h>
@@ -127,8 +183,15 @@ struct pbntlm_context {
     /** Current state of the NTLM mini-FSM */
     enum NPBNTLM_State state;
 
+#if PUBNUB_BUFFER_POOL
+    /** Token received in Type2 NTLM message. Taken from the buffer
+        pool (of #PUBNUB_NTLM_MAX_TOKEN octets) when it is received,
+        given back when the NTLM mini-FSM is done with it. */
+    uint8_t* in_token;
+#else
     /** Token received in Type2 NTLM message */
     uint8_t in_token[PUBNUB_NTLM_MAX_TOKEN];
+#endif
 
     /** The length, in bytes, of the token received in Type2 NTLM
      * message */
@@ -181,6 +244,9 @@ struct pubnub_options {
     bool use_system_certificate_store : 1;
     /** Re-use SSL session on a new connection */
     bool reuse_SSL_session : 1;
+    /** Share the SSL context (and its certificate store) with other
+        contexts that have the same certificate configuration */
+    bool share_SSL_CTX : 1;
 #endif
 };
 
@@ -208,6 +274,36 @@ struct pubnub_flags {
         encoded 'via GET'(, or maybe some third method).
       */
     bool is_publish_via_post : 1;
+
+    /** Indicates whether the HTTP body (chunk) being received is read
+        straight into the reply buffer (true), or into our buffer, to
+        be copied from it into the reply buffer (false).
+     */
+    bool read_into_reply : 1;
+
+#if PUBNUB_SUBSCRIBE_STREAMING
+    /** Indicates whether the response of the current (subscribe)
+        transaction is scanned for messages while it is received,
+        which are then given to the message callback.
+     */
+    bool subscribe_streaming : 1;
+#endif
+
+#if PUBNUB_PUBLISH_PIPELINE
+    /** Indicates whether the current (publish) transaction is a
+        publish pipeline, publishing several messages, with their
+        requests sent (one after the other) before reading responses.
+     */
+    bool publish_pipeline : 1;
+#endif
+
+#if PUBNUB_DNS_CACHE
+    /** Context waits for another one to resolve its origin,
+        @see pubnub_dns_cache.h */
+    bool dns_cache_waiting : 1;
+    /** Context is resolving its origin for the DNS cache */
+    bool dns_cache_resolving : 1;
+#endif
 };
 
 #if PUBNUB_CHANGE_DNS_SERVERS
@@ -247,6 +343,56 @@ struct pubnub_multi_addresses {
 };
 #endif /* PUBNUB_USE_MULTIPLE_ADDRESSES */
 
+#if PUBNUB_HAPPY_EYEBALLS
+/** A connection attempt that races the one on the socket of the PAL,
+    to another of the spare addresses. Whichever connects first is
+    kept, the other is closed.
+ */
+struct pubnub_connect_race {
+    /** Socket of the racing attempt, SOCKET_INVALID if there is none */
+    pb_socket_t socket;
+    /** Is the address of the racing attempt an IPv6 one */
+    bool ipv6 : 1;
+    /** Is the attempt on the socket of the PAL to the current IPv6
+        spare address, though there are IPv4 ones left. That is, an
+        attempt to an IPv6 address took over an IPv4 one, which we
+        keep for later (re)connects.
+     */
+    bool current_ipv6 : 1;
+    /** Index of the address of the racing attempt, in the spare
+        addresses of its family */
+    int index;
+    /** The port to connect to */
+    uint16_t port;
+    /** When was the attempt on the socket of the PAL started, not
+        active if we're not to start an attempt to race it */
+    pbmsref_t started;
+};
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+#if PUBNUB_PUBLISH_PIPELINE
+/** The messages of a publish pipeline and their results */
+struct pubnub_publish_pipeline_data {
+    char const*                channel;
+    char const* const*         messages;
+    enum pubnub_publish_method method;
+    /** Number of messages */
+    unsigned count;
+    /** Index of the message whose request is being sent, the ones
+        before it were sent (or failed to be prepared)
+     */
+    unsigned sent;
+    /** Index of the message whose response is awaited */
+    unsigned done;
+    /** Don't send a request before the response to the previous one
+        is received (connection was lost while pipelining)
+     */
+    bool serial : 1;
+    /** Results, PNR_STARTED for those not known yet */
+    enum pubnub_res results[PUBNUB_PUBLISH_PIPELINE_MAX];
+};
+#endif /* PUBNUB_PUBLISH_PIPELINE */
+
 /** The Pubnub context
 
     @note Don't declare any members as `bool`, as there may be
@@ -267,13 +413,20 @@ struct pubnub_multi_addresses {
 
 */
 struct pubnub_ {
-    struct pbcc_context core;
+    /* The fields used on (almost) every step of the FSM, or
+       whenever the context is processed, are first, together in a
+       few cache lines. Those used only in some transactions or
+       states (like connecting or talking to a proxy) are after the
+       core context, which ends with the big buffers.
+     */
 
     /** Network communication state */
     enum pubnub_state state;
     /** Type of current transaction */
     enum pubnub_trans trans;
 
+    struct pubnub_flags flags;
+
     /** The number of bytes we got (in our buffer) from network but
         have not processed yet. */
     uint16_t unreadlen;
@@ -292,24 +445,82 @@ struct pubnub_ {
     /** Number of bytes to send or read - given by the user */
     unsigned len;
 
-    /** Indicates whether we are receiving chunked or regular HTTP
-     * response
+    /** If not NULL, where to read the data to, instead of our buffer,
+        @see pbpal_start_read_into()
+     */
+    uint8_t* read_into;
+
+    /** What we have learned from the headers of the HTTP response
+        being received
      */
-    uint16_t http_chunked;
+    struct pbhttp_response_headers {
+        /** Value of the `Content-Length` header, 0 if there wasn't one */
+        size_t content_length;
+        /** Indicates whether we are receiving chunked or regular
+            HTTP response (`Transfer-Encoding: chunked`)
+        */
+        bool chunked : 1;
+        /** `Connection: close` */
+        bool close : 1;
+        /** `Content-Encoding: gzip` */
+        bool gzip : 1;
+    } http_headers;
 
     /** Last received HTTP (result) code */
     uint16_t http_code;
 
+    struct pubnub_pal pal;
+
+#if PUBNUB_THREADSAFE
+    pubnub_mutex_t monitor;
+#endif
+
+#if PUBNUB_TIMERS_API
+    /** Duration of the transaction timeout, in milliseconds */
+    int transaction_timeout_ms;
+
+#if defined(PUBNUB_CALLBACK_API)
+    struct pubnub_* previous;
+    struct pubnub_* next;
+    int             timeout_left_ms;
+    /** Tick of the timer wheel on which the transaction timer
+        expires, if the context is in a timer wheel.
+        @see pubnub_timer_wheel.h
+     */
+    unsigned expiry_tick;
+#endif
+
+#endif /* PUBNUB_TIMERS_API */
+
+#if defined(PUBNUB_CALLBACK_API)
+    pubnub_callback_t cb;
+    void*             user_data;
+
+#if PUBNUB_CALLBACK_THREAD_COUNT > 1
+    /** Index of the (watcher) thread that processes this context */
+    unsigned thread_index;
+#endif
+
+    /** Links in the (doubly linked) queue of contexts to process,
+        guarded by the queue's monitor.
+        @see pbpal_ntf_callback_queue.h
+     */
+    struct pubnub_* queue_previous;
+    struct pubnub_* queue_next;
+#endif /* defined(PUBNUB_CALLBACK_API) */
+
+#if PUBNUB_SUBSCRIBE_STREAMING
+    /** The message callback, @see pubnub_subscribe_stream.h */
+    pubnub_message_callback_t msg_cb;
+    void*                     msg_cb_user_data;
+#endif
+
 #if defined PUBNUB_ORIGIN_SETTABLE
     char const* origin;
 #endif
 
-    struct pubnub_pal pal;
-
     struct pubnub_options options;
 
-    struct pubnub_flags flags;
-
 #if PUBNUB_ADVANCED_KEEP_ALIVE
     struct pubnub_keep_alive_data {
         time_t   timeout;
@@ -323,6 +534,8 @@ struct pubnub_ {
     enum pubnub_data_compressionType data_compressed;
 #endif
 
+    struct pbcc_context core;
+
 #if PUBNUB_USE_SSL
     /** Certificate store file */
     char const* ssl_CAfile;
@@ -332,32 +545,40 @@ struct pubnub_ {
     char const* ssl_userPEMcert;
 #endif /* PUBNUB_USE_SSL */
 
-#if PUBNUB_THREADSAFE
-    pubnub_mutex_t monitor;
-#endif
-
-#if PUBNUB_TIMERS_API
-    /** Duration of the transaction timeout, in milliseconds */
-    int transaction_timeout_ms;
-
-#if defined(PUBNUB_CALLBACK_API)
-    struct pubnub_* previous;
-    struct pubnub_* next;
-    int             timeout_left_ms;
+#if PUBNUB_PUBLISH_PIPELINE
+    /** The messages of a publish pipeline and their results,
+        @see pubnub_publish_pipeline.h
+     */
+    struct pubnub_publish_pipeline_data pipeline;
 #endif
 
-#endif /* PUBNUB_TIMERS_API */
-
 #if defined(PUBNUB_CALLBACK_API)
-    pubnub_callback_t cb;
-    void*             user_data;
-
 #if PUBNUB_CHANGE_DNS_SERVERS
     struct pbdns_servers_check dns_check;
 #endif    
 #if PUBNUB_USE_MULTIPLE_ADDRESSES
     struct pubnub_multi_addresses spare_addresses;
 #endif
+#if PUBNUB_DNS_CACHE
+    /** Links in the list of contexts waiting for their origin to be
+        resolved by another context. Guarded by the DNS cache lock.
+        @see pubnub_dns_cache.h
+     */
+    struct pubnub_* dns_cache_previous;
+    struct pubnub_* dns_cache_next;
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    /** The connection attempt racing the one on the socket of the
+        PAL, @see PUBNUB_HAPPY_EYEBALLS */
+    struct pubnub_connect_race connect_race;
+    /** Links in the list of contexts waiting to start a racing
+        connection attempt, of the thread that processes the context,
+        and when it was put on that list. Guarded by its timer lock.
+     */
+    struct pubnub_* connect_race_previous;
+    struct pubnub_* connect_race_next;
+    pbmsref_t       connect_race_watched;
+#endif
 #endif /* defined(PUBNUB_CALLBACK_API) */
     
 #if PUBNUB_PROXY_API
@@ -394,9 +615,18 @@ struct pubnub_ {
     */
     int proxy_tunnel_established;
 
+#if PUBNUB_BUFFER_POOL
+    /** The saved path part of the URL for the Pubnub transaction.
+        Taken from the buffer pool (of #PUBNUB_BUF_MAXLEN octets) when
+        the path is saved, given back on the outcome of the
+        transaction.
+     */
+    char* proxy_saved_path;
+#else
     /** The saved path part of the URL for the Pubnub transaction.
      */
     char proxy_saved_path[PUBNUB_BUF_MAXLEN];
+#endif
 
     /** The length, in characters, of the saved proxy path */
     unsigned proxy_saved_path_len;
@@ -469,6 +699,75 @@ int pbntf_requeue_for_processing(pubnub_t* pb);
 int pbntf_watch_in_events(pubnub_t* pb);
 int pbntf_watch_out_events(pubnub_t* pb);
 
+#if PUBNUB_HAPPY_EYEBALLS
+/** Makes the context @p pb processed once
+    #PUBNUB_CONNECTION_ATTEMPT_DELAY_MS has passed, not just on the
+    events of its socket, so that it can start the connection attempt
+    to race the one on its socket. If already called, the delay
+    starts anew.
+ */
+void pbntf_watch_connect_race(pubnub_t* pb);
+
+/** Stops what pbntf_watch_connect_race() started. It's OK to call
+    if it was not started.
+ */
+void pbntf_unwatch_connect_race(pubnub_t* pb);
+
+/** Starts watching the socket of the connection attempt racing the
+    one of @p pb (`pb->connect_race.socket`), processing @p pb on its
+    events, too.
+ */
+void pbntf_watch_race_socket(pubnub_t* pb);
+
+/** Stops what pbntf_watch_race_socket() started. To be called
+    before the socket is closed or becomes the socket of @p pb.
+ */
+void pbntf_unwatch_race_socket(pubnub_t* pb);
+#endif
+
+#if defined(PUBNUB_CALLBACK_API)
+/** A call that the watcher thread of a context makes, to `fn` (with
+    this as the argument), after some time has passed. Set `fn` and
+    clear `armed` and `in_flight` before the first pbntf_defer().
+ */
+struct pbntf_deferred {
+    /** The function to call */
+    void (*fn)(struct pbntf_deferred* deferred);
+    /** When was it (last) deferred */
+    pbmsref_t since;
+    /** How long after `since` to make the call, in milliseconds */
+    pbms_t delay_ms;
+    /** Is it waiting for the call to be made */
+    bool armed;
+    /** Is the call being made */
+    bool in_flight;
+    /** Next in the list of the watcher thread */
+    struct pbntf_deferred* next;
+};
+
+/** Makes the watcher thread of the context @p pb call
+    `deferred->fn` after @p delay_ms milliseconds. If that is already
+    waiting, it is rescheduled. The call is made with no (watcher or
+    context) lock held, so it can start transactions.
+ */
+void pbntf_defer(pubnub_t* pb, struct pbntf_deferred* deferred, int delay_ms);
+
+/** Stops what pbntf_defer() started. If the call is being made (on
+    another thread), waits for it to return, so, after this, @p deferred
+    can be freed. It's OK to call if nothing was started, and from
+    `deferred->fn` (or anything it calls), in which case @p deferred
+    can be freed before `deferred->fn` returns.
+ */
+void pbntf_cancel_deferred(pubnub_t* pb, struct pbntf_deferred* deferred);
+#endif /* defined(PUBNUB_CALLBACK_API) */
+
+#if PUBNUB_CALLBACK_THREAD_COUNT > 1
+/** Assigns the context @p pb to one of the (watcher) threads that
+    process contexts, round-robin.
+ */
+void pbntf_assign_thread(pubnub_t* pb);
+#endif
+
 
 /** Internal function. Checks if the given pubnub context pointer
     is valid.
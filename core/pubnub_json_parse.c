@@ -6,6 +6,49 @@
 #include <string.h>
 
 
+#if !defined(PUBNUB_JSON_SIMD)
+#if defined(__SSE2__) || defined(_M_X64)                                        \
+    || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+/** Scan JSON for structural characters 16 (or, with AVX2, 32)
+    characters at a time. On by default when SSE2 is available. */
+#define PUBNUB_JSON_SIMD 1
+#else
+#define PUBNUB_JSON_SIMD 0
+#endif
+#endif /* !defined(PUBNUB_JSON_SIMD) */
+
+#if PUBNUB_JSON_SIMD
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+static unsigned first_set_bit(unsigned mask)
+{
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+}
+#else
+#define first_set_bit(mask) (unsigned)__builtin_ctz(mask)
+#endif
+
+#define PBJSON_X16(c) c, c, c, c, c, c, c, c, c, c, c, c, c, c, c, c
+#define PBJSON_X32(c) { PBJSON_X16(c), PBJSON_X16(c) }
+
+/* Loaded rather than made with `_mm_set1_epi8()`, which is (very)
+   slow in unoptimized builds. Or-ing with 0x20 folds `[` into `{`
+   and `]` into `}`. */
+static char const m_quotes[32]      = PBJSON_X32('"');
+static char const m_backslashes[32] = PBJSON_X32('\\');
+static char const m_folds[32]       = PBJSON_X32(0x20);
+static char const m_openings[32]    = PBJSON_X32('{');
+static char const m_closings[32]    = PBJSON_X32('}');
+#endif /* PUBNUB_JSON_SIMD */
+
+
 char const* pbjson_skip_whitespace(char const* start, char const* end)
 {
     for (; start < end; ++start) {
@@ -23,32 +66,137 @@ char const* pbjson_skip_whitespace(char const* start, char const* end)
 }
 
 
-char const* pbjson_find_end_string(char const* start, char const* end)
+char const* pbjson_scan_string(char const* start, char const* end)
 {
-    bool in_escape = false;
-
+#if PUBNUB_JSON_SIMD
+#if defined(__AVX2__)
+    if (end - start >= 32) {
+        __m256i const quote     = _mm256_loadu_si256((__m256i const*)m_quotes);
+        __m256i const backslash = _mm256_loadu_si256((__m256i const*)m_backslashes);
+        __m256i const zero      = _mm256_setzero_si256();
+        do {
+            __m256i  v    = _mm256_loadu_si256((__m256i const*)start);
+            unsigned mask = (unsigned)_mm256_movemask_epi8(
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                                _mm256_cmpeq_epi8(v, backslash)),
+                                _mm256_cmpeq_epi8(v, zero)));
+            if (mask != 0) {
+                return start + first_set_bit(mask);
+            }
+            start += 32;
+        } while (end - start >= 32);
+    }
+#endif
+    if (end - start >= 16) {
+        __m128i const quote     = _mm_loadu_si128((__m128i const*)m_quotes);
+        __m128i const backslash = _mm_loadu_si128((__m128i const*)m_backslashes);
+        __m128i const zero      = _mm_setzero_si128();
+        do {
+            __m128i  v    = _mm_loadu_si128((__m128i const*)start);
+            unsigned mask = (unsigned)_mm_movemask_epi8(
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                          _mm_cmpeq_epi8(v, backslash)),
+                             _mm_cmpeq_epi8(v, zero)));
+            if (mask != 0) {
+                return start + first_set_bit(mask);
+            }
+            start += 16;
+        } while (end - start >= 16);
+    }
+#endif /* PUBNUB_JSON_SIMD */
     for (; start < end; ++start) {
         switch (*start) {
+        case '"':
         case '\\':
-            in_escape = !in_escape;
-            break;
         case '\0':
             return start;
-        case '"':
-            if (!in_escape) {
-                return start;
-            }
-            /*FALLTHRU*/
         default:
-            in_escape = false;
             break;
         }
     }
+    return start;
+}
+
 
+char const* pbjson_scan_structural(char const* start, char const* end)
+{
+#if PUBNUB_JSON_SIMD
+#if defined(__AVX2__)
+    if (end - start >= 32) {
+        __m256i const fold    = _mm256_loadu_si256((__m256i const*)m_folds);
+        __m256i const opening = _mm256_loadu_si256((__m256i const*)m_openings);
+        __m256i const closing = _mm256_loadu_si256((__m256i const*)m_closings);
+        __m256i const quote   = _mm256_loadu_si256((__m256i const*)m_quotes);
+        __m256i const zero    = _mm256_setzero_si256();
+        do {
+            __m256i  v = _mm256_loadu_si256((__m256i const*)start);
+            __m256i  f = _mm256_or_si256(v, fold);
+            unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(f, opening),
+                                _mm256_cmpeq_epi8(f, closing)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, quote),
+                                _mm256_cmpeq_epi8(v, zero))));
+            if (mask != 0) {
+                return start + first_set_bit(mask);
+            }
+            start += 32;
+        } while (end - start >= 32);
+    }
+#endif
+    if (end - start >= 16) {
+        __m128i const fold    = _mm_loadu_si128((__m128i const*)m_folds);
+        __m128i const opening = _mm_loadu_si128((__m128i const*)m_openings);
+        __m128i const closing = _mm_loadu_si128((__m128i const*)m_closings);
+        __m128i const quote   = _mm_loadu_si128((__m128i const*)m_quotes);
+        __m128i const zero    = _mm_setzero_si128();
+        do {
+            __m128i  v = _mm_loadu_si128((__m128i const*)start);
+            __m128i  f = _mm_or_si128(v, fold);
+            unsigned mask = (unsigned)_mm_movemask_epi8(
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(f, opening),
+                                          _mm_cmpeq_epi8(f, closing)),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                          _mm_cmpeq_epi8(v, zero))));
+            if (mask != 0) {
+                return start + first_set_bit(mask);
+            }
+            start += 16;
+        } while (end - start >= 16);
+    }
+#endif /* PUBNUB_JSON_SIMD */
+    for (; start < end; ++start) {
+        switch (*start) {
+        case '"':
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case '\0':
+            return start;
+        default:
+            break;
+        }
+    }
     return start;
 }
 
 
+char const* pbjson_find_end_string(char const* start, char const* end)
+{
+    for (;;) {
+        start = pbjson_scan_string(start, end);
+        if ((start == end) || (*start != '\\')) {
+            return start;
+        }
+        /* Skip the escaped character, unless input ends here */
+        if ((++start == end) || ('\0' == *start)) {
+            return start;
+        }
+        ++start;
+    }
+}
+
+
 char const* pbjson_find_end_primitive(char const* start, char const* end)
 {
     for (; start < end; ++start) {
@@ -73,53 +221,36 @@ char const* pbjson_find_end_primitive(char const* start, char const* end)
 
 char const* pbjson_find_end_complex(char const* start, char const* end)
 {
-    bool        in_string = false, in_escape = false;
     int         bracket_level = 0, brace_level = 0;
-    char        c;
     char const* s;
 
-    for (s = start, c = *s; (c != '\0') && (s < end); ++s, c = *s) {
-        if (!in_string) {
-            switch (c) {
-            case '{':
-                ++brace_level;
-                break;
-            case '}':
-                if ((--brace_level == 0) && (0 == bracket_level)) {
-                    return s;
-                }
-                break;
-            case '[':
-                ++bracket_level;
-                break;
-            case ']':
-                if ((--bracket_level == 0) && (0 == brace_level)) {
-                    return s;
-                }
-                break;
-            case '"':
-                in_string = true;
-                in_escape = false;
-                break;
-            default:
-                break;
+    for (s = pbjson_scan_structural(start, end); (s < end) && (*s != '\0');
+         s = pbjson_scan_structural(s + 1, end)) {
+        switch (*s) {
+        case '{':
+            ++brace_level;
+            break;
+        case '}':
+            if ((--brace_level == 0) && (0 == bracket_level)) {
+                return s;
             }
-        }
-        else {
-            switch (c) {
-            case '\\':
-                in_escape = !in_escape;
-                break;
-            case '"':
-                if (!in_escape) {
-                    in_string = false;
-                    break;
-                }
-                /*FALLTHRU*/
-            default:
-                in_escape = false;
-                break;
+            break;
+        case '[':
+            ++bracket_level;
+            break;
+        case ']':
+            if ((--bracket_level == 0) && (0 == brace_level)) {
+                return s;
+            }
+            break;
+        case '"':
+            s = pbjson_find_end_string(s + 1, end);
+            if ((s == end) || ('\0' == *s)) {
+                return s;
             }
+            break;
+        default:
+            break;
         }
     }
     return s;
@@ -205,6 +336,69 @@ pbjson_get_object_value(struct pbjson_elem const* p,
 }
 
 
+enum pbjson_object_name_parse_result
+pbjson_get_next_object_member(struct pbjson_elem const* p,
+                              char const**              pos,
+                              struct pbjson_elem*       name,
+                              struct pbjson_elem*       value)
+{
+    char const* s = pbjson_skip_whitespace(*pos, p->end);
+    char const* end;
+
+    if (*pos == p->start) {
+        if ((s == p->end) || (*s != '{')) {
+            return jonmpNoStartCurly;
+        }
+        s = pbjson_skip_whitespace(s + 1, p->end);
+        if ((s < p->end) && ('}' == *s)) {
+            *pos = s;
+            return jonmpKeyNotFound;
+        }
+    }
+    else {
+        if (s == p->end) {
+            return jonmpObjectIncomplete;
+        }
+        if ('}' == *s) {
+            return jonmpKeyNotFound;
+        }
+        if (*s != ',') {
+            return jonmpMissingValueSeparator;
+        }
+        s = pbjson_skip_whitespace(s + 1, p->end);
+    }
+    if (s == p->end) {
+        return jonmpKeyMissing;
+    }
+    if (*s != '"') {
+        return jonmpKeyNotString;
+    }
+    end = pbjson_find_end_string(s + 1, p->end);
+    if ((end == p->end) || (*end != '"')) {
+        return jonmpStringNotTerminated;
+    }
+    name->start = s + 1;
+    name->end   = end;
+    s           = pbjson_skip_whitespace(end + 1, p->end);
+    if ((s == p->end) || (*s != ':')) {
+        return jonmpMissingColon;
+    }
+    s = pbjson_skip_whitespace(s + 1, p->end);
+    if (s == p->end) {
+        return jonmpValueIncomplete;
+    }
+    end = pbjson_find_end_element(s, p->end);
+    if ((end == p->end) || ('\0' == *end)) {
+        return jonmpValueIncomplete;
+    }
+    value->start = s;
+    value->end   = end + 1;
+    *pos         = end + 1;
+
+    return jonmpOK;
+}
+
+
 bool pbjson_elem_equals_string(struct pbjson_elem const* e, char const* s)
 {
     char const* p;
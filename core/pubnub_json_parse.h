@@ -69,6 +69,26 @@ enum pbjson_object_name_parse_result {
 char const* pbjson_skip_whitespace(char const* start, char const* end);
 
 
+/** Finds the first character from @p start, until @p end, that can
+    end or escape a JSON string: a double-quote, a backslash or a NUL.
+    Where available (SSE2, AVX2), looks at many characters at a time.
+
+    @return Pointer to the character found. It is == @p end if there
+    is none.
+ */
+char const* pbjson_scan_string(char const* start, char const* end);
+
+
+/** Finds the first "structural" character from @p start, until @p
+    end: a double-quote, square bracket, curly brace or a NUL.  Where
+    available (SSE2, AVX2), looks at many characters at a time.
+
+    @return Pointer to the character found. It is == @p end if there
+    is none.
+ */
+char const* pbjson_scan_structural(char const* start, char const* end);
+
+
 /** Finds the end of the string starting from @p start, until @p end.
     Interprets string as JSON does (starting and ending with
     double-quotation and allowing escape characters with backslash) -
@@ -140,6 +160,23 @@ pbjson_get_object_value(struct pbjson_elem const* p,
                         struct pbjson_elem*       parsed);
 
 
+/** Gets the next member (key-value pair) of the JSON object @p p,
+    for iterating over all its members in one pass. Set @p *pos to
+    `p->start` to get the first member, it is updated to the end of
+    the member got, so pass it back as is to get the next one.
+
+    On success, puts the key (w/out the quotes) to @p name and the
+    value to @p value and returns jonmpOK. When there are no more
+    members, returns jonmpKeyNotFound. Otherwise, returns the error
+    code and the effects on @p name and @p value are not defined.
+*/
+enum pbjson_object_name_parse_result
+pbjson_get_next_object_member(struct pbjson_elem const* p,
+                              char const**              pos,
+                              struct pbjson_elem*       name,
+                              struct pbjson_elem*       value);
+
+
 /** Helper function, returns whether string @p s is equal to the
     contents of the JSON element @p e.
 */
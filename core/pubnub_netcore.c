@@ -15,6 +15,8 @@
 #include "core/pubnub_proxy_core.h"
 
 #include <string.h>
+#include <ctype.h>
+#include <limits.h>
 
 
 /** Each HTTP chunk has a trailining CRLF ("\r\n" in C-speak).  That's
@@ -25,21 +27,36 @@
 #define CHUNK_TRAIL_LENGTH 2
 
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+/** The most of the body of a "streamed" subscribe response that we
+    read at once, before looking for (and handing out) the messages
+    in it. This is also, roughly, how much memory the reply buffer
+    needs, unless there are messages bigger than this.
+ */
+#define SUBSCRIBE_STREAM_READ_LEN 8192
+#define STREAMING_SUBSCRIBE(pb) (pb)->flags.subscribe_streaming
+#else
+#define STREAMING_SUBSCRIBE(pb) false
+#endif
+
+
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
 /* 'Accept-Encoding' header line */
 #define ACCEPT_ENCODING "Accept-Encoding: gzip\r\n"
 #define possible_gzip_response(pb)                                             \
     if ((pb)->data_compressed == compressionGZIP) {                            \
-        pbres                 = pbgzip_decompress(pb);                         \
+        pbres                 = pbgzip_decompress_finish(pb);                  \
         (pb)->data_compressed = compressionNONE;                               \
         if (PNR_OK != pbres) {                                                 \
             outcome_detected((pb), pbres);                                     \
             return pbres;                                                      \
         }                                                                      \
     }
+#define GZIP_RESPONSE(pb) ((pb)->data_compressed == compressionGZIP)
 #else
 #define ACCEPT_ENCODING ""
 #define possible_gzip_response(pb)
+#define GZIP_RESPONSE(pb) false
 #endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
 
 
@@ -62,6 +79,104 @@ static int send_fin_head(struct pubnub_* pb)
     }
 
 
+#if PUBNUB_SEND_REQUEST_AT_ONCE
+static bool append(char** pp, char const* end, void const* data, size_t n)
+{
+    if ((size_t)(end - *pp) < n) {
+        return false;
+    }
+    memcpy(*pp, data, n);
+    *pp += n;
+    return true;
+}
+
+
+/** Puts the whole request - the head and the body (if any) -
+    together in the part of the HTTP buffer after the URL (path),
+    which is not used while sending. The URL itself is left intact,
+    as it might be needed to send the request again.
+
+    @return The length of the request put together at
+    `pb->core.http_buf + pb->core.http_buf_len + 1`, or 0 if it
+    doesn't fit in the HTTP buffer
+ */
+static size_t assemble_request(struct pubnub_* pb)
+{
+    char*       start = pb->core.http_buf + pb->core.http_buf_len + 1;
+    char const* end   = pb->core.http_buf + sizeof pb->core.http_buf;
+    char*       p     = start;
+    char const* o     = PUBNUB_ORIGIN_SETTABLE ? pb->origin : PUBNUB_ORIGIN;
+    char const* method = pb->flags.is_publish_via_post ? "POST " : "GET ";
+    char        s[200];
+
+    if (start >= end) {
+        return 0;
+    }
+    if (!append(&p, end, method, strlen(method))
+        || !append(&p, end, pb->core.http_buf, pb->core.http_buf_len)
+        || !append(&p, end, " HTTP/1.1\r\nHost: ", sizeof " HTTP/1.1\r\nHost: " - 1)
+        || !append(&p, end, o, strlen(o))) {
+        return 0;
+    }
+    if (pb->flags.is_publish_via_post) {
+        char hedr[128] = "\r\n";
+        pbcc_headers_for_publish_via_post(&(pb->core), hedr + 2, sizeof hedr - 2);
+        if (!append(&p, end, hedr, strlen(hedr))) {
+            return 0;
+        }
+    }
+    snprintf(s,
+             sizeof s,
+             "\r\nUser-Agent: %s%s",
+             pubnub_uagent(),
+             "\r\n" ACCEPT_ENCODING "\r\n");
+    if (!append(&p, end, s, strlen(s))) {
+        return 0;
+    }
+    if (pb->flags.is_publish_via_post) {
+        const char* message = pb->core.message_to_publish;
+#if PUBNUB_USE_GZIP_COMPRESSION
+        size_t len = (pb->core.gzip_msg_len != 0) ? pb->core.gzip_msg_len
+                                                  : strlen(message);
+#else
+        size_t len = strlen(message);
+#endif
+        if (!append(&p, end, message, len)) {
+            return 0;
+        }
+    }
+
+    return p - start;
+}
+#endif /* PUBNUB_SEND_REQUEST_AT_ONCE */
+
+
+/** Starts sending the request. If possible, sends the whole request
+    at once, in which case the only thing left is to wait for the
+    sending to finish (in the "send body" state). Otherwise, starts
+    sending it piece by piece, state by state, from the method.
+ */
+static int send_request(struct pubnub_* pb)
+{
+#if PUBNUB_SEND_REQUEST_AT_ONCE
+#if PUBNUB_PROXY_API
+    if (pbproxyNONE == pb->proxy_type)
+#endif
+    {
+        size_t len = assemble_request(pb);
+        if ((len > 0) && (len <= UINT16_MAX)) {
+            PUBNUB_LOG_TRACE("pb=%p sending the whole request at once, len=%zu\n",
+                             pb, len);
+            pb->state = PBS_TX_BODY;
+            return pbpal_send(pb, pb->core.http_buf + pb->core.http_buf_len + 1, len);
+        }
+    }
+#endif /* PUBNUB_SEND_REQUEST_AT_ONCE */
+    pb->state = PBS_TX_GET;
+    return pbpal_send_str(pb, pb->flags.is_publish_via_post ? "POST " : "GET ");
+}
+
+
 static bool should_keep_alive(struct pubnub_* pb, enum pubnub_res rslt)
 {
     if (!pb->flags.should_close) {
@@ -132,8 +247,150 @@ static enum pubnub_state close_kept_alive_connection(struct pubnub_* pb)
 }
 
 
+#if PUBNUB_PUBLISH_PIPELINE
+enum pubnub_res pbnc_pipeline_prep(struct pubnub_* pb)
+{
+    struct pubnub_publish_pipeline_data* pl   = &pb->pipeline;
+    enum pubnub_res                      rslt = PNR_INTERNAL_ERROR;
+
+    for (; pl->sent < pl->count; ++pl->sent) {
+        char const* message = pl->messages[pl->sent];
+#if PUBNUB_USE_GZIP_COMPRESSION
+        pb->core.gzip_msg_len = 0;
+        if ((pubnubPublishViaPOSTwithGZIP == pl->method)
+            && (pbgzip_compress(pb, message) == PNR_OK)) {
+            message = pb->core.gzip_msg_buf;
+        }
+#endif
+        rslt = pbcc_publish_prep(
+            &pb->core, pl->channel, message, true, false, NULL, pl->method);
+        if (PNR_STARTED == rslt) {
+#if PUBNUB_PROXY_API
+            /* The pipeline doesn't go through "idle" between requests,
+               but the path saved for the proxy is of the previous one
+            */
+            pb->proxy_saved_path_len     = 0;
+            pb->proxy_authorization_sent = false;
+            pb->auth_msg_count           = 0;
+#endif
+            break;
+        }
+        PUBNUB_LOG_WARNING("pb=%p can't publish message #%u of the pipeline, "
+                           "error %d\n",
+                           pb,
+                           pl->sent,
+                           rslt);
+        pl->results[pl->sent] = rslt;
+    }
+
+    return rslt;
+}
+
+
+/** Skips the messages of the publish pipeline that we don't wait
+    a response for.
+
+    @return Whether there are requests that were sent, but not
+    responded to
+ */
+static bool pipeline_outstanding(struct pubnub_publish_pipeline_data* pl)
+{
+    while ((pl->done < pl->sent) && (pl->results[pl->done] != PNR_STARTED)) {
+        ++pl->done;
+    }
+    return pl->done < pl->sent;
+}
+
+
+/** Prepares to send the requests that were not responded to again,
+    one by one (on a new connection).
+ */
+static void pipeline_rewind(struct pubnub_* pb)
+{
+    struct pubnub_publish_pipeline_data* pl = &pb->pipeline;
+
+    if (pb->flags.publish_pipeline && pipeline_outstanding(pl)) {
+        PUBNUB_LOG_INFO("pb=%p publish pipeline lost the connection with "
+                        "%u requests not responded to, sending them one by one\n",
+                        pb,
+                        pl->sent - pl->done);
+        pl->serial = true;
+        pl->sent   = pl->done;
+        pbnc_pipeline_prep(pb);
+    }
+}
+
+
+/** Handles the result @p pbres of the response to a request of the
+    publish pipeline, moving on with the rest of the pipeline, if
+    there is any. Otherwise, puts the result of the whole pipeline
+    (the first failure, if any) into @p pbres.
+
+    @return Whether the pipeline goes on (new state was set)
+ */
+static bool pipeline_response_done(struct pubnub_* pb, enum pubnub_res* pbres)
+{
+    struct pubnub_publish_pipeline_data* pl = &pb->pipeline;
+    unsigned                             i;
+
+    while ((pl->done < pl->count) && (pl->results[pl->done] != PNR_STARTED)) {
+        ++pl->done;
+    }
+    if (pl->done >= pl->count) {
+        PUBNUB_LOG_ERROR("pb=%p publish pipeline got a response, but all of "
+                         "its %u requests were already responded to\n",
+                         pb,
+                         pl->count);
+        *pbres = PNR_INTERNAL_ERROR;
+        return false;
+    }
+    pl->results[pl->done++] = *pbres;
+    if (pb->flags.should_close) {
+        /* The server will close the connection, the rest has to go
+           on a new one */
+        pipeline_rewind(pb);
+        if ((pl->sent < pl->count) && (PNR_STARTED == pbnc_pipeline_prep(pb))) {
+            pb->state = close_kept_alive_connection(pb);
+            return true;
+        }
+    }
+    else if (pipeline_outstanding(pl)) {
+        pbpal_start_read_line(pb);
+        pb->state = PBS_RX_HTTP_VER;
+        return true;
+    }
+    else if (PNR_STARTED == pbnc_pipeline_prep(pb)) {
+        if (send_request(pb) < 0) {
+            pb->state = close_kept_alive_connection(pb);
+        }
+        return true;
+    }
+
+    *pbres = PNR_OK;
+    for (i = 0; i < pl->count; ++i) {
+        if (pl->results[i] != PNR_OK) {
+            *pbres = pl->results[i];
+            break;
+        }
+    }
+    return false;
+}
+#endif /* PUBNUB_PUBLISH_PIPELINE */
+
+
 static void outcome_detected(struct pubnub_* pb, enum pubnub_res rslt)
 {
+#if PUBNUB_PUBLISH_PIPELINE
+    if (pb->flags.publish_pipeline && !pb->pipeline.serial
+        && ((PNR_IO_ERROR == rslt) || (PNR_TIMEOUT == rslt)
+            || (PNR_CONNECTION_TIMEOUT == rslt))
+        && pipeline_outstanding(&pb->pipeline)) {
+        pipeline_rewind(pb);
+        pb->state = close_kept_alive_connection(pb);
+        pbntf_requeue_for_processing(pb);
+        return;
+    }
+#endif
     pb->core.last_result = rslt;
     if (should_keep_alive(pb, rslt)) {
         /* We don't monitor the connection while in "keep-alive idle".
@@ -155,6 +412,33 @@ static void outcome_detected(struct pubnub_* pb, enum pubnub_res rslt)
 }
 
 
+#if PUBNUB_PUBLISH_PIPELINE
+/** Handles the end of sending a request, sending the next one, if
+    we're pipelining.
+
+    @return +1: go on to read the response, 0: sending the next
+    request, -1: stop (outcome detected)
+ */
+static int pipeline_request_sent(struct pubnub_* pb)
+{
+    struct pubnub_publish_pipeline_data* pl = &pb->pipeline;
+
+    if (!pb->flags.publish_pipeline) {
+        return +1;
+    }
+    ++pl->sent;
+    if (pl->serial || (pbnc_pipeline_prep(pb) != PNR_STARTED)) {
+        return +1;
+    }
+    if (send_request(pb) < 0) {
+        outcome_detected(pb, PNR_IO_ERROR);
+        return -1;
+    }
+    return 0;
+}
+#endif /* PUBNUB_PUBLISH_PIPELINE */
+
+
 static enum pubnub_res dont_parse(struct pbcc_context* p)
 {
     PUBNUB_UNUSED(p);
@@ -244,6 +528,13 @@ static enum pubnub_res finish(struct pubnub_* pb)
     case pbproxyFinRetry:
         PUBNUB_LOG_TRACE("Proxy: retry in current connection\n");
         pb->flags.retry_after_close = true;
+#if PUBNUB_PUBLISH_PIPELINE
+        if (pb->flags.publish_pipeline) {
+            /* Behind a proxy, pipeline is serial, so it's the last
+               request sent that will be sent again */
+            --pb->pipeline.sent;
+        }
+#endif
         if (pb->flags.should_close) {
             close_connection(pb);
             return PNR_OK;
@@ -265,16 +556,367 @@ static enum pubnub_res finish(struct pubnub_* pb)
     possible_gzip_response(pb);
     pb->core.http_reply[pb->core.http_buf_len] = '\0';
     PUBNUB_LOG_TRACE("finish(pb=%p, '%s')\n", pb, pb->core.http_reply);
+#if PUBNUB_SUBSCRIBE_STREAMING
+    if (pb->flags.subscribe_streaming) {
+        pbres = pbcc_subscribe_stream_finish(&pb->core);
+    }
+    else
+#endif
     pbres = parse_pubnub_result(pb);
     if ((PNR_OK == pbres) && ((pb->http_code / 100) != 2)) {
         pbres = PNR_HTTP_ERROR;
     }
+#if PUBNUB_PUBLISH_PIPELINE
+    if (pb->flags.publish_pipeline && pipeline_response_done(pb, &pbres)) {
+        return PNR_STARTED;
+    }
+#endif
 
     outcome_detected(pb, pbres);
     return pbres;
 }
 
 
+/** Returns whether the first @p n characters of @p s are the same as
+    those of @p lower (which is all lower case), ignoring case.
+ */
+static bool equals_ignore_case(char const* s, char const* lower, size_t n)
+{
+    size_t i;
+    for (i = 0; i < n; ++i) {
+        if (tolower((unsigned char)s[i]) != lower[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** Returns whether the comma separated list of (header value) tokens
+    from @p value to @p end has the (lower case) @p token, ignoring
+    case.
+ */
+static bool has_token(char const* value, char const* end, char const* token)
+{
+    size_t const token_len = strlen(token);
+
+    while (value < end) {
+        char const* comma = (char const*)memchr(value, ',', end - value);
+        char const* tok_end = (NULL == comma) ? end : comma;
+        while ((value < tok_end) && ((' ' == *value) || ('\t' == *value))) {
+            ++value;
+        }
+        while ((tok_end > value) && ((' ' == tok_end[-1]) || ('\t' == tok_end[-1]))) {
+            --tok_end;
+        }
+        if (((size_t)(tok_end - value) == token_len)
+            && equals_ignore_case(value, token, token_len)) {
+            return true;
+        }
+        value = (NULL == comma) ? end : comma + 1;
+    }
+    return false;
+}
+
+
+#define HEADER_NAME_IS(name, name_len, lower_literal)                          \
+    (((name_len) == sizeof lower_literal - 1)                                  \
+     && equals_ignore_case((name), lower_literal, sizeof lower_literal - 1))
+
+
+/** Handles one header line of the HTTP response, @p len characters
+    long, not counting the line end. Header names and values are
+    matched regardless of case, as HTTP requires. The line end (at
+    `line[len]`) is replaced with a NUL, as proxy header handling
+    needs a string.
+
+    @return 0: OK, -1: error (outcome detected)
+ */
+static int handle_header_line(struct pubnub_* pb, char* line, size_t len)
+{
+    char const* end = line + len;
+    char const* colon;
+    char const* value;
+    size_t      name_len;
+
+    line[len] = '\0';
+    while ((end > line) && (('\r' == end[-1]) || (' ' == end[-1]) || ('\t' == end[-1]))) {
+        --end;
+    }
+    colon = (char const*)memchr(line, ':', end - line);
+    if ((NULL == colon) || (' ' == line[0]) || ('\t' == line[0])) {
+        /* Continuation of the previous header line, or garbage */
+        if (pbproxy_handle_http_header(pb, line) != 0) {
+            outcome_detected(pb, PNR_AUTHENTICATION_FAILED);
+            return -1;
+        }
+        return 0;
+    }
+    name_len = colon - line;
+    for (value = colon + 1; (value < end) && ((' ' == *value) || ('\t' == *value));
+         ++value) {
+        continue;
+    }
+
+    if (HEADER_NAME_IS(line, name_len, "content-length")) {
+        unsigned length = 0;
+        for (; (value < end) && isdigit((unsigned char)*value); ++value) {
+            unsigned const digit = *value - '0';
+            if (length > (UINT_MAX - digit) / 10) {
+                PUBNUB_LOG_ERROR("pb=%p Content-Length too big: '%.*s'\n",
+                                 pb,
+                                 (int)(end - colon - 1),
+                                 colon + 1);
+                outcome_detected(pb, PNR_IO_ERROR);
+                return -1;
+            }
+            length = length * 10 + digit;
+        }
+        pb->http_headers.content_length = length;
+        pb->core.http_content_len       = length;
+    }
+    else if (HEADER_NAME_IS(line, name_len, "transfer-encoding")) {
+        pb->http_headers.chunked = has_token(value, end, "chunked");
+    }
+    else if (HEADER_NAME_IS(line, name_len, "connection")) {
+        /* We know that Pubnub will always use keep-alive unless
+           we ask for `close`, so, we only check for `close`.
+        */
+        if (has_token(value, end, "close")) {
+            pb->http_headers.close = true;
+            pb->flags.should_close = true;
+        }
+    }
+    else if (HEADER_NAME_IS(line, name_len, "content-encoding")) {
+        pb->http_headers.gzip = has_token(value, end, "gzip");
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+        if (pb->http_headers.gzip) {
+            pb->data_compressed = compressionGZIP;
+        }
+#endif
+    }
+    else if (pbproxy_handle_http_header(pb, line) != 0) {
+        outcome_detected(pb, PNR_AUTHENTICATION_FAILED);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/** Handles the end of the head of the HTTP response (the empty line
+    after the headers), moving on to reading the body.
+
+    @return 0: go on (to the next state), -1: stop (for now)
+ */
+static int handle_end_of_head(struct pubnub_* pb)
+{
+    pb->core.http_buf_len = 0;
+#if PUBNUB_SUBSCRIBE_STREAMING
+    pb->flags.subscribe_streaming = (PBTT_SUBSCRIBE == pb->trans)
+                                    && (pb->msg_cb != NULL)
+                                    && ((pb->http_code / 100) == 2)
+                                    && !pb->http_headers.gzip;
+    if (pb->flags.subscribe_streaming) {
+        pbcc_subscribe_stream_start(&pb->core);
+    }
+#endif
+    if (!STREAMING_SUBSCRIBE(pb) && !pb->http_headers.chunked
+        && (0 != pbcc_realloc_reply_buffer(&pb->core, pb->core.http_content_len))) {
+        outcome_detected(pb, PNR_REPLY_TOO_BIG);
+        return -1;
+    }
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+    if (GZIP_RESPONSE(pb)) {
+        enum pubnub_res pbres = pbgzip_decompress_start(pb);
+        if (pbres != PNR_OK) {
+            pb->data_compressed = compressionNONE;
+            outcome_detected(pb, pbres);
+            return -1;
+        }
+    }
+#endif
+    if (pb->http_headers.chunked) {
+        pb->state = PBS_RX_CHUNK_LEN;
+        return 0;
+    }
+    if (0 == pb->core.http_content_len) {
+#if PUBNUB_PROXY_API
+        WATCH_ENUM(pb->proxy_type);
+        WATCH_INT(pb->proxy_tunnel_established);
+        if ((pb->proxy_type == pbproxyHTTP_CONNECT) && !pb->proxy_tunnel_established) {
+            return (PNR_OK != finish(pb)) ? -1 : 0;
+        }
+#endif
+        outcome_detected(pb, PNR_IO_ERROR);
+        return -1;
+    }
+    pb->state = PBS_RX_BODY;
+    return 0;
+}
+
+
+/** If the (whole) head of the HTTP response has already been received
+    with the status line, which is usually the case, handles its
+    header lines right where they are in the receive buffer, finding
+    line ends with memchr(), instead of reading them one by one.
+
+    @return 0: done, go on (to the next state), -1: stop (for now),
+    +1: the head was not all received, read the rest line by line
+ */
+static int handle_received_head(struct pubnub_* pb)
+{
+    size_t      len;
+    /* We own the receive buffer, so header lines can be changed */
+    char*       data = (char*)pbpal_unread_data(pb, &len);
+    char*       line = data;
+    char const* end  = data + len;
+
+#if PUBNUB_PROXY_API
+    /* Proxy response headers are rather handled one by one */
+    if (pb->proxy_type != pbproxyNONE) {
+        return +1;
+    }
+#endif
+    if (NULL == data) {
+        return +1;
+    }
+    while (line < end) {
+        char* eol = (char*)memchr(line, '\n', end - line);
+        if (NULL == eol) {
+            break;
+        }
+        if ((eol == line) || ((eol == line + 1) && ('\r' == *line))) {
+            pbpal_skip_unread(pb, eol + 1 - data);
+            return handle_end_of_head(pb);
+        }
+        PUBNUB_LOG_TRACE("pb=%p header line: '%.*s'\n", pb, (int)(eol - line), line);
+        if (handle_header_line(pb, line, eol - line) != 0) {
+            return -1;
+        }
+        line = eol + 1;
+    }
+    pbpal_skip_unread(pb, line - data);
+
+    return +1;
+}
+
+
+/** Returns how many of the @p left octets of the body of the HTTP
+    response (or a chunk of it) to read next. That's all of them,
+    unless the subscribe response is "streamed", when it's no more
+    than SUBSCRIBE_STREAM_READ_LEN (and what fits in a static reply
+    buffer).
+ */
+static size_t body_read_len(struct pubnub_ const* pb, size_t left)
+{
+#if PUBNUB_SUBSCRIBE_STREAMING
+    if (STREAMING_SUBSCRIBE(pb)) {
+#if !PUBNUB_DYNAMIC_REPLY_BUFFER
+        size_t room = sizeof pb->core.http_reply - 1 - pb->core.http_buf_len;
+        if (left > room) {
+            left = room;
+        }
+#endif
+        if (left > SUBSCRIBE_STREAM_READ_LEN) {
+            left = SUBSCRIBE_STREAM_READ_LEN;
+        }
+    }
+#endif
+    return left;
+}
+
+
+#if PUBNUB_SUBSCRIBE_STREAMING
+/** Hands the messages of a "streamed" subscribe response received so
+    far to the message callback and then discards them from the reply
+    buffer, to make room for the rest of the response.
+
+    @return 0: go on, -1: stop (error - outcome detected, or the
+    transaction was canceled from the callback)
+ */
+static int stream_messages(struct pubnub_* pb)
+{
+    enum pubnub_state const state = pb->state;
+    char const*             msg;
+    unsigned                discarded;
+    enum pubnub_res         pbres = pbcc_subscribe_stream_scan(&pb->core);
+
+    if (pbres != PNR_OK) {
+        PUBNUB_LOG_WARNING("pb=%p streamed subscribe response is not valid\n", pb);
+        outcome_detected(pb, pbres);
+        return -1;
+    }
+    while ((msg = pbcc_get_msg(&pb->core)) != NULL) {
+        pb->msg_cb(pb, msg, pb->msg_cb_user_data);
+        if (pb->state != state) {
+            return -1;
+        }
+    }
+    discarded = pbcc_subscribe_stream_compact(&pb->core);
+    if (!pb->http_headers.chunked) {
+        pb->core.http_content_len -= discarded;
+    }
+
+    return 0;
+}
+#endif /* PUBNUB_SUBSCRIBE_STREAMING */
+
+
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+/** Inflates the @p len octets of the gzip-formatted body of the HTTP
+    response (or a chunk of it) that were read into our buffer,
+    appending the inflated data to the reply buffer.
+
+    @return 0: OK, -1: error (outcome detected)
+ */
+static int inflate_body(struct pubnub_* pb, unsigned len)
+{
+    enum pubnub_res pbres =
+        pbgzip_decompress_feed(pb, (uint8_t const*)pb->core.http_buf, len);
+
+    if (pbres != PNR_OK) {
+        pb->data_compressed = compressionNONE;
+        outcome_detected(pb, pbres);
+        return -1;
+    }
+    return 0;
+}
+#endif /* PUBNUB_RECEIVE_GZIP_RESPONSE */
+
+
+/** Starts reading @p n octets of the body of the HTTP response (or a
+    chunk of it) straight into the reply buffer, if the PAL can do
+    that, otherwise into our buffer, to be copied when read. A
+    gzip-formatted body is always read into our buffer, to be inflated
+    into the reply buffer.
+
+    @return 0: started, -1: the reply buffer can't hold them (outcome
+    detected)
+ */
+static int start_read_body(struct pubnub_* pb, size_t n)
+{
+#if PUBNUB_SUBSCRIBE_STREAMING
+    /* A "streamed" reply buffer grows as it goes */
+    if (pb->flags.subscribe_streaming
+        && ((0 == n)
+            || (0 != pbcc_realloc_reply_buffer(&pb->core, pb->core.http_buf_len + n)))) {
+        outcome_detected(pb, PNR_REPLY_TOO_BIG);
+        return -1;
+    }
+#endif
+    if (!GZIP_RESPONSE(pb)
+        && (0 == pbpal_start_read_into(pb, pb->core.http_reply + pb->core.http_buf_len, n))) {
+        pb->flags.read_into_reply = true;
+    }
+    else {
+        pb->flags.read_into_reply = false;
+        pbpal_start_read(pb, n);
+    }
+    return 0;
+}
+
+
 static char const* pbnc_state2str(enum pubnub_state e)
 {
     switch (e) {
@@ -355,6 +997,54 @@ static char const* pbnc_state2str(enum pubnub_state e)
     }
 }
 
+#if PUBNUB_PROXY_API
+/** Saves the path of the URL of the transaction (in the HTTP
+    buffer), to send it again after we talk to the proxy.
+ */
+static int save_proxy_path(struct pubnub_* pb)
+{
+    PUBNUB_ASSERT_OPT(pb->core.http_buf_len < PUBNUB_BUF_MAXLEN);
+#if PUBNUB_BUFFER_POOL
+    if (NULL == pb->proxy_saved_path) {
+        pb->proxy_saved_path = (char*)pbbuf_pool_take(PUBNUB_BUF_MAXLEN);
+        if (NULL == pb->proxy_saved_path) {
+            PUBNUB_LOG_ERROR("pb=%p Failed to take buffer for proxy path\n", pb);
+            return -1;
+        }
+    }
+#endif
+    memcpy(pb->proxy_saved_path, pb->core.http_buf, pb->core.http_buf_len + 1);
+    pb->proxy_saved_path_len = pb->core.http_buf_len;
+
+    return 0;
+}
+#endif /* PUBNUB_PROXY_API */
+
+
+#if PUBNUB_BUFFER_POOL
+void pbnc_give_back_buffers(struct pubnub_* pb)
+{
+#if PUBNUB_CRYPTO_API
+    pbbuf_pool_give(pb->core.encrypted_msg_buf, PUBNUB_BUF_MAXLEN);
+    pb->core.encrypted_msg_buf = NULL;
+#endif
+#if PUBNUB_USE_GZIP_COMPRESSION
+    pbbuf_pool_give(pb->core.gzip_msg_buf, PUBNUB_COMPRESSED_MAXLEN);
+    pb->core.gzip_msg_buf = NULL;
+#endif
+#if PUBNUB_PROXY_API
+    pbbuf_pool_give(pb->proxy_saved_path, PUBNUB_BUF_MAXLEN);
+    pb->proxy_saved_path     = NULL;
+    pb->proxy_saved_path_len = 0;
+    pbbuf_pool_give(pb->ntlm_context.in_token, PUBNUB_NTLM_MAX_TOKEN);
+    pb->ntlm_context.in_token      = NULL;
+    pb->ntlm_context.in_token_size = 0;
+#endif
+    PUBNUB_UNUSED(pb);
+}
+#endif /* PUBNUB_BUFFER_POOL */
+
+
 static void initialize_fields_in_state_IDLE(struct pubnub_* pb)
 {
 #if PUBNUB_CHANGE_DNS_SERVERS
@@ -593,24 +1283,22 @@ next_state:
             }
         }
 #endif /* PUBNUB_USE_SSL */
-        i = pbpal_send_str(pb, pb->flags.is_publish_via_post ? "POST " : "GET ");
+        i = send_request(pb);
         if (i < 0) {
             outcome_detected(pb, PNR_IO_ERROR);
             break;
         }
-        pb->state = PBS_TX_GET;
         goto next_state;
 #if PUBNUB_USE_SSL
     case PBS_WAIT_TLS_CONNECT: {
         enum pbpal_tls_result res = pbpal_check_tls(pb);
         switch (res) {
         case pbtlsEstablished:
-            i = pbpal_send_str(pb, pb->flags.is_publish_via_post ? "POST " : "GET ");
+            i = send_request(pb);
             if (i < 0) {
                 outcome_detected(pb, PNR_IO_ERROR);
                 break;
             }
-            pb->state = PBS_TX_GET;
             goto next_state;
         case pbtlsStarted:
             break;
@@ -651,12 +1339,11 @@ next_state:
                     outcome_detected(pb, PNR_IO_ERROR);
                     break;
                 }
-                PUBNUB_ASSERT_OPT(pb->core.http_buf_len < PUBNUB_BUF_MAXLEN);
                 if (0 == pb->proxy_saved_path_len) {
-                    memcpy(pb->proxy_saved_path,
-                           pb->core.http_buf,
-                           pb->core.http_buf_len + 1);
-                    pb->proxy_saved_path_len = pb->core.http_buf_len;
+                    if (save_proxy_path(pb) != 0) {
+                        outcome_detected(pb, PNR_INTERNAL_ERROR);
+                        break;
+                    }
                 }
                 else {
                     PUBNUB_ASSERT_OPT(pb->proxy_saved_path_len < PUBNUB_BUF_MAXLEN);
@@ -683,12 +1370,9 @@ next_state:
                     break;
                 }
                 if (!pb->proxy_tunnel_established) {
-                    PUBNUB_ASSERT_OPT(pb->core.http_buf_len < PUBNUB_BUF_MAXLEN);
-                    if (0 == pb->proxy_saved_path_len) {
-                        memcpy(pb->proxy_saved_path,
-                               pb->core.http_buf,
-                               pb->core.http_buf_len + 1);
-                        pb->proxy_saved_path_len = pb->core.http_buf_len;
+                    if ((0 == pb->proxy_saved_path_len) && (save_proxy_path(pb) != 0)) {
+                        outcome_detected(pb, PNR_INTERNAL_ERROR);
+                        break;
                     }
                 }
                 else if (pb->proxy_saved_path_len > 0) {
@@ -876,6 +1560,15 @@ next_state:
                 }
             }
             else {
+#if PUBNUB_PUBLISH_PIPELINE
+                i = pipeline_request_sent(pb);
+                if (i < 0) {
+                    break;
+                }
+                else if (0 == i) {
+                    goto next_state;
+                }
+#endif
                 pbpal_start_read_line(pb);
                 pb->state = PBS_RX_HTTP_VER;
                 pbntf_watch_in_events(pb);
@@ -889,6 +1582,15 @@ next_state:
             outcome_detected(pb, PNR_IO_ERROR);
         }
         else if (0 == i) {
+#if PUBNUB_PUBLISH_PIPELINE
+            i = pipeline_request_sent(pb);
+            if (i < 0) {
+                break;
+            }
+            else if (0 == i) {
+                goto next_state;
+            }
+#endif
             pbpal_start_read_line(pb);
             pb->state = PBS_RX_HTTP_VER;
             pbntf_watch_in_events(pb);
@@ -902,6 +1604,13 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK:
+            if (pbpal_read_len(pb) <= 2) {
+                /* Empty line ending the previous (chunked) response,
+                   which we don't read, as we don't need to, unless
+                   responses are pipelined */
+                pbpal_start_read_line(pb);
+                goto next_state;
+            }
             if (strncmp(pb->core.http_buf, "HTTP/1.", 7) != 0) {
                 PUBNUB_LOG_ERROR("pb=%p bad HTTP response version: %.*s\n",
                                  pb,
@@ -913,13 +1622,22 @@ next_state:
             pb->http_code = atoi(pb->core.http_buf + 9);
             WATCH_USHORT(pb->http_code);
             pb->core.http_content_len = 0;
-            pb->http_chunked          = false;
-            pb->state                 = PBS_RX_HEADERS;
+            memset(&pb->http_headers, 0, sizeof pb->http_headers);
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+            pb->data_compressed = compressionNONE;
+#endif
+            pb->state = PBS_RX_HEADERS;
+            if (handle_received_head(pb) < 0) {
+                break;
+            }
             goto next_state;
         case PNR_CONNECTION_TIMEOUT:
         case PNR_TIMEOUT:
         case PNR_IO_ERROR:
             if (pb->flags.started_while_kept_alive) {
+#if PUBNUB_PUBLISH_PIPELINE
+                pipeline_rewind(pb);
+#endif
                 pb->state = close_kept_alive_connection(pb);
                 goto next_state;
             }
@@ -944,16 +1662,6 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK: {
-            /* We know that Pubnub will always use keep-alive unless
-               we ask for `close`, so, we don't check for the
-               `Connection` header.
-            */
-            char h_chunked[] = "Transfer-Encoding: chunked";
-            char h_length[]  = "Content-Length: ";
-            char h_close[]   = "Connection: close";
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-            char h_encoding[] = "Content-Encoding: gzip";
-#endif
             int read_len = pbpal_read_len(pb);
             PUBNUB_LOG_TRACE("pb=%p header line was read: '%.*s'\n",
                              pb,
@@ -961,53 +1669,13 @@ next_state:
                              pb->core.http_buf);
             WATCH_INT(read_len);
             if (read_len <= 2) {
-                pb->core.http_buf_len = 0;
-                if (!pb->http_chunked) {
-                    if (0 == pb->core.http_content_len) {
-#if PUBNUB_PROXY_API
-                        WATCH_ENUM(pb->proxy_type);
-                        WATCH_INT(pb->proxy_tunnel_established);
-                        if ((pb->proxy_type == pbproxyHTTP_CONNECT)
-                            && !pb->proxy_tunnel_established) {
-                            if (PNR_OK != finish(pb)) {
-                                break;
-                            }
-                            goto next_state;
-                        }
-#endif
-                        outcome_detected(pb, PNR_IO_ERROR);
-                        break;
-                    }
-                    pb->state = PBS_RX_BODY;
-                }
-                else {
-                    pb->state = PBS_RX_CHUNK_LEN;
-                }
-                goto next_state;
-            }
-            if (strncmp(pb->core.http_buf, h_chunked, sizeof h_chunked - 1) == 0) {
-                pb->http_chunked = true;
-            }
-            else if (strncmp(pb->core.http_buf, h_length, sizeof h_length - 1) == 0) {
-                size_t len = atoi(pb->core.http_buf + sizeof h_length - 1);
-                if (0 != pbcc_realloc_reply_buffer(&pb->core, len)) {
-                    outcome_detected(pb, PNR_REPLY_TOO_BIG);
+                if (handle_end_of_head(pb) != 0) {
                     break;
                 }
-                pb->core.http_content_len = len;
-            }
-            else if (strncmp(pb->core.http_buf, h_close, sizeof h_close - 1) == 0) {
-                pb->flags.should_close = true;
-            }
-#if PUBNUB_RECEIVE_GZIP_RESPONSE
-            else if (strncmp(pb->core.http_buf, h_encoding, sizeof h_encoding - 1)
-                     == 0) {
-                pb->data_compressed = compressionGZIP;
+                goto next_state;
             }
-#endif
-            else if (pbproxy_handle_http_header(pb, pb->core.http_buf) != 0) {
-                outcome_detected(pb, PNR_AUTHENTICATION_FAILED);
-                return 0;
+            if (handle_header_line(pb, pb->core.http_buf, read_len - 1) != 0) {
+                break;
             }
             pb->state = PBS_RX_HEADERS;
             goto next_state;
@@ -1028,12 +1696,20 @@ next_state:
         break;
     case PBS_RX_BODY:
         if (pb->core.http_buf_len < pb->core.http_content_len) {
-            pbpal_start_read(pb, pb->core.http_content_len - pb->core.http_buf_len);
+            if (start_read_body(
+                    pb,
+                    body_read_len(pb, pb->core.http_content_len - pb->core.http_buf_len))
+                != 0) {
+                break;
+            }
             pb->state = PBS_RX_BODY_WAIT;
             goto next_state;
         }
         else {
-            finish(pb);
+            if (PNR_STARTED == finish(pb)) {
+                /* Publish pipeline goes on */
+                goto next_state;
+            }
 #if PUBNUB_PROXY_API
             if (pb->flags.retry_after_close) {
                 goto next_state;
@@ -1048,14 +1724,41 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK: {
-            unsigned len = pbpal_read_len(pb);
+            unsigned len;
+            if (pb->flags.read_into_reply) {
+                len = body_read_len(pb, pb->core.http_content_len - pb->core.http_buf_len);
+            }
+            else {
+                len = pbpal_read_len(pb);
+                PUBNUB_ASSERT_OPT(pb->core.http_buf_len + len
+                                  <= pb->core.http_content_len);
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+                if (GZIP_RESPONSE(pb)) {
+                    /* What's left to read is the same, though the
+                       reply buffer holds more (inflated) data */
+                    unsigned left =
+                        pb->core.http_content_len - pb->core.http_buf_len - len;
+                    if (inflate_body(pb, len) != 0) {
+                        break;
+                    }
+                    pb->core.http_content_len = pb->core.http_buf_len + left;
+                    pb->state                 = PBS_RX_BODY;
+                    goto next_state;
+                }
+#endif
+                memcpy(pb->core.http_reply + pb->core.http_buf_len,
+                       pb->core.http_buf,
+                       len);
+            }
             WATCH_UINT(len);
             WATCH_SIZE_T(pb->core.http_buf_len);
-            PUBNUB_ASSERT_OPT(pb->core.http_buf_len + len
-                              <= pb->core.http_content_len);
-            memcpy(pb->core.http_reply + pb->core.http_buf_len, pb->core.http_buf, len);
             pb->core.http_buf_len += len;
             pb->state = PBS_RX_BODY;
+#if PUBNUB_SUBSCRIBE_STREAMING
+            if (pb->flags.subscribe_streaming && (stream_messages(pb) != 0)) {
+                break;
+            }
+#endif
             goto next_state;
         }
         default:
@@ -1078,16 +1781,19 @@ next_state:
 
             PUBNUB_LOG_TRACE("About to read a chunk w/length: %u\n", chunk_length);
             if (chunk_length == 0) {
-                finish(pb);
+                if (PNR_STARTED == finish(pb)) {
+                    goto next_state;
+                }
 #if PUBNUB_PROXY_API
                 if (pb->flags.retry_after_close) {
                     goto next_state;
                 }
 #endif
             }
-            else if (0
-                     != pbcc_realloc_reply_buffer(
-                            &pb->core, pb->core.http_buf_len + chunk_length)) {
+            else if (!STREAMING_SUBSCRIBE(pb)
+                     && (0
+                         != pbcc_realloc_reply_buffer(
+                                &pb->core, pb->core.http_buf_len + chunk_length))) {
                 outcome_detected(pb, PNR_REPLY_TOO_BIG);
             }
             else {
@@ -1103,7 +1809,16 @@ next_state:
         }
         break;
     case PBS_RX_BODY_CHUNK:
-        if (pb->core.http_content_len > 0) {
+        if (pb->core.http_content_len > CHUNK_TRAIL_LENGTH) {
+            if (start_read_body(
+                    pb, body_read_len(pb, pb->core.http_content_len - CHUNK_TRAIL_LENGTH))
+                != 0) {
+                break;
+            }
+            pb->state = PBS_RX_BODY_CHUNK_WAIT;
+        }
+        else if (pb->core.http_content_len > 0) {
+            pb->flags.read_into_reply = false;
             pbpal_start_read(pb, pb->core.http_content_len);
             pb->state = PBS_RX_BODY_CHUNK_WAIT;
         }
@@ -1118,8 +1833,23 @@ next_state:
         case PNR_IN_PROGRESS:
             break;
         case PNR_OK: {
-            unsigned len = pbpal_read_len(pb);
+            unsigned len;
 
+            if (pb->flags.read_into_reply) {
+                /* All that was asked for was read (if it's all of the
+                   chunk data, only the trail is left) */
+                len = body_read_len(pb, pb->core.http_content_len - CHUNK_TRAIL_LENGTH);
+                pb->core.http_buf_len += len;
+                pb->core.http_content_len -= len;
+                pb->state = PBS_RX_BODY_CHUNK;
+#if PUBNUB_SUBSCRIBE_STREAMING
+                if (pb->flags.subscribe_streaming && (stream_messages(pb) != 0)) {
+                    break;
+                }
+#endif
+                goto next_state;
+            }
+            len = pbpal_read_len(pb);
             PUBNUB_ASSERT_OPT(pb->core.http_content_len >= len);
             PUBNUB_ASSERT_OPT(len > 0);
 
@@ -1128,13 +1858,28 @@ next_state:
                 if (len < to_copy) {
                     to_copy = len;
                 }
-                memcpy(pb->core.http_reply + pb->core.http_buf_len,
-                       pb->core.http_buf,
-                       to_copy);
-                pb->core.http_buf_len += to_copy;
+#if PUBNUB_RECEIVE_GZIP_RESPONSE
+                if (GZIP_RESPONSE(pb)) {
+                    if (inflate_body(pb, to_copy) != 0) {
+                        break;
+                    }
+                }
+                else
+#endif
+                {
+                    memcpy(pb->core.http_reply + pb->core.http_buf_len,
+                           pb->core.http_buf,
+                           to_copy);
+                    pb->core.http_buf_len += to_copy;
+                }
             }
             pb->core.http_content_len -= len;
             pb->state = PBS_RX_BODY_CHUNK;
+#if PUBNUB_SUBSCRIBE_STREAMING
+            if (pb->flags.subscribe_streaming && (stream_messages(pb) != 0)) {
+                break;
+            }
+#endif
             goto next_state;
         }
         default:
@@ -1199,8 +1944,7 @@ next_state:
             pbntf_trans_outcome(pb, PBS_IDLE);
             break;
         }
-        pb->state = PBS_TX_GET;
-        i = pbpal_send_str(pb, pb->flags.is_publish_via_post ? "POST " : "GET ");
+        i = send_request(pb);
         if (i < 0) {
             pb->state = close_kept_alive_connection(pb);
         }
@@ -134,4 +134,28 @@ void pbnc_stop(struct pubnub_* pb, enum pubnub_res outcome_to_report);
 bool pbnc_can_start_transaction(struct pubnub_ const* pbp);
 
 
+#if PUBNUB_BUFFER_POOL
+/** Gives back to the buffer pool the buffers that @p pb took from it
+    for the transaction, like the one for the compressed message. To
+    be called on the outcome of a transaction and when the context is
+    freed.
+ */
+void pbnc_give_back_buffers(struct pubnub_* pb);
+#else
+#define pbnc_give_back_buffers(pb)
+#endif
+
+
+#if PUBNUB_PUBLISH_PIPELINE
+/** Prepares the request to publish the next message of the publish
+    pipeline of @p pb that is to be sent. Messages whose request can't
+    be prepared get that as their result and are skipped.
+
+    @retval PNR_STARTED prepared, ready to send
+    @return Error of the last message tried, none were prepared
+ */
+enum pubnub_res pbnc_pipeline_prep(struct pubnub_* pb);
+#endif
+
+
 #endif /* !defined INC_PUBNUB_NETCORE */
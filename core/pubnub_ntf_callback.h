@@ -65,6 +65,25 @@ void *pubnub_get_user_data(pubnub_t *pb);
  */
 pubnub_callback_t pubnub_get_callback(pubnub_t *pb);
 
+/** Sets the thread that will process the context @p pb (run its
+    transactions and call its callback), if there is more than one
+    such thread (#PUBNUB_CALLBACK_THREAD_COUNT > 1). By default, the
+    contexts are assigned to threads round-robin, in pubnub_init().
+
+    Can't be changed while a transaction is in progress, nor while
+    the connection is kept alive (until it's closed).
+
+    @param pb The Pubnub context to assign to a thread
+    @param thread_index Index of the thread, must be less than
+    #PUBNUB_CALLBACK_THREAD_COUNT
+
+    @retval PNR_OK success
+    @retval PNR_INVALID_PARAMETERS @p thread_index is out of range
+    @retval PNR_IN_PROGRESS a transaction is in progress or the
+    connection is kept alive
+*/
+enum pubnub_res pubnub_set_thread_affinity(pubnub_t *pb, unsigned thread_index);
+
 
 #endif /* !defined INC_PUBNUB_NTF_CALLBACK */
 
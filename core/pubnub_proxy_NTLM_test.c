@@ -257,6 +257,20 @@ int pbpal_read_len(pubnub_t* pb)
 }
 
 
+char const* pbpal_unread_data(pubnub_t* pb, size_t* len)
+{
+    *len = pb->unreadlen;
+    return (0 == pb->unreadlen) ? NULL : (char const*)pb->ptr;
+}
+
+
+void pbpal_skip_unread(pubnub_t* pb, size_t n)
+{
+    pb->ptr += n;
+    pb->unreadlen -= n;
+}
+
+
 static int my_recv(void* p, size_t n)
 {
     int to_read;
@@ -381,6 +395,15 @@ int pbpal_start_read(pubnub_t* pb, size_t n)
     return +1;
 }
 
+int pbpal_start_read_into(pubnub_t* pb, char* dest, size_t n)
+{
+    /* Reading is simulated with our buffer only */
+    PUBNUB_UNUSED(pb);
+    PUBNUB_UNUSED(dest);
+    PUBNUB_UNUSED(n);
+    return -1;
+}
+
 enum pubnub_res pbpal_read_status(pubnub_t* pb)
 {
     int have_read;
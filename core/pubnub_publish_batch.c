@@ -0,0 +1,438 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "pubnub_publish_batch.h"
+
+#include "pubnub_pubsubapi.h"
+#include "pubnub_coreapi_ex.h"
+#include "pubnub_alloc.h"
+#include "pubnub_free_with_timeout.h"
+#include "pubnub_helper.h"
+#include "pubnub_mutex.h"
+#include "pubnub_assert.h"
+#include "pubnub_log.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/** How many times to retry publishing a batch for which
+    pubnub_should_retry() says it is safe to retry, before reporting
+    it as failed.
+ */
+#define PUBNUB_PUBLISH_BATCH_MAX_RETRIES 3
+
+/** How long to wait for the context to stop, when freeing the
+    batcher, in milliseconds.
+*/
+#define PUBNUB_PUBLISH_BATCH_FREE_TIMEOUT 1000
+
+
+/** A batch of messages */
+struct pbpb_batch {
+    /** The JSON array of the messages, without the closing bracket,
+        until the batch is closed */
+    char* json;
+    /** Length of #json */
+    size_t len;
+    /** Size of the allocation of #json */
+    size_t capacity;
+    /** User data of the messages, to pass to the callback */
+    void** user_data;
+    /** Number of messages in the batch */
+    unsigned count;
+};
+
+
+/** Publish batcher descriptor */
+struct pubnub_publish_batch {
+    /** Callback to call on the outcome of publishing a message */
+    pubnub_publish_batch_callback_t cb;
+    /** The context to publish on */
+    pubnub_t* pb;
+    /** The channel to publish to */
+    char* channel;
+    /** Options of the batcher */
+    struct pubnub_publish_batch_options opts;
+    /** The batch messages are pushed to */
+    pubnub_guarded_by(monitor) struct pbpb_batch fill;
+    /** The batch being published, valid if #in_flight. Only the
+        one that took it can change it until publishing is done. */
+    struct pbpb_batch flight;
+    /** Is a batch being published */
+    pubnub_guarded_by(monitor) bool in_flight;
+    /** Number of times publishing of #flight was retried */
+    unsigned retries;
+    /** Is the publish being started, during which the outcome is
+        handled by the starter, not by the context callback */
+    bool starting;
+    /** Is the batcher being freed */
+    pubnub_guarded_by(monitor) bool stopping;
+    /** Publishes #fill when the linger time of its first message is
+        over */
+    struct pbntf_deferred linger;
+
+#if PUBNUB_THREADSAFE
+    pubnub_mutex_t monitor;
+#endif
+};
+
+
+struct pubnub_publish_batch_options pubnub_publish_batch_defopts(void)
+{
+    struct pubnub_publish_batch_options rslt;
+    rslt.linger_ms    = 5;
+    rslt.max_messages = 100;
+    rslt.max_bytes    = 16384;
+#if PUBNUB_USE_GZIP_COMPRESSION
+    rslt.method = pubnubPublishViaPOSTwithGZIP;
+#else
+    rslt.method = pubnubPublishViaPOST;
+#endif
+    return rslt;
+}
+
+
+/** Appends the @p message, which is @p len long, to the @p batch,
+    leaving room to close it.
+*/
+static int batch_append(struct pbpb_batch*                         batch,
+                        struct pubnub_publish_batch_options const* opts,
+                        char const*                                message,
+                        size_t                                     len,
+                        void*                                      user_data)
+{
+    size_t needed = batch->len + 1 + len + 2;
+
+    if (needed > batch->capacity) {
+        size_t capacity = (needed > opts->max_bytes + 2) ? needed : opts->max_bytes + 2;
+        char*  json     = (char*)realloc(batch->json, capacity);
+        if (NULL == json) {
+            return -1;
+        }
+        batch->json     = json;
+        batch->capacity = capacity;
+    }
+    batch->json[batch->len++] = (0 == batch->count) ? '[' : ',';
+    memcpy(batch->json + batch->len, message, len);
+    batch->len += len;
+    batch->user_data[batch->count++] = user_data;
+
+    return 0;
+}
+
+
+static bool batch_is_full(struct pbpb_batch const*                   batch,
+                          struct pubnub_publish_batch_options const* opts)
+{
+    return (batch->count >= opts->max_messages) || (batch->len + 1 >= opts->max_bytes);
+}
+
+
+/** Takes the batch being filled to be published. Has to be called
+    with the batcher monitor locked, when no batch is being published
+    and there are messages to publish.
+*/
+static void take_batch(pubnub_publish_batch_t* pbb)
+{
+    struct pbpb_batch batch = pbb->flight;
+
+    PUBNUB_ASSERT_OPT(!pbb->in_flight);
+    PUBNUB_ASSERT_OPT(pbb->fill.count > 0);
+
+    pbb->flight = pbb->fill;
+    pbb->flight.json[pbb->flight.len]     = ']';
+    pbb->flight.json[pbb->flight.len + 1] = '\0';
+    pbb->fill      = batch;
+    pbb->in_flight = true;
+    pbb->retries   = 0;
+}
+
+
+static void report(pubnub_publish_batch_t* pbb,
+                   struct pbpb_batch*      batch,
+                   enum pubnub_res         result)
+{
+    unsigned i;
+
+    if (pbb->cb != NULL) {
+        for (i = 0; i < batch->count; ++i) {
+            pbb->cb(pbb, result, batch->user_data[i]);
+        }
+    }
+    batch->len   = 0;
+    batch->count = 0;
+}
+
+
+/** Starts publishing the batch taken to be published. The outcome
+    of a publish that is done before this returns (like a failed DNS
+    request) is returned, rather than handled in the context callback,
+    so that we don't recurse. The context monitor is kept locked, so
+    that the context callback can tell these apart.
+
+    Has to be called with the batcher monitor unlocked, as the context
+    callback locks it with the context monitor locked.
+*/
+static enum pubnub_res start_publish(pubnub_publish_batch_t* pbb)
+{
+    struct pubnub_publish_options opts = pubnub_publish_defopts();
+    enum pubnub_res               rslt;
+
+    opts.method = pbb->opts.method;
+    pubnub_mutex_lock(pbb->pb->monitor);
+    pbb->starting = true;
+    rslt = pubnub_publish_ex(pbb->pb, pbb->channel, pbb->flight.json, opts);
+    pbb->starting = false;
+    pubnub_mutex_unlock(pbb->pb->monitor);
+
+    return rslt;
+}
+
+
+/** Handles the @p result of publishing the batch being published:
+    retries it, or reports it and publishes the next batch, if it has
+    any messages, until a publish is started or there are no more
+    messages.
+
+    Has to be called with the batcher monitor unlocked.
+*/
+static void handle_outcome(pubnub_publish_batch_t* pbb, enum pubnub_res result)
+{
+    for (;;) {
+        bool retry;
+        bool has_next;
+
+        pubnub_mutex_lock(pbb->monitor);
+        if (!pbb->in_flight) {
+            /* Outcome already handled, like on cancel and then free */
+            pubnub_mutex_unlock(pbb->monitor);
+            return;
+        }
+        retry = !pbb->stopping && (pbccTrue == pubnub_should_retry(result))
+                && (pbb->retries < PUBNUB_PUBLISH_BATCH_MAX_RETRIES);
+        if (retry) {
+            ++pbb->retries;
+        }
+        pubnub_mutex_unlock(pbb->monitor);
+
+        if (retry) {
+            PUBNUB_LOG_DEBUG("Publish batcher %p retrying publish of %u "
+                             "messages, result was %d\n",
+                             pbb,
+                             pbb->flight.count,
+                             result);
+        }
+        else {
+            report(pbb, &pbb->flight, result);
+
+            pubnub_mutex_lock(pbb->monitor);
+            pbb->in_flight = false;
+            has_next       = !pbb->stopping && (pbb->fill.count > 0);
+            if (has_next) {
+                take_batch(pbb);
+            }
+            pubnub_mutex_unlock(pbb->monitor);
+            if (!has_next) {
+                return;
+            }
+        }
+        result = start_publish(pbb);
+        if (PNR_STARTED == result) {
+            return;
+        }
+    }
+}
+
+
+static void pbpb_context_callback(pubnub_t*         pb,
+                                  enum pubnub_trans trans,
+                                  enum pubnub_res   result,
+                                  void*             user_data)
+{
+    pubnub_publish_batch_t* pbb = (pubnub_publish_batch_t*)user_data;
+
+    PUBNUB_ASSERT_OPT(pbb != NULL);
+    PUBNUB_ASSERT_OPT(pbb->pb == pb);
+
+    /* Called with the context monitor locked, so if we're starting,
+       it's from start_publish(), on this thread */
+    if ((trans == PBTT_PUBLISH) && !pbb->starting) {
+        handle_outcome(pbb, result);
+    }
+}
+
+
+static void linger_over(struct pbntf_deferred* deferred)
+{
+    pubnub_publish_batch_flush((pubnub_publish_batch_t*)(
+        (char*)deferred - offsetof(struct pubnub_publish_batch, linger)));
+}
+
+
+pubnub_publish_batch_t* pubnub_publish_batch_create(char const* publish_key,
+                                                    char const* subscribe_key,
+                                                    char const* channel,
+                                                    struct pubnub_publish_batch_options opts,
+                                                    pubnub_publish_batch_callback_t cb)
+{
+    pubnub_publish_batch_t* rslt;
+    size_t                  channel_len;
+
+    PUBNUB_ASSERT_OPT(channel != NULL);
+    PUBNUB_ASSERT_OPT(opts.max_messages > 0);
+
+    rslt = (pubnub_publish_batch_t*)calloc(1, sizeof *rslt);
+    if (NULL == rslt) {
+        return NULL;
+    }
+    channel_len   = strlen(channel);
+    rslt->channel = (char*)malloc(channel_len + 1);
+    rslt->fill.user_data   = (void**)malloc(opts.max_messages * sizeof(void*));
+    rslt->flight.user_data = (void**)malloc(opts.max_messages * sizeof(void*));
+    if ((NULL == rslt->channel) || (NULL == rslt->fill.user_data)
+        || (NULL == rslt->flight.user_data)
+        || (NULL == (rslt->pb = pubnub_alloc()))) {
+        PUBNUB_LOG_ERROR("Failed to allocate the publish batcher\n");
+        free(rslt->flight.user_data);
+        free(rslt->fill.user_data);
+        free(rslt->channel);
+        free(rslt);
+        return NULL;
+    }
+    memcpy(rslt->channel, channel, channel_len + 1);
+    rslt->cb        = cb;
+    rslt->opts      = opts;
+    rslt->linger.fn = linger_over;
+    pubnub_mutex_init(rslt->monitor);
+
+    pubnub_init(rslt->pb, publish_key, subscribe_key);
+    pubnub_register_callback(rslt->pb, pbpb_context_callback, rslt);
+
+    return rslt;
+}
+
+
+pubnub_t* pubnub_publish_batch_context(pubnub_publish_batch_t* pbb)
+{
+    PUBNUB_ASSERT_OPT(pbb != NULL);
+    return pbb->pb;
+}
+
+
+enum pubnub_res pubnub_publish_batch_push(pubnub_publish_batch_t* pbb,
+                                          char const*             message,
+                                          void*                   user_data)
+{
+    size_t          len;
+    bool            start = false;
+    bool            arm   = false;
+    enum pubnub_res rslt  = PNR_STARTED;
+
+    PUBNUB_ASSERT_OPT(pbb != NULL);
+    PUBNUB_ASSERT_OPT(message != NULL);
+
+    len = strlen(message);
+
+    pubnub_mutex_lock(pbb->monitor);
+    if (pbb->stopping) {
+        rslt = PNR_CANCELLED;
+    }
+    else {
+        if ((pbb->fill.count > 0)
+            && ((pbb->fill.count >= pbb->opts.max_messages)
+                || (pbb->fill.len + len + 2 > pbb->opts.max_bytes))) {
+            /* Message doesn't fit in the batch */
+            if (pbb->in_flight) {
+                rslt = PNR_IN_PROGRESS;
+            }
+            else {
+                take_batch(pbb);
+                start = true;
+            }
+        }
+        if (PNR_STARTED == rslt) {
+            if (batch_append(&pbb->fill, &pbb->opts, message, len, user_data) != 0) {
+                rslt = PNR_INTERNAL_ERROR;
+            }
+            else if (!pbb->in_flight) {
+                if ((0 == pbb->opts.linger_ms) || batch_is_full(&pbb->fill, &pbb->opts)) {
+                    take_batch(pbb);
+                    start = true;
+                }
+                else if (1 == pbb->fill.count) {
+                    arm = true;
+                }
+            }
+        }
+    }
+    pubnub_mutex_unlock(pbb->monitor);
+
+    if (arm) {
+        pbntf_defer(pbb->pb, &pbb->linger, (int)pbb->opts.linger_ms);
+    }
+    if (start) {
+        enum pubnub_res started = start_publish(pbb);
+        if (started != PNR_STARTED) {
+            handle_outcome(pbb, started);
+        }
+    }
+
+    return rslt;
+}
+
+
+void pubnub_publish_batch_flush(pubnub_publish_batch_t* pbb)
+{
+    bool start;
+
+    PUBNUB_ASSERT_OPT(pbb != NULL);
+
+    pubnub_mutex_lock(pbb->monitor);
+    start = !pbb->stopping && !pbb->in_flight && (pbb->fill.count > 0);
+    if (start) {
+        take_batch(pbb);
+    }
+    pubnub_mutex_unlock(pbb->monitor);
+
+    if (start) {
+        enum pubnub_res rslt = start_publish(pbb);
+        if (rslt != PNR_STARTED) {
+            handle_outcome(pbb, rslt);
+        }
+    }
+}
+
+
+int pubnub_publish_batch_free(pubnub_publish_batch_t* pbb)
+{
+    PUBNUB_ASSERT_OPT(pbb != NULL);
+
+    pubnub_mutex_lock(pbb->monitor);
+    pbb->stopping = true;
+    pubnub_mutex_unlock(pbb->monitor);
+
+    pbntf_cancel_deferred(pbb->pb, &pbb->linger);
+    pubnub_cancel(pbb->pb);
+    if (pubnub_free_with_timeout(pbb->pb, PUBNUB_PUBLISH_BATCH_FREE_TIMEOUT) != 0) {
+        PUBNUB_LOG_ERROR("Failed to free context %p of the publish batcher %p\n",
+                         pbb->pb,
+                         pbb);
+        return -1;
+    }
+
+    if (pbb->in_flight) {
+        report(pbb, &pbb->flight, PNR_CANCELLED);
+    }
+    report(pbb, &pbb->fill, PNR_CANCELLED);
+    pubnub_mutex_destroy(pbb->monitor);
+    free(pbb->flight.json);
+    free(pbb->flight.user_data);
+    free(pbb->fill.json);
+    free(pbb->fill.user_data);
+    free(pbb->channel);
+    free(pbb);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_PUBLISH_BATCH
+#define INC_PUBNUB_PUBLISH_BATCH
+
+
+#include "pubnub_api_types.h"
+
+#include <stdlib.h>
+
+
+/** @file pubnub_publish_batch.h
+
+    This module implements a batching publisher for the callback
+    interface. Messages pushed to it, from any thread, are not
+    published one by one, but collected in a batch, which is published
+    to the channel of the batcher as one message - a JSON array of the
+    messages in it. A batch is published when it is full (by number
+    of messages or size) or when its first message has waited for the
+    "linger" time. While a batch is being published, the next one is
+    collected, and it is published as soon as the first one is done.
+
+    This trades a few milliseconds of latency for (a lot) less
+    transactions, when there are many small messages. Keep in mind
+    that subscribers get the batch, that is, an array of messages.
+*/
+
+
+/** A publish batcher descriptor. An opaque data structure. */
+struct pubnub_publish_batch;
+
+/** A helper typedef of a publish batcher descriptor */
+typedef struct pubnub_publish_batch pubnub_publish_batch_t;
+
+/** Prototype of a function that will be called back for each message
+    of a batch of the batcher @p pbb when publishing of the batch is
+    done, with the @p user_data given when the message was pushed and
+    the final @p result of publishing the batch.
+
+    It is called from the context of the Pubnub FSM (like the
+    callback in the callback interface), so, don't do anything that
+    takes long in it.
+*/
+typedef void (*pubnub_publish_batch_callback_t)(pubnub_publish_batch_t* pbb,
+                                                enum pubnub_res         result,
+                                                void*                   user_data);
+
+/** Options of a publish batcher */
+struct pubnub_publish_batch_options {
+    /** How long can the first message of a batch wait for more
+        messages, in milliseconds. If 0, a batch is published as
+        soon as there is no batch being published.
+    */
+    unsigned linger_ms;
+    /** Max number of messages in a batch, at least 1 */
+    unsigned max_messages;
+    /** Max size of a batch (the JSON array), in octets. A message
+        that is bigger than this is published as a batch of its own.
+    */
+    size_t max_bytes;
+    /** How to publish the batches. If it's `pubnubPublishViaGET`,
+        keep in mind that the batch has to fit in the URL.
+    */
+    enum pubnub_publish_method method;
+};
+
+/** Returns the default options of a publish batcher: `linger_ms =
+    5`, `max_messages = 100`, `max_bytes = 16384` and `method =
+    pubnubPublishViaPOSTwithGZIP` if the library is built with
+    `PUBNUB_USE_GZIP_COMPRESSION`, `pubnubPublishViaPOST` otherwise.
+*/
+struct pubnub_publish_batch_options pubnub_publish_batch_defopts(void);
+
+/** Creates a publish batcher that publishes batches of messages to
+    the @p channel, over a context it owns, initialized with @p
+    publish_key and @p subscribe_key.
+
+    Batches that fail to publish because of an error for which
+    pubnub_should_retry() says it is safe to retry will be retried a
+    few times before they are reported as failed.
+
+    @param publish_key The publish key to use for the context
+    @param subscribe_key The subscribe key to use for the context
+    @param channel The channel to publish to, is copied
+    @param opts The options of the batcher
+    @param cb Function to call for each message when its batch is
+    published (or fails)
+
+    @retval NULL Failed to create the batcher
+    @return The publish batcher created
+*/
+pubnub_publish_batch_t* pubnub_publish_batch_create(char const* publish_key,
+                                                    char const* subscribe_key,
+                                                    char const* channel,
+                                                    struct pubnub_publish_batch_options opts,
+                                                    pubnub_publish_batch_callback_t cb);
+
+/** Returns the context of the publish batcher @p pbb. Use it to set
+    options on the context (like the UUID, auth or transaction
+    timeout) before you push any messages. Don't start transactions on
+    it, nor change its callback.
+*/
+pubnub_t* pubnub_publish_batch_context(pubnub_publish_batch_t* pbb);
+
+/** Pushes the (JSON) @p message to the publish batcher @p pbb. It is
+    copied, so you don't need to keep it. The @p user_data is passed
+    to the callback of the batcher when publishing of the batch that
+    the message is in is done. Thread-safe.
+
+    @retval PNR_STARTED Message will be published, the callback will be
+    called with the result
+    @retval PNR_IN_PROGRESS Batch is full and the previous one is still
+    being published, try again later
+    @retval PNR_CANCELLED Batcher is being freed
+    @retval PNR_INTERNAL_ERROR Out of memory
+*/
+enum pubnub_res pubnub_publish_batch_push(pubnub_publish_batch_t* pbb,
+                                          char const*             message,
+                                          void*                   user_data);
+
+/** Publishes the messages pushed to the publish batcher @p pbb
+    without waiting for the linger time, unless a batch is being
+    published, in which case they are published as soon as it's done.
+    Thread-safe.
+*/
+void pubnub_publish_batch_flush(pubnub_publish_batch_t* pbb);
+
+/** Frees the publish batcher @p pbb. Publishing that is in progress
+    is cancelled, and the callback is called with PNR_CANCELLED for
+    those messages and all the messages waiting in the batcher (use
+    pubnub_publish_batch_flush() and wait for the callbacks if you
+    don't want this). The context of the batcher is freed.
+
+    Don't call from the callback of the batcher.
+
+    @retval 0 Freed
+    @retval -1 The context could not be stopped in a reasonable time,
+    so the batcher was _not_ freed
+*/
+int pubnub_publish_batch_free(pubnub_publish_batch_t* pbb);
+
+
+#endif /* !defined INC_PUBNUB_PUBLISH_BATCH */
@@ -0,0 +1,465 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_publish_batch.h"
+
+#include "pubnub_alloc.h"
+#include "pubnub_pubsubapi.h"
+#include "pubnub_coreapi_ex.h"
+#include "pubnub_ntf_callback.h"
+#include "pubnub_free_with_timeout.h"
+#include "pubnub_helper.h"
+#include "pubnub_assert.h"
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+#define streqs is_equal_to_string
+
+
+#define MAX_LOG 20
+
+/* The context of the batcher, with what the batcher did to it */
+static struct pubnub_    m_pb;
+static bool              m_allocated;
+static pubnub_callback_t m_cb;
+static void*             m_user_data;
+/* Is a publish "in progress" on the context */
+static bool m_publishing;
+
+/* What pubnub_publish_ex() returns next, if not PNR_STARTED */
+static enum pubnub_res m_publish_result;
+/* Batches published, in the order they were published */
+static char     m_published[MAX_LOG][64];
+static unsigned m_published_count;
+/* Messages (user data) reported to the batcher callback, with
+   their results */
+static char const*     m_reported[MAX_LOG];
+static enum pubnub_res m_reported_result[MAX_LOG];
+static unsigned        m_reported_count;
+
+/* The deferred call of the batcher, as the watcher thread would
+   see it */
+static struct pbntf_deferred* m_deferred;
+static int                    m_defer_delay_ms;
+static unsigned               m_defer_count;
+
+
+/* Functions of the Pubnub API the batcher uses */
+
+pubnub_t* pubnub_alloc(void)
+{
+    if (m_allocated) {
+        return NULL;
+    }
+    memset(&m_pb, 0, sizeof m_pb);
+    m_allocated = true;
+    return &m_pb;
+}
+
+
+pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscribe_key)
+{
+    PUBNUB_UNUSED(publish_key);
+    PUBNUB_UNUSED(subscribe_key);
+    return p;
+}
+
+
+enum pubnub_res pubnub_register_callback(pubnub_t* pb, pubnub_callback_t cb, void* user_data)
+{
+    attest(pb, equals(&m_pb));
+    m_cb        = cb;
+    m_user_data = user_data;
+    return PNR_OK;
+}
+
+
+struct pubnub_publish_options pubnub_publish_defopts(void)
+{
+    struct pubnub_publish_options rslt;
+    memset(&rslt, 0, sizeof rslt);
+    rslt.store  = true;
+    rslt.method = pubnubPublishViaGET;
+    return rslt;
+}
+
+
+enum pubnub_res pubnub_publish_ex(pubnub_t*                     p,
+                                  const char*                   channel,
+                                  const char*                   message,
+                                  struct pubnub_publish_options opts)
+{
+    enum pubnub_res rslt = m_publish_result;
+
+    attest(p, equals(&m_pb));
+    attest(channel, streqs("ch"));
+    attest(opts.method, equals(pubnubPublishViaPOST));
+    attest(m_publishing, equals(false));
+    if (m_published_count < MAX_LOG) {
+        strcpy(m_published[m_published_count++], message);
+    }
+    if (rslt != PNR_STARTED) {
+        m_publish_result = PNR_STARTED;
+        return rslt;
+    }
+    m_publishing = true;
+
+    return PNR_STARTED;
+}
+
+
+/* Finishes the publish in progress with @p result, like the FSM
+   would */
+static void finish(enum pubnub_res result)
+{
+    attest(m_publishing, equals(true));
+    m_publishing = false;
+    m_cb(&m_pb, PBTT_PUBLISH, result, m_user_data);
+}
+
+
+enum pubnub_cancel_res pubnub_cancel(pubnub_t* p)
+{
+    attest(p, equals(&m_pb));
+    if (m_publishing) {
+        finish(PNR_CANCELLED);
+    }
+    return PN_CANCEL_FINISHED;
+}
+
+
+int pubnub_free_with_timeout(pubnub_t* pbp, unsigned millisec)
+{
+    PUBNUB_UNUSED(millisec);
+    attest(pbp, equals(&m_pb));
+    attest(m_publishing, equals(false));
+    m_allocated = false;
+    return 0;
+}
+
+
+enum pubnub_tribool pubnub_should_retry(enum pubnub_res e)
+{
+    return (PNR_TIMEOUT == e) ? pbccTrue : pbccFalse;
+}
+
+
+void pbntf_defer(pubnub_t* pb, struct pbntf_deferred* deferred, int delay_ms)
+{
+    attest(pb, equals(&m_pb));
+    attest(deferred->fn, differs(NULL));
+    m_deferred       = deferred;
+    m_defer_delay_ms = delay_ms;
+    deferred->armed  = true;
+    ++m_defer_count;
+}
+
+
+void pbntf_cancel_deferred(pubnub_t* pb, struct pbntf_deferred* deferred)
+{
+    attest(pb, equals(&m_pb));
+    deferred->armed     = false;
+    deferred->in_flight = false;
+    if (m_deferred == deferred) {
+        m_deferred = NULL;
+    }
+}
+
+
+/* The linger time is over, makes the deferred call, like the
+   watcher thread would */
+static void linger_over(void)
+{
+    struct pbntf_deferred* deferred = m_deferred;
+
+    attest(deferred, differs(NULL));
+    attest(deferred->armed, equals(true));
+    deferred->armed     = false;
+    deferred->in_flight = true;
+    deferred->fn(deferred);
+    if (m_deferred == deferred) {
+        deferred->in_flight = false;
+    }
+}
+
+
+static bool linger_armed(void)
+{
+    return (m_deferred != NULL) && m_deferred->armed;
+}
+
+
+static void batch_callback(pubnub_publish_batch_t* pbb,
+                           enum pubnub_res         result,
+                           void*                   user_data)
+{
+    PUBNUB_UNUSED(pbb);
+    if (m_reported_count < MAX_LOG) {
+        m_reported_result[m_reported_count] = result;
+        m_reported[m_reported_count++]      = (char const*)user_data;
+    }
+}
+
+
+static pubnub_publish_batch_t* create(unsigned linger_ms, unsigned max_messages, size_t max_bytes)
+{
+    struct pubnub_publish_batch_options opts = pubnub_publish_batch_defopts();
+    pubnub_publish_batch_t*             pbb;
+
+    opts.linger_ms    = linger_ms;
+    opts.max_messages = max_messages;
+    opts.max_bytes    = max_bytes;
+    opts.method       = pubnubPublishViaPOST;
+    pbb = pubnub_publish_batch_create("pub", "sub", "ch", opts, batch_callback);
+    attest(pbb, differs(NULL));
+    attest(pubnub_publish_batch_context(pbb), equals(&m_pb));
+
+    return pbb;
+}
+
+
+static enum pubnub_res push(pubnub_publish_batch_t* pbb, char const* message)
+{
+    return pubnub_publish_batch_push(pbb, message, (void*)message);
+}
+
+
+Describe(pubnub_publish_batch);
+
+
+BeforeEach(pubnub_publish_batch) {
+    m_allocated       = false;
+    m_publishing      = false;
+    m_publish_result  = PNR_STARTED;
+    m_published_count = 0;
+    m_reported_count  = 0;
+    m_deferred        = NULL;
+    m_defer_delay_ms  = 0;
+    m_defer_count     = 0;
+}
+
+
+AfterEach(pubnub_publish_batch) {
+    attest(m_allocated, equals(false));
+}
+
+
+Ensure(pubnub_publish_batch, publishes_when_linger_time_is_over) {
+    pubnub_publish_batch_t* pbb = create(10, 10, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    attest(m_published_count, equals(0));
+    attest(linger_armed(), equals(true));
+    attest(m_defer_count, equals(1));
+    attest(m_defer_delay_ms, equals(10));
+
+    linger_over();
+    attest(m_published_count, equals(1));
+    attest(m_published[0], streqs("[1,2]"));
+
+    finish(PNR_OK);
+    attest(m_reported_count, equals(2));
+    attest(m_reported[0], streqs("1"));
+    attest(m_reported[1], streqs("2"));
+    attest(m_reported_result[0], equals(PNR_OK));
+    attest(m_reported_result[1], equals(PNR_OK));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+    attest(m_reported_count, equals(2));
+}
+
+
+Ensure(pubnub_publish_batch, full_batch_does_not_wait_for_linger) {
+    pubnub_publish_batch_t* pbb = create(10, 2, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    attest(m_published_count, equals(1));
+    attest(m_published[0], streqs("[1,2]"));
+
+    /* The linger time of the published batch is over, nothing to do */
+    linger_over();
+    attest(m_published_count, equals(1));
+
+    finish(PNR_OK);
+    attest(m_reported_count, equals(2));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, message_that_does_not_fit_flushes_the_batch) {
+    pubnub_publish_batch_t* pbb = create(10, 10, 8);
+
+    attest(push(pbb, "\"ab\""), equals(PNR_STARTED));
+    attest(m_published_count, equals(0));
+    attest(push(pbb, "\"cd\""), equals(PNR_STARTED));
+    attest(m_published_count, equals(1));
+    attest(m_published[0], streqs("[\"ab\"]"));
+
+    finish(PNR_OK);
+    attest(m_published_count, equals(2));
+    attest(m_published[1], streqs("[\"cd\"]"));
+    finish(PNR_OK);
+    attest(m_reported_count, equals(2));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, zero_linger_publishes_right_away) {
+    pubnub_publish_batch_t* pbb = create(0, 10, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    attest(m_published_count, equals(1));
+    attest(m_defer_count, equals(0));
+    finish(PNR_OK);
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, linger_is_rearmed_for_the_next_batch) {
+    pubnub_publish_batch_t* pbb = create(10, 10, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    linger_over();
+    attest(m_published[0], streqs("[1]"));
+    finish(PNR_OK);
+    attest(linger_armed(), equals(false));
+
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    attest(m_defer_count, equals(2));
+    attest(linger_armed(), equals(true));
+    attest(m_published_count, equals(1));
+    linger_over();
+    attest(m_published_count, equals(2));
+    attest(m_published[1], streqs("[2]"));
+    finish(PNR_OK);
+
+    attest(m_reported_count, equals(2));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, messages_pushed_while_publishing_go_in_the_next_batch) {
+    pubnub_publish_batch_t* pbb = create(10, 2, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    linger_over();
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    attest(push(pbb, "3"), equals(PNR_STARTED));
+    attest(push(pbb, "4"), equals(PNR_IN_PROGRESS));
+    attest(m_published_count, equals(1));
+
+    finish(PNR_OK);
+    attest(m_published_count, equals(2));
+    attest(m_published[1], streqs("[2,3]"));
+    finish(PNR_OK);
+
+    attest(m_reported_count, equals(3));
+    attest(m_reported[2], streqs("3"));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, flush_does_not_wait_for_linger) {
+    pubnub_publish_batch_t* pbb = create(10, 10, 1000);
+
+    pubnub_publish_batch_flush(pbb);
+    attest(m_published_count, equals(0));
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    pubnub_publish_batch_flush(pbb);
+    attest(m_published_count, equals(1));
+    attest(m_published[0], streqs("[1]"));
+
+    /* Already published */
+    linger_over();
+    attest(m_published_count, equals(1));
+    finish(PNR_OK);
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, retries_then_reports_failure) {
+    pubnub_publish_batch_t* pbb = create(0, 10, 1000);
+    unsigned                i;
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    for (i = 0; i < 3; ++i) {
+        finish(PNR_TIMEOUT);
+        attest(m_published_count, equals(i + 2));
+        attest(m_reported_count, equals(0));
+    }
+    finish(PNR_TIMEOUT);
+    attest(m_reported_count, equals(1));
+    attest(m_reported_result[0], equals(PNR_TIMEOUT));
+
+    /* Errors that are not safe to retry are reported right away */
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    finish(PNR_PUBLISH_FAILED);
+    attest(m_reported_count, equals(2));
+    attest(m_reported_result[1], equals(PNR_PUBLISH_FAILED));
+    attest(m_published_count, equals(5));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, failure_to_start_is_reported) {
+    pubnub_publish_batch_t* pbb = create(10, 10, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    m_publish_result = PNR_ADDR_RESOLUTION_FAILED;
+    linger_over();
+    attest(m_reported_count, equals(1));
+    attest(m_reported_result[0], equals(PNR_ADDR_RESOLUTION_FAILED));
+    attest(m_publishing, equals(false));
+
+    /* Nothing in flight, so a new batch lingers again */
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    attest(linger_armed(), equals(true));
+    linger_over();
+    finish(PNR_OK);
+    attest(m_reported_count, equals(2));
+    attest(m_reported_result[1], equals(PNR_OK));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+}
+
+
+Ensure(pubnub_publish_batch, free_cancels_linger_and_pending_messages) {
+    pubnub_publish_batch_t* pbb = create(10, 1, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    attest(push(pbb, "2"), equals(PNR_STARTED));
+    attest(m_published_count, equals(1));
+
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+    attest(linger_armed(), equals(false));
+    attest(m_published_count, equals(1));
+    attest(m_reported_count, equals(2));
+    attest(m_reported[0], streqs("1"));
+    attest(m_reported[1], streqs("2"));
+    attest(m_reported_result[0], equals(PNR_CANCELLED));
+    attest(m_reported_result[1], equals(PNR_CANCELLED));
+}
+
+
+Ensure(pubnub_publish_batch, free_while_lingering_cancels_the_deferred_call) {
+    pubnub_publish_batch_t* pbb = create(10, 10, 1000);
+
+    attest(push(pbb, "1"), equals(PNR_STARTED));
+    attest(linger_armed(), equals(true));
+    attest(pubnub_publish_batch_free(pbb), equals(0));
+    attest(m_deferred, equals(NULL));
+    attest(m_published_count, equals(0));
+    attest(m_reported_count, equals(1));
+    attest(m_reported_result[0], equals(PNR_CANCELLED));
+}
@@ -0,0 +1,73 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_PUBLISH_PIPELINE
+#define INC_PUBNUB_PUBLISH_PIPELINE
+
+
+#include "pubnub_api_types.h"
+
+
+/** @file pubnub_publish_pipeline.h
+
+    API for publishing several messages in one transaction, with
+    their requests sent one after the other on the same (kept alive)
+    connection, without waiting for the response to the previous one
+    ("HTTP pipelining"). Responses are received in the same order as
+    requests are sent. This way, publishing N messages takes about one
+    round-trip, rather than N round-trips.
+*/
+
+#if !PUBNUB_PUBLISH_PIPELINE
+#error This API is only supported if PUBNUB_PUBLISH_PIPELINE macro constant is 'true'
+#endif
+
+#if !defined PUBNUB_PUBLISH_PIPELINE_MAX
+/** The maximum number of messages in a publish pipeline */
+#define PUBNUB_PUBLISH_PIPELINE_MAX 16
+#endif
+
+
+/** Publishes the @p count @p messages on the @p channel, using the
+    publish @p method, in one transaction, with requests pipelined.
+
+    The @p messages (array and the strings) have to be valid until
+    the transaction is over.
+
+    If the connection is lost (or closed by the server) while there
+    are requests in the pipeline that were not responded to, they are
+    sent again, but one by one, each after the response to the
+    previous one is received. Keep in mind that the server might have
+    processed some of those, so they might get published twice.
+
+    The outcome of the transaction is PNR_OK if all the messages are
+    published, otherwise it is the result of the first message that
+    failed. To get the result for each message, use
+    pubnub_publish_pipeline_result(). Use pubnub_last_publish_result()
+    to get the response to the last message.
+
+    @param p The Pubnub context. Can't be NULL.
+    @param channel The string with the channel to publish to
+    @param messages The array of messages to publish, in JSON
+    @param count The number of @p messages, no more than
+    #PUBNUB_PUBLISH_PIPELINE_MAX
+    @param method The publish method (GET, POST or POST with GZIP)
+
+    @return #PNR_STARTED on success, an error otherwise
+*/
+enum pubnub_res pubnub_publish_pipelined(pubnub_t*                  p,
+                                         const char*                channel,
+                                         char const* const*         messages,
+                                         unsigned                   count,
+                                         enum pubnub_publish_method method);
+
+/** Returns the result of publishing the message at @p index of the
+    last publish pipeline (pubnub_publish_pipelined()) on the context
+    @p p. For messages that didn't get a response (like when the
+    transaction timed out), that's the outcome of the transaction.
+
+    @retval PNR_INVALID_PARAMETERS @p index out of range
+    @return The result of publishing the message
+*/
+enum pubnub_res pubnub_publish_pipeline_result(pubnub_t* p, unsigned index);
+
+
+#endif /* !defined INC_PUBNUB_PUBLISH_PIPELINE */
@@ -0,0 +1,383 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "pubnub_publish_queue.h"
+
+#include "pubnub_pubsubapi.h"
+#include "pubnub_alloc.h"
+#include "pubnub_free_with_timeout.h"
+#include "pubnub_helper.h"
+#include "pubnub_mutex.h"
+#include "pubnub_assert.h"
+#include "pubnub_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/** How many times to retry publishing a message for which
+    pubnub_should_retry() says it is safe to retry, before reporting
+    it as failed.
+ */
+#define PUBNUB_PUBLISH_QUEUE_MAX_RETRIES 3
+
+/** How long to wait for a context of the pool to stop, when
+    freeing the queue, in milliseconds.
+*/
+#define PUBNUB_PUBLISH_QUEUE_FREE_TIMEOUT 1000
+
+
+/** A message in the publish queue */
+struct pbpq_message {
+    /** Channel and message, in one allocation: "channel\0message\0" */
+    char* channel;
+    /** Points to the message, in the allocation of #channel */
+    char const* message;
+    /** User data to pass to the callback */
+    void* user_data;
+};
+
+
+/** A context in the pool of the publish queue */
+struct pbpq_slot {
+    /** The context */
+    pubnub_t* pb;
+    /** The queue this slot belongs to */
+    struct pubnub_publish_queue* pq;
+    /** The message being published, valid if #busy */
+    struct pbpq_message msg;
+    /** Number of times publishing of #msg was retried */
+    unsigned retries;
+    /** Is a message being published on the context */
+    bool busy;
+    /** Is the publish being started, during which the outcome is
+        handled by the starter, not by the context callback */
+    bool starting;
+};
+
+
+/** Publish queue descriptor */
+struct pubnub_publish_queue {
+    /** Callback to call on the outcome of publishing a message */
+    pubnub_publish_queue_callback_t cb;
+    /** The pool of contexts */
+    pubnub_guarded_by(monitor) struct pbpq_slot* pool;
+    /** Number of contexts in the #pool */
+    unsigned pool_size;
+    /** The ring of messages waiting to be published */
+    pubnub_guarded_by(monitor) struct pbpq_message* ring;
+    /** Max number of messages in the #ring */
+    unsigned capacity;
+    /** Index of the first (oldest) message in the #ring */
+    pubnub_guarded_by(monitor) unsigned head;
+    /** Number of messages in the #ring */
+    pubnub_guarded_by(monitor) unsigned count;
+    /** Is the queue being freed */
+    pubnub_guarded_by(monitor) bool stopping;
+
+#if PUBNUB_THREADSAFE
+    pubnub_mutex_t monitor;
+#endif
+};
+
+
+static bool ring_get(pubnub_publish_queue_t* pq, struct pbpq_message* msg)
+{
+    if (0 == pq->count) {
+        return false;
+    }
+    *msg     = pq->ring[pq->head];
+    pq->head = (pq->head + 1) % pq->capacity;
+    --pq->count;
+    return true;
+}
+
+
+static void report(pubnub_publish_queue_t*    pq,
+                   struct pbpq_message const* msg,
+                   enum pubnub_res            result)
+{
+    if (pq->cb != NULL) {
+        pq->cb(pq, msg->channel, msg->message, result, msg->user_data);
+    }
+    free(msg->channel);
+}
+
+
+/** Starts publishing the message of the @p slot. The outcome of
+    a publish that is done before this returns (like a failed DNS
+    request) is returned, rather than handled in the context callback,
+    so that we don't recurse. The context monitor is kept locked, so
+    that the context callback can tell these apart.
+
+    Has to be called with the queue monitor unlocked, as the context
+    callback locks it with the context monitor locked.
+*/
+static enum pubnub_res start_publish(struct pbpq_slot* slot)
+{
+    enum pubnub_res rslt;
+
+    pubnub_mutex_lock(slot->pb->monitor);
+    slot->starting = true;
+    rslt = pubnub_publish(slot->pb, slot->msg.channel, slot->msg.message);
+    slot->starting = false;
+    pubnub_mutex_unlock(slot->pb->monitor);
+
+    return rslt;
+}
+
+
+/** Handles the @p result of publishing the message of the @p slot:
+    retries it, or reports it and publishes the next message from the
+    queue, if there is one, until a publish is started or there are no
+    more messages.
+
+    Has to be called with the queue monitor unlocked.
+*/
+static void handle_outcome(struct pbpq_slot* slot, enum pubnub_res result)
+{
+    pubnub_publish_queue_t* pq = slot->pq;
+
+    for (;;) {
+        struct pbpq_message done;
+        bool                retry;
+        bool                has_next = false;
+
+        pubnub_mutex_lock(pq->monitor);
+        if (!slot->busy) {
+            /* Outcome already handled, like on cancel and then free */
+            pubnub_mutex_unlock(pq->monitor);
+            return;
+        }
+        retry = !pq->stopping && (pbccTrue == pubnub_should_retry(result))
+                && (slot->retries < PUBNUB_PUBLISH_QUEUE_MAX_RETRIES);
+        if (retry) {
+            ++slot->retries;
+        }
+        else {
+            done     = slot->msg;
+            has_next = !pq->stopping && ring_get(pq, &slot->msg);
+            if (has_next) {
+                slot->retries = 0;
+            }
+            else {
+                slot->busy = false;
+            }
+        }
+        pubnub_mutex_unlock(pq->monitor);
+
+        if (retry) {
+            PUBNUB_LOG_DEBUG("Publish queue %p retrying publish on context "
+                             "%p, result was %d\n",
+                             pq,
+                             slot->pb,
+                             result);
+            result = start_publish(slot);
+        }
+        else {
+            report(pq, &done, result);
+            if (!has_next) {
+                return;
+            }
+            result = start_publish(slot);
+        }
+        if (PNR_STARTED == result) {
+            return;
+        }
+    }
+}
+
+
+static void pbpq_context_callback(pubnub_t*         pb,
+                                  enum pubnub_trans trans,
+                                  enum pubnub_res   result,
+                                  void*             user_data)
+{
+    struct pbpq_slot* slot = (struct pbpq_slot*)user_data;
+
+    PUBNUB_ASSERT_OPT(slot != NULL);
+    PUBNUB_ASSERT_OPT(slot->pb == pb);
+
+    /* Called with the context monitor locked, so if we're starting,
+       it's from start_publish(), on this thread */
+    if ((trans == PBTT_PUBLISH) && !slot->starting) {
+        handle_outcome(slot, result);
+    }
+}
+
+
+pubnub_publish_queue_t* pubnub_publish_queue_create(char const* publish_key,
+                                                    char const* subscribe_key,
+                                                    unsigned    pool_size,
+                                                    unsigned    capacity,
+                                                    pubnub_publish_queue_callback_t cb)
+{
+    unsigned                i;
+    pubnub_publish_queue_t* rslt;
+
+    PUBNUB_ASSERT_OPT(pool_size > 0);
+
+    rslt = (pubnub_publish_queue_t*)malloc(sizeof *rslt);
+    if (NULL == rslt) {
+        return NULL;
+    }
+    rslt->pool = (struct pbpq_slot*)calloc(pool_size, sizeof rslt->pool[0]);
+    rslt->ring = (struct pbpq_message*)malloc(
+        (capacity > 0 ? capacity : 1) * sizeof rslt->ring[0]);
+    if ((NULL == rslt->pool) || (NULL == rslt->ring)) {
+        free(rslt->ring);
+        free(rslt->pool);
+        free(rslt);
+        return NULL;
+    }
+    rslt->cb        = cb;
+    rslt->pool_size = pool_size;
+    rslt->capacity  = capacity;
+    rslt->head      = 0;
+    rslt->count     = 0;
+    rslt->stopping  = false;
+    pubnub_mutex_init(rslt->monitor);
+
+    for (i = 0; i < pool_size; ++i) {
+        struct pbpq_slot* slot = rslt->pool + i;
+        slot->pq               = rslt;
+        slot->pb               = pubnub_alloc();
+        if (NULL == slot->pb) {
+            PUBNUB_LOG_ERROR("Failed to allocate context %u of %u for "
+                             "the publish queue\n",
+                             i,
+                             pool_size);
+            pubnub_publish_queue_free(rslt);
+            return NULL;
+        }
+        pubnub_init(slot->pb, publish_key, subscribe_key);
+        pubnub_register_callback(slot->pb, pbpq_context_callback, slot);
+    }
+
+    return rslt;
+}
+
+
+pubnub_t* pubnub_publish_queue_context(pubnub_publish_queue_t* pq, unsigned index)
+{
+    PUBNUB_ASSERT_OPT(pq != NULL);
+    return (index < pq->pool_size) ? pq->pool[index].pb : NULL;
+}
+
+
+enum pubnub_res pubnub_publish_queue_push(pubnub_publish_queue_t* pq,
+                                          char const*             channel,
+                                          char const*             message,
+                                          void*                   user_data)
+{
+    struct pbpq_message msg;
+    struct pbpq_slot*   slot = NULL;
+    size_t              channel_len;
+    size_t              message_len;
+    enum pubnub_res     rslt = PNR_STARTED;
+    unsigned            i;
+
+    PUBNUB_ASSERT_OPT(pq != NULL);
+    PUBNUB_ASSERT_OPT(message != NULL);
+
+    if ((NULL == channel) || ('\0' == *channel)) {
+        return PNR_INVALID_CHANNEL;
+    }
+    channel_len = strlen(channel);
+    message_len = strlen(message);
+    msg.channel = (char*)malloc(channel_len + message_len + 2);
+    if (NULL == msg.channel) {
+        return PNR_INTERNAL_ERROR;
+    }
+    memcpy(msg.channel, channel, channel_len + 1);
+    memcpy(msg.channel + channel_len + 1, message, message_len + 1);
+    msg.message   = msg.channel + channel_len + 1;
+    msg.user_data = user_data;
+
+    pubnub_mutex_lock(pq->monitor);
+    if (pq->stopping) {
+        rslt = PNR_CANCELLED;
+    }
+    else {
+        for (i = 0; i < pq->pool_size; ++i) {
+            if (!pq->pool[i].busy) {
+                slot = pq->pool + i;
+                break;
+            }
+        }
+        if (slot != NULL) {
+            slot->busy    = true;
+            slot->retries = 0;
+            slot->msg     = msg;
+        }
+        else if (pq->count < pq->capacity) {
+            pq->ring[(pq->head + pq->count) % pq->capacity] = msg;
+            ++pq->count;
+        }
+        else {
+            rslt = PNR_IN_PROGRESS;
+        }
+    }
+    pubnub_mutex_unlock(pq->monitor);
+
+    if (NULL == slot) {
+        if (rslt != PNR_STARTED) {
+            free(msg.channel);
+        }
+        return rslt;
+    }
+    rslt = start_publish(slot);
+    if (rslt != PNR_STARTED) {
+        handle_outcome(slot, rslt);
+    }
+
+    return PNR_STARTED;
+}
+
+
+int pubnub_publish_queue_free(pubnub_publish_queue_t* pq)
+{
+    struct pbpq_message msg;
+    unsigned            i;
+    int                 rslt = 0;
+
+    PUBNUB_ASSERT_OPT(pq != NULL);
+
+    pubnub_mutex_lock(pq->monitor);
+    pq->stopping = true;
+    pubnub_mutex_unlock(pq->monitor);
+
+    for (i = 0; i < pq->pool_size; ++i) {
+        if (pq->pool[i].pb != NULL) {
+            pubnub_cancel(pq->pool[i].pb);
+        }
+    }
+    for (i = 0; i < pq->pool_size; ++i) {
+        if (pq->pool[i].pb != NULL) {
+            if (0 == pubnub_free_with_timeout(
+                         pq->pool[i].pb, PUBNUB_PUBLISH_QUEUE_FREE_TIMEOUT)) {
+                pq->pool[i].pb = NULL;
+            }
+            else {
+                PUBNUB_LOG_ERROR("Failed to free context %p of the publish "
+                                 "queue %p\n",
+                                 pq->pool[i].pb,
+                                 pq);
+                rslt = -1;
+            }
+        }
+    }
+    if (rslt != 0) {
+        return rslt;
+    }
+
+    while (ring_get(pq, &msg)) {
+        report(pq, &msg, PNR_CANCELLED);
+    }
+    pubnub_mutex_destroy(pq->monitor);
+    free(pq->ring);
+    free(pq->pool);
+    free(pq);
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_PUBLISH_QUEUE
+#define INC_PUBNUB_PUBLISH_QUEUE
+
+
+#include "pubnub_api_types.h"
+
+
+/** @file pubnub_publish_queue.h
+
+    This module implements a publish queue for the callback
+    interface. Messages are put in a (bounded) queue, from any thread,
+    and published over a pool of contexts that it owns, so that as
+    many messages are being published at the same time as there are
+    contexts in the pool. Contexts use HTTP keep-alive, so publishing
+    (a lot of) messages doesn't need a new connection for each.
+
+    The queue is guarded by a mutex, rather than being lock-free, as
+    the library has no atomics abstraction and still builds as C89
+    (with MSVC). The mutex is held only to put a message in the queue
+    or take one from it, never while publishing or calling back.
+*/
+
+
+/** A publish queue descriptor. An opaque data structure. */
+struct pubnub_publish_queue;
+
+/** A helper typedef of a publish queue descriptor */
+typedef struct pubnub_publish_queue pubnub_publish_queue_t;
+
+/** Prototype of a function that will be called back when publishing
+    of a message from the queue @p pq is done, with the @p channel,
+    @p message and @p user_data given when the message was pushed and
+    the final @p result of publishing it.
+
+    The @p channel and @p message are valid only until this function
+    returns.
+
+    It is called from the context of the Pubnub FSM (like the
+    callback in the callback interface), so, don't do anything that
+    takes long in it.
+*/
+typedef void (*pubnub_publish_queue_callback_t)(pubnub_publish_queue_t* pq,
+                                                char const*      channel,
+                                                char const*      message,
+                                                enum pubnub_res  result,
+                                                void*            user_data);
+
+/** Creates a publish queue that can hold up to @p capacity messages
+    waiting to be published and a pool of @p pool_size contexts
+    initialized with @p publish_key and @p subscribe_key, over which
+    it will publish them.
+
+    Messages that fail to publish because of an error for which
+    pubnub_should_retry() says it is safe to retry will be retried a
+    few times before they are reported as failed.
+
+    @param publish_key The publish key to use for the contexts
+    @param subscribe_key The subscribe key to use for the contexts
+    @param pool_size Number of contexts to publish over, at least 1
+    @param capacity Max number of messages waiting in the queue
+    @param cb Function to call when a message is published (or fails)
+
+    @retval NULL Failed to create the queue
+    @return The publish queue created
+*/
+pubnub_publish_queue_t* pubnub_publish_queue_create(char const* publish_key,
+                                                    char const* subscribe_key,
+                                                    unsigned    pool_size,
+                                                    unsigned    capacity,
+                                                    pubnub_publish_queue_callback_t cb);
+
+/** Returns the context at @p index in the pool of the publish queue
+    @p pq, or NULL if there is no such context. Use it to set options
+    on the context (like the UUID, auth or transaction timeout) before
+    you push any messages. Don't start transactions on it, nor change
+    its callback.
+*/
+pubnub_t* pubnub_publish_queue_context(pubnub_publish_queue_t* pq, unsigned index);
+
+/** Pushes the @p message to be published on the @p channel to the
+    publish queue @p pq. Both are copied, so you don't need to keep
+    them. The @p user_data is passed to the callback of the queue
+    when publishing is done.
+
+    If there is an idle context in the pool, publishing is started
+    right away, otherwise the message is queued. Thread-safe.
+
+    @retval PNR_STARTED Message will be published, the callback will be
+    called with the result
+    @retval PNR_IN_PROGRESS Queue is full, try again later
+    @retval PNR_INVALID_CHANNEL @p channel is NULL or empty
+    @retval PNR_CANCELLED Queue is being freed
+    @retval PNR_INTERNAL_ERROR Out of memory
+*/
+enum pubnub_res pubnub_publish_queue_push(pubnub_publish_queue_t* pq,
+                                          char const*             channel,
+                                          char const*             message,
+                                          void*                   user_data);
+
+/** Frees the publish queue @p pq. Publishing that is in progress is
+    cancelled, and the callback is called with PNR_CANCELLED for those
+    and all the messages still waiting in the queue. Contexts in the
+    pool are freed.
+
+    Don't call from the callback of the queue.
+
+    @retval 0 Freed
+    @retval -1 Some context(s) of the pool could not be stopped in a
+    reasonable time, so the queue was _not_ freed
+*/
+int pubnub_publish_queue_free(pubnub_publish_queue_t* pq);
+
+
+#endif /* !defined INC_PUBNUB_PUBLISH_QUEUE */
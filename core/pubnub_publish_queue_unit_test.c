@@ -0,0 +1,337 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_publish_queue.h"
+
+#include "pubnub_alloc.h"
+#include "pubnub_pubsubapi.h"
+#include "pubnub_ntf_callback.h"
+#include "pubnub_free_with_timeout.h"
+#include "pubnub_helper.h"
+#include "pubnub_assert.h"
+
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+#define streqs is_equal_to_string
+
+
+#define MAX_CONTEXTS 3
+#define MAX_LOG 20
+
+/* The contexts of the pool, with what the queue did to them */
+static struct stub_context {
+    struct pubnub_    pb;
+    bool              allocated;
+    pubnub_callback_t cb;
+    void*             user_data;
+    /** Is a publish "in progress" on the context */
+    bool              publishing;
+    char              channel[32];
+    char              message[32];
+} m_ctx[MAX_CONTEXTS];
+
+/* What pubnub_publish() returns next, if not PNR_STARTED */
+static enum pubnub_res m_publish_result;
+/* Messages published, in the order they were published */
+static char m_published[MAX_LOG][32];
+static unsigned m_published_count;
+/* Messages reported to the queue callback, with their results */
+static char m_reported[MAX_LOG][32];
+static enum pubnub_res m_reported_result[MAX_LOG];
+static unsigned m_reported_count;
+
+
+static struct stub_context* stub_of(pubnub_t* pb)
+{
+    return (struct stub_context*)pb;
+}
+
+
+/* Functions of the Pubnub API the queue uses */
+
+pubnub_t* pubnub_alloc(void)
+{
+    unsigned i;
+    for (i = 0; i < MAX_CONTEXTS; ++i) {
+        if (!m_ctx[i].allocated) {
+            memset(&m_ctx[i], 0, sizeof m_ctx[i]);
+            m_ctx[i].allocated = true;
+            return &m_ctx[i].pb;
+        }
+    }
+    return NULL;
+}
+
+
+pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscribe_key)
+{
+    PUBNUB_UNUSED(publish_key);
+    PUBNUB_UNUSED(subscribe_key);
+    return p;
+}
+
+
+enum pubnub_res pubnub_register_callback(pubnub_t* pb, pubnub_callback_t cb, void* user_data)
+{
+    stub_of(pb)->cb        = cb;
+    stub_of(pb)->user_data = user_data;
+    return PNR_OK;
+}
+
+
+enum pubnub_res pubnub_publish(pubnub_t* p, const char* channel, const char* message)
+{
+    struct stub_context* ctx = stub_of(p);
+    enum pubnub_res      rslt = m_publish_result;
+
+    attest(ctx->publishing, equals(false));
+    if (m_published_count < MAX_LOG) {
+        strcpy(m_published[m_published_count++], message);
+    }
+    if (rslt != PNR_STARTED) {
+        m_publish_result = PNR_STARTED;
+        return rslt;
+    }
+    ctx->publishing = true;
+    strcpy(ctx->channel, channel);
+    strcpy(ctx->message, message);
+
+    return PNR_STARTED;
+}
+
+
+/* Finishes the publish in progress on the context @p index with
+   @p result, like the FSM would */
+static void finish(unsigned index, enum pubnub_res result)
+{
+    struct stub_context* ctx = &m_ctx[index];
+
+    attest(ctx->publishing, equals(true));
+    ctx->publishing = false;
+    ctx->cb(&ctx->pb, PBTT_PUBLISH, result, ctx->user_data);
+}
+
+
+enum pubnub_cancel_res pubnub_cancel(pubnub_t* p)
+{
+    if (stub_of(p)->publishing) {
+        finish(stub_of(p) - m_ctx, PNR_CANCELLED);
+    }
+    return PN_CANCEL_FINISHED;
+}
+
+
+int pubnub_free_with_timeout(pubnub_t* pbp, unsigned millisec)
+{
+    PUBNUB_UNUSED(millisec);
+    attest(stub_of(pbp)->publishing, equals(false));
+    stub_of(pbp)->allocated = false;
+    return 0;
+}
+
+
+enum pubnub_tribool pubnub_should_retry(enum pubnub_res e)
+{
+    return (PNR_TIMEOUT == e) ? pbccTrue : pbccFalse;
+}
+
+
+static void queue_callback(pubnub_publish_queue_t* pq,
+                           char const*             channel,
+                           char const*             message,
+                           enum pubnub_res         result,
+                           void*                   user_data)
+{
+    PUBNUB_UNUSED(pq);
+    attest(channel, streqs("ch"));
+    attest(user_data, equals(&m_reported_count));
+    if (m_reported_count < MAX_LOG) {
+        m_reported_result[m_reported_count] = result;
+        strcpy(m_reported[m_reported_count++], message);
+    }
+}
+
+
+static pubnub_publish_queue_t* create(unsigned pool_size, unsigned capacity)
+{
+    pubnub_publish_queue_t* pq =
+        pubnub_publish_queue_create("pub", "sub", pool_size, capacity, queue_callback);
+    attest(pq, differs(NULL));
+    return pq;
+}
+
+
+static enum pubnub_res push(pubnub_publish_queue_t* pq, char const* message)
+{
+    return pubnub_publish_queue_push(pq, "ch", message, &m_reported_count);
+}
+
+
+Describe(pubnub_publish_queue);
+
+
+BeforeEach(pubnub_publish_queue) {
+    memset(m_ctx, 0, sizeof m_ctx);
+    m_publish_result  = PNR_STARTED;
+    m_published_count = 0;
+    m_reported_count  = 0;
+}
+
+
+AfterEach(pubnub_publish_queue) {
+}
+
+
+Ensure(pubnub_publish_queue, publishes_on_idle_contexts_right_away) {
+    pubnub_publish_queue_t* pq = create(2, 4);
+
+    attest(push(pq, "1"), equals(PNR_STARTED));
+    attest(push(pq, "2"), equals(PNR_STARTED));
+    attest(m_published_count, equals(2));
+    attest(m_ctx[0].message, streqs("1"));
+    attest(m_ctx[1].message, streqs("2"));
+
+    finish(1, PNR_OK);
+    finish(0, PNR_OK);
+    attest(m_reported_count, equals(2));
+    attest(m_reported[0], streqs("2"));
+    attest(m_reported[1], streqs("1"));
+    attest(m_reported_result[0], equals(PNR_OK));
+    attest(m_reported_result[1], equals(PNR_OK));
+    attest(pubnub_publish_queue_free(pq), equals(0));
+    attest(m_reported_count, equals(2));
+}
+
+
+Ensure(pubnub_publish_queue, publishes_waiting_messages_in_order) {
+    pubnub_publish_queue_t* pq = create(1, 3);
+
+    attest(push(pq, "1"), equals(PNR_STARTED));
+    attest(push(pq, "2"), equals(PNR_STARTED));
+    attest(push(pq, "3"), equals(PNR_STARTED));
+    attest(m_published_count, equals(1));
+
+    finish(0, PNR_OK);
+    attest(m_ctx[0].message, streqs("2"));
+    finish(0, PNR_OK);
+    attest(m_ctx[0].message, streqs("3"));
+    finish(0, PNR_OK);
+
+    attest(m_published_count, equals(3));
+    attest(m_reported_count, equals(3));
+    attest(m_reported[0], streqs("1"));
+    attest(m_reported[1], streqs("2"));
+    attest(m_reported[2], streqs("3"));
+    attest(pubnub_publish_queue_free(pq), equals(0));
+}
+
+
+Ensure(pubnub_publish_queue, full_queue_pushes_back) {
+    pubnub_publish_queue_t* pq = create(1, 1);
+
+    attest(push(pq, "1"), equals(PNR_STARTED));
+    attest(push(pq, "2"), equals(PNR_STARTED));
+    attest(push(pq, "3"), equals(PNR_IN_PROGRESS));
+
+    /* Once a message is done, there's room again */
+    finish(0, PNR_OK);
+    attest(push(pq, "3"), equals(PNR_STARTED));
+    finish(0, PNR_OK);
+    finish(0, PNR_OK);
+
+    attest(m_reported_count, equals(3));
+    attest(m_reported[2], streqs("3"));
+    attest(pubnub_publish_queue_free(pq), equals(0));
+}
+
+
+Ensure(pubnub_publish_queue, invalid_channel_is_rejected) {
+    pubnub_publish_queue_t* pq = create(1, 1);
+
+    attest(pubnub_publish_queue_push(pq, NULL, "1", NULL), equals(PNR_INVALID_CHANNEL));
+    attest(pubnub_publish_queue_push(pq, "", "1", NULL), equals(PNR_INVALID_CHANNEL));
+    attest(m_published_count, equals(0));
+    attest(pubnub_publish_queue_free(pq), equals(0));
+    attest(m_reported_count, equals(0));
+}
+
+
+Ensure(pubnub_publish_queue, retries_then_reports_failure) {
+    pubnub_publish_queue_t* pq = create(1, 1);
+    unsigned                i;
+
+    attest(push(pq, "1"), equals(PNR_STARTED));
+    attest(push(pq, "2"), equals(PNR_STARTED));
+    for (i = 0; i < 3; ++i) {
+        finish(0, PNR_TIMEOUT);
+        attest(m_ctx[0].message, streqs("1"));
+        attest(m_reported_count, equals(0));
+    }
+    finish(0, PNR_TIMEOUT);
+    attest(m_reported_count, equals(1));
+    attest(m_reported_result[0], equals(PNR_TIMEOUT));
+    attest(m_ctx[0].message, streqs("2"));
+
+    /* Errors that are not safe to retry are reported right away */
+    finish(0, PNR_PUBLISH_FAILED);
+    attest(m_reported_count, equals(2));
+    attest(m_reported_result[1], equals(PNR_PUBLISH_FAILED));
+    attest(m_published_count, equals(5));
+    attest(pubnub_publish_queue_free(pq), equals(0));
+}
+
+
+Ensure(pubnub_publish_queue, failure_to_start_moves_on_to_next_message) {
+    pubnub_publish_queue_t* pq = create(1, 1);
+
+    attest(push(pq, "1"), equals(PNR_STARTED));
+    attest(push(pq, "2"), equals(PNR_STARTED));
+    m_publish_result = PNR_ADDR_RESOLUTION_FAILED;
+    finish(0, PNR_OK);
+
+    attest(m_reported_count, equals(2));
+    attest(m_reported[1], streqs("2"));
+    attest(m_reported_result[1], equals(PNR_ADDR_RESOLUTION_FAILED));
+    attest(m_ctx[0].publishing, equals(false));
+
+    /* The context is idle again */
+    attest(push(pq, "3"), equals(PNR_STARTED));
+    attest(m_ctx[0].message, streqs("3"));
+    finish(0, PNR_OK);
+    attest(pubnub_publish_queue_free(pq), equals(0));
+}
+
+
+Ensure(pubnub_publish_queue, free_cancels_pending_messages) {
+    pubnub_publish_queue_t* pq = create(2, 2);
+
+    attest(push(pq, "1"), equals(PNR_STARTED));
+    attest(push(pq, "2"), equals(PNR_STARTED));
+    attest(push(pq, "3"), equals(PNR_STARTED));
+    attest(push(pq, "4"), equals(PNR_STARTED));
+    attest(m_published_count, equals(2));
+
+    attest(pubnub_publish_queue_free(pq), equals(0));
+    attest(m_published_count, equals(2));
+    attest(m_reported_count, equals(4));
+    attest(m_reported[0], streqs("1"));
+    attest(m_reported[1], streqs("2"));
+    attest(m_reported[2], streqs("3"));
+    attest(m_reported[3], streqs("4"));
+    attest(m_reported_result[0], equals(PNR_CANCELLED));
+    attest(m_reported_result[1], equals(PNR_CANCELLED));
+    attest(m_reported_result[2], equals(PNR_CANCELLED));
+    attest(m_reported_result[3], equals(PNR_CANCELLED));
+    attest(m_ctx[0].allocated, equals(false));
+    attest(m_ctx[1].allocated, equals(false));
+}
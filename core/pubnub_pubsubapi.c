@@ -28,6 +28,18 @@ pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscrib
 #if defined(PUBNUB_CALLBACK_API)
     p->cb        = NULL;
     p->user_data = NULL;
+    p->queue_previous = p->queue_next = NULL;
+#if PUBNUB_DNS_CACHE
+    p->dns_cache_previous = p->dns_cache_next = NULL;
+    p->flags.dns_cache_waiting   = false;
+    p->flags.dns_cache_resolving = false;
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    p->connect_race_previous = p->connect_race_next = NULL;
+#endif
+#if PUBNUB_CALLBACK_THREAD_COUNT > 1
+    pbntf_assign_thread(p);
+#endif
 #endif /* defined(PUBNUB_CALLBACK_API) */
     if (PUBNUB_ORIGIN_SETTABLE) {
         p->origin = PUBNUB_ORIGIN;
@@ -51,6 +63,15 @@ pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscrib
 #endif
     p->flags.started_while_kept_alive = false;
     p->flags.is_publish_via_post   = false;
+#if PUBNUB_SUBSCRIBE_STREAMING
+    p->flags.subscribe_streaming = false;
+    p->msg_cb                    = NULL;
+    p->msg_cb_user_data          = NULL;
+#endif
+#if PUBNUB_PUBLISH_PIPELINE
+    p->flags.publish_pipeline = false;
+    p->pipeline.count         = 0;
+#endif
 #if PUBNUB_ADVANCED_KEEP_ALIVE
     p->keep_alive.max     = 1000;
     p->keep_alive.timeout = 50;
@@ -73,6 +94,10 @@ pubnub_t* pubnub_init(pubnub_t* p, const char* publish_key, const char* subscrib
     p->proxy_auth_username      = NULL;
     p->proxy_auth_password      = NULL;
     p->realm[0]                 = '\0'; 
+#if PUBNUB_BUFFER_POOL
+    p->proxy_saved_path      = NULL;
+    p->ntlm_context.in_token = NULL;
+#endif
 #endif
 
 #if PUBNUB_RECEIVE_GZIP_RESPONSE
@@ -323,6 +348,104 @@ int pubnub_origin_set(pubnub_t* pb, char const* origin)
 }
 
 
+#if PUBNUB_SUBSCRIBE_STREAMING
+enum pubnub_res pubnub_register_message_callback(pubnub_t*                 pb,
+                                                 pubnub_message_callback_t cb,
+                                                 void* user_data)
+{
+    enum pubnub_res rslt = PNR_OK;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    pubnub_mutex_lock(pb->monitor);
+    if (!pbnc_can_start_transaction(pb)) {
+        rslt = PNR_IN_PROGRESS;
+    }
+    else {
+        pb->msg_cb           = cb;
+        pb->msg_cb_user_data = user_data;
+    }
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+#endif /* PUBNUB_SUBSCRIBE_STREAMING */
+
+
+#if PUBNUB_PUBLISH_PIPELINE
+enum pubnub_res pubnub_publish_pipelined(pubnub_t*                  pb,
+                                         const char*                channel,
+                                         char const* const*         messages,
+                                         unsigned                   count,
+                                         enum pubnub_publish_method method)
+{
+    enum pubnub_res rslt;
+    unsigned        i;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT(messages != NULL);
+
+    if ((0 == count) || (count > PUBNUB_PUBLISH_PIPELINE_MAX)) {
+        return PNR_INVALID_PARAMETERS;
+    }
+    pubnub_mutex_lock(pb->monitor);
+    if (!pbnc_can_start_transaction(pb)) {
+        pubnub_mutex_unlock(pb->monitor);
+        return PNR_IN_PROGRESS;
+    }
+
+    pb->pipeline.channel  = channel;
+    pb->pipeline.messages = messages;
+    pb->pipeline.method   = method;
+    pb->pipeline.count    = count;
+    pb->pipeline.sent     = 0;
+    pb->pipeline.done     = 0;
+    pb->pipeline.serial   = false;
+#if PUBNUB_PROXY_API
+    /* Proxies are not trusted to pipeline */
+    pb->pipeline.serial = (pb->proxy_type != pbproxyNONE);
+#endif
+    for (i = 0; i < count; ++i) {
+        pb->pipeline.results[i] = PNR_STARTED;
+    }
+    rslt = pbnc_pipeline_prep(pb);
+    if (PNR_STARTED == rslt) {
+        pb->trans                     = PBTT_PUBLISH;
+        pb->core.last_result          = PNR_STARTED;
+        pb->flags.is_publish_via_post = (method != pubnubPublishViaGET);
+        pb->flags.publish_pipeline    = true;
+        pbnc_fsm(pb);
+        rslt = pb->core.last_result;
+    }
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+
+
+enum pubnub_res pubnub_publish_pipeline_result(pubnub_t* pb, unsigned index)
+{
+    enum pubnub_res rslt;
+
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+
+    pubnub_mutex_lock(pb->monitor);
+    if (index >= pb->pipeline.count) {
+        rslt = PNR_INVALID_PARAMETERS;
+    }
+    else {
+        rslt = pb->pipeline.results[index];
+        if ((PNR_STARTED == rslt) && pbnc_can_start_transaction(pb)) {
+            rslt = pb->core.last_result;
+        }
+    }
+    pubnub_mutex_unlock(pb->monitor);
+
+    return rslt;
+}
+#endif /* PUBNUB_PUBLISH_PIPELINE */
+
+
 void pubnub_use_http_keep_alive(pubnub_t* p)
 {
     p->options.use_http_keep_alive = 1;
@@ -75,3 +75,15 @@ void pubnub_set_reuse_ssl_session(pubnub_t *p, bool reuse)
     pubnub_mutex_unlock(p->monitor);
 #endif
 }
+
+
+void pubnub_set_shared_ssl_ctx(pubnub_t *p, bool share)
+{
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(p));
+
+#if PUBNUB_USE_SSL
+    pubnub_mutex_lock(p->monitor);
+    p->options.share_SSL_CTX = share;
+    pubnub_mutex_unlock(p->monitor);
+#endif
+}
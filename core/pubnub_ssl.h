@@ -44,6 +44,23 @@ void pubnub_set_ssl_options(pubnub_t *p, bool useSSL, bool ignoreSecureConnectio
  */
 void pubnub_set_reuse_ssl_session(pubnub_t *p, bool reuse);
 
+/** Sets the option to share the SSL context (with its certificate
+    store) with other contexts that have the same certificates set
+    to @p share on the context @p p.
+
+    By default, SSL context is shared, so that certificates are read
+    and kept in memory only once, rather than for each context. If
+    you turn it off, context @p p will have its own SSL context.
+
+    @note This takes effect on the first SSL/TLS connection of the
+    context, the SSL context is kept afterwards.
+
+    @param p The context for which to set the option for sharing the
+    SSL context
+    @param share The value (true/false == on/off) of the option
+ */
+void pubnub_set_shared_ssl_ctx(pubnub_t *p, bool share);
+
 /** Sets the location(s) of CA certificates for verification
     purposes. This is only available on targets that have a file
     system.
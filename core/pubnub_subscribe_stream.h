@@ -0,0 +1,60 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_SUBSCRIBE_STREAM
+#define INC_PUBNUB_SUBSCRIBE_STREAM
+
+
+#include "pubnub_api_types.h"
+
+
+/** @file pubnub_subscribe_stream.h
+
+    API for getting the messages of a subscribe as soon as they are
+    received, while the rest of the response is still being received
+    ("streaming").
+*/
+
+#if !PUBNUB_SUBSCRIBE_STREAMING
+#error This API is only supported if PUBNUB_SUBSCRIBE_STREAMING macro constant is 'true'
+#endif
+
+/** Type of Pubnub message callback function. It is called with the
+    context @p pb, the @p message received and the user data that
+    was given when it was registered.
+
+    The @p message is valid only until this function returns, so, if
+    you need it later, make a copy.
+*/
+typedef void (*pubnub_message_callback_t)(pubnub_t*   pb,
+                                          char const* message,
+                                          void*       user_data);
+
+/** Registers the message callback @p cb for the context @p pb, with
+    the @p user_data to pass to it. Pass NULL as @p cb to unregister.
+
+    When a message callback is registered, for each message in the
+    response to a subscribe (pubnub_subscribe()) transaction, it is
+    called as soon as the message is received whole - while the rest
+    of the response is still being received. This gets the messages
+    to you sooner when there are many of them (like on "catch up"
+    after reconnecting), and needs less memory for the response, as
+    messages are not kept after you get them.
+
+    Messages given to the callback are not given by pubnub_get().
+    Channels (pubnub_get_channel()) are given at the end of the
+    response, so, they can be gotten only when the transaction is
+    over. Responses that are compressed (gzip) are not "streamed",
+    their messages are gotten via pubnub_get(), as usual.
+
+    The callback is called from the context of the Pubnub FSM, just
+    like the (transaction outcome) callback in the callback
+    interface, so, don't do anything that takes long in it.
+
+    @return PNR_OK: registered, PNR_IN_PROGRESS: can't be done while a
+    transaction is in progress
+*/
+enum pubnub_res pubnub_register_message_callback(pubnub_t*                 pb,
+                                                 pubnub_message_callback_t cb,
+                                                 void* user_data);
+
+
+#endif /* !defined INC_PUBNUB_SUBSCRIBE_STREAM */
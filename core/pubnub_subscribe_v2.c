@@ -113,28 +113,60 @@ enum pubnub_res pubnub_subscribe_v2(pubnub_t*                          p,
 }
 
 
-enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
+/** Returns whether the (JSON object) key @p name is @p key */
+static bool is_key(struct pbjson_elem const* name, char key)
 {
-    enum pbjson_object_name_parse_result jpresult;
-    struct pbjson_elem                   el;
-    struct pbjson_elem                   found;
-    char*                                reply = p->http_reply;
+    return (name->end - name->start == 1) && (*name->start == key);
+}
 
-    if (p->http_buf_len < MIN_SUBSCRIBE_V2_RESPONSE_LENGTH) {
-        return PNR_FORMAT_ERROR;
+
+static int elem_to_int(struct pbjson_elem const* el)
+{
+    char s[20];
+    pbjson_element_strcpy(el, s, sizeof s);
+    return strtol(s, NULL, 0);
+}
+
+
+/** Sets the @p span to the JSON element @p el from the reply of @p
+    p. If @p unquote, @p el has to be a string and its quotes are
+    left out (otherwise, @p span is not set).
+*/
+static void set_span(struct pbcc_context const* p,
+                     struct pbcc_reply_span*    span,
+                     struct pbjson_elem const*  el,
+                     bool                       unquote)
+{
+    if (unquote) {
+        if ((el->end - el->start < 2) || (*el->start != '"') || (el->end[-1] != '"')) {
+            return;
+        }
+        span->ofs = (unsigned)(el->start + 1 - p->http_reply);
+        span->len = (unsigned)(el->end - el->start - 2);
     }
-    if ((reply[0] != '{') || (reply[p->http_buf_len - 1] != '}')) {
-        return PNR_FORMAT_ERROR;
+    else {
+        span->ofs = (unsigned)(el->start - p->http_reply);
+        span->len = (unsigned)(el->end - el->start);
     }
+}
 
-    el.start = p->http_reply;
-    el.end   = p->http_reply + p->http_buf_len;
-    jpresult = pbjson_get_object_value(&el, "t", &found);
-    if (jonmpOK == jpresult) {
-        struct pbjson_elem titel;
-        if (jonmpOK == pbjson_get_object_value(&found, "t", &titel)) {
-            size_t len = titel.end - titel.start - 2;
-            if ((*titel.start != '"') || (titel.end[-1] != '"')) {
+
+/** Parses the `t` (time token) field of the subscribe V2 response,
+    the value of which is @p t.
+ */
+static enum pubnub_res parse_timetoken(struct pbcc_context* p, struct pbjson_elem const* t)
+{
+    enum pbjson_object_name_parse_result jpresult;
+    struct pbjson_elem                   name;
+    struct pbjson_elem                   value;
+    char const*                          pos         = t->start;
+    bool                                 have_tt     = false;
+    bool                                 have_region = false;
+
+    while (jonmpOK == (jpresult = pbjson_get_next_object_member(t, &pos, &name, &value))) {
+        if (is_key(&name, 't')) {
+            size_t len = value.end - value.start - 2;
+            if ((*value.start != '"') || (value.end[-1] != '"')) {
                 PUBNUB_LOG_ERROR("Time token in response is not a string\n");
                 return PNR_FORMAT_ERROR;
             }
@@ -145,44 +177,26 @@ enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
                     sizeof p->timetoken - 1);
                 return PNR_FORMAT_ERROR;
             }
-
-            memcpy(p->timetoken, titel.start + 1, len);
+            memcpy(p->timetoken, value.start + 1, len);
             p->timetoken[len] = '\0';
+            have_tt           = true;
         }
-        else {
-            PUBNUB_LOG_ERROR(
-                "No timetoken value in subscribe V2 response found\n");
-            return PNR_FORMAT_ERROR;
-        }
-        if (jonmpOK == pbjson_get_object_value(&found, "r", &titel)) {
-            char s[20];
-            pbjson_element_strcpy(&titel, s, sizeof s);
-            p->region = strtol(s, NULL, 0);
-        }
-        else {
-            PUBNUB_LOG_ERROR(
-                "No region value in subscribe V2 response found\n");
-            return PNR_FORMAT_ERROR;
+        else if (is_key(&name, 'r')) {
+            p->region   = elem_to_int(&value);
+            have_region = true;
         }
     }
-    else {
+    if (jpresult != jonmpKeyNotFound) {
         PUBNUB_LOG_ERROR(
             "No timetoken in subscribe V2 response found, error=%d\n", jpresult);
         return PNR_FORMAT_ERROR;
     }
-
-    p->chan_ofs = p->chan_end = 0;
-
-    /* We should optimize this to not look from the start again.
-     */
-    jpresult = pbjson_get_object_value(&el, "m", &found);
-    if (jonmpOK == jpresult) {
-        p->msg_ofs = (unsigned)(found.start - reply + 1);
-        p->msg_end = (unsigned)(found.end - reply - 1);
+    if (!have_tt) {
+        PUBNUB_LOG_ERROR("No timetoken value in subscribe V2 response found\n");
+        return PNR_FORMAT_ERROR;
     }
-    else {
-        PUBNUB_LOG_ERROR(
-            "No message array subscribe V2 response found, error=%d\n", jpresult);
+    if (!have_region) {
+        PUBNUB_LOG_ERROR("No region value in subscribe V2 response found\n");
         return PNR_FORMAT_ERROR;
     }
 
@@ -190,102 +204,254 @@ enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
 }
 
 
-struct pubnub_v2_message pubnub_get_v2(pubnub_t* pbp)
+/** Finds all the fields of the V2 message @p msg (JSON object) of
+    the reply of @p p, in one pass, and puts them to @p idx. Fields
+    that are not found are left with zero offset.
+*/
+static void index_v2_message(struct pbcc_context const*    p,
+                             struct pbjson_elem const*     msg,
+                             struct pbcc_v2_message_index* idx)
 {
     enum pbjson_object_name_parse_result jpresult;
-    struct pbjson_elem                   el;
-    struct pbjson_elem                   found;
-    struct pubnub_v2_message             rslt;
-    struct pbcc_context*                 p = &pbp->core;
-    char const*                          start;
-    char const*                          end;
-    char const*                          seeker;
+    struct pbjson_elem                   name;
+    struct pbjson_elem                   value;
+    char const*                          pos = msg->start;
+
+    memset(idx, 0, sizeof *idx);
+    idx->start = (unsigned)(msg->start - p->http_reply);
+    idx->end   = (unsigned)(msg->end - p->http_reply);
+    while (jonmpOK == (jpresult = pbjson_get_next_object_member(msg, &pos, &name, &value))) {
+        if (name.end - name.start != 1) {
+            continue;
+        }
+        switch (*name.start) {
+        case 'd':
+            set_span(p, &idx->payload, &value, false);
+            break;
+        case 'c':
+            set_span(p, &idx->channel, &value, true);
+            break;
+        case 'b':
+            set_span(p, &idx->match_or_group, &value, false);
+            break;
+        case 'u':
+            set_span(p, &idx->metadata, &value, false);
+            break;
+        case 'f':
+            idx->flags = elem_to_int(&value);
+            break;
+        case 'p': {
+            struct pbjson_elem const publish = value;
+            char const*              ppos    = publish.start;
+            while (jonmpOK
+                   == pbjson_get_next_object_member(&publish, &ppos, &name, &value)) {
+                if (is_key(&name, 't')) {
+                    set_span(p, &idx->tt, &value, true);
+                }
+                else if (is_key(&name, 'r')) {
+                    idx->region = elem_to_int(&value);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (jpresult != jonmpKeyNotFound) {
+        PUBNUB_LOG_WARNING("Message in subscribe V2 response is not a valid "
+                           "JSON object, error=%d\n",
+                           jpresult);
+    }
+}
 
-    memset(&rslt, 0, sizeof rslt);
 
-    if (p->msg_ofs >= p->msg_end) {
-        return rslt;
+/** Returns the index entry for the next message in the response, or
+    NULL if the index can't hold any more.
+ */
+static struct pbcc_v2_message_index* v2_index_next_entry(struct pbcc_context* p)
+{
+#if PUBNUB_DYNAMIC_REPLY_BUFFER
+    if (p->v2_msg_count == p->v2_index_capacity) {
+        unsigned capacity = p->v2_index_capacity ? 2 * p->v2_index_capacity : 16;
+        struct pbcc_v2_message_index* newidx =
+            (struct pbcc_v2_message_index*)realloc(p->v2_index, capacity * sizeof *newidx);
+        if (NULL == newidx) {
+            return NULL;
+        }
+        p->v2_index          = newidx;
+        p->v2_index_capacity = capacity;
     }
-    start = p->http_reply + p->msg_ofs;
-    if (*start != '{') {
-        PUBNUB_LOG_ERROR(
-            "Message subscribe V2 response is not a JSON object\n");
-        return rslt;
-    }
-    end    = p->http_reply + p->msg_end;
-    seeker = pbjson_find_end_complex(start, end);
-    if (seeker == end) {
-        PUBNUB_LOG_ERROR(
-            "Message subscribe V2 response has no endo of JSON object\n");
-        return rslt;
+#else
+    if (p->v2_msg_count == PUBNUB_MAX_SUBSCRIBE_V2_MESSAGES) {
+        return NULL;
     }
+#endif
+    return &p->v2_index[p->v2_msg_count++];
+}
 
-    p->msg_ofs = (unsigned)(seeker - p->http_reply + 2);
-    el.start   = start;
-    el.end     = seeker;
 
-    /* @todo We should iterate over elements of JSON message object,
-       instead of looking from the start, again and again.
-    */
+/** Indexes the V2 messages in the message array @p messages of the
+    reply of @p p. If the index can't hold them all, the rest are
+    parsed as they are gotten.
+*/
+static void index_v2_messages(struct pbcc_context* p, struct pbjson_elem const* messages)
+{
+    char const* s = pbjson_skip_whitespace(messages->start + 1, messages->end);
 
-    jpresult = pbjson_get_object_value(&el, "d", &found);
-    if (jonmpOK == jpresult) {
-        rslt.payload.ptr  = (char*)found.start;
-        rslt.payload.size = found.end - found.start;
-    }
-    else {
-        PUBNUB_LOG_ERROR("pbp=%p: No message payload in subscribe V2 response "
-                         "found, error=%d\n",
-                         pbp,
-                         jpresult);
-        return rslt;
+    while ((s < messages->end) && ('{' == *s)) {
+        struct pbcc_v2_message_index* idx;
+        struct pbjson_elem            msg;
+        char const*                   end = pbjson_find_end_complex(s, messages->end);
+
+        if (end == messages->end) {
+            break;
+        }
+        idx = v2_index_next_entry(p);
+        if (NULL == idx) {
+            PUBNUB_LOG_INFO("Subscribe V2 message index full at %u messages\n",
+                            p->v2_msg_count);
+            break;
+        }
+        msg.start = s;
+        msg.end   = end + 1;
+        index_v2_message(p, &msg, idx);
+        s = pbjson_skip_whitespace(end + 1, messages->end);
+        if ((s < messages->end) && (',' == *s)) {
+            s = pbjson_skip_whitespace(s + 1, messages->end);
+        }
     }
+}
 
-    jpresult = pbjson_get_object_value(&el, "c", &found);
-    if (jonmpOK == jpresult) {
-        rslt.channel.ptr  = (char*)found.start + 1;
-        rslt.channel.size = found.end - found.start - 2;
+
+enum pubnub_res pbcc_parse_subscribe_v2_response(struct pbcc_context* p)
+{
+    enum pbjson_object_name_parse_result jpresult;
+    enum pubnub_res                      rslt;
+    struct pbjson_elem                   el;
+    struct pbjson_elem                   name;
+    struct pbjson_elem                   value;
+    struct pbjson_elem                   messages = { NULL, NULL };
+    char const*                          pos;
+    bool                                 have_timetoken = false;
+    char*                                reply          = p->http_reply;
+
+    p->v2_msg_count = p->v2_msg_next = 0;
+    if (p->http_buf_len < MIN_SUBSCRIBE_V2_RESPONSE_LENGTH) {
+        return PNR_FORMAT_ERROR;
     }
-    else {
-        PUBNUB_LOG_ERROR("pbp=%p: No message channel in subscribe V2 response "
-                         "found, error=%d\n",
-                         pbp,
-                         jpresult);
-        return rslt;
+    if ((reply[0] != '{') || (reply[p->http_buf_len - 1] != '}')) {
+        return PNR_FORMAT_ERROR;
     }
 
-    jpresult = pbjson_get_object_value(&el, "p", &found);
-    if (jonmpOK == jpresult) {
-        struct pbjson_elem titel;
-        if (jonmpOK == pbjson_get_object_value(&found, "t", &titel)) {
-            if ((*titel.start != '"') || (titel.end[-1] != '"')) {
-                PUBNUB_LOG_ERROR("Time token in response is not a string\n");
+    /* One pass over the "envelope", the messages are indexed after */
+    el.start = p->http_reply;
+    el.end   = p->http_reply + p->http_buf_len;
+    pos      = el.start;
+    while (jonmpOK == (jpresult = pbjson_get_next_object_member(&el, &pos, &name, &value))) {
+        if (is_key(&name, 't')) {
+            rslt = parse_timetoken(p, &value);
+            if (rslt != PNR_OK) {
                 return rslt;
             }
-            rslt.tt.ptr  = (char*)titel.start + 1;
-            rslt.tt.size = titel.end - titel.start - 2;
+            have_timetoken = true;
+        }
+        else if (is_key(&name, 'm')) {
+            messages = value;
+        }
+    }
+    if ((jpresult != jonmpKeyNotFound) || !have_timetoken) {
+        PUBNUB_LOG_ERROR(
+            "No timetoken in subscribe V2 response found, error=%d\n", jpresult);
+        return PNR_FORMAT_ERROR;
+    }
+
+    p->chan_ofs = p->chan_end = 0;
+
+    if ((NULL == messages.start) || (*messages.start != '[')) {
+        PUBNUB_LOG_ERROR("No message array subscribe V2 response found\n");
+        return PNR_FORMAT_ERROR;
+    }
+    p->msg_ofs = (unsigned)(messages.start - reply + 1);
+    p->msg_end = (unsigned)(messages.end - reply - 1);
+    index_v2_messages(p, &messages);
+
+    return PNR_OK;
+}
+
+
+struct pubnub_v2_message pubnub_get_v2(pubnub_t* pbp)
+{
+    struct pubnub_v2_message            rslt;
+    struct pbcc_context*                p = &pbp->core;
+    struct pbcc_v2_message_index        parsed;
+    struct pbcc_v2_message_index const* idx;
+    char const*                         start;
+
+    memset(&rslt, 0, sizeof rslt);
+
+    if (p->msg_ofs >= p->msg_end) {
+        return rslt;
+    }
+    start = p->http_reply + p->msg_ofs;
+    if ((p->v2_msg_next < p->v2_msg_count)
+        && (p->v2_index[p->v2_msg_next].start == p->msg_ofs)) {
+        idx = &p->v2_index[p->v2_msg_next++];
+    }
+    else {
+        /* Not indexed, parse it now */
+        struct pbjson_elem msg;
+        char const*        end = p->http_reply + p->msg_end;
+        char const*        seeker;
+        if (*start != '{') {
+            PUBNUB_LOG_ERROR(
+                "Message subscribe V2 response is not a JSON object\n");
+            return rslt;
         }
-        else {
+        seeker = pbjson_find_end_complex(start, end);
+        if (seeker == end) {
             PUBNUB_LOG_ERROR(
-                "No timetoken value in subscribe V2 response found\n");
+                "Message subscribe V2 response has no endo of JSON object\n");
             return rslt;
         }
+        msg.start = start;
+        msg.end   = seeker + 1;
+        index_v2_message(p, &msg, &parsed);
+        idx = &parsed;
     }
-    else {
-        PUBNUB_LOG_ERROR("No message publish timetoken in subscribe V2 "
-                         "response found, error=%d\n",
-                         jpresult);
+    p->msg_ofs = idx->end + 1;
+
+    if (0 == idx->payload.ofs) {
+        PUBNUB_LOG_ERROR(
+            "pbp=%p: No message payload in subscribe V2 response found\n", pbp);
         return rslt;
     }
-
-    if (jonmpOK == pbjson_get_object_value(&el, "b", &found)) {
-        rslt.match_or_group.ptr  = (char*)found.start;
-        rslt.match_or_group.size = found.end - found.start;
+    if (0 == idx->channel.ofs) {
+        PUBNUB_LOG_ERROR(
+            "pbp=%p: No message channel in subscribe V2 response found\n", pbp);
+        return rslt;
     }
-
-    if (jonmpOK == pbjson_get_object_value(&el, "u", &found)) {
-        rslt.metadata.ptr  = (char*)found.start;
-        rslt.metadata.size = found.end - found.start;
+    if (0 == idx->tt.ofs) {
+        PUBNUB_LOG_ERROR("pbp=%p: No message publish timetoken in subscribe V2 "
+                         "response found\n",
+                         pbp);
+        return rslt;
+    }
+    rslt.payload.ptr  = p->http_reply + idx->payload.ofs;
+    rslt.payload.size = idx->payload.len;
+    rslt.channel.ptr  = p->http_reply + idx->channel.ofs;
+    rslt.channel.size = idx->channel.len;
+    rslt.tt.ptr       = p->http_reply + idx->tt.ofs;
+    rslt.tt.size      = idx->tt.len;
+    rslt.region       = idx->region;
+    rslt.flags        = idx->flags;
+    if (idx->match_or_group.ofs != 0) {
+        rslt.match_or_group.ptr  = p->http_reply + idx->match_or_group.ofs;
+        rslt.match_or_group.size = idx->match_or_group.len;
+    }
+    if (idx->metadata.ofs != 0) {
+        rslt.metadata.ptr  = p->http_reply + idx->metadata.ofs;
+        rslt.metadata.size = idx->metadata.len;
     }
 
     return rslt;
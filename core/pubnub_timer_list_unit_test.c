@@ -3,10 +3,12 @@
 #include "cgreen/mocks.h"
 
 #include "pubnub_timer_list.h"
+#include "pubnub_timer_wheel.h"
 #include "pubnub_timers.h"
 #include "pubnub_alloc.h"
 
 #include "pubnub_ccore.h"
+#include "pubnub_internal.h"
 
 
 #include <stdlib.h>
@@ -51,10 +53,12 @@ void pbcc_deinit(struct pbcc_context *p)
 Describe(pubnub_timer_list);
 
 pubnub_t *m_list;
+struct pubnub_timer_wheel m_wheel;
 
 
 BeforeEach(pubnub_timer_list) {
     m_list = NULL;
+    pubnub_timer_wheel_init(&m_wheel);
 }
 
 
@@ -422,3 +426,182 @@ Ensure(pubnub_timer_list, expire_in_the_middle) {
     pubnub_free(pbp_two);
     pubnub_free(pbp);
 }
+
+
+Ensure(pubnub_timer_list, wheel_expires_not_before_timeout) {
+    pubnub_t *pbp = pubnub_alloc();
+
+    attest(pbp, differs(NULL));
+    pubnub_timer_list_init(pbp);
+    attest(pubnub_set_transaction_timeout(pbp, 1000), equals(0));
+    pubnub_timer_wheel_add(&m_wheel, pbp);
+    attest(pubnub_timer_wheel_next_expiry_ms(&m_wheel), is_greater_than(999));
+    attest(pubnub_timer_wheel_next_expiry_ms(&m_wheel), is_less_than(1000 + PUBNUB_TIMER_WHEEL_TICK_MS));
+
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, 999), equals(NULL));
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, PUBNUB_TIMER_WHEEL_TICK_MS), equals(pbp));
+    attest(pubnub_timer_list_next(pbp), equals(NULL));
+    attest(pubnub_timer_list_previous(pbp), equals(NULL));
+    attest(pubnub_timer_wheel_next_expiry_ms(&m_wheel), equals(-1));
+
+    pubnub_free(pbp);
+}
+
+
+Ensure(pubnub_timer_list, wheel_counts_time_in_small_steps) {
+    int i;
+    pubnub_t *pbp = pubnub_alloc();
+
+    attest(pbp, differs(NULL));
+    pubnub_timer_list_init(pbp);
+    attest(pubnub_set_transaction_timeout(pbp, 1000), equals(0));
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, 7), equals(NULL));
+    pubnub_timer_wheel_add(&m_wheel, pbp);
+
+    for (i = 0; i < 1000 / 7; ++i) {
+        attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, 7), equals(NULL));
+    }
+    for (i = 0; i <= PUBNUB_TIMER_WHEEL_TICK_MS / 7; ++i) {
+        if (pubnub_timer_wheel_as_time_goes_by(&m_wheel, 7) != NULL) {
+            break;
+        }
+    }
+    attest(i, is_not_equal_to(PUBNUB_TIMER_WHEEL_TICK_MS / 7 + 1));
+    attest(pubnub_timer_wheel_next_expiry_ms(&m_wheel), equals(-1));
+
+    pubnub_free(pbp);
+}
+
+
+Ensure(pubnub_timer_list, wheel_remove) {
+    pubnub_t *expired;
+    pubnub_t *pbp = pubnub_alloc();
+    pubnub_t *pbp_two = pubnub_alloc();
+    pubnub_t *pbp_three = pubnub_alloc();
+
+    attest(pbp, differs(NULL));
+    pubnub_timer_list_init(pbp);
+    attest(pubnub_set_transaction_timeout(pbp, 1000), equals(0));
+    pubnub_timer_wheel_add(&m_wheel, pbp);
+
+    attest(pbp_two, differs(NULL));
+    pubnub_timer_list_init(pbp_two);
+    attest(pubnub_set_transaction_timeout(pbp_two, 1000), equals(0));
+    pubnub_timer_wheel_add(&m_wheel, pbp_two);
+
+    attest(pbp_three, differs(NULL));
+    pubnub_timer_list_init(pbp_three);
+    attest(pubnub_set_transaction_timeout(pbp_three, 1000), equals(0));
+    pubnub_timer_wheel_add(&m_wheel, pbp_three);
+
+    pubnub_timer_wheel_remove(&m_wheel, pbp_two);
+    attest(pubnub_timer_list_next(pbp_two), equals(NULL));
+    attest(pubnub_timer_list_previous(pbp_two), equals(NULL));
+    /* Not in the wheel any more, so this does nothing */
+    pubnub_timer_wheel_remove(&m_wheel, pbp_two);
+
+    expired = pubnub_timer_wheel_as_time_goes_by(&m_wheel, 2000);
+    attest(expired, differs(NULL));
+    attest(expired, differs(pbp_two));
+    attest(pubnub_timer_list_next(expired), differs(NULL));
+    attest(pubnub_timer_list_next(expired), differs(pbp_two));
+    attest(pubnub_timer_list_next(pubnub_timer_list_next(expired)), equals(NULL));
+
+    pubnub_timer_wheel_remove(&m_wheel, pbp);
+    pubnub_timer_list_init(pbp);
+    pubnub_timer_wheel_add(&m_wheel, pbp);
+    pubnub_timer_wheel_remove(&m_wheel, pbp);
+    attest(pubnub_timer_wheel_next_expiry_ms(&m_wheel), equals(-1));
+
+    pubnub_free(pbp_three);
+    pubnub_free(pbp_two);
+    pubnub_free(pbp);
+}
+
+
+Ensure(pubnub_timer_list, wheel_timeout_longer_than_a_turn) {
+    int const turn_ms = PUBNUB_TIMER_WHEEL_SLOTS * PUBNUB_TIMER_WHEEL_TICK_MS;
+    pubnub_t *pbp = pubnub_alloc();
+    pubnub_t *pbp_two = pubnub_alloc();
+
+    attest(pbp, differs(NULL));
+    pubnub_timer_list_init(pbp);
+    attest(pubnub_set_transaction_timeout(pbp, 3 * turn_ms + 1000), equals(0));
+    pubnub_timer_wheel_add(&m_wheel, pbp);
+
+    attest(pbp_two, differs(NULL));
+    pubnub_timer_list_init(pbp_two);
+    attest(pubnub_set_transaction_timeout(pbp_two, 1000), equals(0));
+    pubnub_timer_wheel_add(&m_wheel, pbp_two);
+
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, 2000), equals(pbp_two));
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, turn_ms), equals(NULL));
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, turn_ms), equals(NULL));
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, turn_ms - 1000), equals(NULL));
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, PUBNUB_TIMER_WHEEL_TICK_MS), equals(pbp));
+
+    pubnub_timer_list_init(pbp);
+    pubnub_timer_wheel_add(&m_wheel, pbp);
+    /* Much more than a turn at once */
+    attest(pubnub_timer_wheel_as_time_goes_by(&m_wheel, 10 * turn_ms), equals(pbp));
+
+    pubnub_free(pbp_two);
+    pubnub_free(pbp);
+}
+
+
+/* The number of contexts, i.e. timers, in the scale test */
+#define SCALE_CONTEXTS 5000
+
+
+/* Simulates a lot of long-poll (subscribe) contexts, with slightly
+   different timeouts, that reconnect (restart their timer) as time
+   goes by. Both the timer list and the timer wheel should expire all
+   of them. For how they compare in speed, see
+   `samples/timer_wheel_benchmark.c`.
+ */
+Ensure(pubnub_timer_list, many_timers_expire_from_list_and_wheel) {
+    int       i;
+    int       expired_count;
+    pubnub_t *expired;
+    pubnub_t *ctx = (pubnub_t*)calloc(SCALE_CONTEXTS, sizeof *ctx);
+
+    attest(ctx, differs(NULL));
+    for (i = 0; i < SCALE_CONTEXTS; ++i) {
+        ctx[i].transaction_timeout_ms = 310000 + (i * 7919) % 5000;
+    }
+
+    for (i = 0; i < SCALE_CONTEXTS; ++i) {
+        pubnub_timer_list_init(&ctx[i]);
+        m_list = pubnub_timer_list_add(m_list, &ctx[i]);
+    }
+    for (i = 0; i < SCALE_CONTEXTS; i += 2) {
+        m_list = pubnub_timer_list_remove(m_list, &ctx[i]);
+        m_list = pubnub_timer_list_add(m_list, &ctx[i]);
+    }
+    expired_count = 0;
+    expired = pubnub_timer_list_as_time_goes_by(&m_list, 400000);
+    for (; expired != NULL; expired = pubnub_timer_list_next(expired)) {
+        ++expired_count;
+    }
+    attest(expired_count, equals(SCALE_CONTEXTS));
+    attest(m_list, equals(NULL));
+
+    for (i = 0; i < SCALE_CONTEXTS; ++i) {
+        pubnub_timer_list_init(&ctx[i]);
+        pubnub_timer_wheel_add(&m_wheel, &ctx[i]);
+    }
+    for (i = 0; i < SCALE_CONTEXTS; i += 2) {
+        pubnub_timer_wheel_remove(&m_wheel, &ctx[i]);
+        pubnub_timer_wheel_add(&m_wheel, &ctx[i]);
+    }
+    expired_count = 0;
+    expired = pubnub_timer_wheel_as_time_goes_by(&m_wheel, 400000);
+    for (; expired != NULL; expired = pubnub_timer_list_next(expired)) {
+        ++expired_count;
+    }
+    attest(expired_count, equals(SCALE_CONTEXTS));
+    attest(pubnub_timer_wheel_next_expiry_ms(&m_wheel), equals(-1));
+
+    free(ctx);
+}
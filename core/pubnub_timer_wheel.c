@@ -0,0 +1,173 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_timer_wheel.h"
+
+#include "pubnub_internal.h"
+#include "pubnub_assert.h"
+#include "pubnub_log.h"
+
+#include <string.h>
+
+
+/** Returns whether the tick @p tick has come by the tick @p now,
+    taking into account that ticks wrap around.
+ */
+static int has_come(unsigned tick, unsigned now)
+{
+    return (int)(tick - now) <= 0;
+}
+
+
+static pubnub_t** slot_of(struct pubnub_timer_wheel* wheel, unsigned tick)
+{
+    return wheel->slot + (tick % PUBNUB_TIMER_WHEEL_SLOTS);
+}
+
+
+static void unlink_from_slot(pubnub_t** slot, pubnub_t* pbp)
+{
+    if (NULL == pbp->previous) {
+        *slot = pbp->next;
+    }
+    else {
+        pbp->previous->next = pbp->next;
+    }
+    if (pbp->next != NULL) {
+        pbp->next->previous = pbp->previous;
+    }
+    pbp->previous = pbp->next = NULL;
+}
+
+
+void pubnub_timer_wheel_init(struct pubnub_timer_wheel* wheel)
+{
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+    memset(wheel, 0, sizeof *wheel);
+}
+
+
+void pubnub_timer_wheel_add(struct pubnub_timer_wheel* wheel, pubnub_t* to_add)
+{
+    pubnub_t** slot;
+    int        ticks;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+    PUBNUB_ASSERT_OPT(to_add != NULL);
+
+    /* Part of the current tick has already passed, so count the
+       timeout from its start, to not expire before time.
+     */
+    ticks = (to_add->transaction_timeout_ms + wheel->ms_residue
+             + PUBNUB_TIMER_WHEEL_TICK_MS - 1)
+            / PUBNUB_TIMER_WHEEL_TICK_MS;
+    if (ticks < 1) {
+        ticks = 1;
+    }
+    to_add->expiry_tick = wheel->now + ticks;
+    slot                = slot_of(wheel, to_add->expiry_tick);
+
+    PUBNUB_LOG_TRACE("pubnub_timer_wheel_add(wheel=%p, to_add=%p): "
+                     "transaction_timeout_ms=%d, now=%u, expiry_tick=%u\n",
+                     wheel, to_add, to_add->transaction_timeout_ms,
+                     wheel->now, to_add->expiry_tick);
+
+    PUBNUB_ASSERT_OPT(*slot != to_add);
+    to_add->previous = NULL;
+    to_add->next     = *slot;
+    if (*slot != NULL) {
+        (*slot)->previous = to_add;
+    }
+    *slot = to_add;
+    ++wheel->count;
+}
+
+
+void pubnub_timer_wheel_remove(struct pubnub_timer_wheel* wheel, pubnub_t* to_remove)
+{
+    pubnub_t** slot;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+    PUBNUB_ASSERT_OPT(to_remove != NULL);
+
+    slot = slot_of(wheel, to_remove->expiry_tick);
+    if ((NULL == to_remove->previous) && (*slot != to_remove)) {
+        PUBNUB_LOG_TRACE("pubnub_timer_wheel_remove(wheel=%p, to_remove=%p): "
+                         "not in the wheel\n",
+                         wheel, to_remove);
+        return;
+    }
+    unlink_from_slot(slot, to_remove);
+    PUBNUB_ASSERT(wheel->count > 0);
+    --wheel->count;
+}
+
+
+pubnub_t* pubnub_timer_wheel_as_time_goes_by(struct pubnub_timer_wheel* wheel,
+                                             int time_passed_ms)
+{
+    pubnub_t* expired_list = NULL;
+    pubnub_t* expired_tail = NULL;
+    unsigned  ticks;
+    unsigned  to_visit;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+    PUBNUB_ASSERT_OPT(time_passed_ms > 0);
+
+    time_passed_ms += wheel->ms_residue;
+    ticks             = time_passed_ms / PUBNUB_TIMER_WHEEL_TICK_MS;
+    wheel->ms_residue = time_passed_ms % PUBNUB_TIMER_WHEEL_TICK_MS;
+    if (0 == ticks) {
+        return NULL;
+    }
+    wheel->now += ticks;
+    if (0 == wheel->count) {
+        return NULL;
+    }
+
+    /* If more than a whole turn has passed, each slot is visited
+       only once, as all that has expired in it can be found in one
+       visit.
+     */
+    to_visit = (ticks < PUBNUB_TIMER_WHEEL_SLOTS) ? ticks : PUBNUB_TIMER_WHEEL_SLOTS;
+    while (to_visit-- > 0) {
+        pubnub_t** slot = slot_of(wheel, wheel->now - to_visit);
+        pubnub_t*  pbp  = *slot;
+        while (pbp != NULL) {
+            pubnub_t* next = pbp->next;
+            if (has_come(pbp->expiry_tick, wheel->now)) {
+                unlink_from_slot(slot, pbp);
+                --wheel->count;
+                if (NULL == expired_tail) {
+                    expired_list = pbp;
+                }
+                else {
+                    expired_tail->next = pbp;
+                    pbp->previous      = expired_tail;
+                }
+                expired_tail = pbp;
+            }
+            pbp = next;
+        }
+    }
+
+    return expired_list;
+}
+
+
+int pubnub_timer_wheel_next_expiry_ms(struct pubnub_timer_wheel const* wheel)
+{
+    unsigned i;
+
+    PUBNUB_ASSERT_OPT(wheel != NULL);
+
+    if (0 == wheel->count) {
+        return -1;
+    }
+    for (i = 1; i <= PUBNUB_TIMER_WHEEL_SLOTS; ++i) {
+        if (wheel->slot[(wheel->now + i) % PUBNUB_TIMER_WHEEL_SLOTS] != NULL) {
+            return i * PUBNUB_TIMER_WHEEL_TICK_MS - wheel->ms_residue;
+        }
+    }
+    PUBNUB_ASSERT(0 == wheel->count);
+
+    return -1;
+}
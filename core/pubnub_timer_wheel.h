@@ -0,0 +1,93 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_TIMER_WHEEL
+#define	INC_PUBNUB_TIMER_WHEEL
+
+
+#include "pubnub_api_types.h"
+
+
+/** Duration of one tick of the timer wheel, in milliseconds. This is
+    the resolution of the timers in the wheel - a timer will expire
+    at most this much later than requested (but never sooner).
+ */
+#if !defined PUBNUB_TIMER_WHEEL_TICK_MS
+#define PUBNUB_TIMER_WHEEL_TICK_MS 64
+#endif
+
+/** Number of slots in the timer wheel. One "turn" of the wheel is
+    `PUBNUB_TIMER_WHEEL_SLOTS * PUBNUB_TIMER_WHEEL_TICK_MS`
+    milliseconds. Timers longer than that are still fine, they just
+    stay in their slot for more than one turn.
+ */
+#if !defined PUBNUB_TIMER_WHEEL_SLOTS
+#define PUBNUB_TIMER_WHEEL_SLOTS 1024
+#endif
+
+
+/** A hashed timer wheel of Pubnub contexts (their transaction
+    timers). Each context is kept in the (doubly linked) list of the
+    slot of the tick on which it expires, so adding and removing a
+    timer is O(1), regardless of the number of timers, unlike the
+    timer list (@see pubnub_timer_list.h) where adding is O(n).
+
+    Uses the same links in the context as the timer list, so a context
+    can be either in a timer list or in a timer wheel, but not both.
+ */
+struct pubnub_timer_wheel {
+    /** Number of ticks since the wheel was initialized (wraps around) */
+    unsigned now;
+    /** Milliseconds that have passed, but don't yet add up to a
+        whole tick */
+    int ms_residue;
+    /** Number of timers in the wheel */
+    unsigned count;
+    /** The slots, each is the head of a list of contexts */
+    pubnub_t* slot[PUBNUB_TIMER_WHEEL_SLOTS];
+};
+
+
+/** Initialize the timer wheel @p wheel - to be empty. */
+void pubnub_timer_wheel_init(struct pubnub_timer_wheel* wheel);
+
+/** Add a Pubnub context @p to_add to the timer @p wheel. It will
+    expire after its transaction timeout passes.
+
+    @pre wheel != NULL
+    @pre to_add != NULL
+    @pre @p to_add is not in @p wheel
+ */
+void pubnub_timer_wheel_add(struct pubnub_timer_wheel* wheel, pubnub_t* to_add);
+
+/** Remove a Pubnub context @p to_remove from the timer @p wheel.
+    Unlike pubnub_timer_list_remove(), it is not a precondition that
+    @p to_remove is in @p wheel - if it's not, nothing is done.
+
+    @pre wheel != NULL
+    @pre to_remove != NULL
+ */
+void pubnub_timer_wheel_remove(struct pubnub_timer_wheel*  wheel,
+                               pubnub_t*                   to_remove);
+
+/** Advances the timer @p wheel for @p time_passed_ms, and dequeues
+    all the timers that have expired in that time, returning them in
+    a list, just like pubnub_timer_list_as_time_goes_by() does.
+
+    @pre wheel != NULL
+    @pre time_passed_ms > 0
+    @return List of expired timers (NULL if none have expired),
+    use pubnub_timer_list_next() to iterate over it
+ */
+pubnub_t* pubnub_timer_wheel_as_time_goes_by(struct pubnub_timer_wheel* wheel,
+                                             int time_passed_ms);
+
+/** Returns the number of milliseconds until the next timer in
+    the @p wheel might expire. It might not expire then, but
+    none will expire sooner. If there are no timers in the
+    @p wheel, returns -1.
+
+    @pre wheel != NULL
+ */
+int pubnub_timer_wheel_next_expiry_ms(struct pubnub_timer_wheel const* wheel);
+
+
+#endif /* !defined INC_PUBNUB_TIMER_WHEEL */
@@ -0,0 +1,270 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_callback.h"
+
+#include "core/pubnub_helper.h"
+#include "core/pubnub_mutex.h"
+#include "core/pubnub_free_with_timeout.h"
+#include "core/pubnub_proxy.h"
+#if PUBNUB_USE_SSL
+#include "core/pubnub_ssl.h"
+#endif
+
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** @file fsm_stepping_benchmark.c
+
+    Drives the transaction FSM of N contexts against a stub HTTP
+    server on the loopback interface, to measure how many transactions
+    per second the callback thread can process. As the stub answers
+    right away, and all connections are kept alive, almost all of the
+    time is spent stepping the FSMs of the contexts, so this shows the
+    effect of the layout of the context (how many cache lines are
+    touched on each step) on throughput.
+
+    The contexts reach the stub through a (numeric) HTTP GET proxy,
+    which is the stub itself, so there's no DNS resolution involved.
+
+    Usage: fsm_stepping_benchmark [contexts [seconds]]
+*/
+
+/** The maximum number of contexts we drive. Each takes two sockets
+    (its own and the one the stub accepted), and connecting uses
+    `select()`, so all must fit in `FD_SETSIZE`.
+*/
+#define MAX_CONTEXTS 500
+
+/** The response to a `time` transaction */
+static char const m_response[] = "HTTP/1.1 200 OK\r\n"
+                                 "Content-Type: application/json\r\n"
+                                 "Connection: keep-alive\r\n"
+                                 "Content-Length: 19\r\n"
+                                 "\r\n"
+                                 "[15000000000000000]";
+
+static volatile int m_stop;
+static unsigned long m_done pubnub_guarded_by(m_lock);
+static unsigned long m_failed pubnub_guarded_by(m_lock);
+pubnub_mutex_static_decl_and_init(m_lock);
+
+
+/** The stub server. Accepts connections and answers each request
+    (recognized by the empty line ending its headers) on them with
+    #m_response.
+*/
+static void* stub_server(void* arg)
+{
+    int            listener = *(int*)arg;
+    struct pollfd  fds[MAX_CONTEXTS + 1];
+    unsigned char  matched[MAX_CONTEXTS + 1];
+    nfds_t         n = 1;
+    int            one = 1;
+
+    fds[0].fd     = listener;
+    fds[0].events = POLLIN;
+    while (!m_stop) {
+        nfds_t i;
+        if (poll(fds, n, 100) <= 0) {
+            continue;
+        }
+        if ((fds[0].revents & POLLIN) && (n < MAX_CONTEXTS + 1)) {
+            int s = accept(listener, NULL, NULL);
+            if (s >= 0) {
+                fds[n].fd     = s;
+                fds[n].events = POLLIN;
+                matched[n]    = 0;
+                ++n;
+            }
+        }
+        for (i = 1; i < n; ++i) {
+            char    buf[2048];
+            ssize_t got;
+            ssize_t j;
+            if (0 == (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            got = read(fds[i].fd, buf, sizeof buf);
+            setsockopt(fds[i].fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof one);
+            if (got <= 0) {
+                close(fds[i].fd);
+                fds[i]     = fds[n - 1];
+                matched[i] = matched[n - 1];
+                --n;
+                --i;
+                continue;
+            }
+            for (j = 0; j < got; ++j) {
+                if (buf[j] == "\r\n\r\n"[matched[i]]) {
+                    if (4 == ++matched[i]) {
+                        if (write(fds[i].fd, m_response, sizeof m_response - 1)
+                            < 0) {
+                            break;
+                        }
+                        matched[i] = 0;
+                    }
+                }
+                else {
+                    matched[i] = ('\r' == buf[j]) ? 1 : 0;
+                }
+            }
+        }
+    }
+    while (n > 1) {
+        close(fds[--n].fd);
+    }
+
+    return NULL;
+}
+
+
+static int start_stub_server(uint16_t* port)
+{
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof addr;
+    int                s   = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (s < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(s, (struct sockaddr*)&addr, sizeof addr) != 0)
+        || (listen(s, SOMAXCONN) != 0)
+        || (getsockname(s, (struct sockaddr*)&addr, &len) != 0)) {
+        close(s);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+
+    return s;
+}
+
+
+static void time_callback(pubnub_t*         pb,
+                          enum pubnub_trans trans,
+                          enum pubnub_res   result,
+                          void*             user_data)
+{
+    PUBNUB_UNUSED(trans);
+    PUBNUB_UNUSED(user_data);
+    pubnub_mutex_lock(m_lock);
+    if (PNR_OK == result) {
+        ++m_done;
+    }
+    else {
+        ++m_failed;
+    }
+    pubnub_mutex_unlock(m_lock);
+    /* The reply has to be read before starting another transaction */
+    while (pubnub_get(pb) != NULL) {
+    }
+    if (!m_stop) {
+        pubnub_time(pb);
+    }
+}
+
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char* argv[])
+{
+    unsigned      contexts = (argc > 1) ? (unsigned)atoi(argv[1]) : MAX_CONTEXTS;
+    unsigned      seconds  = (argc > 2) ? (unsigned)atoi(argv[2]) : 5;
+    pubnub_t**    pbp;
+    pthread_t     server;
+    int           listener;
+    uint16_t      port;
+    unsigned      i;
+    unsigned long warmed_up;
+    unsigned long done;
+    double        start;
+    double        elapsed;
+
+    if ((0 == contexts) || (contexts > MAX_CONTEXTS) || (0 == seconds)) {
+        printf("Usage: %s [contexts (1-%d) [seconds]]\n", argv[0], MAX_CONTEXTS);
+        return -1;
+    }
+    pubnub_mutex_init_static(m_lock);
+    listener = start_stub_server(&port);
+    if (listener < 0) {
+        puts("Failed to start the stub server");
+        return -1;
+    }
+    if (pthread_create(&server, NULL, stub_server, &listener) != 0) {
+        puts("Failed to start the stub server thread");
+        return -1;
+    }
+    pbp = (pubnub_t**)calloc(contexts, sizeof *pbp);
+    if (NULL == pbp) {
+        puts("Out of memory");
+        return -1;
+    }
+    for (i = 0; i < contexts; ++i) {
+        pbp[i] = pubnub_alloc();
+        if (NULL == pbp[i]) {
+            printf("Failed to allocate context %u\n", i);
+            return -1;
+        }
+        pubnub_init(pbp[i], "demo", "demo");
+#if PUBNUB_USE_SSL
+        pubnub_set_ssl_options(pbp[i], false, false);
+#endif
+        pubnub_set_proxy_manual(pbp[i], pbproxyHTTP_GET, "127.0.0.1", port);
+        pubnub_register_callback(pbp[i], time_callback, NULL);
+    }
+
+    printf("Driving %u contexts against the stub on port %u for %u s\n",
+           contexts,
+           (unsigned)port,
+           seconds);
+    for (i = 0; i < contexts; ++i) {
+        pubnub_time(pbp[i]);
+    }
+    /* Let all the contexts connect before we start measuring */
+    sleep(1);
+    pubnub_mutex_lock(m_lock);
+    warmed_up = m_done;
+    pubnub_mutex_unlock(m_lock);
+    start = now();
+    sleep(seconds);
+    pubnub_mutex_lock(m_lock);
+    done = m_done - warmed_up;
+    pubnub_mutex_unlock(m_lock);
+    elapsed = now() - start;
+
+    m_stop = 1;
+    printf("%lu transactions in %.3f s: %.0f transactions/s, %lu failed\n",
+           done,
+           elapsed,
+           done / elapsed,
+           m_failed);
+
+    for (i = 0; i < contexts; ++i) {
+        if (pubnub_free_with_timeout(pbp[i], 1500) != 0) {
+            printf("Failed to free context %u in due time\n", i);
+        }
+    }
+    free(pbp);
+    pthread_join(server, NULL);
+    close(listener);
+
+    return 0;
+}
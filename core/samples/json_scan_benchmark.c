@@ -0,0 +1,196 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pubnub_json_parse.h"
+#include "core/pubnub_ccore_pubsub.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** @file json_scan_benchmark.c
+
+    Compares finding the end of (pbjson_find_end_complex()) and
+    splitting (pbcc_split_array()) a subscribe V1 (or history) like
+    response, with many messages, with doing the same one character at
+    a time, the way it was done before the JSON scanning looked at 16
+    (or 32) characters at a time.
+
+    The response is synthetic, most of it is inside strings, which is
+    what scanning skips most of the time.
+
+    Usage: json_scan_benchmark [messages]
+*/
+
+/** The default number of messages in the response */
+#define DEFAULT_MESSAGES 3000
+
+/** How many times to go over the response */
+#define ROUNDS 50
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+
+static char const* one_at_a_time_find_end_complex(char const* start, char const* end)
+{
+    bool        in_string = false, in_escape = false;
+    int         bracket_level = 0, brace_level = 0;
+    char const* s;
+
+    for (s = start; (s < end) && (*s != '\0'); ++s) {
+        if (!in_string) {
+            switch (*s) {
+            case '{':
+                ++brace_level;
+                break;
+            case '}':
+                if ((--brace_level == 0) && (0 == bracket_level)) {
+                    return s;
+                }
+                break;
+            case '[':
+                ++bracket_level;
+                break;
+            case ']':
+                if ((--bracket_level == 0) && (0 == brace_level)) {
+                    return s;
+                }
+                break;
+            case '"':
+                in_string = true;
+                in_escape = false;
+                break;
+            default:
+                break;
+            }
+        }
+        else if ('\\' == *s) {
+            in_escape = !in_escape;
+        }
+        else {
+            if (('"' == *s) && !in_escape) {
+                in_string = false;
+            }
+            in_escape = false;
+        }
+    }
+    return s;
+}
+
+
+static bool one_at_a_time_split_array(char* buf)
+{
+    bool escaped       = false;
+    bool in_string     = false;
+    int  bracket_level = 0;
+
+    for (; *buf != '\0'; ++buf) {
+        if (escaped) {
+            escaped = false;
+        }
+        else if ('"' == *buf) {
+            in_string = !in_string;
+        }
+        else if (in_string) {
+            escaped = ('\\' == *buf);
+        }
+        else if (('[' == *buf) || ('{' == *buf)) {
+            bracket_level++;
+        }
+        else if ((']' == *buf) || ('}' == *buf)) {
+            bracket_level--;
+        }
+        else if ((',' == *buf) && (0 == bracket_level)) {
+            *buf = '\0';
+        }
+    }
+    return !(escaped || in_string || (bracket_level > 0));
+}
+
+
+static char* make_subscribe_like_payload(int messages, size_t* len)
+{
+    int   i;
+    char* rslt = (char*)malloc(messages * 300 + 100);
+    char* s    = rslt;
+
+    if (NULL == rslt) {
+        return NULL;
+    }
+    s += sprintf(s, "[[");
+    for (i = 0; i < messages; ++i) {
+        s += sprintf(s,
+                     "%s{\"n\":%d,\"text\":\"%0150d\",\"q\":\"a \\\"quoted\\\" "
+                     "[word]\",\"l\":[1,2,{\"x\":\"%060d\"}]}",
+                     (i > 0) ? "," : "",
+                     i,
+                     i,
+                     i);
+    }
+    s += sprintf(s, "],\"15000000000000000\"]");
+    *len = s - rslt;
+
+    return rslt;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int         messages = (argc > 1) ? atoi(argv[1]) : DEFAULT_MESSAGES;
+    size_t      len;
+    char*       payload;
+    char*       copy;
+    char const* found = NULL;
+    char const* ref   = NULL;
+    bool        split_ok = true;
+    double      start;
+    double      scan_ms;
+    double      one_ms;
+    int         i;
+
+    if (messages <= 0) {
+        printf("Usage: %s [messages]\n", argv[0]);
+        return -1;
+    }
+    payload = make_subscribe_like_payload(messages, &len);
+    copy    = (NULL == payload) ? NULL : (char*)malloc(len + 1);
+    if (NULL == copy) {
+        free(payload);
+        puts("Out of memory");
+        return -1;
+    }
+
+    start = now_ms();
+    for (i = 0; i < ROUNDS; ++i) {
+        found = pbjson_find_end_complex(payload + 1, payload + len);
+        memcpy(copy, payload, len + 1);
+        split_ok = pbcc_split_array(copy + 1) && split_ok;
+    }
+    scan_ms = now_ms() - start;
+
+    start = now_ms();
+    for (i = 0; i < ROUNDS; ++i) {
+        ref = one_at_a_time_find_end_complex(payload + 1, payload + len);
+        memcpy(copy, payload, len + 1);
+        split_ok = one_at_a_time_split_array(copy + 1) && split_ok;
+    }
+    one_ms = now_ms() - start;
+
+    printf("%lu octets x %d: scan %.1f ms, one at a time %.1f ms\n",
+           (unsigned long)len,
+           ROUNDS,
+           scan_ms,
+           one_ms);
+    free(copy);
+    free(payload);
+
+    return ((found == ref) && split_ok) ? 0 : -1;
+}
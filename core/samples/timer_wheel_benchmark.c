@@ -0,0 +1,124 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "core/pubnub_timer_list.h"
+#include "core/pubnub_timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+/** @file timer_wheel_benchmark.c
+
+    Compares the (sorted, delta) timer list with the timer wheel on a
+    lot of long-poll (subscribe) contexts, with slightly different
+    timeouts, half of which reconnect (restart their timer) before
+    all of them expire. Adding to the timer list is O(n), adding to
+    the timer wheel is O(1), so with many contexts the wheel should
+    be much faster.
+
+    Only the timers of the contexts are used, the contexts are not
+    initialized (nor allocated with pubnub_alloc()).
+
+    Usage: timer_wheel_benchmark [contexts]
+*/
+
+/** The default number of contexts, i.e. timers */
+#define DEFAULT_CONTEXTS 5000
+
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+
+static double time_list(pubnub_t* ctx, int n, int* expired_count)
+{
+    pubnub_t* list = NULL;
+    pubnub_t* expired;
+    double    start = now_ms();
+    int       i;
+
+    for (i = 0; i < n; ++i) {
+        pubnub_timer_list_init(&ctx[i]);
+        list = pubnub_timer_list_add(list, &ctx[i]);
+    }
+    for (i = 0; i < n; i += 2) {
+        list = pubnub_timer_list_remove(list, &ctx[i]);
+        list = pubnub_timer_list_add(list, &ctx[i]);
+    }
+    *expired_count = 0;
+    expired = pubnub_timer_list_as_time_goes_by(&list, 400000);
+    for (; expired != NULL; expired = pubnub_timer_list_next(expired)) {
+        ++*expired_count;
+    }
+
+    return now_ms() - start;
+}
+
+
+static double time_wheel(pubnub_t* ctx, int n, int* expired_count)
+{
+    struct pubnub_timer_wheel wheel;
+    pubnub_t*                 expired;
+    double                    start = now_ms();
+    int                       i;
+
+    pubnub_timer_wheel_init(&wheel);
+    for (i = 0; i < n; ++i) {
+        pubnub_timer_list_init(&ctx[i]);
+        pubnub_timer_wheel_add(&wheel, &ctx[i]);
+    }
+    for (i = 0; i < n; i += 2) {
+        pubnub_timer_wheel_remove(&wheel, &ctx[i]);
+        pubnub_timer_wheel_add(&wheel, &ctx[i]);
+    }
+    *expired_count = 0;
+    expired = pubnub_timer_wheel_as_time_goes_by(&wheel, 400000);
+    for (; expired != NULL; expired = pubnub_timer_list_next(expired)) {
+        ++*expired_count;
+    }
+
+    return now_ms() - start;
+}
+
+
+int main(int argc, char* argv[])
+{
+    int       n = (argc > 1) ? atoi(argv[1]) : DEFAULT_CONTEXTS;
+    pubnub_t* ctx;
+    int       i;
+    int       list_expired;
+    int       wheel_expired;
+    double    list_ms;
+    double    wheel_ms;
+
+    if (n <= 0) {
+        printf("Usage: %s [contexts]\n", argv[0]);
+        return -1;
+    }
+    ctx = (pubnub_t*)calloc(n, sizeof *ctx);
+    if (NULL == ctx) {
+        puts("Out of memory");
+        return -1;
+    }
+    for (i = 0; i < n; ++i) {
+        ctx[i].transaction_timeout_ms = 310000 + (i * 7919) % 5000;
+    }
+
+    list_ms  = time_list(ctx, n, &list_expired);
+    wheel_ms = time_wheel(ctx, n, &wheel_expired);
+    printf("%d timers: list %.1f ms (%d expired), wheel %.1f ms (%d expired)\n",
+           n,
+           list_ms,
+           list_expired,
+           wheel_ms,
+           wheel_expired);
+    free(ctx);
+
+    return ((list_expired == n) && (wheel_expired == n)) ? 0 : -1;
+}
@@ -114,6 +114,11 @@
 #define PUBNUB_RECEIVE_GZIP_RESPONSE 1
 #endif
 
+#if PUBNUB_USE_GZIP_COMPRESSION
+// Maximum compressed message length allowed
+#define PUBNUB_COMPRESSED_MAXLEN 32000
+#endif
+
 #define PUBNUB_DEFAULT_TRANSACTION_TIMER    310000
 
 #define PUBNUB_MIN_TRANSACTION_TIMER 200
@@ -124,5 +129,15 @@
 #define PUBNUB_USE_ADVANCED_HISTORY 1
 #endif
 
+#if !defined(PUBNUB_SUBSCRIBE_STREAMING)
+/** Unit test the streaming of subscribe messages */
+#define PUBNUB_SUBSCRIBE_STREAMING 1
+#endif
+
+#if !defined(PUBNUB_PUBLISH_PIPELINE)
+/** Unit test the publish pipeline */
+#define PUBNUB_PUBLISH_PIPELINE 1
+#endif
+
 
 #endif /* !defined INC_PUBNUB_CONFIG */
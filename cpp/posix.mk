@@ -1,4 +1,4 @@
-SOURCEFILES = ../core/pubnub_pubsubapi.c ../core/pubnub_coreapi.c ../core/pubnub_coreapi_ex.c ../core/pubnub_ccore_pubsub.c ../core/pubnub_ccore.c ../core/pubnub_netcore.c  ../lib/sockets/pbpal_sockets.c ../lib/sockets/pbpal_resolv_and_connect_sockets.c ../core/pubnub_alloc_std.c ../core/pubnub_assert_std.c ../core/pubnub_generate_uuid.c ../core/pubnub_blocking_io.c ../posix/posix_socket_blocking_io.c ../core/pubnub_timers.c ../core/pubnub_json_parse.c ../lib/md5/md5.c ../lib/base64/pbbase64.c ../core/pubnub_helper.c pubnub_version_posix.cpp ../posix/pubnub_generate_uuid_posix.c ../posix/pbpal_posix_blocking_io.c ../core/pubnub_free_with_timeout_std.c pubnub_subloop.cpp ../posix/msstopwatch_monotonic_clock.c ../core/pubnub_url_encode.c
+SOURCEFILES = ../core/pubnub_pubsubapi.c ../core/pubnub_coreapi.c ../core/pubnub_coreapi_ex.c ../core/pubnub_ccore_pubsub.c ../core/pubnub_ccore.c ../core/pbbuf_pool.c ../core/pubnub_netcore.c  ../lib/sockets/pbpal_sockets.c ../lib/sockets/pbpal_resolv_and_connect_sockets.c ../core/pubnub_alloc_std.c ../core/pubnub_assert_std.c ../core/pubnub_generate_uuid.c ../core/pubnub_blocking_io.c ../posix/posix_socket_blocking_io.c ../core/pubnub_timers.c ../core/pubnub_json_parse.c ../lib/md5/md5.c ../lib/base64/pbbase64.c ../core/pubnub_helper.c pubnub_version_posix.cpp ../posix/pubnub_generate_uuid_posix.c ../posix/pbpal_posix_blocking_io.c ../core/pubnub_free_with_timeout_std.c pubnub_subloop.cpp ../posix/msstopwatch_monotonic_clock.c ../core/pubnub_url_encode.c
 
 ifndef ONLY_PUBSUB_API
 ONLY_PUBSUB_API = 0
@@ -36,6 +36,10 @@ endif
 ifeq ($(RECEIVE_GZIP_RESPONSE), 1)
 SOURCEFILES += ../lib/miniz/miniz_tinfl.c ../core/pbgzip_decompress.c
 OBJFILES += miniz_tinfl.o pbgzip_decompress.o
+ifneq ($(USE_GZIP_COMPRESSION), 1)
+SOURCEFILES += ../lib/pbcrc32.c
+OBJFILES += pbcrc32.o
+endif
 endif
 
 ifeq ($(USE_SUBSCRIBE_V2), 1)
@@ -80,16 +84,24 @@ pubnub_sync_subloop_sample: samples/pubnub_subloop_sample.cpp $(SOURCEFILES) ../
 	$(CXX) -o $@ $(CFLAGS)  -x c++ samples/pubnub_subloop_sample.cpp ../core/pubnub_ntf_sync.c pubnub_futres_sync.cpp $(SOURCEFILES) $(LDLIBS)
 
 ##
-# The socket poller module to use. You should use the `poll` poller, it
-# doesn't have the weird restrictions of `select` poller. OTOH,
-# select() on Windows is compatible w/BSD sockets select(), while
-# WSAPoll() has some weird differences to poll().  The names are the
-# same until the last `_`, then it's `poll` vs `select`.
-SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_poll.c
-SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_poll.o
-
-CALLBACK_INTF_SOURCEFILES= ../posix/pubnub_ntf_callback_posix.c ../posix/pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c $(SOCKET_POLLER_C)  ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c
-CALLBACK_INTF_OBJFILES=pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pbpal_adns_sockets.o pubnub_dns_codec.o $(SOCKET_POLLER_OBJ) pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o
+# The socket poller module to use. On Linux we use the `epoll` poller,
+# which scales to many contexts (its operations don't depend on the
+# number of sockets watched). Elsewhere use the `poll` poller, it
+# doesn't have the weird restrictions of `select` poller. The names
+# are the same until the last `_`, then it's `epoll`, `poll` or
+# `select`. Set SOCKET_POLLER to override.
+ifndef SOCKET_POLLER
+ifeq ($(shell uname),Linux)
+SOCKET_POLLER = epoll
+else
+SOCKET_POLLER = poll
+endif
+endif
+SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_$(SOCKET_POLLER).c
+SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_$(SOCKET_POLLER).o
+
+CALLBACK_INTF_SOURCEFILES= ../posix/pubnub_ntf_callback_posix.c ../posix/pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../core/pubnub_timer_wheel.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c ../lib/pubnub_dns_cache.c $(SOCKET_POLLER_C)  ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c ../core/pubnub_publish_queue.c ../core/pubnub_publish_batch.c
+CALLBACK_INTF_OBJFILES=pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pubnub_timer_wheel.o pbpal_adns_sockets.o pubnub_dns_codec.o pubnub_dns_cache.o $(SOCKET_POLLER_OBJ) pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o pubnub_publish_queue.o pubnub_publish_batch.o
 
 ifndef USE_DNS_SERVERS
 USE_DNS_SERVERS = 1
@@ -1,4 +1,4 @@
-SOURCEFILES = ../core/pubnub_pubsubapi.c ../core/pubnub_coreapi.c ../core/pubnub_ccore_pubsub.c ../core/pubnub_ccore.c ../core/pubnub_netcore.c ../lib/sockets/pbpal_resolv_and_connect_sockets.c ../openssl/pbpal_openssl.c ../openssl/pbpal_connect_openssl.c  ../openssl/pbpal_add_system_certs_posix.c ../core/pubnub_alloc_std.c ../core/pubnub_assert_std.c ../core/pubnub_generate_uuid.c ../core/pubnub_blocking_io.c ../posix/posix_socket_blocking_io.c ../core/pubnub_free_with_timeout_std.c ../core/pubnub_timers.c ../core/pubnub_json_parse.c ../lib/md5/md5.c ../lib/base64/pbbase64.c ../core/pubnub_helper.c pubnub_version_posix.cpp ../posix/pubnub_generate_uuid_posix.c ../openssl/pbpal_openssl_blocking_io.c ../core/pubnub_crypto.c ../core/pubnub_coreapi_ex.c ../openssl/pbaes256.c ../posix/msstopwatch_monotonic_clock.c ../core/pubnub_url_encode.c
+SOURCEFILES = ../core/pubnub_pubsubapi.c ../core/pubnub_coreapi.c ../core/pubnub_ccore_pubsub.c ../core/pubnub_ccore.c ../core/pbbuf_pool.c ../core/pubnub_netcore.c ../lib/sockets/pbpal_resolv_and_connect_sockets.c ../openssl/pbpal_openssl.c ../openssl/pbpal_connect_openssl.c ../openssl/pbpal_ssl_ctx_cache.c  ../openssl/pbpal_add_system_certs_posix.c ../core/pubnub_alloc_std.c ../core/pubnub_assert_std.c ../core/pubnub_generate_uuid.c ../core/pubnub_blocking_io.c ../posix/posix_socket_blocking_io.c ../core/pubnub_free_with_timeout_std.c ../core/pubnub_timers.c ../core/pubnub_json_parse.c ../lib/md5/md5.c ../lib/base64/pbbase64.c ../core/pubnub_helper.c pubnub_version_posix.cpp ../posix/pubnub_generate_uuid_posix.c ../openssl/pbpal_openssl_blocking_io.c ../core/pubnub_crypto.c ../core/pubnub_coreapi_ex.c ../openssl/pbaes256.c ../posix/msstopwatch_monotonic_clock.c ../core/pubnub_url_encode.c
 
 ifndef ONLY_PUBSUB_API
 ONLY_PUBSUB_API = 0
@@ -36,6 +36,10 @@ endif
 ifeq ($(RECEIVE_GZIP_RESPONSE), 1)
 SOURCEFILES += ../lib/miniz/miniz_tinfl.c ../core/pbgzip_decompress.c
 OBJFILES += miniz_tinfl.o pbgzip_decompress.o
+ifneq ($(USE_GZIP_COMPRESSION), 1)
+SOURCEFILES += ../lib/pbcrc32.c
+OBJFILES += pbcrc32.o
+endif
 endif
 
 ifeq ($(USE_SUBSCRIBE_V2), 1)
@@ -78,16 +82,24 @@ openssl/fntest_runner: fntest/pubnub_fntest_runner.cpp $(SOURCEFILES)  ../core/p
 	$(CXX) -o $@ --std=c++11 $(CFLAGS) -x c++ fntest/pubnub_fntest_runner.cpp ../core/pubnub_ntf_sync.c ../core/srand_from_pubnub_time.c pubnub_futres_sync.cpp fntest/pubnub_fntest.cpp fntest/pubnub_fntest_basic.cpp fntest/pubnub_fntest_medium.cpp $(SOURCEFILES) $(LDLIBS) 
 
 ##
-# The socket poller module to use. You should use the `poll` poller it
-# doesn't have the weird restrictions of `select` poller. OTOH,
-# select() on Windows is compatible w/BSD sockets select(), while
-# WSAPoll() has some weird differences to poll().  The names are the
-# same until the last `_`, then it's `poll` vs `select.
-SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_poll.c
-SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_poll.o
-
-CALLBACK_INTF_SOURCEFILES= ../openssl/pubnub_ntf_callback_posix.c ../openssl/pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c $(SOCKET_POLLER_C) ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c
-CALLBACK_INTF_OBJFILES= pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pbpal_adns_sockets.o pubnub_dns_codec.o $(SOCKET_POLLER_OBJ) pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o
+# The socket poller module to use. On Linux we use the `epoll` poller,
+# which scales to many contexts (its operations don't depend on the
+# number of sockets watched). Elsewhere use the `poll` poller, it
+# doesn't have the weird restrictions of `select` poller. The names
+# are the same until the last `_`, then it's `epoll`, `poll` or
+# `select`. Set SOCKET_POLLER to override.
+ifndef SOCKET_POLLER
+ifeq ($(shell uname),Linux)
+SOCKET_POLLER = epoll
+else
+SOCKET_POLLER = poll
+endif
+endif
+SOCKET_POLLER_C=../lib/sockets/pbpal_ntf_callback_poller_$(SOCKET_POLLER).c
+SOCKET_POLLER_OBJ=pbpal_ntf_callback_poller_$(SOCKET_POLLER).o
+
+CALLBACK_INTF_SOURCEFILES= ../openssl/pubnub_ntf_callback_posix.c ../openssl/pubnub_get_native_socket.c ../core/pubnub_timer_list.c ../core/pubnub_timer_wheel.c ../lib/sockets/pbpal_adns_sockets.c ../lib/pubnub_dns_codec.c ../lib/pubnub_dns_cache.c $(SOCKET_POLLER_C) ../core/pbpal_ntf_callback_queue.c ../core/pbpal_ntf_callback_admin.c ../core/pbpal_ntf_callback_handle_timer_list.c  ../core/pubnub_callback_subscribe_loop.c ../core/pubnub_publish_queue.c ../core/pubnub_publish_batch.c
+CALLBACK_INTF_OBJFILES= pubnub_ntf_callback_posix.o pubnub_get_native_socket.o pubnub_timer_list.o pubnub_timer_wheel.o pbpal_adns_sockets.o pubnub_dns_codec.o pubnub_dns_cache.o $(SOCKET_POLLER_OBJ) pbpal_ntf_callback_queue.o pbpal_ntf_callback_admin.o pbpal_ntf_callback_handle_timer_list.o pubnub_callback_subscribe_loop.o pubnub_publish_queue.o pubnub_publish_batch.o
 
 ifndef USE_DNS_SERVERS
 USE_DNS_SERVERS = 1
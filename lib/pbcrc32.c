@@ -11,14 +11,12 @@ static uint32_t crc32_for_byte(uint32_t r)
     return r ^ (uint32_t)0xFF000000L;
 }
 
-uint32_t pbcrc32(const void *data, size_t n_bytes)
+uint32_t pbcrc32_update(uint32_t crc, const void *data, size_t n_bytes)
 {
     static uint32_t table[0x100];
-    uint32_t crc = 0;
     uint8_t *p, *end;
 
     PUBNUB_ASSERT_OPT(data != NULL);
-    PUBNUB_ASSERT_OPT(n_bytes > 0);
     if (!(*table)) {
         size_t i;
         for(i = 0; i < 0x100; ++i) {
@@ -32,3 +30,9 @@ uint32_t pbcrc32(const void *data, size_t n_bytes)
     }
     return crc;
 }
+
+uint32_t pbcrc32(const void *data, size_t n_bytes)
+{
+    PUBNUB_ASSERT_OPT(n_bytes > 0);
+    return pbcrc32_update(0, data, n_bytes);
+}
@@ -11,5 +11,11 @@
  */ 
 uint32_t pbcrc32(const void *data, size_t n_bytes);
 
+/* Updates the CRC32 checksum @p crc - of the data before - with the
+   @p data of @p n_bytes length in octets, that follow. Starting with
+   0, gives the same checksum as pbcrc32() of all the data at once.
+ */
+uint32_t pbcrc32_update(uint32_t crc, const void *data, size_t n_bytes);
+
 #endif /* INC_PB_CRC32 */
 
@@ -0,0 +1,300 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#if PUBNUB_DNS_CACHE
+#include "lib/pubnub_dns_cache.h"
+
+#include "core/pbpal.h"
+#include "core/pubnub_mutex.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include <string.h>
+#include <time.h>
+
+
+/** An entry (hostname) in the DNS cache */
+struct pbdns_cache_entry {
+    /** The hostname, empty if the entry is not used */
+    char host[PUBNUB_DNS_CACHE_MAX_HOST_LENGTH + 1];
+    /** The type of the query the addresses were resolved with */
+    enum DNSqueryType query_type;
+    /** The context that is resolving the hostname, NULL if none.
+        Only compared to, never dereferenced.
+     */
+    pubnub_t const* resolver;
+    /** The addresses resolved, with their TTLs */
+    struct pubnub_multi_addresses addresses;
+    /** The list of contexts waiting for the @p resolver */
+    pubnub_t* waiting;
+};
+
+
+pubnub_mutex_static_decl_and_init(m_lock);
+static struct pbdns_cache_entry m_cache[PUBNUB_DNS_CACHE_SIZE] pubnub_guarded_by(m_lock);
+
+
+/** Is there an address in @p addr that has at least a second to
+    live, at the time @p now. Same as the check before connecting to
+    a spare address.
+ */
+static bool has_valid_address(struct pubnub_multi_addresses const* addr, time_t now)
+{
+    int i;
+
+    for (i = 0; i < addr->n_ipv4; ++i) {
+        if (addr->ttl_ipv4[i] - 2 > now - addr->time_of_the_last_dns_query) {
+            return true;
+        }
+    }
+#if PUBNUB_USE_IPV6
+    for (i = 0; i < addr->n_ipv6; ++i) {
+        if (addr->ttl_ipv6[i] - 2 > now - addr->time_of_the_last_dns_query) {
+            return true;
+        }
+    }
+#endif
+    return false;
+}
+
+
+static struct pbdns_cache_entry* find(char const* host, enum DNSqueryType query_type)
+{
+    unsigned i;
+
+    for (i = 0; i < PUBNUB_DNS_CACHE_SIZE; ++i) {
+        if ((m_cache[i].query_type == query_type)
+            && (0 == strcmp(m_cache[i].host, host))) {
+            return m_cache + i;
+        }
+    }
+    return NULL;
+}
+
+
+/** Gets an entry to use for the @p host: an unused one, or the one
+    that was resolved the longest time ago. Entries being resolved are
+    not reused.
+ */
+static struct pbdns_cache_entry* make_entry(char const*       host,
+                                            enum DNSqueryType query_type)
+{
+    struct pbdns_cache_entry* rslt = NULL;
+    unsigned                  i;
+
+    if (strlen(host) > PUBNUB_DNS_CACHE_MAX_HOST_LENGTH) {
+        return NULL;
+    }
+    for (i = 0; i < PUBNUB_DNS_CACHE_SIZE; ++i) {
+        struct pbdns_cache_entry* entry = m_cache + i;
+        if ('\0' == entry->host[0]) {
+            rslt = entry;
+            break;
+        }
+        if ((NULL == entry->resolver)
+            && ((NULL == rslt)
+                || (entry->addresses.time_of_the_last_dns_query
+                    < rslt->addresses.time_of_the_last_dns_query))) {
+            rslt = entry;
+        }
+    }
+    if (rslt != NULL) {
+        /* Only a resolver has waiting contexts */
+        PUBNUB_ASSERT_OPT(NULL == rslt->waiting);
+        strcpy(rslt->host, host);
+        rslt->query_type = query_type;
+        rslt->resolver   = NULL;
+        pbpal_multiple_addresses_reset_counters(&rslt->addresses);
+    }
+    return rslt;
+}
+
+
+/** Returns the entry whose waiting list starts with @p pb, if any */
+static struct pbdns_cache_entry* waiting_head_of(pubnub_t const* pb)
+{
+    unsigned i;
+
+    for (i = 0; i < PUBNUB_DNS_CACHE_SIZE; ++i) {
+        if (m_cache[i].waiting == pb) {
+            return m_cache + i;
+        }
+    }
+    return NULL;
+}
+
+
+static bool is_waiting(pubnub_t const* pb)
+{
+    return (pb->dns_cache_previous != NULL) || (waiting_head_of(pb) != NULL);
+}
+
+
+static void link_waiting(struct pbdns_cache_entry* entry, pubnub_t* pb)
+{
+    if (!is_waiting(pb)) {
+        pb->dns_cache_previous = NULL;
+        pb->dns_cache_next     = entry->waiting;
+        if (entry->waiting != NULL) {
+            entry->waiting->dns_cache_previous = pb;
+        }
+        entry->waiting = pb;
+    }
+}
+
+
+static void unlink_waiting(pubnub_t* pb)
+{
+    if (NULL == pb->dns_cache_previous) {
+        struct pbdns_cache_entry* entry = waiting_head_of(pb);
+        PUBNUB_ASSERT_OPT(entry != NULL);
+        entry->waiting = pb->dns_cache_next;
+    }
+    else {
+        pb->dns_cache_previous->dns_cache_next = pb->dns_cache_next;
+    }
+    if (pb->dns_cache_next != NULL) {
+        pb->dns_cache_next->dns_cache_previous = pb->dns_cache_previous;
+    }
+    pb->dns_cache_previous = pb->dns_cache_next = NULL;
+}
+
+
+/** Requeues the contexts waiting for the @p entry for processing.
+    They look up the cache again, to get the addresses, or to take
+    over resolving, if the resolver gave up.
+ */
+static void wake_waiting(struct pbdns_cache_entry* entry)
+{
+    while (entry->waiting != NULL) {
+        pubnub_t* pb = entry->waiting;
+        unlink_waiting(pb);
+        pbntf_requeue_for_processing(pb);
+    }
+}
+
+
+enum pbdns_cache_result pbdns_cache_lookup(pubnub_t*         pb,
+                                           char const*       host,
+                                           enum DNSqueryType query_type)
+{
+    struct pbdns_cache_entry* entry;
+    enum pbdns_cache_result   rslt = pbdnscacheMiss;
+
+    PUBNUB_ASSERT_OPT(host != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    if (is_waiting(pb)) {
+        unlink_waiting(pb);
+    }
+    entry = find(host, query_type);
+    if (NULL == entry) {
+        entry = make_entry(host, query_type);
+    }
+    if (NULL == entry) {
+        /* Can't cache it, resolve it as if there was no cache */
+    }
+    else if (has_valid_address(&entry->addresses, time(NULL))) {
+        if (entry->resolver == pb) {
+            entry->resolver = NULL;
+        }
+        pb->spare_addresses = entry->addresses;
+        rslt                = pbdnscacheHit;
+    }
+    else if ((entry->resolver != NULL) && (entry->resolver != pb)) {
+        link_waiting(entry, pb);
+        rslt = pbdnscacheWait;
+    }
+    else {
+        entry->resolver = pb;
+    }
+    pb->flags.dns_cache_waiting   = (pbdnscacheWait == rslt);
+    pb->flags.dns_cache_resolving = (entry != NULL) && (entry->resolver == pb);
+    pubnub_mutex_unlock(m_lock);
+
+    PUBNUB_LOG_TRACE("pbdns_cache_lookup(pb=%p, host='%s', query_type=%d) = %d\n",
+                     pb,
+                     host,
+                     query_type,
+                     rslt);
+
+    return rslt;
+}
+
+
+void pbdns_cache_store(pubnub_t* pb, char const* host, enum DNSqueryType query_type)
+{
+    struct pbdns_cache_entry* entry;
+
+    PUBNUB_ASSERT_OPT(host != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find(host, query_type);
+    if (NULL == entry) {
+        entry = make_entry(host, query_type);
+    }
+    if (entry != NULL) {
+        entry->addresses            = pb->spare_addresses;
+        entry->addresses.ipv4_index = 0;
+#if PUBNUB_USE_IPV6
+        entry->addresses.ipv6_index = 0;
+#endif
+        entry->resolver = NULL;
+        wake_waiting(entry);
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    pb->flags.dns_cache_resolving = false;
+}
+
+
+void pbdns_cache_invalidate(char const*       host,
+                            enum DNSqueryType query_type,
+                            time_t            resolved_at)
+{
+    struct pbdns_cache_entry* entry;
+
+    PUBNUB_ASSERT_OPT(host != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find(host, query_type);
+    if ((entry != NULL) && (NULL == entry->resolver)
+        && (entry->addresses.time_of_the_last_dns_query == resolved_at)) {
+        PUBNUB_LOG_DEBUG("No cached address of '%s' can be connected to\n", host);
+        pbpal_multiple_addresses_reset_counters(&entry->addresses);
+    }
+    pubnub_mutex_unlock(m_lock);
+}
+
+
+void pbdns_cache_forget(pubnub_t* pb)
+{
+    unsigned i;
+
+    if (!pb->flags.dns_cache_waiting && !pb->flags.dns_cache_resolving) {
+        return;
+    }
+
+    pubnub_mutex_lock(m_lock);
+    if (pb->flags.dns_cache_waiting && is_waiting(pb)) {
+        unlink_waiting(pb);
+    }
+    if (pb->flags.dns_cache_resolving) {
+        for (i = 0; i < PUBNUB_DNS_CACHE_SIZE; ++i) {
+            if (m_cache[i].resolver == pb) {
+                PUBNUB_LOG_DEBUG("pb=%p gave up resolving '%s'\n", pb, m_cache[i].host);
+                m_cache[i].resolver = NULL;
+                wake_waiting(m_cache + i);
+            }
+        }
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    pb->flags.dns_cache_waiting   = false;
+    pb->flags.dns_cache_resolving = false;
+}
+
+#endif /* PUBNUB_DNS_CACHE */
@@ -0,0 +1,93 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_DNS_CACHE
+#define      INC_PUBNUB_DNS_CACHE
+
+#include "pubnub_internal.h"
+#include "lib/pubnub_dns_codec.h"
+
+
+/** @file pubnub_dns_cache.h
+
+    A process-wide cache of the addresses resolved by the asynchronous
+    DNS resolver, shared by all the contexts. It is keyed by the
+    hostname and the query type (A or AAAA) and respects the TTL of
+    the addresses from the DNS response.
+
+    At most one context at a time sends a DNS query for the same
+    hostname. Others that need it in the meantime wait for it to be
+    resolved, so starting (or reconnecting) any number of contexts
+    takes one DNS round-trip per origin.
+
+    These functions are to be called with the monitor of the context
+    locked, as they change its fields (the spare addresses and flags).
+*/
+
+#if !defined PUBNUB_DNS_CACHE_SIZE
+/** The maximum number of hostnames in the DNS cache */
+#define PUBNUB_DNS_CACHE_SIZE 4
+#endif
+
+#if !defined PUBNUB_DNS_CACHE_MAX_HOST_LENGTH
+/** The maximum length of a hostname in the DNS cache. Longer ones
+    are resolved, but not cached.
+*/
+#define PUBNUB_DNS_CACHE_MAX_HOST_LENGTH 127
+#endif
+
+
+/** Results of looking up the DNS cache */
+enum pbdns_cache_result {
+    /** Valid addresses were found, they are copied to the spare
+        addresses of the context */
+    pbdnscacheHit,
+    /** Another context is resolving the hostname. This context
+        will be requeued for processing when it's done. */
+    pbdnscacheWait,
+    /** Not in the cache, the context should resolve the hostname
+        (and then store the result) */
+    pbdnscacheMiss
+};
+
+
+/** Looks up the DNS cache for the addresses of the @p host, for
+    the @p query_type.
+
+    If the addresses are not in the cache and no other context is
+    resolving the @p host, @p pb is registered as the one that does.
+    If some other context is resolving it, @p pb waits for it and is
+    requeued for processing when that context is done with the
+    @p host (and not some other hostname).
+ */
+enum pbdns_cache_result pbdns_cache_lookup(pubnub_t*         pb,
+                                           char const*       host,
+                                           enum DNSqueryType query_type);
+
+/** Stores the spare addresses of @p pb, that it got in the DNS
+    response, to the cache, for the @p host and @p query_type.
+    Contexts waiting for it are requeued for processing.
+ */
+void pbdns_cache_store(pubnub_t* pb, char const* host, enum DNSqueryType query_type);
+
+/** Invalidates the addresses of the @p host for the @p query_type,
+    if they are still the ones resolved at @p resolved_at, so the
+    next lookup misses and the hostname is resolved again. To be
+    called when none of the cached addresses could be connected to -
+    otherwise, we would keep connecting to dead addresses until they
+    expire.
+ */
+void pbdns_cache_invalidate(char const*       host,
+                            enum DNSqueryType query_type,
+                            time_t            resolved_at);
+
+/** Tells the DNS cache that @p pb is done with it. If it was
+    waiting for a hostname to be resolved, it is not any more. If it
+    was resolving one, it's given up and a waiting context, if any,
+    will take over.
+
+    Cheap if @p pb is not involved with the cache, so it can be called
+    on closing every connection.
+ */
+void pbdns_cache_forget(pubnub_t* pb);
+
+
+#endif /* defined INC_PUBNUB_DNS_CACHE */
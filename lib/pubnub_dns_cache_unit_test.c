@@ -0,0 +1,243 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "lib/pubnub_dns_cache.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define streqs is_equal_to_string
+#define differs is_not_equal_to
+#define strdifs is_not_equal_to_string
+#define returns will_return
+
+
+void assert_handler(char const* s, const char* file, long i)
+{
+    printf("%s:%ld: Pubnub assert failed '%s'\n", file, i, s);
+}
+
+
+/* Mocks */
+
+int pbntf_requeue_for_processing(pubnub_t* pb)
+{
+    return (int)mock(pb);
+}
+
+
+void pbpal_multiple_addresses_reset_counters(struct pubnub_multi_addresses* spare_addresses)
+{
+    spare_addresses->n_ipv4     = 0;
+    spare_addresses->ipv4_index = 0;
+#if PUBNUB_USE_IPV6
+    spare_addresses->n_ipv6     = 0;
+    spare_addresses->ipv6_index = 0;
+#endif
+}
+
+
+Describe(pubnub_dns_cache);
+
+static pubnub_t m_pb[3];
+
+
+static void init_context(pubnub_t* pb)
+{
+    memset(pb, 0, sizeof *pb);
+    pbpal_multiple_addresses_reset_counters(&pb->spare_addresses);
+}
+
+
+/** Sets the spare addresses of @p pb as if it got one IPv4 address
+    with the @p ttl from the DNS response.
+ */
+static void resolved(pubnub_t* pb, uint8_t last_octet, uint16_t ttl)
+{
+    struct pubnub_multi_addresses* addr = &pb->spare_addresses;
+
+    addr->time_of_the_last_dns_query = time(NULL);
+    addr->n_ipv4                     = 1;
+    addr->ipv4_index                 = 1;
+    addr->ipv4_addresses[0].ipv4[0]  = 127;
+    addr->ipv4_addresses[0].ipv4[1]  = 0;
+    addr->ipv4_addresses[0].ipv4[2]  = 0;
+    addr->ipv4_addresses[0].ipv4[3]  = last_octet;
+    addr->ttl_ipv4[0]                = ttl;
+}
+
+
+BeforeEach(pubnub_dns_cache)
+{
+    pubnub_assert_set_handler((pubnub_assert_handler_t)assert_handler);
+    init_context(&m_pb[0]);
+    init_context(&m_pb[1]);
+    init_context(&m_pb[2]);
+}
+
+
+AfterEach(pubnub_dns_cache)
+{
+    PUBNUB_LOG_TRACE("========================================================\n");
+}
+
+
+Ensure(pubnub_dns_cache, first_lookup_misses_and_others_wait)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "first.host", dnsA), equals(pbdnscacheMiss));
+    attest(m_pb[0].flags.dns_cache_resolving, is_true);
+    attest(m_pb[0].flags.dns_cache_waiting, is_false);
+
+    attest(pbdns_cache_lookup(&m_pb[1], "first.host", dnsA), equals(pbdnscacheWait));
+    attest(pbdns_cache_lookup(&m_pb[2], "first.host", dnsA), equals(pbdnscacheWait));
+    attest(m_pb[1].flags.dns_cache_waiting, is_true);
+    attest(m_pb[1].flags.dns_cache_resolving, is_false);
+
+    /* Resolver looking up again still resolves, not waits */
+    attest(pbdns_cache_lookup(&m_pb[0], "first.host", dnsA), equals(pbdnscacheMiss));
+}
+
+
+Ensure(pubnub_dns_cache, store_wakes_waiting_which_then_hit)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "store.host", dnsA), equals(pbdnscacheMiss));
+    attest(pbdns_cache_lookup(&m_pb[1], "store.host", dnsA), equals(pbdnscacheWait));
+    attest(pbdns_cache_lookup(&m_pb[2], "store.host", dnsA), equals(pbdnscacheWait));
+
+    resolved(&m_pb[0], 7, 60);
+    expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[2])), returns(+1));
+    expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[1])), returns(+1));
+    pbdns_cache_store(&m_pb[0], "store.host", dnsA);
+    attest(m_pb[0].flags.dns_cache_resolving, is_false);
+
+    attest(pbdns_cache_lookup(&m_pb[1], "store.host", dnsA), equals(pbdnscacheHit));
+    attest(m_pb[1].flags.dns_cache_waiting, is_false);
+    attest(m_pb[1].spare_addresses.n_ipv4, equals(1));
+    attest(m_pb[1].spare_addresses.ipv4_index, equals(0));
+    attest(m_pb[1].spare_addresses.ipv4_addresses[0].ipv4[3], equals(7));
+    attest(m_pb[1].spare_addresses.ttl_ipv4[0], equals(60));
+    attest(pbdns_cache_lookup(&m_pb[2], "store.host", dnsA), equals(pbdnscacheHit));
+}
+
+
+Ensure(pubnub_dns_cache, query_types_are_cached_separately)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "types.host", dnsA), equals(pbdnscacheMiss));
+    resolved(&m_pb[0], 8, 60);
+    pbdns_cache_store(&m_pb[0], "types.host", dnsA);
+
+    attest(pbdns_cache_lookup(&m_pb[1], "types.host", dnsAAAA), equals(pbdnscacheMiss));
+    attest(pbdns_cache_lookup(&m_pb[2], "types.host", dnsA), equals(pbdnscacheHit));
+}
+
+
+Ensure(pubnub_dns_cache, expired_addresses_are_resolved_again)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "expired.host", dnsA), equals(pbdnscacheMiss));
+    resolved(&m_pb[0], 9, 2);
+    pbdns_cache_store(&m_pb[0], "expired.host", dnsA);
+
+    attest(pbdns_cache_lookup(&m_pb[1], "expired.host", dnsA), equals(pbdnscacheMiss));
+    attest(m_pb[1].flags.dns_cache_resolving, is_true);
+    attest(pbdns_cache_lookup(&m_pb[2], "expired.host", dnsA), equals(pbdnscacheWait));
+}
+
+
+Ensure(pubnub_dns_cache, resolver_giving_up_lets_waiting_take_over)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "giveup.host", dnsA), equals(pbdnscacheMiss));
+    attest(pbdns_cache_lookup(&m_pb[1], "giveup.host", dnsA), equals(pbdnscacheWait));
+
+    expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[1])), returns(+1));
+    pbdns_cache_forget(&m_pb[0]);
+    attest(m_pb[0].flags.dns_cache_resolving, is_false);
+
+    attest(pbdns_cache_lookup(&m_pb[1], "giveup.host", dnsA), equals(pbdnscacheMiss));
+    attest(m_pb[1].flags.dns_cache_resolving, is_true);
+    attest(m_pb[1].flags.dns_cache_waiting, is_false);
+}
+
+
+Ensure(pubnub_dns_cache, waiting_context_forgotten_is_not_woken)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "forget.host", dnsA), equals(pbdnscacheMiss));
+    attest(pbdns_cache_lookup(&m_pb[1], "forget.host", dnsA), equals(pbdnscacheWait));
+    attest(pbdns_cache_lookup(&m_pb[2], "forget.host", dnsA), equals(pbdnscacheWait));
+
+    pbdns_cache_forget(&m_pb[1]);
+    attest(m_pb[1].flags.dns_cache_waiting, is_false);
+
+    resolved(&m_pb[0], 10, 60);
+    expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[2])), returns(+1));
+    never_expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[1])));
+    pbdns_cache_store(&m_pb[0], "forget.host", dnsA);
+}
+
+
+Ensure(pubnub_dns_cache, too_long_hostname_is_not_cached)
+{
+    char host[PUBNUB_DNS_CACHE_MAX_HOST_LENGTH + 2];
+
+    memset(host, 'x', sizeof host - 1);
+    host[sizeof host - 1] = '\0';
+    attest(pbdns_cache_lookup(&m_pb[0], host, dnsA), equals(pbdnscacheMiss));
+    attest(m_pb[0].flags.dns_cache_resolving, is_false);
+    attest(pbdns_cache_lookup(&m_pb[1], host, dnsA), equals(pbdnscacheMiss));
+    attest(m_pb[1].flags.dns_cache_waiting, is_false);
+}
+
+
+Ensure(pubnub_dns_cache, store_wakes_only_those_waiting_for_the_host)
+{
+    attest(pbdns_cache_lookup(&m_pb[0], "one.host", dnsA), equals(pbdnscacheMiss));
+    attest(pbdns_cache_lookup(&m_pb[1], "one.host", dnsA), equals(pbdnscacheWait));
+    attest(pbdns_cache_lookup(&m_pb[2], "one.host", dnsAAAA), equals(pbdnscacheMiss));
+
+    resolved(&m_pb[2], 11, 60);
+    never_expect(pbntf_requeue_for_processing);
+    pbdns_cache_store(&m_pb[2], "one.host", dnsAAAA);
+    attest(m_pb[1].flags.dns_cache_waiting, is_true);
+
+    resolved(&m_pb[0], 12, 60);
+    expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[1])), returns(+1));
+    pbdns_cache_store(&m_pb[0], "one.host", dnsA);
+}
+
+
+Ensure(pubnub_dns_cache, invalidated_addresses_are_resolved_again)
+{
+    time_t resolved_at;
+
+    attest(pbdns_cache_lookup(&m_pb[0], "dead.host", dnsA), equals(pbdnscacheMiss));
+    resolved(&m_pb[0], 13, 60);
+    resolved_at = m_pb[0].spare_addresses.time_of_the_last_dns_query;
+    pbdns_cache_store(&m_pb[0], "dead.host", dnsA);
+    attest(pbdns_cache_lookup(&m_pb[1], "dead.host", dnsA), equals(pbdnscacheHit));
+
+    /* Addresses from some other (earlier) resolving are not it */
+    pbdns_cache_invalidate("dead.host", dnsA, resolved_at - 1);
+    attest(pbdns_cache_lookup(&m_pb[2], "dead.host", dnsA), equals(pbdnscacheHit));
+
+    pbdns_cache_invalidate("dead.host", dnsA, resolved_at);
+    attest(pbdns_cache_lookup(&m_pb[1], "dead.host", dnsA), equals(pbdnscacheMiss));
+    attest(m_pb[1].flags.dns_cache_resolving, is_true);
+    attest(pbdns_cache_lookup(&m_pb[2], "dead.host", dnsA), equals(pbdnscacheWait));
+
+    /* Being resolved, so nothing to invalidate */
+    pbdns_cache_invalidate("dead.host", dnsA, resolved_at);
+    resolved(&m_pb[1], 14, 60);
+    expect(pbntf_requeue_for_processing, when(pb, equals(&m_pb[2])), returns(+1));
+    pbdns_cache_store(&m_pb[1], "dead.host", dnsA);
+    attest(pbdns_cache_lookup(&m_pb[2], "dead.host", dnsA), equals(pbdnscacheHit));
+    attest(m_pb[2].spare_addresses.ipv4_addresses[0].ipv4[3], equals(14));
+}
@@ -0,0 +1,250 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pubnub_internal.h"
+
+#include "lib/sockets/pbpal_ntf_callback_poller_epoll.h"
+
+#include "pubnub_get_native_socket.h"
+
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+
+#if !defined(INVALID_SOCKET)
+#define INVALID_SOCKET -1
+#endif
+
+
+struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
+{
+    struct pbpal_poll_data* rslt;
+    struct epoll_event      ev;
+
+    rslt = (struct pbpal_poll_data*)malloc(sizeof *rslt);
+    if (NULL == rslt) {
+        return NULL;
+    }
+    rslt->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (-1 == rslt->epfd) {
+        PUBNUB_LOG_ERROR("epoll_create1() failed, errno=%d\n", errno);
+        free(rslt);
+        return NULL;
+    }
+    rslt->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == rslt->wakefd) {
+        PUBNUB_LOG_ERROR("eventfd() failed, errno=%d\n", errno);
+        close(rslt->epfd);
+        free(rslt);
+        return NULL;
+    }
+    memset(&ev, 0, sizeof ev);
+    ev.events   = EPOLLIN;
+    ev.data.ptr = NULL;
+    if (0 != epoll_ctl(rslt->epfd, EPOLL_CTL_ADD, rslt->wakefd, &ev)) {
+        PUBNUB_LOG_ERROR("Failed to watch the eventfd, errno=%d\n", errno);
+        close(rslt->wakefd);
+        close(rslt->epfd);
+        free(rslt);
+        return NULL;
+    }
+
+    return rslt;
+}
+
+
+static int epoll_ctl_pb(struct pbpal_poll_data* data,
+                        int                     op,
+                        pubnub_t*               pb,
+                        pbpal_native_socket_t   sockt,
+                        uint32_t                events)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof ev);
+    ev.events   = events;
+    ev.data.ptr = pb;
+
+    return epoll_ctl(data->epfd, op, sockt, &ev);
+}
+
+
+void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_ADD, pb, sockt, EPOLLOUT)) {
+        PUBNUB_LOG_WARNING(
+            "pbpal_ntf_callback_save_socket(pb=%p) sockt=%d: errno=%d\n",
+            pb,
+            sockt,
+            errno);
+    }
+}
+
+
+void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    /* Kernel takes (closed) sockets out of the interest set on its
+       own, so failure here is not a problem.
+     */
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_DEL, pb, sockt, 0)) {
+        PUBNUB_LOG_DEBUG(
+            "pbpal_ntf_callback_remove_socket(pb=%p) sockt=%d: Not Found!", pb, sockt);
+    }
+}
+
+
+void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+    if (INVALID_SOCKET == sockt) {
+        PUBNUB_LOG_WARNING(
+            "pbpal_ntf_callback_update_socket(pb=%p) sockt=%d: Not Found!", pb, sockt);
+        return;
+    }
+    /* The old socket was closed (and thus removed from the interest
+       set by the kernel) before the new one was created, so we add
+       the new one. If it turns out to be the same one, we just
+       modify it.
+     */
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_ADD, pb, sockt, EPOLLOUT)) {
+        if ((errno != EEXIST)
+            || (0 != epoll_ctl_pb(data, EPOLL_CTL_MOD, pb, sockt, EPOLLOUT))) {
+            PUBNUB_LOG_WARNING(
+                "pbpal_ntf_callback_update_socket(pb=%p) sockt=%d: errno=%d\n",
+                pb,
+                sockt,
+                errno);
+        }
+    }
+}
+
+
+#if PUBNUB_HAPPY_EYEBALLS
+void pbpal_ntf_callback_save_race_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pb->connect_race.socket;
+
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_ADD, pb, sockt, EPOLLOUT)) {
+        PUBNUB_LOG_WARNING(
+            "pbpal_ntf_callback_save_race_socket(pb=%p) sockt=%d: errno=%d\n",
+            pb,
+            sockt,
+            errno);
+    }
+}
+
+
+void pbpal_ntf_callback_remove_race_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pb->connect_race.socket;
+
+    if (0 != epoll_ctl_pb(data, EPOLL_CTL_DEL, pb, sockt, 0)) {
+        PUBNUB_LOG_DEBUG(
+            "pbpal_ntf_callback_remove_race_socket(pb=%p) sockt=%d: Not Found!", pb, sockt);
+    }
+}
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
+int pbpal_ntf_watch_out_events(struct pbpal_poll_data* data, pubnub_t* pbp)
+{
+    if (INVALID_SOCKET == pubnub_get_native_socket(pbp)) {
+        /* Nothing to watch (yet) */
+        return 0;
+    }
+    if (0 != epoll_ctl_pb(
+                 data, EPOLL_CTL_MOD, pbp, pubnub_get_native_socket(pbp), EPOLLOUT)) {
+        PUBNUB_LOG_WARNING("pbpal_ntf_watch_out_events(pbp=%p): Not Found!", pbp);
+        return -1;
+    }
+    return 0;
+}
+
+
+int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp)
+{
+    if (INVALID_SOCKET == pubnub_get_native_socket(pbp)) {
+        /* Nothing to watch (yet) */
+        return 0;
+    }
+    if (0 != epoll_ctl_pb(
+                 data, EPOLL_CTL_MOD, pbp, pubnub_get_native_socket(pbp), EPOLLIN)) {
+        PUBNUB_LOG_WARNING("pbpal_ntf_watch_in_events(pbp=%p): Not Found!", pbp);
+        return -1;
+    }
+    return 0;
+}
+
+
+int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
+{
+    int rslt;
+    int i;
+
+    /* We wait even if there are no sockets to watch, so that the
+       watcher thread doesn't spin - the eventfd will wake us up.
+     */
+    rslt = epoll_wait(data->epfd, data->aevents, PBPAL_EPOLL_MAX_EVENTS, ms);
+    if (-1 == rslt) {
+        if (errno != EINTR) {
+            PUBNUB_LOG_WARNING("epoll_wait error = %d\n", errno);
+        }
+        return -1;
+    }
+    for (i = 0; i < rslt; ++i) {
+        if (NULL == data->aevents[i].data.ptr) {
+            uint64_t val;
+            if (read(data->wakefd, &val, sizeof val) < 0) {
+                PUBNUB_LOG_TRACE("Nothing to read from eventfd, errno=%d\n", errno);
+            }
+            continue;
+        }
+        /* Errors and hang-ups are reported to the FSM as readiness,
+           it will learn about them from the socket itself.
+         */
+        if (data->aevents[i].events & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            pbntf_requeue_for_processing((pubnub_t*)data->aevents[i].data.ptr);
+        }
+    }
+
+    return rslt;
+}
+
+
+int pbpal_ntf_callback_poller_wakeup(struct pbpal_poll_data* data)
+{
+    uint64_t const one = 1;
+
+    /* If the counter would overflow, it's already non-zero, so it will
+       wake up the poller anyway.
+     */
+    if ((write(data->wakefd, &one, sizeof one) < 0) && (errno != EAGAIN)) {
+        PUBNUB_LOG_WARNING("Failed to write to eventfd, errno=%d\n", errno);
+        return -1;
+    }
+    return 0;
+}
+
+
+void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data)
+{
+    PUBNUB_ASSERT_OPT(data != NULL);
+    PUBNUB_ASSERT_OPT(*data != NULL);
+
+    close((*data)->wakefd);
+    close((*data)->epfd);
+    free(*data);
+    *data = NULL;
+}
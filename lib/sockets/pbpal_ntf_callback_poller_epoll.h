@@ -0,0 +1,41 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined(INC_PBPAL_NTF_CALLBACK_POLLER_EPOLL)
+#define      INC_PBPAL_NTF_CALLBACK_POLLER_EPOLL
+
+#include "core/pbpal_ntf_callback_poller.h"
+
+#include <sys/epoll.h>
+
+
+/** Maximum number of events we get from one call to epoll_wait().
+    If more sockets are ready, the rest will be reported on the next
+    call(s), so this is not a limit on the number of sockets we can
+    watch, just on the size of the "batch" we process at once.
+ */
+#define PBPAL_EPOLL_MAX_EVENTS 64
+
+
+/** The `epoll` poller data. Unlike the `poll` and `select` pollers,
+    we don't keep the sockets (and contexts) in arrays - the kernel
+    keeps the interest set and we keep the Pubnub context pointer in
+    the `data.ptr` of each registered event. So, all operations are
+    O(1) in the number of sockets (contexts) and polling itself is
+    O(number of ready sockets).
+
+    Sockets are watched level-triggered, just like with poll(), as
+    the FSM doesn't necessarily drain a socket before it stops
+    processing a context.
+ */
+struct pbpal_poll_data {
+    /** The `epoll` instance file descriptor */
+    int                epfd;
+    /** The `eventfd` used to wake up the poller. It is in the
+        interest set of `epfd` with `NULL` as `data.ptr`.
+     */
+    int                wakefd;
+    /** Events gotten from the last call to epoll_wait() */
+    struct epoll_event aevents[PBPAL_EPOLL_MAX_EVENTS];
+};
+
+
+#endif  /* !defined(INC_PBPAL_NTF_CALLBACK_POLLER_EPOLL) */
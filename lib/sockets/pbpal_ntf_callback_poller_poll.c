@@ -10,6 +10,12 @@
 
 #include <string.h>
 
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
 
 #if defined(_WIN32)
 /* Yes, we do know that it's not really that simple, there are subtle,
@@ -40,21 +46,45 @@ struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
     rslt->apoll            = NULL;
     rslt->apb              = NULL;
 
+#if !defined(_WIN32)
+    if (0 != pipe(rslt->wakepipe)) {
+        PUBNUB_LOG_ERROR("Failed to create the wake-up pipe, errno=%d\n", errno);
+        free(rslt);
+        return NULL;
+    }
+    fcntl(rslt->wakepipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(rslt->wakepipe[1], F_SETFL, O_NONBLOCK);
+    fcntl(rslt->wakepipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(rslt->wakepipe[1], F_SETFD, FD_CLOEXEC);
+
+    rslt->apoll = (struct pollfd*)malloc(sizeof rslt->apoll[0] * 2);
+    rslt->apb   = (pubnub_t**)malloc(sizeof rslt->apb[0] * 2);
+    if ((NULL == rslt->apoll) || (NULL == rslt->apb)) {
+        free(rslt->apoll);
+        free(rslt->apb);
+        close(rslt->wakepipe[0]);
+        close(rslt->wakepipe[1]);
+        free(rslt);
+        return NULL;
+    }
+    rslt->cap             = 2;
+    rslt->apoll[0].fd     = rslt->wakepipe[0];
+    rslt->apoll[0].events = POLLIN;
+    rslt->apb[0]          = NULL;
+    rslt->size            = 1;
+#endif
+
     return rslt;
 }
 
 
-void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+/** Adds the socket @p sockt, whose events are processed as events
+    of @p pb, to the poll-set @p data.
+ */
+static void add_socket(struct pbpal_poll_data* data,
+                       pubnub_t*               pb,
+                       pbpal_native_socket_t   sockt)
 {
-    size_t                i;
-    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
-    if (INVALID_SOCKET == sockt) {
-        return;
-    }
-    for (i = 0; i < data->size; ++i) {
-        PUBNUB_ASSERT_OPT(data->apoll[i].fd != sockt);
-        PUBNUB_ASSERT_OPT(data->apb[i] != pb);
-    }
     if (data->size == data->cap) {
         size_t const   newcap = data->size + 2;
         struct pollfd* npalloc =
@@ -83,13 +113,12 @@ void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
 }
 
 
-void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+/** Removes the socket @p sockt, of @p pb, from the poll-set @p data */
+static void remove_socket(struct pbpal_poll_data* data,
+                          pubnub_t*               pb,
+                          pbpal_native_socket_t   sockt)
 {
-    size_t                i;
-    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
-    if (INVALID_SOCKET == sockt) {
-        return;
-    }
+    size_t i;
     for (i = 0; i < data->size; ++i) {
         if (data->apoll[i].fd == sockt) {
             size_t to_move = data->size - i - 1;
@@ -109,6 +138,49 @@ void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb
 }
 
 
+void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    size_t                i;
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    for (i = 0; i < data->size; ++i) {
+        PUBNUB_ASSERT_OPT(data->apoll[i].fd != sockt);
+        PUBNUB_ASSERT_OPT(data->apb[i] != pb);
+    }
+    add_socket(data, pb, sockt);
+}
+
+
+void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    remove_socket(data, pb, sockt);
+}
+
+
+#if PUBNUB_HAPPY_EYEBALLS
+/* The racing socket is added after the one of the context, and the
+   order is kept on removal, so looking up by the context (to update
+   or watch) finds the latter.
+ */
+void pbpal_ntf_callback_save_race_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    add_socket(data, pb, pb->connect_race.socket);
+}
+
+
+void pbpal_ntf_callback_remove_race_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    remove_socket(data, pb, pb->connect_race.socket);
+}
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
 void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb)
 {
     pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
@@ -124,6 +196,9 @@ void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb
                 return;
             }
         }
+        /* It had no socket before (waiting on the DNS cache) */
+        pbpal_ntf_callback_save_socket(data, pb);
+        return;
     }
     PUBNUB_LOG_WARNING(
         "pbpal_ntf_callback_update_socket(pb=%p) sockt=%d: Not Found!", pb, sockt);
@@ -133,6 +208,10 @@ void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb
 int pbpal_ntf_watch_out_events(struct pbpal_poll_data* data, pubnub_t* pbp)
 {
     unsigned i;
+    if (INVALID_SOCKET == pubnub_get_native_socket(pbp)) {
+        /* Nothing to watch (yet) */
+        return 0;
+    }
     for (i = 0; i < data->size; ++i) {
         if (data->apb[i] == pbp) {
             data->apoll[i].events = POLLOUT;
@@ -147,6 +226,10 @@ int pbpal_ntf_watch_out_events(struct pbpal_poll_data* data, pubnub_t* pbp)
 int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp)
 {
     unsigned i;
+    if (INVALID_SOCKET == pubnub_get_native_socket(pbp)) {
+        /* Nothing to watch (yet) */
+        return 0;
+    }
     for (i = 0; i < data->size; ++i) {
         if (data->apb[i] == pbp) {
             data->apoll[i].events = POLLIN;
@@ -185,6 +268,15 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
         size_t apoll_size = data->size;
         for (i = 0; i < apoll_size; ++i) {
             if (data->apoll[i].revents & (POLLIN | POLLOUT)) {
+#if !defined(_WIN32)
+                if (NULL == data->apb[i]) {
+                    char buf[64];
+                    while (read(data->wakepipe[0], buf, sizeof buf) > 0) {
+                        continue;
+                    }
+                    continue;
+                }
+#endif
                 pbntf_requeue_for_processing(data->apb[i]);
             }
         }
@@ -194,11 +286,34 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
 }
 
 
+int pbpal_ntf_callback_poller_wakeup(struct pbpal_poll_data* data)
+{
+#if defined(_WIN32)
+    PUBNUB_UNUSED(data);
+    return -1;
+#else
+    char const c = 1;
+    /* If the pipe is full, the poller will wake up anyway */
+    if ((write(data->wakepipe[1], &c, 1) < 0) && (errno != EAGAIN)) {
+        PUBNUB_LOG_WARNING("Failed to write to the wake-up pipe, errno=%d\n", errno);
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+
 void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data)
 {
     PUBNUB_ASSERT_OPT(data != NULL);
     PUBNUB_ASSERT_OPT(*data != NULL);
 
+#if !defined(_WIN32)
+    close((*data)->wakepipe[0]);
+    close((*data)->wakepipe[1]);
+#endif
+    free((*data)->apoll);
+    free((*data)->apb);
     free(*data);
     *data = NULL;
 }
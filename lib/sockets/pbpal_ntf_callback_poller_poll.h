@@ -23,6 +23,12 @@ struct pbpal_poll_data {
     size_t         size;
     size_t         cap;
     pubnub_t**     apb;
+#if !defined(_WIN32)
+    /** The self-pipe used to wake up the poller. Its read end is
+        always the first element of `apoll`, with `NULL` in `apb`.
+     */
+    int            wakepipe[2];
+#endif
 };
 
 
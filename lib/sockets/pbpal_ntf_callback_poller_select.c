@@ -8,6 +8,20 @@
 
 #include <stdlib.h>
 
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+#if !defined(INVALID_SOCKET)
+#define INVALID_SOCKET -1
+#endif
+
+#if !defined(SOCKET_ERROR)
+#define SOCKET_ERROR -1
+#endif
+
 
 struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
 {
@@ -22,6 +36,20 @@ struct pbpal_poll_data* pbpal_ntf_callback_poller_init(void)
     FD_ZERO(&rslt->exceptfds);
     rslt->size = rslt->nfds = 0;
 
+#if !defined(_WIN32)
+    if (0 != pipe(rslt->wakepipe)) {
+        PUBNUB_LOG_ERROR("Failed to create the wake-up pipe, errno=%d\n", errno);
+        free(rslt);
+        return NULL;
+    }
+    fcntl(rslt->wakepipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(rslt->wakepipe[1], F_SETFL, O_NONBLOCK);
+    fcntl(rslt->wakepipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(rslt->wakepipe[1], F_SETFD, FD_CLOEXEC);
+    FD_SET(rslt->wakepipe[0], &rslt->readfds);
+    rslt->nfds = rslt->wakepipe[0];
+#endif
+
     return rslt;
 }
 
@@ -38,19 +66,30 @@ static bool we_ve_got_ya(struct pbpal_poll_data const* data, pubnub_t const* pb)
 }
 
 
-void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+/** Is @p sockt a socket of @p pb: its own, or that of the connection
+    attempt racing its own
+ */
+static bool is_socket_of(pubnub_t* pb, pbpal_native_socket_t sockt)
 {
-    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+#if PUBNUB_HAPPY_EYEBALLS
+    if ((pbpal_native_socket_t)pb->connect_race.socket == sockt) {
+        return true;
+    }
+#endif
+    return pubnub_get_native_socket(pb) == sockt;
+}
 
-    PUBNUB_ASSERT_OPT(data != NULL);
 
-    if (INVALID_SOCKET == sockt) {
-        return;
-    }
+/** Adds the socket @p sockt, whose events are processed as events
+    of @p pb, to the poll-set @p data.
+ */
+static void add_socket(struct pbpal_poll_data* data,
+                       pubnub_t*               pb,
+                       pbpal_native_socket_t   sockt)
+{
     PUBNUB_ASSERT(!FD_ISSET(sockt, &data->exceptfds));
     PUBNUB_ASSERT(!FD_ISSET(sockt, &data->writefds));
     PUBNUB_ASSERT(!FD_ISSET(sockt, &data->readfds));
-    PUBNUB_ASSERT_EX(!we_ve_got_ya(data, pb));
 
     if ((int)sockt > data->nfds) {
         data->nfds = sockt;
@@ -63,27 +102,22 @@ void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
 }
 
 
-void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+/** Removes the socket @p sockt from the poll-set @p data */
+static void remove_socket(struct pbpal_poll_data* data, pbpal_native_socket_t sockt)
 {
-    size_t                i;
-    int                   new_nfds = 0;
-    pbpal_native_socket_t sockt    = pubnub_get_native_socket(pb);
-
-    PUBNUB_ASSERT_OPT(data != NULL);
+    size_t i;
+#if defined(_WIN32)
+    int    new_nfds = 0;
+#else
+    int    new_nfds = data->wakepipe[0];
+#endif
 
-    if (INVALID_SOCKET == sockt) {
-        return;
-    }
     PUBNUB_ASSERT(FD_ISSET(sockt, &data->exceptfds));
-    PUBNUB_ASSERT_EX(we_ve_got_ya(data, pb));
 
     for (i = 0; i < data->size; ++i) {
         pbpal_native_socket_t i_sckt = data->asocket[i];
-        PUBNUB_ASSERT(pubnub_get_native_socket(data->apb[i]) == data->asocket[i]);
-        if ((int)i_sckt > new_nfds) {
-            new_nfds = i_sckt;
-        }
-        if (data->apb[i] == pb) {
+        PUBNUB_ASSERT(is_socket_of(data->apb[i], data->asocket[i]));
+        if (i_sckt == sockt) {
             size_t to_move = data->size - i - 1;
             if (to_move > 0) {
                 memmove(data->apb + i, data->apb + i + 1, sizeof data->apb[0] * to_move);
@@ -94,6 +128,9 @@ void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb
             --data->size;
             break;
         }
+        if ((int)i_sckt > new_nfds) {
+            new_nfds = i_sckt;
+        }
     }
 
     FD_CLR(sockt, &data->exceptfds);
@@ -102,7 +139,7 @@ void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb
 
     for (; i < data->size; ++i) {
         pbpal_native_socket_t i_sckt = data->asocket[i];
-        PUBNUB_ASSERT(pubnub_get_native_socket(data->apb[i]) == data->asocket[i]);
+        PUBNUB_ASSERT(is_socket_of(data->apb[i], data->asocket[i]));
         if ((int)i_sckt > new_nfds) {
             new_nfds = i_sckt;
         }
@@ -111,18 +148,76 @@ void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb
 }
 
 
+void pbpal_ntf_callback_save_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    PUBNUB_ASSERT_EX(!we_ve_got_ya(data, pb));
+
+    add_socket(data, pb, sockt);
+}
+
+
+void pbpal_ntf_callback_remove_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    pbpal_native_socket_t sockt = pubnub_get_native_socket(pb);
+
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    if (INVALID_SOCKET == sockt) {
+        return;
+    }
+    PUBNUB_ASSERT_EX(we_ve_got_ya(data, pb));
+
+    remove_socket(data, sockt);
+}
+
+
+#if PUBNUB_HAPPY_EYEBALLS
+/* The racing socket is added after the one of the context, and the
+   order is kept on removal, so looking up by the context (to update
+   it) finds the latter.
+ */
+void pbpal_ntf_callback_save_race_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    PUBNUB_ASSERT_OPT(data != NULL);
+    PUBNUB_ASSERT_EX(we_ve_got_ya(data, pb));
+
+    add_socket(data, pb, pb->connect_race.socket);
+}
+
+
+void pbpal_ntf_callback_remove_race_socket(struct pbpal_poll_data* data, pubnub_t* pb)
+{
+    PUBNUB_ASSERT_OPT(data != NULL);
+
+    remove_socket(data, pb->connect_race.socket);
+}
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
 void pbpal_ntf_callback_update_socket(struct pbpal_poll_data* data, pubnub_t* pb)
 {
     size_t i;
 
     PUBNUB_ASSERT_OPT(data != NULL);
+    if (!we_ve_got_ya(data, pb)) {
+        /* It had no socket before (waiting on the DNS cache) */
+        pbpal_ntf_callback_save_socket(data, pb);
+        return;
+    }
     for (i = 0; i < data->size; ++i) {
         if (data->apb[i] == pb) {
             pbpal_native_socket_t sckt = data->asocket[i];
 
             FD_CLR(sckt, &data->readfds);
-            FD_CLR(sckt, &data->readfds);
-            FD_CLR(sckt, &data->readfds);
+            FD_CLR(sckt, &data->writefds);
+            FD_CLR(sckt, &data->exceptfds);
 
             sckt = pubnub_get_native_socket(data->apb[i]);
             FD_CLR(sckt, &data->readfds);
@@ -140,6 +235,10 @@ int pbpal_ntf_watch_out_events(struct pbpal_poll_data* data, pubnub_t* pbp)
     pbpal_native_socket_t scket = pubnub_get_native_socket(pbp);
 
     PUBNUB_ASSERT_OPT(data != NULL);
+    if (INVALID_SOCKET == scket) {
+        /* Nothing to watch (yet) */
+        return 0;
+    }
     if (!we_ve_got_ya(data, pbp)) {
         return -1;
     }
@@ -156,6 +255,10 @@ int pbpal_ntf_watch_in_events(struct pbpal_poll_data* data, pubnub_t* pbp)
     pbpal_native_socket_t scket = pubnub_get_native_socket(pbp);
 
     PUBNUB_ASSERT_OPT(data != NULL);
+    if (INVALID_SOCKET == scket) {
+        /* Nothing to watch (yet) */
+        return 0;
+    }
     if (!we_ve_got_ya(data, pbp)) {
         return -1;
     }
@@ -176,9 +279,11 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
     fd_set         exceptfds;
     struct timeval timeout;
 
+#if defined(_WIN32)
     if (0 == data->size) {
         return 0;
     }
+#endif
 
     timeout.tv_sec  = ms / 1000;
     timeout.tv_usec = (ms % 1000) * 1000;
@@ -186,7 +291,11 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
     memcpy(&readfds, &data->readfds, sizeof readfds);
     memcpy(&writefds, &data->writefds, sizeof writefds);
     memcpy(&exceptfds, &data->exceptfds, sizeof exceptfds);
-    rslt = select(data->nfds + 1, &readfds, &writefds, &exceptfds, &timeout);
+    rslt = select(data->nfds + 1,
+                  &readfds,
+                  &writefds,
+                  &exceptfds,
+                  (ms < 0) ? NULL : &timeout);
     if (SOCKET_ERROR == rslt) {
         int last_err =
 #if defined(_WIN32)
@@ -200,6 +309,15 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
             "poll size = %u, error = %d\n", (unsigned)data->size, last_err);
         return -1;
     }
+#if !defined(_WIN32)
+    if ((rslt > 0) && FD_ISSET(data->wakepipe[0], &readfds)) {
+        char buf[64];
+        while (read(data->wakepipe[0], buf, sizeof buf) > 0) {
+            continue;
+        }
+        --rslt;
+    }
+#endif
     for (i = 0; (i < (int)data->size) && (rslt > 0); ++i) {
         bool should_process = false;
         if (FD_ISSET(data->asocket[i], &readfds)) {
@@ -226,11 +344,32 @@ int pbpal_ntf_poll_away(struct pbpal_poll_data* data, int ms)
 }
 
 
+int pbpal_ntf_callback_poller_wakeup(struct pbpal_poll_data* data)
+{
+#if defined(_WIN32)
+    PUBNUB_UNUSED(data);
+    return -1;
+#else
+    char const c = 1;
+    /* If the pipe is full, the poller will wake up anyway */
+    if ((write(data->wakepipe[1], &c, 1) < 0) && (errno != EAGAIN)) {
+        PUBNUB_LOG_WARNING("Failed to write to the wake-up pipe, errno=%d\n", errno);
+        return -1;
+    }
+    return 0;
+#endif
+}
+
+
 void pbpal_ntf_callback_poller_deinit(struct pbpal_poll_data** data)
 {
     PUBNUB_ASSERT_OPT(data != NULL);
     PUBNUB_ASSERT_OPT(*data != NULL);
 
+#if !defined(_WIN32)
+    close((*data)->wakepipe[0]);
+    close((*data)->wakepipe[1]);
+#endif
     free(*data);
     *data = NULL;
 }
@@ -26,6 +26,12 @@ struct pbpal_poll_data {
     size_t    size;
     pubnub_t* apb[FD_SETSIZE];
     pbpal_native_socket_t asocket[FD_SETSIZE];
+#if !defined(_WIN32)
+    /** The self-pipe used to wake up the poller. Its read end is
+        always in `readfds`, but not in `asocket`.
+     */
+    int       wakepipe[2];
+#endif
 };
 
 
@@ -6,14 +6,20 @@
 #include "core/pubnub_log.h"
 #include "lib/sockets/pbpal_adns_sockets.h"
 #include "lib/sockets/pbpal_socket_blocking_io.h"
+#if PUBNUB_DNS_CACHE
+#include "lib/pubnub_dns_cache.h"
+#endif
 
 #include <string.h>
 #include <sys/types.h>
 
 #if defined(_WIN32)
 #include "windows/pubnub_get_native_socket.h"
+/* For our purposes (one socket), WSAPoll() is the same as poll() */
+#define poll(fdarray, nfds, timeout) WSAPoll(fdarray, nfds, timeout)
 #else
 #include "posix/pubnub_get_native_socket.h"
+#include <poll.h>
 #endif
 
 #define HTTP_PORT 80
@@ -39,7 +45,8 @@ static void prepare_port_and_hostname(pubnub_t*    pb,
                                       char const** p_origin)
 {
     PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
-    PUBNUB_ASSERT_OPT((pb->state == PBS_READY) || (pb->state == PBS_WAIT_DNS_SEND));
+    PUBNUB_ASSERT_OPT((pb->state == PBS_READY) || (pb->state == PBS_WAIT_DNS_SEND)
+                      || (pb->state == PBS_WAIT_DNS_RCV));
     *p_origin = PUBNUB_ORIGIN_SETTABLE ? pb->origin : PUBNUB_ORIGIN;
 #if PUBNUB_USE_SSL
     if (pb->flags.trySSL) {
@@ -291,6 +298,336 @@ try_TCP_connect_spare_address(pb_socket_t*                   skt,
     return rslt;
 }
 #endif /* PUBNUB_USE_MULTIPLE_ADDRESSES */
+
+
+#if PUBNUB_HAPPY_EYEBALLS
+/** Is the current spare address (the one the attempt on the socket
+    of the PAL is to) an IPv4 one.
+ */
+static bool current_is_ipv4(struct pubnub_multi_addresses const* spare_addresses,
+                            struct pubnub_connect_race const*    race)
+{
+    return !race->current_ipv6
+           && (spare_addresses->ipv4_index < spare_addresses->n_ipv4);
+}
+
+
+/** Gets the spare address to race the attempt to connect to the
+    current one with: one of the other family, if there is such, or
+    the next one of the same family. Puts it in @p dest and what it is
+    in @p race.
+
+    @return true if there is an address to race with, false otherwise
+ */
+static bool race_address(struct pubnub_multi_addresses const* spare_addresses,
+                         struct pubnub_connect_race*          race,
+                         sockaddr_inX_t*                      dest)
+{
+    time_t const elapsed = time(NULL) - spare_addresses->time_of_the_last_dns_query;
+    bool const   ipv4    = current_is_ipv4(spare_addresses, race);
+    int          index;
+
+#if PUBNUB_USE_IPV6
+    index = ipv4 ? spare_addresses->ipv6_index : spare_addresses->ipv6_index + 1;
+    /* Need at least a second to live */
+    if ((index < spare_addresses->n_ipv6)
+        && (spare_addresses->ttl_ipv6[index] - 2 > elapsed)) {
+        struct sockaddr_in6* dest6 = (struct sockaddr_in6*)dest;
+        memcpy(dest6->sin6_addr.s6_addr,
+               spare_addresses->ipv6_addresses[index].ipv6,
+               sizeof dest6->sin6_addr.s6_addr);
+        dest6->sin6_family = AF_INET6;
+        race->ipv6         = true;
+        race->index        = index;
+        return true;
+    }
+#endif /* PUBNUB_USE_IPV6 */
+    /* If IPv6 is current, the IPv4 one we're at is yet to be tried */
+    index = ipv4 ? spare_addresses->ipv4_index + 1 : spare_addresses->ipv4_index;
+    if ((index < spare_addresses->n_ipv4)
+        && (spare_addresses->ttl_ipv4[index] - 2 > elapsed)) {
+        struct sockaddr_in* dest4 = (struct sockaddr_in*)dest;
+        memcpy(&(dest4->sin_addr.s_addr),
+               spare_addresses->ipv4_addresses[index].ipv4,
+               sizeof dest4->sin_addr.s_addr);
+        dest4->sin_family = AF_INET;
+        race->ipv6        = false;
+        race->index       = index;
+        return true;
+    }
+    return false;
+}
+
+
+/** Makes the address of the racing attempt the current spare
+    address. The IPv4 addresses are kept if an IPv6 one takes over,
+    to fall back to on later (re)connects, but the one that was
+    current is skipped if @p current_failed.
+ */
+static void race_address_is_current(struct pubnub_multi_addresses* spare_addresses,
+                                    struct pubnub_connect_race*    race,
+                                    bool                           current_failed)
+{
+#if PUBNUB_USE_IPV6
+    if (race->ipv6) {
+        if (current_failed && current_is_ipv4(spare_addresses, race)) {
+            ++spare_addresses->ipv4_index;
+        }
+        spare_addresses->ipv6_index = race->index;
+        race->current_ipv6 = spare_addresses->ipv4_index < spare_addresses->n_ipv4;
+        return;
+    }
+#else
+    PUBNUB_UNUSED(current_failed);
+#endif
+    spare_addresses->ipv4_index = race->index;
+    race->current_ipv6          = false;
+}
+
+
+/** The attempt to connect to the current spare address failed, so
+    moves to the next one, to retry with, if there is one.
+ */
+static void current_address_failed(struct pubnub_multi_addresses* spare_addresses,
+                                   struct pubnub_connect_race*    race,
+                                   struct pubnub_flags*           flags,
+                                   struct pubnub_options const*   options)
+{
+    if (current_is_ipv4(spare_addresses, race)) {
+        ++spare_addresses->ipv4_index;
+    }
+#if PUBNUB_USE_IPV6
+    else if (spare_addresses->ipv6_index < spare_addresses->n_ipv6) {
+        ++spare_addresses->ipv6_index;
+    }
+    flags->retry_after_close =
+        (spare_addresses->ipv4_index < spare_addresses->n_ipv4)
+        || (spare_addresses->ipv6_index < spare_addresses->n_ipv6);
+#else
+    flags->retry_after_close = (spare_addresses->ipv4_index < spare_addresses->n_ipv4);
+#endif
+    race->current_ipv6 = false;
+#if PUBNUB_USE_SSL
+    flags->trySSL = options->useSSL;
+#else
+    PUBNUB_UNUSED(options);
+#endif
+}
+
+
+/** Gets ready to race the attempt to connect to the current spare
+    address on the @p port, if it is in progress (@p rslt) and there
+    is an address to race it with.
+    @return @p rslt
+ */
+static enum pbpal_resolv_n_connect_result
+prepare_connect_race(pubnub_t* pb, enum pbpal_resolv_n_connect_result rslt, uint16_t port)
+{
+    struct pubnub_connect_race* race = &pb->connect_race;
+    sockaddr_inX_t              dest = { 0 };
+
+    PUBNUB_ASSERT_OPT(SOCKET_INVALID == race->socket);
+    if ((pbpal_connect_wouldblock == rslt)
+        && race_address(&pb->spare_addresses, race, &dest)) {
+        race->port    = port;
+        race->started = pbms_start();
+        pbntf_watch_connect_race(pb);
+    }
+    return rslt;
+}
+
+
+/** Closes the socket of the racing attempt, if there is one */
+static void close_race_socket(pubnub_t* pb)
+{
+    struct pubnub_connect_race* race = &pb->connect_race;
+
+    if (race->socket != SOCKET_INVALID) {
+        pbntf_unwatch_race_socket(pb);
+        socket_close(race->socket);
+        race->socket = SOCKET_INVALID;
+    }
+}
+
+
+/** Starts the attempt to race the one on the socket of @p pb */
+static void start_racing_attempt(pubnub_t* pb)
+{
+    struct pubnub_connect_race*        race = &pb->connect_race;
+    sockaddr_inX_t                     dest = { 0 };
+    enum pbpal_resolv_n_connect_result rslt = pbpal_connect_failed;
+
+    pbms_stop(&race->started);
+    if (race_address(&pb->spare_addresses, race, &dest)) {
+        rslt = connect_TCP_socket(
+            &race->socket, &pb->options, (struct sockaddr*)&dest, race->port);
+    }
+    PUBNUB_LOG_TRACE("pb=%p: started racing connection attempt, socket=%ld, "
+                     "ipv6=%d, index=%d, rslt=%d\n",
+                     pb,
+                     (long)race->socket,
+                     race->ipv6,
+                     race->index,
+                     rslt);
+    if ((rslt == pbpal_connect_wouldblock) || (rslt == pbpal_connect_success)) {
+        pbntf_watch_race_socket(pb);
+    }
+    else if (race->socket != SOCKET_INVALID) {
+        socket_close(race->socket);
+        race->socket = SOCKET_INVALID;
+    }
+}
+
+
+/** Checks the state of the attempt to connect on the socket @p skt,
+    waiting for at most @p wait_ms milliseconds. Uses poll(), as
+    select() can't handle sockets beyond `FD_SETSIZE`, which we can
+    easily have with many contexts.
+    @retval 0 connected
+    @retval +1 still in progress
+    @retval -1 failed
+ */
+static int connect_attempt_status(pb_socket_t skt, int wait_ms)
+{
+    struct pollfd pfd;
+    int           error = 0;
+    socklen_t     len   = sizeof error;
+
+    pfd.fd      = skt;
+    pfd.events  = POLLOUT;
+    pfd.revents = 0;
+    switch (poll(&pfd, 1, wait_ms)) {
+    case SOCKET_ERROR:
+        return -1;
+    case 0:
+        return +1;
+    default:
+        break;
+    }
+    if ((getsockopt(skt, SOL_SOCKET, SO_ERROR, (char*)&error, &len) != 0)
+        || (error != 0)) {
+        PUBNUB_LOG_DEBUG("connect_attempt_status(skt=%ld): error=%d\n", (long)skt, error);
+        return -1;
+    }
+    return 0;
+}
+
+
+void pbpal_connect_race_forget(pubnub_t* pb)
+{
+    struct pubnub_connect_race* race = &pb->connect_race;
+
+    close_race_socket(pb);
+    pbms_stop(&race->started);
+    pbntf_unwatch_connect_race(pb);
+    race->current_ipv6 = false;
+}
+
+
+/** pbpal_check_connect() when racing connection attempts. The
+    attempt on the socket of @p pb is checked first, and if it's still
+    in progress after #PUBNUB_CONNECTION_ATTEMPT_DELAY_MS, another is
+    started to race it. When one of them connects, the other is closed
+    and the socket of @p pb is the one connected. If one fails, the
+    other one goes on alone, and it can be raced, too. If both fail, we
+    retry with the next spare address, if there is one.
+ */
+static enum pbpal_resolv_n_connect_result check_connect_race(pubnub_t* pb)
+{
+    struct pubnub_connect_race* race = &pb->connect_race;
+    int                         status;
+
+    if ((SOCKET_INVALID == race->socket) && pbms_active(race->started)
+        && (pbms_elapsed(race->started) >= PUBNUB_CONNECTION_ATTEMPT_DELAY_MS)) {
+        start_racing_attempt(pb);
+    }
+    status = connect_attempt_status(pb->pal.socket, 0);
+    if (0 == status) {
+        pbpal_connect_race_forget(pb);
+        return pbpal_connect_success;
+    }
+    if (race->socket != SOCKET_INVALID) {
+        int const race_status = connect_attempt_status(race->socket, 0);
+        if ((0 == race_status) || (status < 0)) {
+            PUBNUB_LOG_TRACE("pb=%p: racing connection attempt on socket=%ld "
+                             "takes over, race_status=%d\n",
+                             pb,
+                             (long)race->socket,
+                             race_status);
+            pbntf_unwatch_race_socket(pb);
+            socket_close(pb->pal.socket);
+            pb->pal.socket = race->socket;
+            race->socket   = SOCKET_INVALID;
+            pbntf_update_socket(pb);
+            race_address_is_current(&pb->spare_addresses, race, status < 0);
+            status = race_status;
+            if (status > 0) {
+                prepare_connect_race(pb, pbpal_connect_wouldblock, race->port);
+            }
+        }
+        else if (race_status < 0) {
+            close_race_socket(pb);
+        }
+    }
+    if (status > 0) {
+        return pbpal_connect_wouldblock;
+    }
+    if (status < 0) {
+        current_address_failed(&pb->spare_addresses, race, &pb->flags, &pb->options);
+    }
+    pbpal_connect_race_forget(pb);
+
+    return (status < 0) ? pbpal_connect_failed : pbpal_connect_success;
+}
+#else
+#define prepare_connect_race(pb, rslt, port) (rslt)
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
+#if PUBNUB_DNS_CACHE
+/** Checks whether the context @p pb, which waits for another one to
+    resolve the @p origin, can stop waiting. If it's resolved, connects
+    to the @p port on a resolved address. If the other context gave up
+    resolving, opens the DNS socket (waiting contexts don't have one)
+    and sends the DNS query to the @p dns_server itself.
+ */
+static enum pbpal_resolv_n_connect_result check_dns_cache(pubnub_t*        pb,
+                                                          char const*      origin,
+                                                          struct sockaddr* dns_server,
+                                                          const uint16_t   port)
+{
+    switch (pbdns_cache_lookup(pb, origin, QUERY_TYPE)) {
+    case pbdnscacheWait:
+        return pbpal_resolv_rcv_wouldblock;
+    case pbdnscacheHit:
+        if (pb->pal.socket != SOCKET_INVALID) {
+            socket_close(pb->pal.socket);
+            pb->pal.socket = SOCKET_INVALID;
+        }
+        return prepare_connect_race(
+            pb,
+            try_TCP_connect_spare_address(
+                &pb->pal.socket, &pb->spare_addresses, &pb->options, &pb->flags, port),
+            port);
+    default:
+        break;
+    }
+    if (SOCKET_INVALID == pb->pal.socket) {
+        pb->pal.socket = socket(dns_server->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+        if (SOCKET_INVALID == pb->pal.socket) {
+            return pbpal_resolv_resource_failure;
+        }
+        pb->options.use_blocking_io = false;
+        pbpal_set_blocking_io(pb);
+        pbntf_update_socket(pb);
+        pbntf_watch_in_events(pb);
+    }
+    if (send_dns_query(pb->pal.socket, dns_server, origin, QUERY_TYPE) != 0) {
+        return pbpal_resolv_failed_rcv;
+    }
+    return pbpal_resolv_rcv_wouldblock;
+}
+#endif /* PUBNUB_DNS_CACHE */
 #endif /* PUBNUB_CALLBACK_API */
 
 
@@ -330,11 +667,50 @@ enum pbpal_resolv_n_connect_result pbpal_resolv_and_connect(pubnub_t* pb)
 #if PUBNUB_USE_MULTIPLE_ADDRESSES
     {
         enum pbpal_resolv_n_connect_result rslt;
+#if PUBNUB_DNS_CACHE
+        time_t const resolved_at = pb->spare_addresses.time_of_the_last_dns_query;
+        bool const   had_spare   = pb->spare_addresses.n_ipv4 > 0
+#if PUBNUB_USE_IPV6
+                               || pb->spare_addresses.n_ipv6 > 0
+#endif
+            ;
+#endif
         rslt = try_TCP_connect_spare_address(
             &pb->pal.socket, &pb->spare_addresses, &pb->options, &pb->flags, port);
         if (rslt != pbpal_resolv_resource_failure) {
-            return rslt;
+            return prepare_connect_race(pb, rslt, port);
         }
+#if PUBNUB_DNS_CACHE
+        if (had_spare) {
+            /* Tried them all, so don't get the same ones from the
+               cache again - resolve the origin anew */
+            pbdns_cache_invalidate(origin, QUERY_TYPE, resolved_at);
+        }
+#endif
+    }
+#endif
+#if PUBNUB_DNS_CACHE
+    if (pbdns_cache_lookup(pb, origin, QUERY_TYPE) == pbdnscacheHit) {
+        enum pbpal_resolv_n_connect_result rslt;
+        if (pb->pal.socket != SOCKET_INVALID) {
+            /* Resolved by someone else while we were about to send */
+            socket_close(pb->pal.socket);
+            pb->pal.socket = SOCKET_INVALID;
+        }
+        rslt = try_TCP_connect_spare_address(
+            &pb->pal.socket, &pb->spare_addresses, &pb->options, &pb->flags, port);
+        if (rslt != pbpal_resolv_resource_failure) {
+            return prepare_connect_race(pb, rslt, port);
+        }
+    }
+#endif
+#if PUBNUB_DNS_CACHE
+    if (pb->flags.dns_cache_waiting) {
+        /* Another context sent the query, we'll be requeued for
+           processing when the response to it arrives. No need for a
+           DNS socket, unless we have to send the query ourselves.
+        */
+        return pbpal_resolv_sent;
     }
 #endif
 #if PUBNUB_CHANGE_DNS_SERVERS
@@ -354,6 +730,9 @@ enum pbpal_resolv_n_connect_result pbpal_resolv_and_connect(pubnub_t* pb)
     error =
         send_dns_query(pb->pal.socket, (struct sockaddr*)&dest, origin, QUERY_TYPE);
     if (error < 0) {
+#if PUBNUB_DNS_CACHE
+        pbdns_cache_forget(pb);
+#endif
 #if PUBNUB_CHANGE_DNS_SERVERS
         check_dns_server_error(&pb->dns_check, &pb->flags);
         if_no_retry_close_socket(&pb->pal.socket, &pb->flags);
@@ -434,6 +813,10 @@ enum pbpal_resolv_n_connect_result pbpal_check_resolv_and_connect(pubnub_t* pb)
     sockaddr_inX_t                     dest       = { 0 };
     uint16_t                           port       = HTTP_PORT;
     enum pbpal_resolv_n_connect_result rslt;
+#if PUBNUB_DNS_CACHE
+    uint16_t    origin_port = HTTP_PORT;
+    char const* origin;
+#endif
 
     PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
     PUBNUB_ASSERT_OPT(pb->state == PBS_WAIT_DNS_RCV);
@@ -452,6 +835,12 @@ enum pbpal_resolv_n_connect_result pbpal_check_resolv_and_connect(pubnub_t* pb)
     get_dns_ip(&pb->dns_check, (struct sockaddr*)&dns_server);
 #else
     get_dns_ip((struct sockaddr*)&dns_server);
+#endif
+#if PUBNUB_DNS_CACHE
+    prepare_port_and_hostname(pb, &origin_port, &origin);
+    if (pb->flags.dns_cache_waiting) {
+        return check_dns_cache(pb, origin, (struct sockaddr*)&dns_server, port);
+    }
 #endif
     switch (read_dns_response(pb->pal.socket,
                               (struct sockaddr*)&dns_server,
@@ -466,6 +855,9 @@ enum pbpal_resolv_n_connect_result pbpal_check_resolv_and_connect(pubnub_t* pb)
     case 0:
         break;
     }
+#if PUBNUB_DNS_CACHE
+    pbdns_cache_store(pb, origin, QUERY_TYPE);
+#endif
     socket_close(pb->pal.socket);
 
     rslt = connect_TCP_socket(
@@ -487,7 +879,7 @@ enum pbpal_resolv_n_connect_result pbpal_check_resolv_and_connect(pubnub_t* pb)
 #endif
     }
 #endif /* PUBNUB_USE_MULTIPLE_ADDRESSES */
-    return rslt;
+    return prepare_connect_race(pb, rslt, port);
 #else /* PUBNUB_CALLBACK_API */
 
     PUBNUB_UNUSED(pb);
@@ -502,24 +894,32 @@ enum pbpal_resolv_n_connect_result pbpal_check_resolv_and_connect(pubnub_t* pb)
 
 enum pbpal_resolv_n_connect_result pbpal_check_connect(pubnub_t* pb)
 {
-    fd_set         write_set;
-    int            rslt;
-    struct timeval timev = { 0, 300000 };
+#if PUBNUB_HAPPY_EYEBALLS
+    PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
+    PUBNUB_ASSERT_OPT(pb->state == PBS_WAIT_CONNECT);
+
+    return check_connect_race(pb);
+#else
+    struct pollfd pfd;
+    int           rslt;
 
     PUBNUB_ASSERT(pb_valid_ctx_ptr(pb));
     PUBNUB_ASSERT_OPT(pb->state == PBS_WAIT_CONNECT);
 
-    FD_ZERO(&write_set);
-    FD_SET(pb->pal.socket, &write_set);
-    rslt = select(pb->pal.socket + 1, NULL, &write_set, NULL, &timev);
+    /* Not select(), it can't handle sockets beyond `FD_SETSIZE` */
+    pfd.fd      = pb->pal.socket;
+    pfd.events  = POLLOUT;
+    pfd.revents = 0;
+    rslt        = poll(&pfd, 1, 300);
     if (SOCKET_ERROR == rslt) {
-        PUBNUB_LOG_ERROR("pbpal_connected(): select() Error!\n");
+        PUBNUB_LOG_ERROR("pbpal_connected(): poll() Error!\n");
         return pbpal_connect_resource_failure;
     }
     else if (rslt > 0) {
-        PUBNUB_LOG_TRACE("pbpal_connected(): select() event\n");
+        PUBNUB_LOG_TRACE("pbpal_connected(): poll() event\n");
         return pbpal_connect_success;
     }
-    PUBNUB_LOG_TRACE("pbpal_connected(): no select() events\n");
+    PUBNUB_LOG_TRACE("pbpal_connected(): no poll() events\n");
     return pbpal_connect_wouldblock;
+#endif /* PUBNUB_HAPPY_EYEBALLS */
 }
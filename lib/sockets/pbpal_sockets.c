@@ -6,6 +6,9 @@
 #include "core/pubnub_netcore.h"
 #include "core/pubnub_assert.h"
 #include "core/pubnub_log.h"
+#if PUBNUB_DNS_CACHE
+#include "lib/pubnub_dns_cache.h"
+#endif
 
 #include <sys/types.h>
 #include <fcntl.h>
@@ -15,8 +18,9 @@
 
 static void buf_setup(pubnub_t* pb)
 {
-    pb->ptr  = (uint8_t*)pb->core.http_buf;
-    pb->left = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+    pb->ptr       = (uint8_t*)pb->core.http_buf;
+    pb->left      = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+    pb->read_into = NULL;
 }
 
 
@@ -43,6 +47,11 @@ void pbpal_init(pubnub_t* pb)
 #if PUBNUB_USE_MULTIPLE_ADDRESSES
     pbpal_multiple_addresses_reset_counters(&pb->spare_addresses);
 #endif
+#if PUBNUB_HAPPY_EYEBALLS
+    pb->connect_race.socket       = SOCKET_INVALID;
+    pb->connect_race.current_ipv6 = false;
+    pbms_stop(&pb->connect_race.started);
+#endif
 }
 
 
@@ -196,13 +205,12 @@ enum pubnub_res pbpal_line_read_status(pubnub_t* pb)
         pb->left -= recvres;
     }
 
-    while (pb->unreadlen > 0) {
-        uint8_t c;
-
-        --pb->unreadlen;
-
-        c = *pb->ptr++;
-        if (c == '\n') {
+    if (pb->unreadlen > 0) {
+        uint8_t* newline = (uint8_t*)memchr(pb->ptr, '\n', pb->unreadlen);
+        if (newline != NULL) {
+            ++newline;
+            pb->unreadlen -= newline - pb->ptr;
+            pb->ptr = newline;
             PUBNUB_LOG_TRACE("pb=%p, newline found, line length: %d, ",
                              pb,
                              pbpal_read_len(pb));
@@ -210,6 +218,8 @@ enum pubnub_res pbpal_line_read_status(pubnub_t* pb)
             pb->sock_state = STATE_NONE;
             return PNR_OK;
         }
+        pb->ptr += pb->unreadlen;
+        pb->unreadlen = 0;
     }
 
     if (pb->left == 0) {
@@ -229,6 +239,22 @@ int pbpal_read_len(pubnub_t* pb)
 }
 
 
+char const* pbpal_unread_data(pubnub_t* pb, size_t* len)
+{
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+    *len = pb->unreadlen;
+    return (0 == pb->unreadlen) ? NULL : (char const*)pb->ptr;
+}
+
+
+void pbpal_skip_unread(pubnub_t* pb, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, <=, pb->unreadlen);
+    pb->ptr += n;
+    pb->unreadlen -= n;
+}
+
+
 int pbpal_start_read(pubnub_t* pb, size_t n)
 {
     unsigned distance;
@@ -253,17 +279,71 @@ int pbpal_start_read(pubnub_t* pb, size_t n)
 
     pb->sock_state = STATE_READ;
     pb->len        = n;
+    pb->read_into  = NULL;
 
     return +1;
 }
 
 
+int pbpal_start_read_into(pubnub_t* pb, char* dest, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, >, 0);
+    PUBNUB_ASSERT_OPT(dest != NULL);
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+
+    pb->sock_state = STATE_READ;
+    pb->len        = n;
+    pb->read_into  = (uint8_t*)dest;
+
+    return 0;
+}
+
+
+/** Reading for pbpal_start_read_into(): first the data we already
+    have in our buffer is copied, the rest is received straight into
+    the destination.
+ */
+static enum pubnub_res read_into_status(pubnub_t* pb)
+{
+    int have_read;
+
+    if (pb->unreadlen > 0) {
+        have_read = (pb->unreadlen >= pb->len) ? pb->len : pb->unreadlen;
+        memcpy(pb->read_into, pb->ptr, have_read);
+        pb->ptr += have_read;
+        pb->unreadlen -= have_read;
+        pb->read_into += have_read;
+        pb->len -= have_read;
+    }
+    if (pb->len > 0) {
+        have_read = socket_recv(pb->pal.socket, (char*)pb->read_into, pb->len, 0);
+        if (have_read <= 0) {
+            return handle_socket_error(have_read, pb);
+        }
+        PUBNUB_ASSERT_OPT((unsigned)have_read <= pb->len);
+        pb->read_into += have_read;
+        pb->len -= have_read;
+    }
+
+    if (0 == pb->len) {
+        pb->read_into  = NULL;
+        pb->sock_state = STATE_NONE;
+        return PNR_OK;
+    }
+
+    return PNR_IN_PROGRESS;
+}
+
+
 enum pubnub_res pbpal_read_status(pubnub_t* pb)
 {
     int have_read;
 
     PUBNUB_ASSERT_OPT(STATE_READ == pb->sock_state);
 
+    if (pb->read_into != NULL) {
+        return read_into_status(pb);
+    }
     if (0 == pb->unreadlen) {
         unsigned to_recv = pb->len;
         if (to_recv > pb->left) {
@@ -309,6 +389,12 @@ void pbpal_forget(pubnub_t* pb)
 
 int pbpal_close(pubnub_t* pb)
 {
+#if PUBNUB_DNS_CACHE
+    pbdns_cache_forget(pb);
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    pbpal_connect_race_forget(pb);
+#endif
     pb->unreadlen = 0;
     if (pb->pal.socket != SOCKET_INVALID) {
         pbntf_lost_socket(pb);
@@ -324,6 +410,12 @@ int pbpal_close(pubnub_t* pb)
 
 void pbpal_free(pubnub_t* pb)
 {
+#if PUBNUB_DNS_CACHE
+    pbdns_cache_forget(pb);
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    pbpal_connect_race_forget(pb);
+#endif
     if (pb->pal.socket != SOCKET_INVALID) {
         /* While this should not happen, it doesn't hurt to be paranoid.
          */
@@ -159,6 +159,24 @@ int pbpal_read_len(pubnub_t *pb)
 }
 
 
+char const* pbpal_unread_data(pubnub_t *pb, size_t *len)
+{
+    /* We don't keep track of the unread data in a way that would let
+       anyone process it in place, so, pretend there is none.
+     */
+    PUBNUB_UNUSED(pb);
+    *len = 0;
+    return NULL;
+}
+
+
+void pbpal_skip_unread(pubnub_t *pb, size_t n)
+{
+    PUBNUB_UNUSED(pb);
+    PUBNUB_UNUSED(n);
+}
+
+
 int pbpal_start_read(pubnub_t *pb, size_t n)
 {
     if (pb->sock_state != STATE_NONE) {
@@ -184,6 +202,15 @@ int pbpal_start_read(pubnub_t *pb, size_t n)
 }
 
 
+int pbpal_start_read_into(pubnub_t *pb, char* dest, size_t n)
+{
+    PUBNUB_UNUSED(pb);
+    PUBNUB_UNUSED(dest);
+    PUBNUB_UNUSED(n);
+    return -1;
+}
+
+
 enum pubnub_res pbpal_read_status(pubnub_t *pb)
 {
     unsigned to_read = 0;
@@ -22,11 +22,14 @@ static int print_to_pubnub_log(const char *s, size_t len, void *p)
 }
 
 
+/** Encrypts @p msg with @p key and @p iv. If @p key is NULL, @p
+    aes256 was already keyed (for encryption) and that key is used.
+*/
 static int do_encrypt(EVP_CIPHER_CTX* aes256, pubnub_bymebl_t msg, uint8_t const* key, uint8_t const* iv, pubnub_bymebl_t *encrypted)
 {
     int len = 0;
 
-    if (!EVP_EncryptInit_ex(aes256, EVP_aes_256_cbc(), NULL, key, iv)) {
+    if (!EVP_EncryptInit_ex(aes256, (NULL == key) ? NULL : EVP_aes_256_cbc(), NULL, key, iv)) {
         ERR_print_errors_cb(print_to_pubnub_log, NULL);
         PUBNUB_LOG_ERROR("Failed to initialize AES-256 encryption\n");
         return -1;
@@ -95,10 +98,13 @@ pubnub_bymebl_t pbaes256_encrypt_alloc(pubnub_bymebl_t msg, uint8_t const* key,
 }
 
 
+/** Decrypts @p data with @p key and @p iv. If @p key is NULL, @p
+    aes256 was already keyed (for decryption) and that key is used.
+*/
 static int do_decrypt(EVP_CIPHER_CTX* aes256, pubnub_bymebl_t data, uint8_t const* key, uint8_t const* iv, pubnub_bymebl_t *msg)
 {
     int len = 0;
-    if (!EVP_DecryptInit_ex(aes256, EVP_aes_256_cbc(), NULL, key, iv)) {
+    if (!EVP_DecryptInit_ex(aes256, (NULL == key) ? NULL : EVP_aes_256_cbc(), NULL, key, iv)) {
         ERR_print_errors_cb(print_to_pubnub_log, NULL);
         PUBNUB_LOG_ERROR("Failed to initialize AES-256 decryption\n");
         return -1;
@@ -178,3 +184,78 @@ pubnub_bymebl_t pbaes256_decrypt_alloc(pubnub_bymebl_t data, uint8_t const* key,
 
     return result;
 }
+
+
+struct pbaes256_context* pbaes256_context_new_encrypt(uint8_t const* key)
+{
+    EVP_CIPHER_CTX* aes256 = EVP_CIPHER_CTX_new();
+
+    if (NULL == aes256) {
+        PUBNUB_LOG_ERROR("Failed to allocate AES-256 encryption context\n");
+        return NULL;
+    }
+    /* Expands the key, which is kept for all messages to come */
+    if (!EVP_EncryptInit_ex(aes256, EVP_aes_256_cbc(), NULL, key, NULL)) {
+        ERR_print_errors_cb(print_to_pubnub_log, NULL);
+        PUBNUB_LOG_ERROR("Failed to initialize AES-256 encryption\n");
+        EVP_CIPHER_CTX_free(aes256);
+        return NULL;
+    }
+
+    return (struct pbaes256_context*)aes256;
+}
+
+
+struct pbaes256_context* pbaes256_context_new_decrypt(uint8_t const* key)
+{
+    EVP_CIPHER_CTX* aes256 = EVP_CIPHER_CTX_new();
+
+    if (NULL == aes256) {
+        PUBNUB_LOG_ERROR("Failed to allocate AES-256 decryption context\n");
+        return NULL;
+    }
+    if (!EVP_DecryptInit_ex(aes256, EVP_aes_256_cbc(), NULL, key, NULL)) {
+        ERR_print_errors_cb(print_to_pubnub_log, NULL);
+        PUBNUB_LOG_ERROR("Failed to initialize AES-256 decryption\n");
+        EVP_CIPHER_CTX_free(aes256);
+        return NULL;
+    }
+
+    return (struct pbaes256_context*)aes256;
+}
+
+
+void pbaes256_context_free(struct pbaes256_context* ctx)
+{
+    if (ctx != NULL) {
+        EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)ctx);
+    }
+}
+
+
+int pbaes256_encrypt_with(struct pbaes256_context* ctx, pubnub_bymebl_t msg, uint8_t const* iv, pubnub_bymebl_t *encrypted)
+{
+    PUBNUB_ASSERT_OPT(ctx != NULL);
+
+    if (encrypted->size < msg.size + EVP_CIPHER_block_size(EVP_aes_256_cbc())) {
+        PUBNUB_LOG_ERROR("Not enough room to save AES-256 encrypted data\n");
+        return -1;
+    }
+    /* With no cipher and key given, this keeps the expanded key and
+       only starts a new message with the @p iv
+    */
+    return do_encrypt((EVP_CIPHER_CTX*)ctx, msg, NULL, iv, encrypted);
+}
+
+
+int pbaes256_decrypt_with(struct pbaes256_context* ctx, pubnub_bymebl_t data, uint8_t const* iv, pubnub_bymebl_t *msg)
+{
+    PUBNUB_ASSERT_OPT(ctx != NULL);
+
+    if (msg->size < data.size + EVP_CIPHER_block_size(EVP_aes_256_cbc()) + 1) {
+        PUBNUB_LOG_ERROR("Not enough room to save AES-256 decrypted data\n");
+        return -1;
+    }
+    return do_decrypt((EVP_CIPHER_CTX*)ctx, data, NULL, iv, msg);
+}
+
@@ -41,4 +41,38 @@ int pbaes256_decrypt(pubnub_bymebl_t data, uint8_t const* key, uint8_t const* iv
 pubnub_bymebl_t pbaes256_decrypt_alloc(pubnub_bymebl_t data, uint8_t const* key, uint8_t const* iv);
 
 
+/** An AES-256 context, keyed once (for encrypting or decrypting) and
+    then used for any number of messages, without allocating memory
+    or expanding the key again. It's an "opaque" type, only to be
+    used via pointer.
+
+    A context is not thread-safe, it may be used by one thread at a
+    time.
+*/
+struct pbaes256_context;
+
+/** Creates an AES-256 context for encrypting with @p key.
+    @return The context, NULL on error
+*/
+struct pbaes256_context* pbaes256_context_new_encrypt(uint8_t const* key);
+
+/** Creates an AES-256 context for decrypting with @p key.
+    @return The context, NULL on error
+*/
+struct pbaes256_context* pbaes256_context_new_decrypt(uint8_t const* key);
+
+/** Frees the AES-256 context @p ctx. Does nothing if it's NULL. */
+void pbaes256_context_free(struct pbaes256_context* ctx);
+
+/** Similar to pbaes256_encrypt(), but uses the key of the context
+    @p ctx (created with pbaes256_context_new_encrypt()).
+*/
+int pbaes256_encrypt_with(struct pbaes256_context* ctx, pubnub_bymebl_t msg, uint8_t const* iv, pubnub_bymebl_t *encrypted);
+
+/** Similar to pbaes256_decrypt(), but uses the key of the context
+    @p ctx (created with pbaes256_context_new_decrypt()).
+*/
+int pbaes256_decrypt_with(struct pbaes256_context* ctx, pubnub_bymebl_t data, uint8_t const* iv, pubnub_bymebl_t *msg);
+
+
 #endif /* !defined INC_PBAES256 */
@@ -2,12 +2,13 @@
 #if !defined INC_PBPAL_ADD_SYSTEM_CERTS
 #define      INC_PBPAL_ADD_SYSTEM_CERTS
 
-#include "core/pubnub_api_types.h"
+#include <openssl/ssl.h>
 
-/** Adds CA certificates from the system store. Available on platforms
-    that have a system store (like Windows).
+/** Adds CA certificates from the system store to the certificate
+    store of @p sslCtx. Available on platforms that have a system
+    store (like Windows).
  */
-int pbpal_add_system_certs(pubnub_t* pb);
+int pbpal_add_system_certs(SSL_CTX* sslCtx);
 
 
 #endif /* !defined INC_PBPAL_ADD_SYSTEM_CERTS */
@@ -10,6 +10,7 @@
 #endif
 
 #include "pbpal_add_system_certs.h"
+#include "pbpal_ssl_ctx_cache.h"
 #include "pubnub_internal.h"
 #include "core/pubnub_assert.h"
 #include "core/pubnub_log.h"
@@ -139,7 +140,7 @@ static int add_pubnub_cert(SSL_CTX* sslCtx)
 }
 
 
-static void add_certs(pubnub_t* pb)
+static void add_certs(pubnub_t* pb, SSL_CTX* sslCtx)
 {
     PUBNUB_LOG_TRACE(
         "add_certs(pb=%p): pb->options.use_system_certificate_store=%d, "
@@ -151,20 +152,20 @@ static void add_certs(pubnub_t* pb)
         pb->ssl_CApath);
 
     if (pb->options.use_system_certificate_store
-        && (0 == pbpal_add_system_certs(pb))) {
+        && (0 == pbpal_add_system_certs(sslCtx))) {
         return;
     }
 
     if (NULL != pb->ssl_userPEMcert) {
-        add_pem_cert(pb->pal.ctx, pb->ssl_userPEMcert);
+        add_pem_cert(sslCtx, pb->ssl_userPEMcert);
     }
 
     if ((NULL == pb->ssl_CAfile) && (NULL == pb->ssl_CApath)) {
-        add_pubnub_cert(pb->pal.ctx);
+        add_pubnub_cert(sslCtx);
     }
     else {
         if (!SSL_CTX_load_verify_locations(
-                pb->pal.ctx, pb->ssl_CAfile, pb->ssl_CApath)) {
+                sslCtx, pb->ssl_CAfile, pb->ssl_CApath)) {
             ERR_print_errors_cb(print_to_pubnub_log, NULL);
             PUBNUB_LOG_ERROR(
                 "SSL_CTX_load_verify_locations(CAfile=%s, CApath=%s) failed",
@@ -174,6 +175,62 @@ static void add_certs(pubnub_t* pb)
     }
 }
 
+
+static char const* origin_of(pubnub_t const* pb)
+{
+    return PUBNUB_ORIGIN_SETTABLE ? pb->origin : PUBNUB_ORIGIN;
+}
+
+
+/** Called by OpenSSL when a new session is established (during the
+    handshake, or, for TLS 1.3, when the server sends the session
+    ticket). If the context reuses sessions, the session is kept in
+    the cache of the SSL_CTX, for other contexts to resume.
+*/
+static int new_session_cb(SSL* ssl, SSL_SESSION* session)
+{
+    pubnub_t* pb = (pubnub_t*)SSL_get_app_data(ssl);
+
+    if ((NULL == pb) || !pb->options.reuse_SSL_session) {
+        return 0;
+    }
+    return pbpal_ssl_ctx_cache_keep_session(ssl, session, origin_of(pb), TLS_PORT)
+               ? 1
+               : 0;
+}
+
+
+/** Gets the SSL_CTX to use for @p pb: the shared one for its
+    certificate configuration, if there is one (and @p pb shares it),
+    otherwise makes a new one, with the certificates added, and shares
+    it if it should.
+ */
+static SSL_CTX* get_ssl_ctx(pubnub_t* pb)
+{
+    SSL_CTX* rslt;
+
+    if (pb->options.share_SSL_CTX) {
+        rslt = pbpal_ssl_ctx_cache_get(pb);
+        if (rslt != NULL) {
+            return rslt;
+        }
+    }
+    PUBNUB_LOG_TRACE("pb=%p: Don't have SSL_CTX\n", pb);
+    rslt = SSL_CTX_new(SSLv23_client_method());
+    if (NULL == rslt) {
+        ERR_print_errors_cb(print_to_pubnub_log, pb);
+        PUBNUB_LOG_ERROR("pb=%p SSL_CTX_new failed\n", pb);
+        return NULL;
+    }
+    PUBNUB_LOG_TRACE("pb=%p: Got SSL_CTX\n", pb);
+    add_certs(pb, rslt);
+    SSL_CTX_set_session_cache_mode(
+        rslt, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(rslt, new_session_cb);
+
+    return pb->options.share_SSL_CTX ? pbpal_ssl_ctx_cache_put(pb, rslt) : rslt;
+}
+
 enum pbpal_tls_result pbpal_start_tls(pubnub_t* pb)
 {
     SSL* ssl;
@@ -185,15 +242,10 @@ enum pbpal_tls_result pbpal_start_tls(pubnub_t* pb)
     PUBNUB_ASSERT(NULL == ssl);
 
     if (NULL == pb->pal.ctx) {
-        PUBNUB_LOG_TRACE("pb=%p: Don't have SSL_CTX\n", pb);
-        pb->pal.ctx = SSL_CTX_new(SSLv23_client_method());
+        pb->pal.ctx = get_ssl_ctx(pb);
         if (NULL == pb->pal.ctx) {
-            ERR_print_errors_cb(print_to_pubnub_log, pb);
-            PUBNUB_LOG_ERROR("pb=%p SSL_CTX_new failed\n", pb);
             return pbtlsResourceFailure;
         }
-        PUBNUB_LOG_TRACE("pb=%p: Got SSL_CTX\n", pb);
-        add_certs(pb);
     }
     ssl = pb->pal.ssl = SSL_new(pb->pal.ctx);
     if (NULL == ssl) {
@@ -202,10 +254,15 @@ enum pbpal_tls_result pbpal_start_tls(pubnub_t* pb)
         return pbtlsResourceFailure;
     }
     PUBNUB_LOG_TRACE("pb=%p: Got SSL\n", pb);
+    SSL_set_app_data(ssl, pb);
     SSL_set_fd(ssl, pb->pal.socket);
     WATCH_ENUM(pb->options.use_blocking_io);
     pb->pal.tryconn = pbms_start();
-    if (pb->options.reuse_SSL_session && (pb->pal.session != NULL)) {
+    /* The session in the cache is the latest one for the origin, so
+       prefer it to the one this context saved */
+    if (pb->options.reuse_SSL_session
+        && !pbpal_ssl_ctx_cache_set_session(ssl, origin_of(pb), TLS_PORT)
+        && (pb->pal.session != NULL)) {
         if (!SSL_set_session(ssl, pb->pal.session)) {
             ERR_print_errors_cb(print_to_pubnub_log, NULL);
         }
@@ -234,7 +291,13 @@ enum pbpal_tls_result pbpal_check_tls(pubnub_t* pb)
     rslt = SSL_connect(ssl);
     rslt = pbpal_handle_socket_condition(rslt, pb);
     if (PNR_OK != rslt) {
-        return (rslt == PNR_IN_PROGRESS) ? pbtlsStarted : pbtlsFailed;
+        if (rslt == PNR_IN_PROGRESS) {
+            return pbtlsStarted;
+        }
+        if (pb->options.reuse_SSL_session) {
+            pbpal_ssl_ctx_cache_remove_session(pb->pal.ctx, origin_of(pb), TLS_PORT);
+        }
+        return pbtlsFailed;
     }
     PUBNUB_LOG_TRACE("pb=%p: SSL connected\n", pb);
     socket_set_rcv_timeout(pb->pal.socket, pb->transaction_timeout_ms);
@@ -250,6 +313,7 @@ enum pbpal_tls_result pbpal_check_tls(pubnub_t* pb)
                 rslt,
                 X509_verify_cert_error_string(rslt));
             ERR_print_errors_cb(print_to_pubnub_log, NULL);
+            pbpal_ssl_ctx_cache_remove_session(pb->pal.ctx, origin_of(pb), TLS_PORT);
 
             return pbtlsFailed;
         }
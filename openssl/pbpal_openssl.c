@@ -4,12 +4,16 @@
 #include "core/pbpal.h"
 
 #include "pbpal_mutex.h"
+#include "pbpal_ssl_ctx_cache.h"
 #include "core/pubnub_ntf_sync.h"
 #include "core/pubnub_netcore.h"
 #include "core/pubnub_assert.h"
 #include "core/pubnub_log.h"
 
 #include "lib/msstopwatch/msstopwatch.h"
+#if PUBNUB_DNS_CACHE
+#include "lib/pubnub_dns_cache.h"
+#endif
 
 #include <sys/types.h>
 #include <fcntl.h>
@@ -87,8 +91,9 @@ static int locks_setup(void)
 
 static void buf_setup(pubnub_t* pb)
 {
-    pb->ptr  = (uint8_t*)pb->core.http_buf;
-    pb->left = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+    pb->ptr       = (uint8_t*)pb->core.http_buf;
+    pb->left      = sizeof pb->core.http_buf / sizeof pb->core.http_buf[0];
+    pb->read_into = NULL;
 }
 
 
@@ -126,9 +131,15 @@ void pbpal_init(pubnub_t* pb)
     pb->options.useSSL = pb->flags.trySSL = pb->options.fallbackSSL = true;
     pb->options.use_system_certificate_store                        = false;
     pb->options.reuse_SSL_session                                   = false;
+    pb->options.share_SSL_CTX                                       = true;
     pb->ssl_CAfile = pb->ssl_CApath = NULL;
     pb->ssl_userPEMcert             = NULL;
     pb->sock_state                  = STATE_NONE;
+#if PUBNUB_HAPPY_EYEBALLS
+    pb->connect_race.socket       = SOCKET_INVALID;
+    pb->connect_race.current_ipv6 = false;
+    pbms_stop(&pb->connect_race.started);
+#endif
     buf_setup(pb);
 }
 
@@ -356,17 +367,18 @@ enum pubnub_res pbpal_line_read_status(pubnub_t* pb)
             pb->left -= recvres;
         }
 
-        while (pb->unreadlen > 0) {
-            uint8_t c;
-
-            --pb->unreadlen;
-
-            c = *pb->ptr++;
-            if (c == '\n') {
+        if (pb->unreadlen > 0) {
+            uint8_t* newline = (uint8_t*)memchr(pb->ptr, '\n', pb->unreadlen);
+            if (newline != NULL) {
+                ++newline;
+                pb->unreadlen -= newline - pb->ptr;
+                pb->ptr = newline;
                 WATCH_USHORT(pb->unreadlen);
                 pb->sock_state = STATE_NONE;
                 return PNR_OK;
             }
+            pb->ptr += pb->unreadlen;
+            pb->unreadlen = 0;
         }
 
         if (pb->left == 0) {
@@ -391,6 +403,22 @@ int pbpal_read_len(pubnub_t* pb)
 }
 
 
+char const* pbpal_unread_data(pubnub_t* pb, size_t* len)
+{
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+    *len = pb->unreadlen;
+    return (0 == pb->unreadlen) ? NULL : (char const*)pb->ptr;
+}
+
+
+void pbpal_skip_unread(pubnub_t* pb, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, <=, pb->unreadlen);
+    pb->ptr += n;
+    pb->unreadlen -= n;
+}
+
+
 int pbpal_start_read(pubnub_t* pb, size_t n)
 {
     unsigned distance;
@@ -415,11 +443,72 @@ int pbpal_start_read(pubnub_t* pb, size_t n)
 
     pb->sock_state = STATE_READ;
     pb->len        = n;
+    pb->read_into  = NULL;
 
     return +1;
 }
 
 
+int pbpal_start_read_into(pubnub_t* pb, char* dest, size_t n)
+{
+    PUBNUB_ASSERT_UINT_OPT(n, >, 0);
+    PUBNUB_ASSERT_OPT(dest != NULL);
+    PUBNUB_ASSERT_INT_OPT(pb->sock_state, ==, STATE_NONE);
+
+    pb->sock_state = STATE_READ;
+    pb->len        = n;
+    pb->read_into  = (uint8_t*)dest;
+
+    return 0;
+}
+
+
+/** Reading for pbpal_start_read_into(): first the data we already
+    have in our buffer is copied, the rest is received straight into
+    the destination.
+ */
+static enum pubnub_res read_into_status(pubnub_t* pb)
+{
+    int  have_read;
+    SSL* ssl = pb->pal.ssl;
+
+    if (pb->unreadlen > 0) {
+        have_read = (pb->unreadlen >= pb->len) ? pb->len : pb->unreadlen;
+        memcpy(pb->read_into, pb->ptr, have_read);
+        pb->ptr += have_read;
+        pb->unreadlen -= have_read;
+        pb->read_into += have_read;
+        pb->len -= have_read;
+    }
+    /* OpenSSL reads one TLS record at a time, so, read in a loop */
+    while (pb->len > 0) {
+        if (NULL == ssl) {
+            have_read = socket_recv(pb->pal.socket, (char*)pb->read_into, pb->len, 0);
+        }
+        else {
+            have_read = SSL_read(ssl, pb->read_into, pb->len);
+        }
+        if (have_read <= 0) {
+            return pbpal_handle_socket_condition(have_read, pb);
+        }
+        PUBNUB_ASSERT_OPT((unsigned)have_read <= pb->len);
+        pb->read_into += have_read;
+        pb->len -= have_read;
+        if (NULL == ssl) {
+            break;
+        }
+    }
+
+    if (0 == pb->len) {
+        pb->read_into  = NULL;
+        pb->sock_state = STATE_NONE;
+        return PNR_OK;
+    }
+
+    return PNR_IN_PROGRESS;
+}
+
+
 enum pubnub_res pbpal_read_status(pubnub_t* pb)
 {
     int  have_read;
@@ -427,6 +516,10 @@ enum pubnub_res pbpal_read_status(pubnub_t* pb)
 
     PUBNUB_ASSERT_OPT(STATE_READ == pb->sock_state);
 
+    if (pb->read_into != NULL) {
+        return read_into_status(pb);
+    }
+
     /* OpenSSL reads one TLS record at a time,
        so, we need to call it in a loop to read ll there is
     */
@@ -484,6 +577,12 @@ void pbpal_forget(pubnub_t* pb)
 
 int pbpal_close(pubnub_t* pb)
 {
+#if PUBNUB_DNS_CACHE
+    pbdns_cache_forget(pb);
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    pbpal_connect_race_forget(pb);
+#endif
     pb->unreadlen = 0;
     if (pb->pal.ssl != NULL) {
         SSL_shutdown(pb->pal.ssl);
@@ -504,6 +603,12 @@ int pbpal_close(pubnub_t* pb)
 
 void pbpal_free(pubnub_t* pb)
 {
+#if PUBNUB_DNS_CACHE
+    pbdns_cache_forget(pb);
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    pbpal_connect_race_forget(pb);
+#endif
     /* While this should not happen, it doesn't hurt to 'catch' it, if it
      * happens..
      */
@@ -525,7 +630,8 @@ void pbpal_free(pubnub_t* pb)
     }
     /* The rest, OTOH, is expected */
     if (pb->pal.ctx != NULL) {
-        SSL_CTX_free(pb->pal.ctx);
+        pbpal_ssl_ctx_cache_release(pb->pal.ctx);
+        pb->pal.ctx = NULL;
         if (NULL != pb->pal.session) {
             SSL_SESSION_free(pb->pal.session);
             pb->pal.session = NULL;
@@ -0,0 +1,397 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "pbpal_ssl_ctx_cache.h"
+#include "pubnub_ssl_session_cache.h"
+
+#include "pubnub_internal.h"
+#include "core/pubnub_mutex.h"
+#include "core/pubnub_assert.h"
+#include "core/pubnub_log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/** An SSL session kept for an origin */
+struct pbpal_ssl_session_entry {
+    /** The host of the origin, empty if the entry is not used */
+    char host[PUBNUB_SSL_SESSION_CACHE_MAX_HOST_LENGTH + 1];
+    uint16_t     port;
+    SSL_SESSION* session;
+    /** When the #session expires, by its timeout and ticket lifetime */
+    time_t expires;
+};
+
+
+/** An `SSL_CTX` in the cache, with the certificate configuration it
+    was made for. The strings of the configuration are copied to the
+    same allocation, right after the entry.
+ */
+struct pbpal_ssl_ctx_entry {
+    struct pbpal_ssl_ctx_entry* next;
+    char const*                 CAfile;
+    char const*                 CApath;
+    char const*                 userPEMcert;
+    bool                        use_system_certificate_store;
+    SSL_CTX*                    ctx;
+    /** Number of Pubnub contexts using the #ctx */
+    unsigned refcount;
+    /** SSL sessions made with the #ctx */
+    struct pbpal_ssl_session_entry sessions[PUBNUB_SSL_SESSION_CACHE_SIZE];
+};
+
+
+pubnub_mutex_static_decl_and_init(m_lock);
+static struct pbpal_ssl_ctx_entry* m_cache pubnub_guarded_by(m_lock);
+static struct pubnub_ssl_session_cache_stats m_stats pubnub_guarded_by(m_lock);
+
+
+static bool same_str(char const* a, char const* b)
+{
+    if ((NULL == a) || (NULL == b)) {
+        return a == b;
+    }
+    return 0 == strcmp(a, b);
+}
+
+
+static size_t str_size(char const* s)
+{
+    return (NULL == s) ? 0 : strlen(s) + 1;
+}
+
+
+/** Copies @p s to @p p and sets @p dst to point to the copy.
+    @return The position after the copy
+ */
+static char* copy_str(char const** dst, char* p, char const* s)
+{
+    if (NULL == s) {
+        *dst = NULL;
+        return p;
+    }
+    strcpy(p, s);
+    *dst = p;
+    return p + strlen(s) + 1;
+}
+
+
+static bool matches(struct pbpal_ssl_ctx_entry const* entry, pubnub_t const* pb)
+{
+    return (entry->use_system_certificate_store
+            == pb->options.use_system_certificate_store)
+           && same_str(entry->CAfile, pb->ssl_CAfile)
+           && same_str(entry->CApath, pb->ssl_CApath)
+           && same_str(entry->userPEMcert, pb->ssl_userPEMcert);
+}
+
+
+static struct pbpal_ssl_ctx_entry* find_ctx(SSL_CTX const* ctx)
+{
+    struct pbpal_ssl_ctx_entry* entry;
+
+    for (entry = m_cache; entry != NULL; entry = entry->next) {
+        if (entry->ctx == ctx) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+
+static void clear_session(struct pbpal_ssl_session_entry* se)
+{
+    if (se->session != NULL) {
+        SSL_SESSION_free(se->session);
+        se->session = NULL;
+    }
+    se->host[0] = '\0';
+}
+
+
+static struct pbpal_ssl_session_entry* find_session(struct pbpal_ssl_ctx_entry* entry,
+                                                    char const* host,
+                                                    uint16_t    port)
+{
+    unsigned i;
+
+    for (i = 0; i < PUBNUB_SSL_SESSION_CACHE_SIZE; ++i) {
+        struct pbpal_ssl_session_entry* se = entry->sessions + i;
+        if ((se->port == port) && (0 == strcmp(se->host, host))) {
+            return se;
+        }
+    }
+    return NULL;
+}
+
+
+/** Returns when the @p session expires: by its timeout, or its
+    ticket lifetime hint, whichever comes first.
+ */
+static time_t session_expires(SSL_SESSION* session)
+{
+    time_t rslt = SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session);
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    unsigned long hint = SSL_SESSION_get_ticket_lifetime_hint(session);
+    if ((hint > 0) && (SSL_SESSION_get_time(session) + (time_t)hint < rslt)) {
+        rslt = SSL_SESSION_get_time(session) + (time_t)hint;
+    }
+#endif
+    return rslt;
+}
+
+
+static struct pbpal_ssl_ctx_entry* find(pubnub_t const* pb)
+{
+    struct pbpal_ssl_ctx_entry* entry;
+
+    for (entry = m_cache; entry != NULL; entry = entry->next) {
+        if (matches(entry, pb)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+
+SSL_CTX* pbpal_ssl_ctx_cache_get(pubnub_t const* pb)
+{
+    struct pbpal_ssl_ctx_entry* entry;
+    SSL_CTX*                    rslt = NULL;
+
+    PUBNUB_ASSERT_OPT(pb != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find(pb);
+    if (entry != NULL) {
+        ++entry->refcount;
+        rslt = entry->ctx;
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    PUBNUB_LOG_TRACE("pb=%p: SSL_CTX from cache: %p\n", pb, rslt);
+
+    return rslt;
+}
+
+
+SSL_CTX* pbpal_ssl_ctx_cache_put(pubnub_t const* pb, SSL_CTX* ctx)
+{
+    struct pbpal_ssl_ctx_entry* entry;
+
+    PUBNUB_ASSERT_OPT(pb != NULL);
+    PUBNUB_ASSERT_OPT(ctx != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find(pb);
+    if (entry != NULL) {
+        ++entry->refcount;
+        pubnub_mutex_unlock(m_lock);
+        PUBNUB_LOG_TRACE("pb=%p: SSL_CTX %p already in cache, freeing %p\n",
+                         pb,
+                         entry->ctx,
+                         ctx);
+        SSL_CTX_free(ctx);
+        return entry->ctx;
+    }
+    entry = (struct pbpal_ssl_ctx_entry*)malloc(
+        sizeof *entry + str_size(pb->ssl_CAfile) + str_size(pb->ssl_CApath)
+        + str_size(pb->ssl_userPEMcert));
+    if (NULL == entry) {
+        pubnub_mutex_unlock(m_lock);
+        PUBNUB_LOG_WARNING("pb=%p: Failed to allocate SSL_CTX cache entry, "
+                           "SSL_CTX %p will not be shared\n",
+                           pb,
+                           ctx);
+        return ctx;
+    }
+    {
+        char* p = (char*)(entry + 1);
+        p       = copy_str(&entry->CAfile, p, pb->ssl_CAfile);
+        p       = copy_str(&entry->CApath, p, pb->ssl_CApath);
+        copy_str(&entry->userPEMcert, p, pb->ssl_userPEMcert);
+    }
+    entry->use_system_certificate_store = pb->options.use_system_certificate_store;
+    entry->ctx                          = ctx;
+    entry->refcount                     = 1;
+    memset(entry->sessions, 0, sizeof entry->sessions);
+    entry->next = m_cache;
+    m_cache     = entry;
+    pubnub_mutex_unlock(m_lock);
+
+    PUBNUB_LOG_TRACE("pb=%p: SSL_CTX %p put in cache\n", pb, ctx);
+
+    return ctx;
+}
+
+
+void pbpal_ssl_ctx_cache_release(SSL_CTX* ctx)
+{
+    struct pbpal_ssl_ctx_entry** pentry;
+    unsigned                     i;
+
+    PUBNUB_ASSERT_OPT(ctx != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    for (pentry = &m_cache; *pentry != NULL; pentry = &(*pentry)->next) {
+        struct pbpal_ssl_ctx_entry* entry = *pentry;
+        if (entry->ctx == ctx) {
+            PUBNUB_ASSERT_OPT(entry->refcount > 0);
+            if (--entry->refcount > 0) {
+                pubnub_mutex_unlock(m_lock);
+                return;
+            }
+            *pentry = entry->next;
+            for (i = 0; i < PUBNUB_SSL_SESSION_CACHE_SIZE; ++i) {
+                clear_session(entry->sessions + i);
+            }
+            free(entry);
+            break;
+        }
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    SSL_CTX_free(ctx);
+}
+
+
+bool pbpal_ssl_ctx_cache_set_session(SSL* ssl, char const* host, uint16_t port)
+{
+    struct pbpal_ssl_ctx_entry*     entry;
+    struct pbpal_ssl_session_entry* se   = NULL;
+    bool                            rslt = false;
+
+    PUBNUB_ASSERT_OPT(ssl != NULL);
+    PUBNUB_ASSERT_OPT(host != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find_ctx(SSL_get_SSL_CTX(ssl));
+    if (NULL == entry) {
+        pubnub_mutex_unlock(m_lock);
+        return false;
+    }
+    se = find_session(entry, host, port);
+    if ((se != NULL) && (se->expires <= time(NULL))) {
+        clear_session(se);
+        se = NULL;
+    }
+    if (se != NULL) {
+        /* SSL takes its own reference to the session */
+        rslt = (0 != SSL_set_session(ssl, se->session));
+#if defined TLS1_3_VERSION
+        /* TLS 1.3 tickets are for a single use (RFC 8446, C.4), the
+           server sends new ones after the handshake, which will be
+           kept instead.
+        */
+        if (rslt && (TLS1_3_VERSION == SSL_SESSION_get_protocol_version(se->session))) {
+            clear_session(se);
+        }
+#endif
+    }
+    if (rslt) {
+        ++m_stats.hits;
+    }
+    else {
+        ++m_stats.misses;
+    }
+    pubnub_mutex_unlock(m_lock);
+
+    PUBNUB_LOG_TRACE("SSL=%p: session for %s:%hu from cache: %s\n",
+                     ssl,
+                     host,
+                     port,
+                     rslt ? "yes" : "no");
+
+    return rslt;
+}
+
+
+bool pbpal_ssl_ctx_cache_keep_session(SSL*         ssl,
+                                      SSL_SESSION* session,
+                                      char const*  host,
+                                      uint16_t     port)
+{
+    struct pbpal_ssl_ctx_entry*     entry;
+    struct pbpal_ssl_session_entry* se;
+    unsigned                        i;
+
+    PUBNUB_ASSERT_OPT(ssl != NULL);
+    PUBNUB_ASSERT_OPT(session != NULL);
+    PUBNUB_ASSERT_OPT(host != NULL);
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (!SSL_SESSION_is_resumable(session)) {
+        return false;
+    }
+#endif
+    if (strlen(host) > PUBNUB_SSL_SESSION_CACHE_MAX_HOST_LENGTH) {
+        return false;
+    }
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find_ctx(SSL_get_SSL_CTX(ssl));
+    if (NULL == entry) {
+        pubnub_mutex_unlock(m_lock);
+        return false;
+    }
+    se = find_session(entry, host, port);
+    if (NULL == se) {
+        /* An unused entry, or the one that expires first */
+        se = entry->sessions;
+        for (i = 0; i < PUBNUB_SSL_SESSION_CACHE_SIZE; ++i) {
+            if ('\0' == entry->sessions[i].host[0]) {
+                se = entry->sessions + i;
+                break;
+            }
+            if (entry->sessions[i].expires < se->expires) {
+                se = entry->sessions + i;
+            }
+        }
+    }
+    clear_session(se);
+    strcpy(se->host, host);
+    se->port    = port;
+    se->session = session;
+    se->expires = session_expires(session);
+    pubnub_mutex_unlock(m_lock);
+
+    PUBNUB_LOG_TRACE("SSL=%p: kept session %p for %s:%hu\n", ssl, session, host, port);
+
+    return true;
+}
+
+
+void pbpal_ssl_ctx_cache_remove_session(SSL_CTX* ctx, char const* host, uint16_t port)
+{
+    struct pbpal_ssl_ctx_entry* entry;
+
+    PUBNUB_ASSERT_OPT(ctx != NULL);
+    PUBNUB_ASSERT_OPT(host != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    entry = find_ctx(ctx);
+    if (entry != NULL) {
+        struct pbpal_ssl_session_entry* se = find_session(entry, host, port);
+        if (se != NULL) {
+            clear_session(se);
+        }
+    }
+    pubnub_mutex_unlock(m_lock);
+}
+
+
+void pubnub_ssl_session_cache_get_stats(struct pubnub_ssl_session_cache_stats* stats)
+{
+    PUBNUB_ASSERT_OPT(stats != NULL);
+
+    pubnub_mutex_init_static(m_lock);
+    pubnub_mutex_lock(m_lock);
+    *stats = m_stats;
+    pubnub_mutex_unlock(m_lock);
+}
@@ -0,0 +1,97 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PBPAL_SSL_CTX_CACHE
+#define      INC_PBPAL_SSL_CTX_CACHE
+
+#include "core/pubnub_api_types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <openssl/ssl.h>
+
+
+/** @file pbpal_ssl_ctx_cache.h
+
+    A process-wide cache of OpenSSL contexts (`SSL_CTX`), shared by
+    Pubnub contexts that have the same certificate configuration (CA
+    file and path, user PEM certificate and the use of the system
+    certificate store). This way the certificates are read and parsed
+    once, rather than once per Pubnub context, and there is only one
+    copy of the certificate store in memory.
+
+    Cached `SSL_CTX`s are reference counted, freed when the last
+    Pubnub context using them releases them.
+
+    For each cached `SSL_CTX`, the last SSL session for an origin
+    (host and port) is kept, so that Pubnub contexts that share the
+    `SSL_CTX` can resume it. @see pubnub_ssl_session_cache.h
+*/
+
+#if !defined PUBNUB_SSL_SESSION_CACHE_SIZE
+/** The maximum number of origins for which to keep an SSL session,
+    per cached `SSL_CTX` */
+#define PUBNUB_SSL_SESSION_CACHE_SIZE 4
+#endif
+
+#if !defined PUBNUB_SSL_SESSION_CACHE_MAX_HOST_LENGTH
+/** The maximum length of the host of an origin for which to keep an
+    SSL session. Sessions for longer ones are not kept.
+*/
+#define PUBNUB_SSL_SESSION_CACHE_MAX_HOST_LENGTH 127
+#endif
+
+/** Gets the `SSL_CTX` from the cache for the certificate
+    configuration of @p pb and references it.
+
+    @return The `SSL_CTX` to use, NULL if there is none in the cache
+    (in which case the caller should make one and give it to
+    pbpal_ssl_ctx_cache_put()).
+ */
+SSL_CTX* pbpal_ssl_ctx_cache_get(pubnub_t const* pb);
+
+/** Puts the (new) @p ctx to the cache for the certificate
+    configuration of @p pb and references it.
+
+    If another `SSL_CTX` for the same configuration was put in the
+    meantime, @p ctx is freed and the one in the cache is used
+    instead. If @p ctx can't be put in the cache (out of memory), it
+    is used as is - not shared.
+
+    @return The `SSL_CTX` to use
+ */
+SSL_CTX* pbpal_ssl_ctx_cache_put(pubnub_t const* pb, SSL_CTX* ctx);
+
+/** Releases the @p ctx. If it is in the cache, it is dereferenced and
+    freed if there are no more references. Otherwise, it is simply
+    freed.
+ */
+void pbpal_ssl_ctx_cache_release(SSL_CTX* ctx);
+
+/** Sets the SSL session for the @p host and @p port from the cache
+    of the `SSL_CTX` of @p ssl to @p ssl, if there is one that is
+    still valid.
+
+    @return true if a session was set, false otherwise
+ */
+bool pbpal_ssl_ctx_cache_set_session(SSL* ssl, char const* host, uint16_t port);
+
+/** Keeps the @p session of @p ssl, for the @p host and @p port, in
+    the cache of the `SSL_CTX` of @p ssl, replacing the one that was
+    kept, if any.
+
+    @return true if the @p session is kept (the cache took over the
+    reference to it), false otherwise (`SSL_CTX` is not in the cache,
+    or @p session can't be resumed)
+ */
+bool pbpal_ssl_ctx_cache_keep_session(SSL*         ssl,
+                                      SSL_SESSION* session,
+                                      char const*  host,
+                                      uint16_t     port);
+
+/** Removes the SSL session for the @p host and @p port from the cache
+    of @p ctx, like when resuming it failed.
+ */
+void pbpal_ssl_ctx_cache_remove_session(SSL_CTX* ctx, char const* host, uint16_t port);
+
+
+#endif /* !defined INC_PBPAL_SSL_CTX_CACHE */
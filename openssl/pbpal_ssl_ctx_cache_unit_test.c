@@ -0,0 +1,341 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#include "cgreen/cgreen.h"
+#include "cgreen/mocks.h"
+
+#include "pubnub_internal.h"
+#include "pbpal_ssl_ctx_cache.h"
+#include "pubnub_ssl_session_cache.h"
+#include "core/pubnub_assert.h"
+
+#include <string.h>
+#include <time.h>
+
+
+/* A less chatty cgreen :) */
+
+#define attest assert_that
+#define equals is_equal_to
+#define differs is_not_equal_to
+
+
+#define ORIGIN "ps.pndsn.com"
+#define TLS_PORT 443
+
+static pubnub_t m_pb;
+static SSL_CTX* m_ctx;
+static SSL*     m_ssl;
+/* The index of the SSL_CTX "ex data" to learn when it's freed */
+static int      m_ex_index = -1;
+static unsigned m_freed;
+
+
+static void count_freed(void*           parent,
+                        void*           ptr,
+                        CRYPTO_EX_DATA* ad,
+                        int             idx,
+                        long            argl,
+                        void*           argp)
+{
+    PUBNUB_UNUSED(parent);
+    PUBNUB_UNUSED(ad);
+    PUBNUB_UNUSED(idx);
+    PUBNUB_UNUSED(argl);
+    PUBNUB_UNUSED(argp);
+    if (ptr != NULL) {
+        ++m_freed;
+    }
+}
+
+
+/* Makes an SSL_CTX, which counts in #m_freed when it's freed */
+static SSL_CTX* make_ctx(void)
+{
+    SSL_CTX* rslt = SSL_CTX_new(SSLv23_client_method());
+
+    attest(rslt, differs(NULL));
+    if (m_ex_index < 0) {
+        m_ex_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, count_freed);
+    }
+    SSL_CTX_set_ex_data(rslt, m_ex_index, &m_freed);
+
+    return rslt;
+}
+
+
+/* Makes a session, resumable, that was made @p ago seconds ago
+   and is valid for @p timeout seconds, of TLS @p version */
+static SSL_SESSION* make_session(unsigned char id, long ago, long timeout, int version)
+{
+    SSL_SESSION*  rslt = SSL_SESSION_new();
+    unsigned char sid[32];
+
+    attest(rslt, differs(NULL));
+    memset(sid, id, sizeof sid);
+    attest(SSL_SESSION_set1_id(rslt, sid, sizeof sid), equals(1));
+    SSL_SESSION_set_time(rslt, time(NULL) - ago);
+    SSL_SESSION_set_timeout(rslt, timeout);
+    attest(SSL_SESSION_set_protocol_version(rslt, version), equals(1));
+
+    return rslt;
+}
+
+
+/* Sets the session from the cache to a new SSL of @p ctx, returns
+   the session set, NULL if none was */
+static SSL_SESSION* resume(SSL_CTX* ctx, char const* host, uint16_t port)
+{
+    SSL*         ssl = SSL_new(ctx);
+    SSL_SESSION* rslt = NULL;
+
+    attest(ssl, differs(NULL));
+    if (pbpal_ssl_ctx_cache_set_session(ssl, host, port)) {
+        rslt = SSL_get_session(ssl);
+        attest(rslt, differs(NULL));
+    }
+    SSL_free(ssl);
+
+    return rslt;
+}
+
+
+Describe(pbpal_ssl_ctx_cache);
+
+
+BeforeEach(pbpal_ssl_ctx_cache) {
+    memset(&m_pb, 0, sizeof m_pb);
+    m_pb.ssl_CAfile = "session.pem";
+    m_freed         = 0;
+    attest(pbpal_ssl_ctx_cache_get(&m_pb), equals(NULL));
+    m_ctx = pbpal_ssl_ctx_cache_put(&m_pb, make_ctx());
+    attest(m_ctx, differs(NULL));
+    m_ssl = SSL_new(m_ctx);
+    attest(m_ssl, differs(NULL));
+}
+
+
+AfterEach(pbpal_ssl_ctx_cache) {
+    SSL_free(m_ssl);
+    pbpal_ssl_ctx_cache_release(m_ctx);
+    attest(pbpal_ssl_ctx_cache_get(&m_pb), equals(NULL));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, shares_ssl_ctx_for_same_configuration) {
+    pubnub_t pb;
+    char     CAfile[] = "ca.pem";
+    SSL_CTX* ctx = make_ctx();
+
+    memset(&pb, 0, sizeof pb);
+    pb.ssl_CAfile = "ca.pem";
+    pb.ssl_CApath = "/etc/ssl/certs";
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+    attest(pbpal_ssl_ctx_cache_put(&pb, ctx), equals(ctx));
+
+    /* The configuration is copied, compared by value */
+    pb.ssl_CAfile = CAfile;
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(ctx));
+
+    /* Any difference in configuration is another SSL_CTX */
+    CAfile[0] = 'x';
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+    CAfile[0] = 'c';
+    pb.ssl_CApath = NULL;
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+    pb.ssl_CApath      = "/etc/ssl/certs";
+    pb.ssl_userPEMcert = "-----BEGIN CERTIFICATE-----";
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+    pb.ssl_userPEMcert                      = NULL;
+    pb.options.use_system_certificate_store = true;
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+    pb.options.use_system_certificate_store = false;
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(ctx));
+
+    pbpal_ssl_ctx_cache_release(ctx);
+    pbpal_ssl_ctx_cache_release(ctx);
+    attest(m_freed, equals(0));
+    pbpal_ssl_ctx_cache_release(ctx);
+    attest(m_freed, equals(1));
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, ssl_ctx_is_freed_with_last_reference) {
+    pubnub_t pb;
+    SSL_CTX* ctx = make_ctx();
+    unsigned i;
+
+    memset(&pb, 0, sizeof pb);
+    pb.ssl_CAfile = "refcount.pem";
+    attest(pbpal_ssl_ctx_cache_put(&pb, ctx), equals(ctx));
+    for (i = 0; i < 9; ++i) {
+        attest(pbpal_ssl_ctx_cache_get(&pb), equals(ctx));
+    }
+    for (i = 0; i < 9; ++i) {
+        pbpal_ssl_ctx_cache_release(ctx);
+        attest(m_freed, equals(0));
+        attest(pbpal_ssl_ctx_cache_get(&pb), equals(ctx));
+        pbpal_ssl_ctx_cache_release(ctx);
+    }
+    pbpal_ssl_ctx_cache_release(ctx);
+    attest(m_freed, equals(1));
+    attest(pbpal_ssl_ctx_cache_get(&pb), equals(NULL));
+
+    /* Other SSL_CTXs in the cache are not affected */
+    attest(pbpal_ssl_ctx_cache_get(&m_pb), equals(m_ctx));
+    pbpal_ssl_ctx_cache_release(m_ctx);
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, putting_same_configuration_again_uses_the_cached) {
+    pubnub_t pb;
+    SSL_CTX* ctx = make_ctx();
+    SSL_CTX* late = make_ctx();
+
+    memset(&pb, 0, sizeof pb);
+    pb.ssl_CAfile = "race.pem";
+    attest(pbpal_ssl_ctx_cache_put(&pb, ctx), equals(ctx));
+    /* Like when another context made one in the meantime */
+    attest(pbpal_ssl_ctx_cache_put(&pb, late), equals(ctx));
+    attest(m_freed, equals(1));
+
+    pbpal_ssl_ctx_cache_release(ctx);
+    attest(m_freed, equals(1));
+    pbpal_ssl_ctx_cache_release(ctx);
+    attest(m_freed, equals(2));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, ssl_ctx_not_in_cache_is_freed_on_release) {
+    SSL_CTX* ctx = make_ctx();
+
+    pbpal_ssl_ctx_cache_release(ctx);
+    attest(m_freed, equals(1));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, counts_hits_and_misses) {
+    struct pubnub_ssl_session_cache_stats before;
+    struct pubnub_ssl_session_cache_stats after;
+    SSL_SESSION* session = make_session(1, 0, 300, TLS1_2_VERSION);
+
+    pubnub_ssl_session_cache_get_stats(&before);
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(NULL));
+    pubnub_ssl_session_cache_get_stats(&after);
+    attest(after.hits, equals(before.hits));
+    attest(after.misses, equals(before.misses + 1));
+
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, ORIGIN, TLS_PORT),
+           equals(true));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(session));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(session));
+    pubnub_ssl_session_cache_get_stats(&after);
+    attest(after.hits, equals(before.hits + 2));
+    attest(after.misses, equals(before.misses + 1));
+
+    /* Other origins don't have a session */
+    attest(resume(m_ctx, "other.pndsn.com", TLS_PORT), equals(NULL));
+    attest(resume(m_ctx, ORIGIN, 8443), equals(NULL));
+    pubnub_ssl_session_cache_get_stats(&after);
+    attest(after.hits, equals(before.hits + 2));
+    attest(after.misses, equals(before.misses + 3));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, keeps_the_latest_session_for_origin) {
+    SSL_SESSION* first = make_session(1, 0, 300, TLS1_2_VERSION);
+    SSL_SESSION* second = make_session(2, 0, 300, TLS1_2_VERSION);
+
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, first, ORIGIN, TLS_PORT), equals(true));
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, second, ORIGIN, TLS_PORT), equals(true));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(second));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, expired_session_is_not_resumed) {
+    SSL_SESSION* session = make_session(1, 100, 10, TLS1_2_VERSION);
+    SSL_SESSION* fresh = make_session(2, 100, 300, TLS1_2_VERSION);
+
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, ORIGIN, TLS_PORT),
+           equals(true));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(NULL));
+
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, fresh, ORIGIN, TLS_PORT), equals(true));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(fresh));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, evicts_the_session_that_expires_first) {
+    char     host[PUBNUB_SSL_SESSION_CACHE_SIZE + 1][32];
+    unsigned i;
+
+    /* The second one expires first, the last one doesn't fit */
+    for (i = 0; i <= PUBNUB_SSL_SESSION_CACHE_SIZE; ++i) {
+        long const   timeout = (1 == i) ? 100 : 300 + i;
+        SSL_SESSION* session = make_session(i + 1, 0, timeout, TLS1_2_VERSION);
+
+        snprintf(host[i], sizeof host[i], "origin%u.pndsn.com", i);
+        attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, host[i], TLS_PORT),
+               equals(true));
+    }
+
+    for (i = 0; i <= PUBNUB_SSL_SESSION_CACHE_SIZE; ++i) {
+        if (1 == i) {
+            attest(resume(m_ctx, host[i], TLS_PORT), equals(NULL));
+        }
+        else {
+            attest(resume(m_ctx, host[i], TLS_PORT), differs(NULL));
+        }
+    }
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, removed_session_is_not_resumed) {
+    SSL_SESSION* session = make_session(1, 0, 300, TLS1_2_VERSION);
+
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, ORIGIN, TLS_PORT),
+           equals(true));
+    pbpal_ssl_ctx_cache_remove_session(m_ctx, ORIGIN, TLS_PORT);
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(NULL));
+    /* Nothing to remove is fine, too */
+    pbpal_ssl_ctx_cache_remove_session(m_ctx, ORIGIN, TLS_PORT);
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, tls13_session_is_resumed_once) {
+    SSL_SESSION* session = make_session(1, 0, 300, TLS1_3_VERSION);
+    SSL_SESSION* ticket = make_session(2, 0, 300, TLS1_3_VERSION);
+
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, ORIGIN, TLS_PORT),
+           equals(true));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(session));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(NULL));
+
+    /* The ticket from the server, on the resumed connection */
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, ticket, ORIGIN, TLS_PORT), equals(true));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(ticket));
+    attest(resume(m_ctx, ORIGIN, TLS_PORT), equals(NULL));
+}
+
+
+Ensure(pbpal_ssl_ctx_cache, doesnt_keep_sessions_it_cant_resume) {
+    SSL_SESSION* session = SSL_SESSION_new();
+    char         host[PUBNUB_SSL_SESSION_CACHE_MAX_HOST_LENGTH + 2];
+    SSL_CTX*     ctx = SSL_CTX_new(SSLv23_client_method());
+    SSL*         ssl = SSL_new(ctx);
+
+    /* No session ID, nor ticket */
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, ORIGIN, TLS_PORT), equals(false));
+    SSL_SESSION_free(session);
+
+    memset(host, 'a', sizeof host - 1);
+    host[sizeof host - 1] = '\0';
+    session = make_session(1, 0, 300, TLS1_2_VERSION);
+    attest(pbpal_ssl_ctx_cache_keep_session(m_ssl, session, host, TLS_PORT), equals(false));
+
+    /* The SSL_CTX is not in the cache */
+    attest(pbpal_ssl_ctx_cache_keep_session(ssl, session, ORIGIN, TLS_PORT), equals(false));
+    attest(pbpal_ssl_ctx_cache_set_session(ssl, ORIGIN, TLS_PORT), equals(false));
+    SSL_SESSION_free(session);
+    SSL_free(ssl);
+    SSL_CTX_free(ctx);
+}
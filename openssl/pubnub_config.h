@@ -102,6 +102,17 @@
     */
 #define PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB 0
 
+#if !defined(PUBNUB_CALLBACK_THREAD_COUNT)
+/** The number of "polling" threads, when using the callback
+    interface. Each thread has its own poller, queue of contexts to
+    process and transaction timers, and one context is always
+    processed by the same thread. Contexts are assigned to threads
+    round-robin in pubnub_init(), use pubnub_set_thread_affinity()
+    to assign a context to a particular thread.
+    */
+#define PUBNUB_CALLBACK_THREAD_COUNT 1
+#endif
+
 #if !defined(PUBNUB_USE_IPV6)
 /** If true (!=0), enable support for Ipv6 network addresses */
 #define PUBNUB_USE_IPV6 1
@@ -119,6 +130,27 @@
 #endif
 #endif /* PUBNUB_USE_MULTIPLE_ADDRESSES */
 
+#if !defined(PUBNUB_HAPPY_EYEBALLS)
+/** If true (!=0), when connecting to the server (in the callback
+    interface), if the attempt to connect to one of the resolved
+    addresses doesn't complete in #PUBNUB_CONNECTION_ATTEMPT_DELAY_MS,
+    another one is started, to another address (preferably of the
+    other IP family), and whichever connects first is used ("Happy
+    Eyeballs", RFC 8305).
+    */
+#define PUBNUB_HAPPY_EYEBALLS 1
+#endif
+
+#if !defined(PUBNUB_DNS_CACHE)
+/** If true (!=0), addresses resolved by the asynchronous DNS
+    resolver (callback interface) are cached and shared by all the
+    contexts, respecting their TTL, and contexts that need the same
+    hostname resolved wait for the one DNS query for it.
+    @see pubnub_dns_cache.h
+    */
+#define PUBNUB_DNS_CACHE 1
+#endif
+
 #if !defined(PUBNUB_SET_DNS_SERVERS)
 /** If true (!=0), enable support for setting DNS servers */
 #define PUBNUB_SET_DNS_SERVERS 1
@@ -147,6 +179,51 @@
 #define PUBNUB_COMPRESSED_MAXLEN 32000
 #endif
 
+#if !defined(PUBNUB_SEND_REQUEST_AT_ONCE)
+/** If true (!=0), the whole HTTP request - the head and the body
+    (if any) - is put together in the HTTP buffer and sent at once,
+    instead of piece by piece. This saves a lot of send calls (and
+    TLS records) per transaction and doesn't let Nagle's algorithm
+    hold back the last piece(s) of the request. Requests that don't
+    fit in the buffer or go through a proxy are still sent piece by
+    piece.
+    */
+#define PUBNUB_SEND_REQUEST_AT_ONCE 1
+#endif
+
+#if !defined(PUBNUB_SUBSCRIBE_STREAMING)
+/** If true (!=0), the messages of a subscribe response can be
+    given to a (registered) message callback as soon as they are
+    received, while the rest of the response is still being
+    received. This gets the messages sooner on big ("catch up")
+    responses and they don't have to fit in the reply buffer all at
+    once. @see pubnub_subscribe_stream.h
+    */
+#define PUBNUB_SUBSCRIBE_STREAMING 1
+#endif
+
+#if !defined(PUBNUB_PUBLISH_PIPELINE)
+/** If true (!=0), several publish requests can be sent, one after
+    the other, on the same (kept alive) connection, before their
+    responses are received ("HTTP pipelining").
+    @see pubnub_publish_pipeline.h
+    */
+#define PUBNUB_PUBLISH_PIPELINE 1
+#endif
+
+#if !defined(PUBNUB_BUFFER_POOL)
+/** If true (!=0), the big buffers that a context needs only for
+    some transactions - for the compressed and the encrypted message
+    to publish, the path saved while talking to a proxy and the NTLM
+    token - are taken from a pool of buffers shared by all the
+    contexts only while they are needed, instead of being a part of
+    every context. This saves about 100 KB per context that isn't
+    publishing, which adds up with many (subscribing) contexts.
+    @see pbbuf_pool.h
+    */
+#define PUBNUB_BUFFER_POOL 1
+#endif
+
 /** The maximum channel name length */
 #define PUBNUB_MAX_CHANNEL_NAME_LENGTH 92
 
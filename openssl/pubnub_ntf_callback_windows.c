@@ -40,6 +40,20 @@ struct SocketWatcherData {
 #if PUBNUB_TIMERS_API
     _Guarded_by_(timerlock) pubnub_t* timer_head;
 #endif
+#if PUBNUB_HAPPY_EYEBALLS
+    /** The list of contexts waiting to start racing connection
+        attempts */
+    _Guarded_by_(timerlock) pubnub_t* connect_races;
+#endif
+    /** The list of calls to make after some time */
+    _Guarded_by_(timerlock) struct pbntf_deferred* deferred;
+    /** The deferred call being made, if any */
+    _Guarded_by_(deferlock) struct pbntf_deferred* deferred_running;
+    /** Guards the deferred call being made. Not held while making
+        the call, as it may cancel deferred calls, even its own. */
+    CRITICAL_SECTION deferlock;
+    /** Signalled when a deferred call is done */
+    CONDITION_VARIABLE deferdone;
     struct pbpal_ntf_callback_queue queue;
 };
 
@@ -71,24 +85,257 @@ int pbntf_watch_out_events(pubnub_t* pbp)
 }
 
 
+#if PUBNUB_HAPPY_EYEBALLS
+static bool is_racing(pubnub_t const* pb)
+{
+    return (pb->connect_race_previous != NULL) || (m_watcher.connect_races == pb);
+}
+
+
+/** Takes @p pb off the list of contexts waiting to start racing
+    connection attempts. Has to be called with the `timerlock` locked.
+ */
+static void unlink_connect_race(pubnub_t* pb)
+{
+    if (NULL == pb->connect_race_previous) {
+        m_watcher.connect_races = pb->connect_race_next;
+    }
+    else {
+        pb->connect_race_previous->connect_race_next = pb->connect_race_next;
+    }
+    if (pb->connect_race_next != NULL) {
+        pb->connect_race_next->connect_race_previous = pb->connect_race_previous;
+    }
+    pb->connect_race_previous = pb->connect_race_next = NULL;
+}
+
+
+void pbntf_watch_connect_race(pubnub_t* pb)
+{
+    EnterCriticalSection(&m_watcher.timerlock);
+    if (!is_racing(pb)) {
+        pb->connect_race_previous = NULL;
+        pb->connect_race_next     = m_watcher.connect_races;
+        if (m_watcher.connect_races != NULL) {
+            m_watcher.connect_races->connect_race_previous = pb;
+        }
+        m_watcher.connect_races = pb;
+    }
+    pb->connect_race_watched = pbms_start();
+    LeaveCriticalSection(&m_watcher.timerlock);
+}
+
+
+void pbntf_unwatch_connect_race(pubnub_t* pb)
+{
+    EnterCriticalSection(&m_watcher.timerlock);
+    if (is_racing(pb)) {
+        unlink_connect_race(pb);
+    }
+    LeaveCriticalSection(&m_watcher.timerlock);
+}
+
+
+void pbntf_watch_race_socket(pubnub_t* pb)
+{
+    EnterCriticalSection(&m_watcher.mutw);
+    pbpal_ntf_callback_save_race_socket(m_watcher.poll, pb);
+    LeaveCriticalSection(&m_watcher.mutw);
+}
+
+
+void pbntf_unwatch_race_socket(pubnub_t* pb)
+{
+    EnterCriticalSection(&m_watcher.mutw);
+    pbpal_ntf_callback_remove_race_socket(m_watcher.poll, pb);
+    LeaveCriticalSection(&m_watcher.mutw);
+}
+
+
+/** Queues the contexts that have waited long enough to start racing
+    connection attempts for processing, taking them off the list.
+ */
+static void process_connect_races(void)
+{
+    pubnub_t* pb;
+    pubnub_t* next;
+
+    EnterCriticalSection(&m_watcher.timerlock);
+    for (pb = m_watcher.connect_races; pb != NULL; pb = next) {
+        next = pb->connect_race_next;
+        if (pbms_elapsed(pb->connect_race_watched)
+            >= PUBNUB_CONNECTION_ATTEMPT_DELAY_MS) {
+            unlink_connect_race(pb);
+            pbntf_requeue_for_processing(pb);
+        }
+    }
+    LeaveCriticalSection(&m_watcher.timerlock);
+}
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
+/** Removes @p deferred from the list, if it's there. Has to be
+    called with the `timerlock` locked.
+ */
+static void remove_deferred(struct pbntf_deferred* deferred)
+{
+    struct pbntf_deferred** pp;
+
+    for (pp = &m_watcher.deferred; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == deferred) {
+            *pp            = deferred->next;
+            deferred->next = NULL;
+            break;
+        }
+    }
+    deferred->armed = false;
+}
+
+
+void pbntf_defer(pubnub_t* pb, struct pbntf_deferred* deferred, int delay_ms)
+{
+    PUBNUB_UNUSED(pb);
+    PUBNUB_ASSERT_OPT(deferred->fn != NULL);
+
+    EnterCriticalSection(&m_watcher.timerlock);
+    deferred->since    = pbms_start();
+    deferred->delay_ms = delay_ms;
+    if (!deferred->armed) {
+        deferred->next     = m_watcher.deferred;
+        m_watcher.deferred = deferred;
+        deferred->armed    = true;
+    }
+    LeaveCriticalSection(&m_watcher.timerlock);
+}
+
+
+void pbntf_cancel_deferred(pubnub_t* pb, struct pbntf_deferred* deferred)
+{
+    PUBNUB_UNUSED(pb);
+
+    EnterCriticalSection(&m_watcher.deferlock);
+    EnterCriticalSection(&m_watcher.timerlock);
+    if (deferred->armed) {
+        remove_deferred(deferred);
+    }
+    LeaveCriticalSection(&m_watcher.timerlock);
+    if (deferred->in_flight) {
+        if (GetCurrentThreadId() == m_watcher.thread_id) {
+            /* Cancelled from the call itself (or a callback it made),
+               so @p deferred may be freed before the call returns */
+            PUBNUB_ASSERT_OPT(m_watcher.deferred_running == deferred);
+            deferred->in_flight        = false;
+            m_watcher.deferred_running = NULL;
+        }
+        else {
+            while (deferred->in_flight) {
+                SleepConditionVariableCS(
+                    &m_watcher.deferdone, &m_watcher.deferlock, INFINITE);
+            }
+        }
+    }
+    LeaveCriticalSection(&m_watcher.deferlock);
+}
+
+
+/** Makes the deferred calls that are due, one by one, as each may
+    (re)defer or cancel calls.
+ */
+static void process_deferred(void)
+{
+    for (;;) {
+        struct pbntf_deferred* deferred;
+
+        EnterCriticalSection(&m_watcher.deferlock);
+        EnterCriticalSection(&m_watcher.timerlock);
+        for (deferred = m_watcher.deferred; deferred != NULL; deferred = deferred->next) {
+            if (pbms_elapsed(deferred->since) >= deferred->delay_ms) {
+                remove_deferred(deferred);
+                deferred->in_flight        = true;
+                m_watcher.deferred_running = deferred;
+                break;
+            }
+        }
+        LeaveCriticalSection(&m_watcher.timerlock);
+        LeaveCriticalSection(&m_watcher.deferlock);
+
+        if (NULL == deferred) {
+            break;
+        }
+        deferred->fn(deferred);
+
+        EnterCriticalSection(&m_watcher.deferlock);
+        if (m_watcher.deferred_running != NULL) {
+            m_watcher.deferred_running->in_flight = false;
+            m_watcher.deferred_running            = NULL;
+        }
+        WakeAllConditionVariable(&m_watcher.deferdone);
+        LeaveCriticalSection(&m_watcher.deferlock);
+    }
+}
+
+
+/** Returns how long to wait in the poller: @p ms, or less, if a
+    deferred call is due, or a context should start a racing
+    connection attempt, before that.
+ */
+static DWORD poll_ms(DWORD ms)
+{
+    struct pbntf_deferred const* deferred;
+
+    EnterCriticalSection(&m_watcher.timerlock);
+#if PUBNUB_HAPPY_EYEBALLS
+    {
+        pubnub_t const* pb;
+        for (pb = m_watcher.connect_races; pb != NULL; pb = pb->connect_race_next) {
+            int left = PUBNUB_CONNECTION_ATTEMPT_DELAY_MS
+                       - pbms_elapsed(pb->connect_race_watched);
+            if (left < 0) {
+                left = 0;
+            }
+            if ((DWORD)left < ms) {
+                ms = (DWORD)left;
+            }
+        }
+    }
+#endif
+    for (deferred = m_watcher.deferred; deferred != NULL; deferred = deferred->next) {
+        int left = deferred->delay_ms - pbms_elapsed(deferred->since);
+        if (left < 0) {
+            left = 0;
+        }
+        if ((DWORD)left < ms) {
+            ms = (DWORD)left;
+        }
+    }
+    LeaveCriticalSection(&m_watcher.timerlock);
+
+    return ms;
+}
+
+
 void socket_watcher_thread(void* arg)
 {
     FILETIME prev_time;
+    DWORD    ms = 100;
     GetSystemTimeAsFileTime(&prev_time);
 
     PUBNUB_UNUSED(arg);
 
     for (;;) {
-        const DWORD ms = 100;
-
         pbpal_ntf_callback_process_queue(&m_watcher.queue);
 
         Sleep(1);
 
         EnterCriticalSection(&m_watcher.mutw);
-        pbpal_ntf_poll_away(m_watcher.poll, ms);
+        pbpal_ntf_poll_away(m_watcher.poll, poll_ms(ms));
         LeaveCriticalSection(&m_watcher.mutw);
 
+#if PUBNUB_HAPPY_EYEBALLS
+        process_connect_races();
+#endif
+        process_deferred();
+
         if (PUBNUB_TIMERS_API) {
             FILETIME current_time;
             int      elapsed;
@@ -110,6 +357,8 @@ int pbntf_init(void)
 {
     InitializeCriticalSection(&m_watcher.mutw);
     InitializeCriticalSection(&m_watcher.timerlock);
+    InitializeCriticalSection(&m_watcher.deferlock);
+    InitializeConditionVariable(&m_watcher.deferdone);
 
     m_watcher.poll = pbpal_ntf_callback_poller_init();
     if (NULL == m_watcher.poll) {
@@ -124,6 +373,7 @@ int pbntf_init(void)
                          errno);
         DeleteCriticalSection(&m_watcher.mutw);
         DeleteCriticalSection(&m_watcher.timerlock);
+        DeleteCriticalSection(&m_watcher.deferlock);
         pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
         pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
         return -1;
@@ -0,0 +1,37 @@
+/* -*- c-file-style:"stroustrup"; indent-tabs-mode: nil -*- */
+#if !defined INC_PUBNUB_SSL_SESSION_CACHE
+#define      INC_PUBNUB_SSL_SESSION_CACHE
+
+
+/** @file pubnub_ssl_session_cache.h
+
+    Contexts that share the SSL context (the default, see
+    pubnub_set_shared_ssl_ctx()) and have SSL session reuse turned on
+    (see pubnub_set_reuse_ssl_session()) also share the SSL sessions
+    (with their tickets), per origin. So, a context that doesn't have
+    a session of its own (like a freshly allocated one) resumes a
+    session of another context, with an abbreviated TLS handshake,
+    rather than doing a full one.
+
+    Sessions are kept while they are valid, as long as the server
+    said (via session timeout and ticket lifetime hint). A TLS 1.3
+    session (ticket) is resumed only once, it's taken out of the cache
+    when a context uses it, and the ones the server sends on that
+    connection are kept instead.
+*/
+
+/** Statistics of the shared SSL session cache */
+struct pubnub_ssl_session_cache_stats {
+    /** Number of times a session from the cache was used */
+    unsigned long hits;
+    /** Number of times there was no (valid) session in the cache */
+    unsigned long misses;
+};
+
+/** Gets the statistics of the shared SSL session cache (since the
+    start of the process) to @p stats.
+ */
+void pubnub_ssl_session_cache_get_stats(struct pubnub_ssl_session_cache_stats* stats);
+
+
+#endif /* !defined INC_PUBNUB_SSL_SESSION_CACHE */
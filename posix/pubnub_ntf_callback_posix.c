@@ -6,10 +6,10 @@
 #include "pubnub_internal.h"
 #include "core/pubnub_assert.h"
 #include "core/pubnub_log.h"
-#include "core/pubnub_timer_list.h"
+#include "core/pubnub_timer_wheel.h"
 #include "core/pbpal.h"
 
-#include "lib/sockets/pbpal_ntf_callback_poller_poll.h"
+#include "core/pbpal_ntf_callback_poller.h"
 #include "core/pbpal_ntf_callback_queue.h"
 #include "core/pbpal_ntf_callback_handle_timer_list.h"
 
@@ -23,15 +23,51 @@ struct SocketWatcherData {
     struct pbpal_poll_data* poll pubnub_guarded_by(mutw);
     pthread_mutex_t mutw;
     pthread_mutex_t timerlock;
+    /** Number of (other) threads waiting to lock `mutw`. While
+        there are any, the watcher thread doesn't wait in the poller
+        (while holding `mutw`).
+     */
+    int lock_waiters pubnub_guarded_by(waitlock);
+    pthread_mutex_t waitlock;
     pthread_t       thread_id;
 #if PUBNUB_TIMERS_API
-    pubnub_t* timer_head pubnub_guarded_by(timerlock);
+    struct pubnub_timer_wheel timers pubnub_guarded_by(timerlock);
 #endif
+#if PUBNUB_HAPPY_EYEBALLS
+    /** The list of contexts waiting to start racing connection
+        attempts */
+    pubnub_t* connect_races pubnub_guarded_by(timerlock);
+#endif
+    /** The list of calls to make after some time */
+    struct pbntf_deferred* deferred pubnub_guarded_by(timerlock);
+    /** The deferred call being made, if any */
+    struct pbntf_deferred* deferred_running pubnub_guarded_by(deferlock);
+    /** Guards the deferred call being made. Not held while making
+        the call, as it may cancel deferred calls, even its own. */
+    pthread_mutex_t deferlock;
+    /** Signalled when a deferred call is done */
+    pthread_cond_t deferdone;
     struct pbpal_ntf_callback_queue queue;
 };
 
 
-static struct SocketWatcherData m_watcher;
+/** One watcher per thread that processes contexts. Each context
+    is processed by the same one (thread), which is chosen by the
+    `thread_index` of the context.
+ */
+static struct SocketWatcherData m_watcher[PUBNUB_CALLBACK_THREAD_COUNT];
+
+
+static struct SocketWatcherData* watcher_of(pubnub_t const* pb)
+{
+#if PUBNUB_CALLBACK_THREAD_COUNT > 1
+    PUBNUB_ASSERT_OPT(pb->thread_index < PUBNUB_CALLBACK_THREAD_COUNT);
+    return m_watcher + pb->thread_index;
+#else
+    PUBNUB_UNUSED(pb);
+    return m_watcher;
+#endif
+}
 
 
 static int elapsed_ms(struct timespec prev_timspec, struct timespec timspec)
@@ -42,49 +78,412 @@ static int elapsed_ms(struct timespec prev_timspec, struct timespec timspec)
 }
 
 
+static bool in_watcher_thread(struct SocketWatcherData const* watcher)
+{
+    return pthread_equal(pthread_self(), watcher->thread_id);
+}
+
+
+/** Wakes up the watcher thread, if it might be waiting in the
+    poller, so that it picks up the change (in the queue or timer
+    list) that we made.
+ */
+static void wake_watcher(struct SocketWatcherData* watcher)
+{
+    if (!in_watcher_thread(watcher)) {
+        pbpal_ntf_callback_poller_wakeup(watcher->poll);
+    }
+}
+
+
+/** Locks the poller data. The watcher thread holds that lock
+    while it waits in the poller, so, from other threads, we wake it
+    up and keep it from waiting again until we get the lock.
+ */
+static void lock_poller(struct SocketWatcherData* watcher)
+{
+    if (in_watcher_thread(watcher)) {
+        pthread_mutex_lock(&watcher->mutw);
+        return;
+    }
+    pthread_mutex_lock(&watcher->waitlock);
+    ++watcher->lock_waiters;
+    pthread_mutex_unlock(&watcher->waitlock);
+
+    pbpal_ntf_callback_poller_wakeup(watcher->poll);
+    pthread_mutex_lock(&watcher->mutw);
+
+    pthread_mutex_lock(&watcher->waitlock);
+    --watcher->lock_waiters;
+    pthread_mutex_unlock(&watcher->waitlock);
+}
+
+
+/** Returns how long until the first deferred call is due, in
+    milliseconds, or -1 if there are none. Has to be called with the
+    `timerlock` locked.
+ */
+static int deferred_due_ms(struct SocketWatcherData const* watcher)
+{
+    struct pbntf_deferred const* deferred;
+    int                          rslt = -1;
+
+    for (deferred = watcher->deferred; deferred != NULL; deferred = deferred->next) {
+        int left = deferred->delay_ms - pbms_elapsed(deferred->since);
+        if (left < 0) {
+            left = 0;
+        }
+        if ((rslt < 0) || (left < rslt)) {
+            rslt = left;
+        }
+    }
+
+    return rslt;
+}
+
+
+#if PUBNUB_HAPPY_EYEBALLS
+/** Returns the number of milliseconds until the first context of
+    @p watcher waiting to start a racing connection attempt should do
+    so, -1 if none waits. Has to be called with the `timerlock`
+    locked.
+ */
+static int connect_race_due_ms(struct SocketWatcherData const* watcher)
+{
+    pubnub_t const* pb;
+    int             rslt = -1;
+
+    for (pb = watcher->connect_races; pb != NULL; pb = pb->connect_race_next) {
+        int left = PUBNUB_CONNECTION_ATTEMPT_DELAY_MS
+                   - pbms_elapsed(pb->connect_race_watched);
+        if (left < 0) {
+            left = 0;
+        }
+        if ((rslt < 0) || (left < rslt)) {
+            rslt = left;
+        }
+    }
+
+    return rslt;
+}
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
+/** Returns how long should the watcher thread wait in the poller:
+    until the first timer expires or deferred call is due, or for ever
+    (-1) if there are no timers, or not at all if some thread waits
+    for the poller lock.
+ */
+static int poll_timeout_ms(struct SocketWatcherData* watcher,
+                           struct timespec           prev_timspec)
+{
+    int rslt = -1;
+
+    pthread_mutex_lock(&watcher->waitlock);
+    if (watcher->lock_waiters > 0) {
+        rslt = 0;
+    }
+    pthread_mutex_unlock(&watcher->waitlock);
+
+    if (PUBNUB_TIMERS_API && (rslt != 0)) {
+        pthread_mutex_lock(&watcher->timerlock);
+        rslt = pubnub_timer_wheel_next_expiry_ms(&watcher->timers);
+        if (rslt > 0) {
+            struct timespec timspec;
+            monotonic_clock_get_time(&timspec);
+            rslt -= elapsed_ms(prev_timspec, timspec);
+            if (rslt < 0) {
+                rslt = 0;
+            }
+        }
+        pthread_mutex_unlock(&watcher->timerlock);
+    }
+    if (rslt != 0) {
+        int due_ms;
+        pthread_mutex_lock(&watcher->timerlock);
+        due_ms = deferred_due_ms(watcher);
+#if PUBNUB_HAPPY_EYEBALLS
+        {
+            int const race_due_ms = connect_race_due_ms(watcher);
+            if ((race_due_ms >= 0) && ((due_ms < 0) || (due_ms > race_due_ms))) {
+                due_ms = race_due_ms;
+            }
+        }
+#endif
+        pthread_mutex_unlock(&watcher->timerlock);
+        if ((due_ms >= 0) && ((rslt < 0) || (rslt > due_ms))) {
+            rslt = due_ms;
+        }
+    }
+
+    return rslt;
+}
+
+
 int pbntf_watch_in_events(pubnub_t* pbp)
 {
-    return pbpal_ntf_watch_in_events(m_watcher.poll, pbp);
+    int                       rslt;
+    struct SocketWatcherData* watcher = watcher_of(pbp);
+
+    lock_poller(watcher);
+    rslt = pbpal_ntf_watch_in_events(watcher->poll, pbp);
+    pthread_mutex_unlock(&watcher->mutw);
+
+    return rslt;
 }
 
 
 int pbntf_watch_out_events(pubnub_t* pbp)
 {
-    return pbpal_ntf_watch_out_events(m_watcher.poll, pbp);
+    int                       rslt;
+    struct SocketWatcherData* watcher = watcher_of(pbp);
+
+    lock_poller(watcher);
+    rslt = pbpal_ntf_watch_out_events(watcher->poll, pbp);
+    pthread_mutex_unlock(&watcher->mutw);
+
+    return rslt;
+}
+
+
+#if PUBNUB_HAPPY_EYEBALLS
+static bool is_racing(struct SocketWatcherData const* watcher, pubnub_t const* pb)
+{
+    return (pb->connect_race_previous != NULL) || (watcher->connect_races == pb);
+}
+
+
+/** Takes @p pb off the list of contexts waiting to start racing
+    connection attempts of @p watcher. Has to be called with the
+    `timerlock` locked.
+ */
+static void unlink_connect_race(struct SocketWatcherData* watcher, pubnub_t* pb)
+{
+    if (NULL == pb->connect_race_previous) {
+        watcher->connect_races = pb->connect_race_next;
+    }
+    else {
+        pb->connect_race_previous->connect_race_next = pb->connect_race_next;
+    }
+    if (pb->connect_race_next != NULL) {
+        pb->connect_race_next->connect_race_previous = pb->connect_race_previous;
+    }
+    pb->connect_race_previous = pb->connect_race_next = NULL;
+}
+
+
+void pbntf_watch_connect_race(pubnub_t* pb)
+{
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    pthread_mutex_lock(&watcher->timerlock);
+    if (!is_racing(watcher, pb)) {
+        pb->connect_race_previous = NULL;
+        pb->connect_race_next     = watcher->connect_races;
+        if (watcher->connect_races != NULL) {
+            watcher->connect_races->connect_race_previous = pb;
+        }
+        watcher->connect_races = pb;
+    }
+    pb->connect_race_watched = pbms_start();
+    pthread_mutex_unlock(&watcher->timerlock);
+    wake_watcher(watcher);
+}
+
+
+void pbntf_unwatch_connect_race(pubnub_t* pb)
+{
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    pthread_mutex_lock(&watcher->timerlock);
+    if (is_racing(watcher, pb)) {
+        unlink_connect_race(watcher, pb);
+    }
+    pthread_mutex_unlock(&watcher->timerlock);
+}
+
+
+void pbntf_watch_race_socket(pubnub_t* pb)
+{
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_save_race_socket(watcher->poll, pb);
+    pthread_mutex_unlock(&watcher->mutw);
+}
+
+
+void pbntf_unwatch_race_socket(pubnub_t* pb)
+{
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_remove_race_socket(watcher->poll, pb);
+    pthread_mutex_unlock(&watcher->mutw);
+}
+
+
+/** Queues the contexts that have waited long enough to start racing
+    connection attempts for processing, taking them off the list.
+ */
+static void process_connect_races(struct SocketWatcherData* watcher)
+{
+    pubnub_t* pb;
+    pubnub_t* next;
+
+    pthread_mutex_lock(&watcher->timerlock);
+    for (pb = watcher->connect_races; pb != NULL; pb = next) {
+        next = pb->connect_race_next;
+        if (pbms_elapsed(pb->connect_race_watched)
+            >= PUBNUB_CONNECTION_ATTEMPT_DELAY_MS) {
+            unlink_connect_race(watcher, pb);
+            pbntf_requeue_for_processing(pb);
+        }
+    }
+    pthread_mutex_unlock(&watcher->timerlock);
+}
+#endif /* PUBNUB_HAPPY_EYEBALLS */
+
+
+/** Removes @p deferred from the list of @p watcher, if it's there.
+    Has to be called with the `timerlock` locked.
+ */
+static void remove_deferred(struct SocketWatcherData* watcher,
+                            struct pbntf_deferred*    deferred)
+{
+    struct pbntf_deferred** pp;
+
+    for (pp = &watcher->deferred; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == deferred) {
+            *pp            = deferred->next;
+            deferred->next = NULL;
+            break;
+        }
+    }
+    deferred->armed = false;
+}
+
+
+void pbntf_defer(pubnub_t* pb, struct pbntf_deferred* deferred, int delay_ms)
+{
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    PUBNUB_ASSERT_OPT(deferred->fn != NULL);
+
+    pthread_mutex_lock(&watcher->timerlock);
+    deferred->since    = pbms_start();
+    deferred->delay_ms = delay_ms;
+    if (!deferred->armed) {
+        deferred->next    = watcher->deferred;
+        watcher->deferred = deferred;
+        deferred->armed   = true;
+    }
+    pthread_mutex_unlock(&watcher->timerlock);
+    wake_watcher(watcher);
+}
+
+
+void pbntf_cancel_deferred(pubnub_t* pb, struct pbntf_deferred* deferred)
+{
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    pthread_mutex_lock(&watcher->deferlock);
+    pthread_mutex_lock(&watcher->timerlock);
+    if (deferred->armed) {
+        remove_deferred(watcher, deferred);
+    }
+    pthread_mutex_unlock(&watcher->timerlock);
+    if (deferred->in_flight) {
+        if (in_watcher_thread(watcher)) {
+            /* Cancelled from the call itself (or a callback it made),
+               so @p deferred may be freed before the call returns */
+            PUBNUB_ASSERT_OPT(watcher->deferred_running == deferred);
+            deferred->in_flight       = false;
+            watcher->deferred_running = NULL;
+        }
+        else {
+            while (deferred->in_flight) {
+                pthread_cond_wait(&watcher->deferdone, &watcher->deferlock);
+            }
+        }
+    }
+    pthread_mutex_unlock(&watcher->deferlock);
+}
+
+
+/** Makes the deferred calls that are due, one by one, as each may
+    (re)defer or cancel calls.
+ */
+static void process_deferred(struct SocketWatcherData* watcher)
+{
+    for (;;) {
+        struct pbntf_deferred* deferred;
+
+        pthread_mutex_lock(&watcher->deferlock);
+        pthread_mutex_lock(&watcher->timerlock);
+        for (deferred = watcher->deferred; deferred != NULL; deferred = deferred->next) {
+            if (pbms_elapsed(deferred->since) >= deferred->delay_ms) {
+                remove_deferred(watcher, deferred);
+                deferred->in_flight       = true;
+                watcher->deferred_running = deferred;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&watcher->timerlock);
+        pthread_mutex_unlock(&watcher->deferlock);
+
+        if (NULL == deferred) {
+            break;
+        }
+        deferred->fn(deferred);
+
+        pthread_mutex_lock(&watcher->deferlock);
+        if (watcher->deferred_running != NULL) {
+            watcher->deferred_running->in_flight = false;
+            watcher->deferred_running            = NULL;
+        }
+        pthread_cond_broadcast(&watcher->deferdone);
+        pthread_mutex_unlock(&watcher->deferlock);
+    }
 }
 
 
 void* socket_watcher_thread(void* arg)
 {
-    const int max_poll_ms = 100;
-    struct timespec prev_timspec;
+    struct SocketWatcherData* watcher = (struct SocketWatcherData*)arg;
+    struct timespec           prev_timspec;
     monotonic_clock_get_time(&prev_timspec);
 
     for (;;) {
         struct timespec timspec;
+        int             timeout_ms;
+
+        pbpal_ntf_callback_process_queue(&watcher->queue);
 
-        pbpal_ntf_callback_process_queue(&m_watcher.queue);
+        timeout_ms = poll_timeout_ms(watcher, prev_timspec);
 
-        monotonic_clock_get_time(&timspec);
+        pthread_mutex_lock(&watcher->mutw);
+        pbpal_ntf_poll_away(watcher->poll, timeout_ms);
+        pthread_mutex_unlock(&watcher->mutw);
 
-        pthread_mutex_lock(&m_watcher.mutw);
-        pbpal_ntf_poll_away(m_watcher.poll, max_poll_ms);
-        pthread_mutex_unlock(&m_watcher.mutw);
+#if PUBNUB_HAPPY_EYEBALLS
+        process_connect_races(watcher);
+#endif
+        process_deferred(watcher);
 
         if (PUBNUB_TIMERS_API) {
-            int elapsed = elapsed_ms(prev_timspec, timspec);
+            int elapsed;
+            monotonic_clock_get_time(&timspec);
+            elapsed = elapsed_ms(prev_timspec, timspec);
             if (elapsed > 0) {
-                if (elapsed > max_poll_ms + 5) {
-                    PUBNUB_LOG_TRACE("elapsed = %d: prev_timspec={%ld, %ld}, timspec={%ld,%ld}\n",
-                                     elapsed,
-                                     prev_timspec.tv_sec, prev_timspec.tv_nsec,
-                                     timspec.tv_sec, timspec.tv_nsec
-                                     
-                        );
-                }
-                pthread_mutex_lock(&m_watcher.timerlock);
-                pbntf_handle_timer_list(elapsed, &m_watcher.timer_head);
-                pthread_mutex_unlock(&m_watcher.timerlock);
+                PUBNUB_LOG_TRACE("elapsed = %d: prev_timspec={%ld, %ld}, timspec={%ld,%ld}\n",
+                                 elapsed,
+                                 prev_timspec.tv_sec, prev_timspec.tv_nsec,
+                                 timspec.tv_sec, timspec.tv_nsec);
+                pthread_mutex_lock(&watcher->timerlock);
+                pbntf_handle_expired_timers(
+                    pubnub_timer_wheel_as_time_goes_by(&watcher->timers, elapsed));
+                pthread_mutex_unlock(&watcher->timerlock);
 
                 prev_timspec = timspec;
             }
@@ -95,109 +494,156 @@ void* socket_watcher_thread(void* arg)
 }
 
 
-int pbntf_init(void)
+static void watcher_deinit(struct SocketWatcherData* watcher)
 {
-    int                 rslt;
-    pthread_mutexattr_t attr;
+    pthread_mutex_destroy(&watcher->mutw);
+    pthread_mutex_destroy(&watcher->timerlock);
+    pthread_mutex_destroy(&watcher->waitlock);
+    pthread_mutex_destroy(&watcher->deferlock);
+    pthread_cond_destroy(&watcher->deferdone);
+    pbpal_ntf_callback_queue_deinit(&watcher->queue);
+    pbpal_ntf_callback_poller_deinit(&watcher->poll);
+}
 
-    rslt = pthread_mutexattr_init(&attr);
+
+static int start_watcher_thread(struct SocketWatcherData* watcher)
+{
+    int rslt;
+#if defined(PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB)                              \
+    && (PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB > 0)
+    pthread_attr_t thread_attr;
+
+    rslt = pthread_attr_init(&thread_attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR(
-            "Failed to initialize mutex attributes, error code: %d", rslt);
+            "Failed to initialize thread attributes, error code: %d\n", rslt);
         return -1;
     }
-    rslt = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    rslt = pthread_attr_setstacksize(
+        &thread_attr, PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB * 1024);
     if (rslt != 0) {
-        PUBNUB_LOG_ERROR("Failed to set mutex attribute type, error code: %d",
-                         rslt);
-        pthread_mutexattr_destroy(&attr);
+        PUBNUB_LOG_ERROR(
+            "Failed to set thread stack size to %d kb, error code: %d\n",
+            PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB,
+            rslt);
+        pthread_attr_destroy(&thread_attr);
+        return -1;
+    }
+    rslt = pthread_create(
+        &watcher->thread_id, &thread_attr, socket_watcher_thread, watcher);
+    pthread_attr_destroy(&thread_attr);
+#else
+    rslt = pthread_create(&watcher->thread_id, NULL, socket_watcher_thread, watcher);
+#endif
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR(
+            "Failed to create the polling thread, error code: %d\n", rslt);
         return -1;
     }
-    rslt = pthread_mutex_init(&m_watcher.mutw, &attr);
+
+    return 0;
+}
+
+
+static int watcher_init(struct SocketWatcherData* watcher,
+                        pthread_mutexattr_t*      attr)
+{
+    int rslt;
+
+    rslt = pthread_mutex_init(&watcher->mutw, attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR("Failed to initialize mutex, error code: %d", rslt);
-        pthread_mutexattr_destroy(&attr);
         return -1;
     }
-    rslt = pthread_mutex_init(&m_watcher.timerlock, &attr);
+    rslt = pthread_mutex_init(&watcher->timerlock, attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR("Failed to initialize mutex for timers, error code: %d", rslt);
-        pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.mutw);
+        pthread_mutex_destroy(&watcher->mutw);
         return -1;
     }
-
-    m_watcher.poll = pbpal_ntf_callback_poller_init();
-    if (NULL == m_watcher.poll) {
-        pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.mutw);
-        pthread_mutex_destroy(&m_watcher.timerlock);
+    rslt = pthread_mutex_init(&watcher->waitlock, NULL);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR("Failed to initialize mutex for lock waiters, error code: %d", rslt);
+        pthread_mutex_destroy(&watcher->mutw);
+        pthread_mutex_destroy(&watcher->timerlock);
+        return -1;
+    }
+    watcher->lock_waiters = 0;
+    rslt = pthread_mutex_init(&watcher->deferlock, NULL);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR("Failed to initialize mutex for deferred calls, error code: %d", rslt);
+        pthread_mutex_destroy(&watcher->mutw);
+        pthread_mutex_destroy(&watcher->timerlock);
+        pthread_mutex_destroy(&watcher->waitlock);
+        return -1;
+    }
+    rslt = pthread_cond_init(&watcher->deferdone, NULL);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR("Failed to initialize condition for deferred calls, error code: %d", rslt);
+        pthread_mutex_destroy(&watcher->mutw);
+        pthread_mutex_destroy(&watcher->timerlock);
+        pthread_mutex_destroy(&watcher->waitlock);
+        pthread_mutex_destroy(&watcher->deferlock);
         return -1;
     }
-    pbpal_ntf_callback_queue_init(&m_watcher.queue);
 
-#if defined(PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB)                              \
-    && (PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB > 0)
-    {
-        pthread_attr_t thread_attr;
+    watcher->poll = pbpal_ntf_callback_poller_init();
+    if (NULL == watcher->poll) {
+        pthread_mutex_destroy(&watcher->mutw);
+        pthread_mutex_destroy(&watcher->timerlock);
+        pthread_mutex_destroy(&watcher->waitlock);
+        pthread_mutex_destroy(&watcher->deferlock);
+        pthread_cond_destroy(&watcher->deferdone);
+        return -1;
+    }
+    pbpal_ntf_callback_queue_init(&watcher->queue);
+#if PUBNUB_TIMERS_API
+    pubnub_timer_wheel_init(&watcher->timers);
+#endif
+#if PUBNUB_HAPPY_EYEBALLS
+    watcher->connect_races = NULL;
+#endif
+    watcher->deferred         = NULL;
+    watcher->deferred_running = NULL;
 
-        rslt = pthread_attr_init(&thread_attr);
-        if (rslt != 0) {
-            PUBNUB_LOG_ERROR(
-                "Failed to initialize thread attributes, error code: %d\n", rslt);
-            pthread_mutexattr_destroy(&attr);
-            pthread_mutex_destroy(&m_watcher.mutw);
-            pthread_mutex_destroy(&m_watcher.timerlock);
-            pthread_mutex_destroy(&m_watcher.queue_lock);
-            pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-            pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
-            return -1;
-        }
-        rslt = pthread_attr_setstacksize(
-            &thread_attr, PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB * 1024);
-        if (rslt != 0) {
-            PUBNUB_LOG_ERROR(
-                "Failed to set thread stack size to %d kb, error code: %d\n",
-                PUBNUB_CALLBACK_THREAD_STACK_SIZE_KB,
-                rslt);
-            pthread_mutexattr_destroy(&attr);
-            pthread_mutex_destroy(&m_watcher.mutw);
-            pthread_mutex_destroy(&m_watcher.timerlock);
-            pthread_mutex_destroy(&m_watcher.queue_lock);
-            pthread_attr_destroy(&thread_attr);
-            pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-            pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
-            return -1;
-        }
-        rslt = pthread_create(
-            &m_watcher.thread_id, &thread_attr, socket_watcher_thread, NULL);
-        if (rslt != 0) {
-            PUBNUB_LOG_ERROR(
-                "Failed to create the polling thread, error code: %d\n", rslt);
-            pthread_mutexattr_destroy(&attr);
-            pthread_mutex_destroy(&m_watcher.mutw);
-            pthread_mutex_destroy(&m_watcher.timerlock);
-            pthread_mutex_destroy(&m_watcher.queue_lock);
-            pthread_attr_destroy(&thread_attr);
-            pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-            pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
-            return -1;
-        }
+    if (start_watcher_thread(watcher) != 0) {
+        watcher_deinit(watcher);
+        return -1;
     }
-#else
-    rslt =
-        pthread_create(&m_watcher.thread_id, NULL, socket_watcher_thread, NULL);
+
+    return 0;
+}
+
+
+int pbntf_init(void)
+{
+    int                 rslt;
+    unsigned            i;
+    pthread_mutexattr_t attr;
+
+    rslt = pthread_mutexattr_init(&attr);
     if (rslt != 0) {
         PUBNUB_LOG_ERROR(
-            "Failed to create the polling thread, error code: %d\n", rslt);
+            "Failed to initialize mutex attributes, error code: %d", rslt);
+        return -1;
+    }
+    rslt = pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (rslt != 0) {
+        PUBNUB_LOG_ERROR("Failed to set mutex attribute type, error code: %d",
+                         rslt);
         pthread_mutexattr_destroy(&attr);
-        pthread_mutex_destroy(&m_watcher.mutw);
-        pthread_mutex_destroy(&m_watcher.timerlock);
-        pbpal_ntf_callback_queue_deinit(&m_watcher.queue);
-        pbpal_ntf_callback_poller_deinit(&m_watcher.poll);
         return -1;
     }
-#endif
+    for (i = 0; i < PUBNUB_CALLBACK_THREAD_COUNT; ++i) {
+        if (watcher_init(m_watcher + i, &attr) != 0) {
+            /* We don't stop the threads already started, they have
+               nothing to do, so they'll just wait in their pollers.
+             */
+            pthread_mutexattr_destroy(&attr);
+            return -1;
+        }
+    }
+    pthread_mutexattr_destroy(&attr);
 
     return 0;
 }
@@ -205,26 +651,43 @@ int pbntf_init(void)
 
 int pbntf_enqueue_for_processing(pubnub_t* pb)
 {
-    return pbpal_ntf_callback_enqueue_for_processing(&m_watcher.queue, pb);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+    int rslt = pbpal_ntf_callback_enqueue_for_processing(&watcher->queue, pb);
+    if (rslt > 0) {
+        wake_watcher(watcher);
+    }
+    return rslt;
 }
 
 
 int pbntf_requeue_for_processing(pubnub_t* pb)
 {
-    return pbpal_ntf_callback_requeue_for_processing(&m_watcher.queue, pb);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+    int rslt = pbpal_ntf_callback_requeue_for_processing(&watcher->queue, pb);
+    if (rslt > 0) {
+        wake_watcher(watcher);
+    }
+    return rslt;
 }
 
 
 int pbntf_got_socket(pubnub_t* pb)
 {
-    pthread_mutex_lock(&m_watcher.mutw);
-    pbpal_ntf_callback_save_socket(m_watcher.poll, pb);
-    pthread_mutex_unlock(&m_watcher.mutw);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_save_socket(watcher->poll, pb);
+    pthread_mutex_unlock(&watcher->mutw);
 
     if (PUBNUB_TIMERS_API) {
-        pthread_mutex_lock(&m_watcher.timerlock);
-        m_watcher.timer_head = pubnub_timer_list_add(m_watcher.timer_head, pb);
-        pthread_mutex_unlock(&m_watcher.timerlock);
+        pthread_mutex_lock(&watcher->timerlock);
+        /* Starting a transaction while the timer of the previous
+           one is still running restarts the timer.
+         */
+        pubnub_timer_wheel_remove(&watcher->timers, pb);
+        pubnub_timer_wheel_add(&watcher->timers, pb);
+        pthread_mutex_unlock(&watcher->timerlock);
+        wake_watcher(watcher);
     }
 
     return +1;
@@ -233,21 +696,27 @@ int pbntf_got_socket(pubnub_t* pb)
 
 void pbntf_lost_socket(pubnub_t* pb)
 {
-    pthread_mutex_lock(&m_watcher.mutw);
-    pbpal_ntf_callback_remove_socket(m_watcher.poll, pb);
-    pthread_mutex_unlock(&m_watcher.mutw);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_remove_socket(watcher->poll, pb);
+    pthread_mutex_unlock(&watcher->mutw);
 
-    pbpal_ntf_callback_remove_from_queue(&m_watcher.queue, pb);
+    pbpal_ntf_callback_remove_from_queue(&watcher->queue, pb);
 
-    pthread_mutex_lock(&m_watcher.timerlock);
-    pbpal_remove_timer_safe(pb, &m_watcher.timer_head);
-    pthread_mutex_unlock(&m_watcher.timerlock);
+    if (PUBNUB_TIMERS_API) {
+        pthread_mutex_lock(&watcher->timerlock);
+        pubnub_timer_wheel_remove(&watcher->timers, pb);
+        pthread_mutex_unlock(&watcher->timerlock);
+    }
 }
 
 
 void pbntf_update_socket(pubnub_t* pb)
 {
-    pthread_mutex_lock(&m_watcher.mutw);
-    pbpal_ntf_callback_update_socket(m_watcher.poll, pb);
-    pthread_mutex_unlock(&m_watcher.mutw);
+    struct SocketWatcherData* watcher = watcher_of(pb);
+
+    lock_poller(watcher);
+    pbpal_ntf_callback_update_socket(watcher->poll, pb);
+    pthread_mutex_unlock(&watcher->mutw);
 }
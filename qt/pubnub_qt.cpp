@@ -758,7 +758,8 @@ void pubnub_qt::httpFinished()
                  << ", string: " << d_reply->errorString();
         d_context->http_buf_len = 0;
         if (PUBNUB_DYNAMIC_REPLY_BUFFER) {
-            d_context->http_reply = NULL;
+            d_context->http_reply          = NULL;
+            d_context->http_reply_capacity = 0;
         }
         else {
             d_context->http_reply[0] = '\0';